@@ -0,0 +1,404 @@
+/*
+ * Bolt file cache simulator.
+ *
+ * Replays a request trace against several eviction policies sized like
+ * the server's file cache and reports object and byte hit ratios. The
+ * S3-FIFO run uses src/cache_policy.c itself, so it is the policy the
+ * server ships; LRU and FIFO are simulated here for comparison.
+ *
+ * The trace is read from access logs in Bolt's (combined) log format:
+ * each GET with a 200 status is one request for its URI, sized by the
+ * logged byte count. Without log files a synthetic trace is generated:
+ * Zipf-distributed requests over a site, with a crawler fetching every
+ * page of a much larger site once in the middle of it.
+ *
+ * Objects larger than the cache's per-entry limit are never cached,
+ * as in the server.
+ *
+ * Usage: cache_sim [-n entries] [-b bytes] [-e max_entry_bytes] [access.log ...]
+ */
+
+#include "cache_policy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SIM_LINE_MAX        8192
+
+/* Synthetic workload */
+#define SIM_SITE_OBJECTS    10000
+#define SIM_CRAWL_OBJECTS   40000
+#define SIM_REQUESTS        1000000
+#define SIM_ZIPF_ALPHA      0.9
+
+typedef struct {
+    char* key;
+    uint32_t hash;
+    size_t size;
+} SimObject;
+
+typedef struct {
+    SimObject* objects;
+    size_t count;
+    size_t capacity;
+    uint32_t* index;            /* Open addressing: object id + 1, 0 = empty */
+    size_t index_mask;
+
+    uint32_t* requests;
+    size_t request_count;
+    size_t request_capacity;
+} SimTrace;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t requests;
+    uint64_t hit_bytes;
+    uint64_t bytes;
+} SimResult;
+
+static uint32_t fnv1a32(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)(*s++);
+        h *= 16777619u;
+    }
+    return h ? h : 1u;
+}
+
+static void* xrealloc(void* p, size_t size) {
+    p = realloc(p, size);
+    if (!p) {
+        fprintf(stderr, "cache_sim: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+/*
+ * Grow the key index so it stays at most half full.
+ */
+static void trace_grow_index(SimTrace* trace) {
+    size_t size = trace->index ? (trace->index_mask + 1) * 2 : 1024;
+    free(trace->index);
+    trace->index = (uint32_t*)calloc(size, sizeof(uint32_t));
+    if (!trace->index) {
+        fprintf(stderr, "cache_sim: out of memory\n");
+        exit(1);
+    }
+    trace->index_mask = size - 1;
+
+    for (size_t id = 0; id < trace->count; id++) {
+        size_t slot = trace->objects[id].hash & trace->index_mask;
+        while (trace->index[slot]) slot = (slot + 1) & trace->index_mask;
+        trace->index[slot] = (uint32_t)(id + 1);
+    }
+}
+
+/*
+ * Append a request for key, registering the object on first sight.
+ */
+static void trace_add(SimTrace* trace, const char* key, size_t size) {
+    if (!trace->index || (trace->count + 1) * 2 > trace->index_mask + 1) {
+        trace_grow_index(trace);
+    }
+
+    uint32_t hash = fnv1a32(key);
+    size_t slot = hash & trace->index_mask;
+    uint32_t id = 0;
+    while (trace->index[slot]) {
+        SimObject* object = &trace->objects[trace->index[slot] - 1];
+        if (object->hash == hash && strcmp(object->key, key) == 0) {
+            id = trace->index[slot];
+            break;
+        }
+        slot = (slot + 1) & trace->index_mask;
+    }
+
+    if (!id) {
+        if (trace->count == trace->capacity) {
+            trace->capacity = trace->capacity ? trace->capacity * 2 : 1024;
+            trace->objects = (SimObject*)xrealloc(trace->objects, trace->capacity * sizeof(SimObject));
+        }
+        SimObject* object = &trace->objects[trace->count];
+        object->key = strdup(key);
+        object->hash = hash;
+        object->size = size ? size : 1;
+        if (!object->key) {
+            fprintf(stderr, "cache_sim: out of memory\n");
+            exit(1);
+        }
+        trace->index[slot] = (uint32_t)(++trace->count);
+        id = trace->index[slot];
+    }
+
+    if (trace->request_count == trace->request_capacity) {
+        trace->request_capacity = trace->request_capacity ? trace->request_capacity * 2 : 65536;
+        trace->requests = (uint32_t*)xrealloc(trace->requests, trace->request_capacity * sizeof(uint32_t));
+    }
+    trace->requests[trace->request_count++] = id - 1;
+}
+
+/*
+ * Parse one access log line: ... "GET /uri HTTP/1.1" 200 1234 ...
+ */
+static bool parse_log_line(char* line, char** uri, size_t* bytes) {
+    char* request = strchr(line, '"');
+    if (!request || strncmp(request + 1, "GET ", 4) != 0) return false;
+
+    *uri = request + 5;
+    char* end = strchr(*uri, ' ');
+    if (!end) return false;
+    *end = '\0';
+
+    char* quote = strchr(end + 1, '"');
+    if (!quote) return false;
+
+    int status = 0;
+    unsigned long long size = 0;
+    if (sscanf(quote + 1, " %d %llu", &status, &size) != 2 || status != 200) return false;
+
+    *bytes = (size_t)size;
+    return true;
+}
+
+static bool trace_load_log(SimTrace* trace, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[SIM_LINE_MAX];
+    while (fgets(line, sizeof(line), f)) {
+        char* uri;
+        size_t bytes;
+        if (parse_log_line(line, &uri, &bytes)) {
+            trace_add(trace, uri, bytes);
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+/* xorshift64*: deterministic across runs */
+static uint64_t sim_random(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+/*
+ * Zipf over site pages, plus a crawler walking SIM_CRAWL_OBJECTS distinct
+ * pages once, interleaved one-for-one with regular traffic mid-trace.
+ */
+static void trace_generate(SimTrace* trace) {
+    double* cdf = (double*)malloc(SIM_SITE_OBJECTS * sizeof(double));
+    size_t* sizes = (size_t*)malloc(SIM_SITE_OBJECTS * sizeof(size_t));
+    if (!cdf || !sizes) {
+        fprintf(stderr, "cache_sim: out of memory\n");
+        exit(1);
+    }
+
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    double sum = 0;
+    for (int i = 0; i < SIM_SITE_OBJECTS; i++) {
+        sum += 1.0 / pow(i + 1, SIM_ZIPF_ALPHA);
+        cdf[i] = sum;
+        sizes[i] = 512 + (size_t)(sim_random(&rng) % (48 * 1024));
+    }
+
+    size_t crawl_start = SIM_REQUESTS / 2 - SIM_CRAWL_OBJECTS;
+    int crawled = 0;
+    char key[64];
+
+    for (size_t r = 0; r < SIM_REQUESTS; r++) {
+        if (r >= crawl_start && crawled < SIM_CRAWL_OBJECTS && (r - crawl_start) % 2 == 0) {
+            snprintf(key, sizeof(key), "/archive/%d.html", crawled++);
+            trace_add(trace, key, 4096 + (size_t)(sim_random(&rng) % 16384));
+            continue;
+        }
+
+        double u = (double)(sim_random(&rng) >> 11) / 9007199254740992.0 * sum;
+        int lo = 0, hi = SIM_SITE_OBJECTS - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cdf[mid] < u) lo = mid + 1;
+            else hi = mid;
+        }
+        snprintf(key, sizeof(key), "/site/%d", lo);
+        trace_add(trace, key, sizes[lo]);
+    }
+
+    free(cdf);
+    free(sizes);
+}
+
+/*============================================================================
+ * Policies
+ *============================================================================*/
+
+typedef struct SimNode {
+    struct SimNode* prev;
+    struct SimNode* next;
+    bool cached;
+} SimNode;
+
+static void sim_list_push(SimNode* head, SimNode* node) {
+    node->prev = head;
+    node->next = head->next;
+    head->next->prev = node;
+    head->next = node;
+}
+
+static void sim_list_unlink(SimNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+}
+
+static void record(SimResult* result, size_t size, bool hit) {
+    result->requests++;
+    result->bytes += size;
+    if (hit) {
+        result->hits++;
+        result->hit_bytes += size;
+    }
+}
+
+/*
+ * LRU (move_to_front on hit) or FIFO (insertion order only).
+ */
+static SimResult run_list_policy(const SimTrace* trace, size_t max_entries, size_t max_bytes,
+                                 size_t max_entry, bool lru) {
+    SimResult result = { 0 };
+    SimNode* nodes = (SimNode*)calloc(trace->count, sizeof(SimNode));
+    if (!nodes) return result;
+
+    SimNode head;
+    head.next = head.prev = &head;
+    size_t entries = 0, bytes = 0;
+
+    for (size_t r = 0; r < trace->request_count; r++) {
+        uint32_t id = trace->requests[r];
+        SimNode* node = &nodes[id];
+        size_t size = trace->objects[id].size;
+
+        if (node->cached) {
+            record(&result, size, true);
+            if (lru) {
+                sim_list_unlink(node);
+                sim_list_push(&head, node);
+            }
+            continue;
+        }
+
+        record(&result, size, false);
+        if (size > max_entry) continue;
+
+        while (entries >= max_entries || bytes + size > max_bytes) {
+            SimNode* victim = head.prev;
+            sim_list_unlink(victim);
+            victim->cached = false;
+            entries--;
+            bytes -= trace->objects[victim - nodes].size;
+        }
+        sim_list_push(&head, node);
+        node->cached = true;
+        entries++;
+        bytes += size;
+    }
+
+    free(nodes);
+    return result;
+}
+
+static SimResult run_s3fifo(const SimTrace* trace, size_t max_entries, size_t max_bytes,
+                            size_t max_entry) {
+    SimResult result = { 0 };
+    BoltS3Node* nodes = (BoltS3Node*)calloc(trace->count, sizeof(BoltS3Node));
+    BoltS3Fifo policy;
+    if (!nodes || !bolt_s3fifo_init(&policy, max_bytes, max_entries)) {
+        free(nodes);
+        return result;
+    }
+
+    for (size_t r = 0; r < trace->request_count; r++) {
+        uint32_t id = trace->requests[r];
+        BoltS3Node* node = &nodes[id];
+        size_t size = trace->objects[id].size;
+
+        if (node->queue != BOLT_S3FIFO_NONE) {
+            record(&result, size, true);
+            bolt_s3fifo_hit(node);
+            continue;
+        }
+
+        record(&result, size, false);
+        if (size > max_entry) continue;
+
+        while (bolt_s3fifo_full(&policy, size)) {
+            if (!bolt_s3fifo_evict(&policy)) break;
+        }
+        node->hash = trace->objects[id].hash;
+        node->bytes = size;
+        bolt_s3fifo_insert(&policy, node);
+    }
+
+    bolt_s3fifo_destroy(&policy);
+    free(nodes);
+    return result;
+}
+
+static void print_result(const char* name, SimResult result) {
+    printf("  %-8s  %10.2f%%  %10.2f%%\n", name,
+           result.requests ? 100.0 * result.hits / result.requests : 0.0,
+           result.bytes ? 100.0 * result.hit_bytes / result.bytes : 0.0);
+}
+
+int main(int argc, char** argv) {
+    size_t max_entries = BOLT_FILE_CACHE_CAPACITY;
+    size_t max_bytes = BOLT_FILE_CACHE_MAX_TOTAL_BYTES;
+    size_t max_entry = BOLT_FILE_CACHE_MAX_ENTRY_SIZE;
+    SimTrace trace;
+    memset(&trace, 0, sizeof(trace));
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (arg + 1 >= argc) break;
+        if (strcmp(argv[arg], "-n") == 0) max_entries = strtoull(argv[++arg], NULL, 10);
+        else if (strcmp(argv[arg], "-b") == 0) max_bytes = strtoull(argv[++arg], NULL, 10);
+        else if (strcmp(argv[arg], "-e") == 0) max_entry = strtoull(argv[++arg], NULL, 10);
+        else break;
+    }
+    if (max_entries == 0 || max_bytes == 0 ||
+        (arg < argc && argv[arg][0] == '-')) {
+        fprintf(stderr, "Usage: %s [-n entries] [-b bytes] [-e max_entry_bytes] [access.log ...]\n", argv[0]);
+        return 2;
+    }
+
+    if (arg < argc) {
+        for (; arg < argc; arg++) {
+            if (!trace_load_log(&trace, argv[arg])) return 1;
+        }
+        printf("Trace: %zu requests, %zu objects (access log)\n", trace.request_count, trace.count);
+    } else {
+        trace_generate(&trace);
+        printf("Trace: %zu requests, %zu objects (synthetic: Zipf %.1f over %d pages, "
+               "crawler over %d more)\n", trace.request_count, trace.count,
+               SIM_ZIPF_ALPHA, SIM_SITE_OBJECTS, SIM_CRAWL_OBJECTS);
+    }
+    printf("Cache: %zu entries, %zu bytes, %zu bytes per entry\n\n", max_entries, max_bytes, max_entry);
+
+    printf("  %-8s  %11s  %11s\n", "policy", "object hits", "byte hits");
+    print_result("LRU", run_list_policy(&trace, max_entries, max_bytes, max_entry, true));
+    print_result("FIFO", run_list_policy(&trace, max_entries, max_bytes, max_entry, false));
+    print_result("S3-FIFO", run_s3fifo(&trace, max_entries, max_bytes, max_entry));
+
+    for (size_t i = 0; i < trace.count; i++) free(trace.objects[i].key);
+    free(trace.objects);
+    free(trace.index);
+    free(trace.requests);
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Bolt compressor microbenchmark.
+ *
+ * Compresses the same response over and over the way the server did
+ * before encoder contexts were pooled (a fresh deflate or br state and a
+ * malloc'd output per response) and the way it does now (a per-thread
+ * context reset for each response, output into a buffer that is reused:
+ * the thread's scratch buffer for cache fills, the send buffer inline).
+ * For each it reports heap allocations, bytes allocated and nanoseconds
+ * per compressed response.
+ *
+ * Allocations are counted by wrapping malloc and friends, which also
+ * catches the ones zlib and brotli make.
+ *
+ * Usage: compress_bench [-n iterations] [file ...]
+ * Without files it compresses generated HTML of 4 KB and 32 KB.
+ */
+
+#include "compression.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#if __has_include(<brotli/encode.h>)
+#include <brotli/encode.h>
+#define HAVE_BROTLI 1
+#else
+#define HAVE_BROTLI 0
+#endif
+
+#define BENCH_ITERATIONS    1000
+#define BENCH_ROUNDS        5       /* Timing is the best round's */
+#define BENCH_OUT_SIZE      (BOLT_SEND_BUFFER_SIZE - 1024)
+
+/*============================================================================
+ * Allocation counting
+ *============================================================================*/
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static unsigned long long g_allocs;
+static unsigned long long g_alloc_bytes;
+
+void* malloc(size_t size) {
+    g_allocs++;
+    g_alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    g_allocs++;
+    g_alloc_bytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    g_allocs++;
+    g_alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+/*============================================================================
+ * Per-response compression as it was: new state, new output buffer
+ *============================================================================*/
+
+static bool fresh_gzip(const char* input, size_t size, int level, size_t* out_len) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    size_t dest_size = deflateBound(&stream, (uLong)size) + 18;
+    char* dest = (char*)malloc(dest_size);
+    if (!dest) {
+        deflateEnd(&stream);
+        return false;
+    }
+    stream.next_in = (Bytef*)input;
+    stream.avail_in = (uInt)size;
+    stream.next_out = (Bytef*)dest;
+    stream.avail_out = (uInt)dest_size;
+    bool ok = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+    *out_len = dest_size - stream.avail_out;
+    deflateEnd(&stream);
+
+    char* resized = (char*)realloc(dest, *out_len);
+    free(resized ? resized : dest);
+    return ok;
+}
+
+#if HAVE_BROTLI
+static bool fresh_brotli(const char* input, size_t size, int level, size_t* out_len) {
+    size_t dest_size = BrotliEncoderMaxCompressedSize(size);
+    char* dest = (char*)malloc(dest_size);
+    if (!dest) {
+        return false;
+    }
+    bool ok = BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                    size, (const uint8_t*)input,
+                                    &dest_size, (uint8_t*)dest);
+    *out_len = dest_size;
+
+    char* resized = (char*)realloc(dest, dest_size);
+    free(resized ? resized : dest);
+    return ok;
+}
+#endif
+
+/*============================================================================
+ * Runs
+ *============================================================================*/
+
+typedef enum {
+    MODE_FRESH,         /* Before: init/end and malloc per response */
+    MODE_SCRATCH,       /* Pooled context, thread scratch buffer (cache fills) */
+    MODE_INTO           /* Pooled context, caller's buffer (send buffer) */
+} BenchMode;
+
+static const char* g_mode_names[] = { "fresh", "pooled+scratch", "pooled+in-place" };
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bool compress_once(BenchMode mode, BoltCompressionType type,
+                          const char* input, size_t size, int level,
+                          char* out, size_t* out_len) {
+    switch (mode) {
+        case MODE_FRESH:
+#if HAVE_BROTLI
+            if (type == BOLT_COMPRESS_BROTLI) {
+                return fresh_brotli(input, size, level, out_len);
+            }
+#endif
+            return fresh_gzip(input, size, level, out_len);
+        case MODE_SCRATCH:
+            return compression_compress_scratch(type, input, size, out_len, level) != NULL;
+        case MODE_INTO:
+            return compression_compress_into(type, input, size, out, BENCH_OUT_SIZE,
+                                             out_len, level);
+    }
+    return false;
+}
+
+static void run(const char* label, BoltCompressionType type,
+                const char* input, size_t size, int iterations) {
+    static char out[BENCH_OUT_SIZE];
+    int level = compression_level(NULL, type);
+
+    for (int mode = MODE_FRESH; mode <= MODE_INTO; mode++) {
+        if (mode == MODE_INTO && compression_bound(type, size) > BENCH_OUT_SIZE) {
+            continue;  /* Too large to compress inline in the server */
+        }
+
+        /* Warm up: the pooled modes make their context here */
+        size_t out_len = 0;
+        if (!compress_once((BenchMode)mode, type, input, size, level, out, &out_len)) {
+            fprintf(stderr, "%s %s: compression failed\n", label, g_mode_names[mode]);
+            return;
+        }
+
+        unsigned long long allocs = g_allocs;
+        unsigned long long bytes = g_alloc_bytes;
+        double best = 0;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            double start = now_ns();
+            for (int i = 0; i < iterations; i++) {
+                compress_once((BenchMode)mode, type, input, size, level, out, &out_len);
+            }
+            double elapsed = (now_ns() - start) / iterations;
+            if (round == 0 || elapsed < best) best = elapsed;
+        }
+        int responses = iterations * BENCH_ROUNDS;
+
+        printf("  %-6s %-10s %-16s %8.1f %12.0f %10.0f %8zu\n",
+               compression_coding_name(type), label, g_mode_names[mode],
+               (double)(g_allocs - allocs) / responses,
+               (double)(g_alloc_bytes - bytes) / responses,
+               best, out_len);
+    }
+}
+
+static char* make_html(size_t size) {
+    static const char* words[] = {
+        "<div class=\"item\">", "</div>\n", "<a href=\"/docs/", "\">", "</a>",
+        "bolt", "server", "cache", "request", "response", "file", "<p>", "</p>\n",
+        "the", "fast", "static", "content", " ", " ", "\n"
+    };
+    char* html = (char*)malloc(size);
+    if (!html) return NULL;
+
+    unsigned int seed = 42;
+    size_t pos = 0;
+    while (pos < size) {
+        seed = seed * 1103515245u + 12345u;
+        const char* word = words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+        size_t len = strlen(word);
+        if (len > size - pos) len = size - pos;
+        memcpy(html + pos, word, len);
+        pos += len;
+    }
+    return html;
+}
+
+static char* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = len > 0 ? (char*)malloc((size_t)len) : NULL;
+    if (data && fread(data, 1, (size_t)len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+static void run_input(const char* label, const char* input, size_t size, int iterations) {
+    run(label, BOLT_COMPRESS_GZIP, input, size, iterations);
+    if (compression_available(BOLT_COMPRESS_BROTLI)) {
+        run(label, BOLT_COMPRESS_BROTLI, input, size, iterations);
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = BENCH_ITERATIONS;
+    int first_file = 1;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        iterations = atoi(argv[2]);
+        first_file = 3;
+        if (iterations < 1) iterations = 1;
+    }
+
+    printf("  coding input      mode               allocs  bytes alloc   ns/resp   output\n");
+
+    if (first_file >= argc) {
+        static const size_t sizes[] = { 4096, 32768 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            char label[32];
+            snprintf(label, sizeof(label), "html %zuK", sizes[i] / 1024);
+            char* html = make_html(sizes[i]);
+            if (!html) return 1;
+            run_input(label, html, sizes[i], iterations);
+            free(html);
+        }
+    }
+
+    for (int i = first_file; i < argc; i++) {
+        size_t size = 0;
+        char* data = read_file(argv[i], &size);
+        if (!data) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        const char* name = strrchr(argv[i], '/');
+        run_input(name ? name + 1 : argv[i], data, size, iterations);
+        free(data);
+    }
+
+    compression_release_thread_contexts();
+    return 0;
+}
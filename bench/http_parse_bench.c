@@ -0,0 +1,230 @@
+/*
+ * Bolt request parser microbenchmark.
+ *
+ * Parses the same request heads over and over the way the server did
+ * before the single-pass tokenizer (a strstr for the end of the head,
+ * one per header the parser copied out, and more in connection.c,
+ * file_server.c and the access log, all case-sensitive) and the way it
+ * does now (one pass recording slices, lookups by header ID). Each round
+ * first copies the head into a receive buffer, as a recv would, since
+ * the old code needs it NUL-terminated and the new one terminates values
+ * in place. It reports nanoseconds per request.
+ *
+ * Usage: http_parse_bench [-n iterations]
+ */
+
+#include "http.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS    1000000
+#define BENCH_ROUNDS        5       /* Timing is the best round's */
+#define BENCH_BUFFER_SIZE   8192
+
+/*============================================================================
+ * The parser as it was: fixed arrays, strstr per header
+ *============================================================================*/
+
+typedef struct {
+    HttpMethod method;
+    char uri[2048];
+    char if_none_match[64];
+    char if_modified_since[64];
+    char accept_encoding[128];
+    HttpRange range;
+    unsigned char version_minor;
+    bool valid;
+} OldRequest;
+
+static void old_extract_header(const char* request, const char* header_name,
+                               char* out_value, size_t out_size) {
+    out_value[0] = '\0';
+    const char* header_start = strstr(request, header_name);
+    if (!header_start) return;
+
+    const char* value_start = header_start + strlen(header_name);
+    if (*value_start == ':') value_start++;
+    while (*value_start == ' ' || *value_start == '\t') value_start++;
+    const char* value_end = value_start;
+    while (*value_end && *value_end != '\r' && *value_end != '\n') value_end++;
+
+    size_t value_len = (size_t)(value_end - value_start);
+    if (value_len >= out_size) value_len = out_size - 1;
+    char temp[256];
+    size_t temp_len = value_len < sizeof(temp) ? value_len : sizeof(temp) - 1;
+    strncpy(temp, value_start, temp_len);
+    temp[temp_len] = '\0';
+
+    /* sanitize_header_value() */
+    size_t len = 0;
+    for (const char* p = temp; *p && len < out_size - 1; p++) {
+        if (*p == '\r' || *p == '\n' || (*p < 0x20 && *p != '\t')) continue;
+        out_value[len++] = *p;
+    }
+    out_value[len] = '\0';
+}
+
+static OldRequest old_parse_request(const char* raw, size_t length) {
+    OldRequest req = { HTTP_UNKNOWN, "", "", "", "", { 0, SIZE_MAX, false }, 0, false };
+    if (!raw || length == 0) return req;
+
+    const char* line_end = strstr(raw, "\r\n");
+    if (!line_end) return req;
+    const char* method_end = raw;
+    while (method_end < line_end && *method_end != ' ') method_end++;
+    if (method_end >= line_end) return req;
+    req.method = strncmp(raw, "GET", 3) == 0 ? HTTP_GET : HTTP_UNKNOWN;
+
+    const char* uri_start = method_end + 1;
+    const char* full_uri_end = uri_start;
+    while (full_uri_end < line_end && *full_uri_end != ' ') full_uri_end++;
+    const char* path_end = uri_start;
+    while (path_end < full_uri_end && *path_end != '?') path_end++;
+    const char* version = full_uri_end;
+    while (version < line_end && *version == ' ') version++;
+    if (version >= line_end || strncmp(version, "HTTP/1.", 7) != 0) return req;
+    req.version_minor = (unsigned char)(version[7] - '0');
+
+    size_t uri_len = (size_t)(path_end - uri_start);
+    if (uri_len >= sizeof(req.uri)) uri_len = sizeof(req.uri) - 1;
+    strncpy(req.uri, uri_start, uri_len);
+    req.uri[uri_len] = '\0';
+
+    old_extract_header(raw, "If-None-Match", req.if_none_match, sizeof(req.if_none_match));
+    old_extract_header(raw, "If-Modified-Since", req.if_modified_since, sizeof(req.if_modified_since));
+    old_extract_header(raw, "Accept-Encoding", req.accept_encoding, sizeof(req.accept_encoding));
+    char range_header[128];
+    old_extract_header(raw, "Range", range_header, sizeof(range_header));
+
+    req.valid = true;
+    return req;
+}
+
+/* What one request cost: connection.c, file_server.c and the access log */
+static size_t old_request(char* buf, size_t length) {
+    char* end_of_headers = strstr(buf, "\r\n\r\n");
+    if (!end_of_headers) return 0;
+    size_t head = (size_t)(end_of_headers - buf) + 4;
+    buf[head] = '\0';
+
+    OldRequest req = old_parse_request(buf, length);
+    bool keep_alive = true;
+    char* conn_header = strstr(buf, "Connection:");
+    if (conn_header && strstr(conn_header, "close")) keep_alive = false;
+    char* length_header = strstr(buf, "Content-Length:");
+    if (length_header && atol(length_header + 15) > 0) keep_alive = false;
+
+    char host[256];
+    char range[128];
+    char referer[256];
+    char user_agent[512];
+    old_extract_header(buf, "Host", host, sizeof(host));
+    old_extract_header(buf, "Range", range, sizeof(range));
+    old_extract_header(buf, "Referer", referer, sizeof(referer));
+    old_extract_header(buf, "User-Agent", user_agent, sizeof(user_agent));
+
+    return req.valid && keep_alive ? strlen(req.uri) + strlen(host) + strlen(user_agent) : 1;
+}
+
+/*============================================================================
+ * The parser as it is
+ *============================================================================*/
+
+static size_t new_request(char* buf, size_t length) {
+    HttpRequest req = http_parse_request(buf, length);
+    if (req.head_length == 0) return 0;
+    buf[req.head_length] = '\0';
+
+    bool keep_alive = !http_slice_has_token(req.headers[HTTP_HEADER_CONNECTION], "close");
+    const char* length_header = http_header(&req, HTTP_HEADER_CONTENT_LENGTH);
+    if (length_header && atol(length_header) > 0) keep_alive = false;
+
+    return req.valid && keep_alive ?
+        req.uri_len + req.headers[HTTP_HEADER_HOST].len + req.headers[HTTP_HEADER_USER_AGENT].len : 1;
+}
+
+/*============================================================================
+ * Runs
+ *============================================================================*/
+
+static const char* g_curl_request =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static const char* g_browser_request =
+    "GET /assets/js/app.3f9c2b.js?v=20240611 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/124.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Accept: */*\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Dest: script\r\n"
+    "Referer: https://www.example.com/docs/getting-started.html\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+    "Cookie: session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; consent=1\r\n"
+    "If-None-Match: \"5a3c-66683a1f-br\"\r\n"
+    "If-Modified-Since: Tue, 11 Jun 2024 10:15:27 GMT\r\n"
+    "\r\n";
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double run(size_t (*parse)(char* buf, size_t length), const char* request,
+                  int iterations, size_t* check) {
+    static char buf[BENCH_BUFFER_SIZE];
+    size_t length = strlen(request);
+    double best = 0;
+    size_t sum = 0;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double start = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            memcpy(buf, request, length + 1);
+            sum += parse(buf, length);
+        }
+        double elapsed = (now_ns() - start) / iterations;
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+    *check = sum;
+    return best;
+}
+
+static void run_request(const char* label, const char* request, int iterations) {
+    size_t old_check;
+    size_t new_check;
+    double old_ns = run(old_request, request, iterations, &old_check);
+    double new_ns = run(new_request, request, iterations, &new_check);
+
+    printf("  %-8s %6zu %14.1f %14.1f %7.2fx\n", label, strlen(request),
+           old_ns, new_ns, new_ns > 0 ? old_ns / new_ns : 0.0);
+    if (old_check == 0 || new_check == 0) {
+        fprintf(stderr, "%s: a parser did not find the end of the head\n", label);
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = BENCH_ITERATIONS;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        iterations = atoi(argv[2]);
+        if (iterations < 1) iterations = 1;
+    }
+
+    printf("  request   bytes  strstr ns/req  1-pass ns/req  speedup\n");
+    run_request("curl", g_curl_request, iterations);
+    run_request("browser", g_browser_request, iterations);
+    return 0;
+}
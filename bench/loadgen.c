@@ -0,0 +1,512 @@
+/*
+ * Bolt loopback load generator (Linux).
+ *
+ * Opens N keep-alive connections, each driven by its own thread, and issues
+ * back-to-back GET requests for a fixed duration. Reports requests/sec and
+ * throughput. Intended for quick A/B comparisons on one machine, not as a
+ * replacement for wrk.
+ *
+ * With -m, the server's /metrics counters are sampled before and after the
+ * run to report I/O syscalls per request for the backend under test.
+ *
+ * With -s N, connections are bound round-robin to the loopback source
+ * addresses 127.0.0.1 .. 127.0.0.N, so more than BOLT_MAX_CONNECTIONS_PER_IP
+ * connections can be opened against a local server.
+ *
+ * With -P N, each connection writes N pipelined requests in one send and
+ * then reads the N responses.
+ *
+ * Bodies are framed by Content-Length or, for streamed compressed
+ * responses, by chunked transfer coding.
+ *
+ * Latency is timed from the send to each response's last byte, and
+ * reported as p50/p99/max (10 us buckets up to 10 ms, then 1 ms ones).
+ *
+ * Usage: loadgen [-h host] [-p port] [-c connections] [-d seconds] [-s sources] [-P depth] [-m] [path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define LOADGEN_BUFFER_SIZE 65536
+#define LATENCY_FINE_US     10          /* Bucket width below LATENCY_COARSE_FROM */
+#define LATENCY_COARSE_US   1000        /* ...and above it */
+#define LATENCY_COARSE_FROM 10000
+#define LATENCY_BUCKETS     11000       /* Up to 10 s; the last holds slower ones */
+
+typedef struct {
+    const char* host;
+    int port;
+    uint32_t source_ip;         /* Host order; 0 = let the kernel choose */
+    const char* request;        /* depth copies of the request */
+    size_t request_len;
+    int depth;
+    volatile bool* stop;
+
+    /* Results */
+    uint64_t requests;
+    uint64_t bytes;
+    uint64_t errors;
+    uint64_t connects;
+    uint64_t* latency;          /* Responses per latency bucket */
+    uint64_t latency_max_us;
+} LoadgenConn;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void record_latency(LoadgenConn* c, uint64_t us) {
+    uint64_t bucket = us < LATENCY_COARSE_FROM ? us / LATENCY_FINE_US :
+        LATENCY_COARSE_FROM / LATENCY_FINE_US + (us - LATENCY_COARSE_FROM) / LATENCY_COARSE_US;
+    if (bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+    c->latency[bucket]++;
+    if (us > c->latency_max_us) c->latency_max_us = us;
+}
+
+/*
+ * Upper bound (ms) of a latency bucket.
+ */
+static double latency_bucket_ms(int bucket) {
+    int fine = LATENCY_COARSE_FROM / LATENCY_FINE_US;
+    if (bucket < fine) return (double)(bucket + 1) * LATENCY_FINE_US / 1000.0;
+    return (double)(LATENCY_COARSE_FROM + (bucket - fine + 1) * LATENCY_COARSE_US) / 1000.0;
+}
+
+/*
+ * Upper bound (ms) of the bucket holding the given fraction of responses.
+ */
+static double latency_percentile(const uint64_t* histogram, uint64_t total, double fraction) {
+    uint64_t rank = (uint64_t)((double)total * fraction);
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > rank) return latency_bucket_ms(i);
+    }
+    return latency_bucket_ms(LATENCY_BUCKETS - 1);
+}
+
+static int connect_to(const char* host, int port, uint32_t source_ip) {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
+
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    if (source_ip != 0) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(source_ip);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/*
+ * Read more of a response into buf after the *have bytes already there.
+ * Returns the bytes read, 0 if the server closed, -1 on error.
+ */
+static ssize_t recv_more(int fd, char* buf, size_t* have, size_t max) {
+    for (;;) {
+        ssize_t n = recv(fd, buf + *have, max, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n > 0) *have += (size_t)n;
+        return n;
+    }
+}
+
+static void consume(char* buf, size_t* have, size_t n) {
+    memmove(buf, buf + n, *have - n);
+    *have -= n;
+}
+
+/*
+ * Read up to the end of the next line in buf; its length with the LF, or
+ * -1 on error.
+ */
+static long long read_line(int fd, char* buf, size_t* have) {
+    for (;;) {
+        char* lf = (char*)memchr(buf, '\n', *have);
+        if (lf) return (long long)(lf - buf) + 1;
+        if (*have == LOADGEN_BUFFER_SIZE - 1) return -1;
+        if (recv_more(fd, buf, have, LOADGEN_BUFFER_SIZE - 1 - *have) <= 0) return -1;
+    }
+}
+
+/*
+ * Read a chunked body whose first *have bytes are at the start of buf.
+ * Returns its size on the wire, framing included, or -1 on error. Bytes
+ * past it (the next pipelined response) are left at the start of buf.
+ */
+static long long read_chunked_body(int fd, char* buf, size_t* have) {
+    long long total = 0;
+    for (;;) {
+        long long line = read_line(fd, buf, have);
+        if (line < 0) return -1;
+        char* digits_end;
+        long long size = strtoll(buf, &digits_end, 16);
+        if (digits_end == buf || size < 0) return -1;
+        consume(buf, have, (size_t)line);
+        total += line;
+
+        if (size == 0) {
+            /* Trailer lines up to the empty one */
+            for (;;) {
+                line = read_line(fd, buf, have);
+                if (line < 0) return -1;
+                bool empty = line <= 2;
+                consume(buf, have, (size_t)line);
+                total += line;
+                if (empty) return total;
+            }
+        }
+
+        /* Chunk data and its CRLF; never read past them */
+        long long skip = size + 2;
+        total += skip;
+        size_t taken = (long long)*have < skip ? *have : (size_t)skip;
+        consume(buf, have, taken);
+        skip -= (long long)taken;
+        while (skip > 0) {
+            size_t want = skip > LOADGEN_BUFFER_SIZE - 1 ? LOADGEN_BUFFER_SIZE - 1 : (size_t)skip;
+            ssize_t n = recv_more(fd, buf, have, want);
+            if (n <= 0) return -1;
+            *have = 0;
+            skip -= n;
+        }
+    }
+}
+
+/*
+ * Read one response. Returns total bytes read (headers + body), -1 on error,
+ * or 0 if the server closed the connection before sending anything.
+ * *keep_alive is cleared if the server asked to close.
+ * *carry holds the bytes already in buf; on return it holds the bytes of
+ * the next pipelined response that were read along with this one.
+ */
+static long long read_response(int fd, char* buf, size_t* carry, bool* keep_alive) {
+    size_t have = *carry;
+    buf[have] = '\0';
+    char* end = strstr(buf, "\r\n\r\n");
+
+    *carry = 0;
+    while (!end) {
+        if (have == LOADGEN_BUFFER_SIZE - 1) return -1;
+        ssize_t n = recv(fd, buf + have, LOADGEN_BUFFER_SIZE - 1 - have, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 && have == 0) return 0;
+        if (n <= 0) return -1;
+        have += (size_t)n;
+        buf[have] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+
+    size_t header_len = (size_t)(end - buf) + 4;
+    long long content_length = 0;
+    bool chunked = false;
+    for (char* line = strstr(buf, "\r\n"); line && line < end; line = strstr(line, "\r\n")) {
+        line += 2;
+        char* eol = strstr(line, "\r\n");
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = atoll(line + 15);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            char* chunked_token = strstr(line, "chunked");
+            chunked = chunked_token && chunked_token < eol;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            char* close_token = strstr(line, "close");
+            if (close_token && close_token < eol) {
+                *keep_alive = false;
+            }
+        }
+    }
+
+    if (chunked) {
+        consume(buf, &have, header_len);
+        long long body = read_chunked_body(fd, buf, &have);
+        if (body < 0) return -1;
+        *carry = have;
+        return (long long)header_len + body;
+    }
+
+    long long remaining = content_length - (long long)(have - header_len);
+    if (remaining < 0) {
+        *carry = (size_t)-remaining;
+        memmove(buf, buf + have - *carry, *carry);
+    }
+    while (remaining > 0) {
+        size_t want = remaining > LOADGEN_BUFFER_SIZE ? LOADGEN_BUFFER_SIZE : (size_t)remaining;
+        ssize_t n = recv(fd, buf, want, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        remaining -= n;
+    }
+
+    return (long long)header_len + content_length;
+}
+
+/*
+ * Find "key": <number> after the "section" object in a /metrics response.
+ */
+static long long json_number(const char* json, const char* section, const char* key) {
+    const char* p = strstr(json, section);
+    if (!p) return -1;
+    p = strstr(p, key);
+    if (!p) return -1;
+    p = strchr(p, ':');
+    return p ? atoll(p + 1) : -1;
+}
+
+/*
+ * Sample the server's request and syscall counters from /metrics.
+ */
+static bool fetch_metrics(const char* host, int port, long long* requests, long long* syscalls) {
+    int fd = connect_to(host, port, 0);
+    if (fd < 0) return false;
+
+    char req[256];
+    int len = snprintf(req, sizeof(req),
+                       "GET /metrics HTTP/1.1\r\nHost: %s:%d\r\nConnection: close\r\n\r\n",
+                       host, port);
+    char* buf = (char*)malloc(LOADGEN_BUFFER_SIZE);
+    size_t have = 0;
+    bool ok = buf && send_all(fd, req, (size_t)len);
+    while (ok && have < LOADGEN_BUFFER_SIZE - 1) {
+        ssize_t n = recv(fd, buf + have, LOADGEN_BUFFER_SIZE - 1 - have, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        have += (size_t)n;
+    }
+    close(fd);
+
+    if (ok) {
+        buf[have] = '\0';
+        *requests = json_number(buf, "\"requests\"", "\"total\"");
+        *syscalls = json_number(buf, "\"io\"", "\"syscalls\"");
+        ok = *requests >= 0 && *syscalls >= 0;
+    }
+    free(buf);
+    return ok;
+}
+
+static void* conn_thread(void* param) {
+    LoadgenConn* c = (LoadgenConn*)param;
+    char* buf = (char*)malloc(LOADGEN_BUFFER_SIZE);
+    int fd = -1;
+    bool reused = false;
+
+    while (buf && !*c->stop) {
+        if (fd < 0) {
+            fd = connect_to(c->host, c->port, c->source_ip);
+            if (fd < 0) {
+                c->errors++;
+                usleep(1000);
+                continue;
+            }
+            c->connects++;
+            reused = false;
+        }
+
+        uint64_t sent_at = now_us();
+        if (!send_all(fd, c->request, c->request_len)) {
+            if (!reused) c->errors++;
+            close(fd);
+            fd = -1;
+            continue;
+        }
+
+        bool keep_alive = true;
+        size_t carry = 0;
+        for (int i = 0; i < c->depth && keep_alive; i++) {
+            long long n = read_response(fd, buf, &carry, &keep_alive);
+            if (n <= 0) {
+                /* A keep-alive connection closed by the server is not an error */
+                if (n < 0 || !reused) c->errors++;
+                keep_alive = false;
+                break;
+            }
+
+            reused = true;
+            record_latency(c, now_us() - sent_at);
+            c->requests++;
+            c->bytes += (uint64_t)n;
+        }
+        if (!keep_alive) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd >= 0) close(fd);
+    free(buf);
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    const char* host = "127.0.0.1";
+    int port = 8080;
+    int connections = 8;
+    int seconds = 5;
+    const char* path = "/";
+    int sources = 1;
+    int depth = 1;
+    bool metrics = false;
+    const char* header = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:d:s:P:mH:")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'c': connections = atoi(optarg); break;
+            case 'd': seconds = atoi(optarg); break;
+            case 's': sources = atoi(optarg); break;
+            case 'P': depth = atoi(optarg); break;
+            case 'm': metrics = true; break;
+            case 'H': header = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-h host] [-p port] [-c connections] [-d seconds] "
+                        "[-s sources] [-P depth] [-m] [-H header] [path]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (optind < argc) path = argv[optind];
+    if (connections < 1) connections = 1;
+    if (seconds < 1) seconds = 1;
+    if (sources < 1) sources = 1;
+    if (sources > 254) sources = 254;
+    if (depth < 1) depth = 1;
+    if (depth > 64) depth = 64;
+
+    char request[1024];
+    int request_len = snprintf(request, sizeof(request),
+                               "GET %s HTTP/1.1\r\nHost: %s:%d\r\nConnection: keep-alive\r\n%s%s\r\n",
+                               path, host, port, header ? header : "", header ? "\r\n" : "");
+    if (request_len < 0 || request_len >= (int)sizeof(request)) return 2;
+
+    char* pipeline = (char*)malloc((size_t)request_len * (size_t)depth);
+    if (!pipeline) return 1;
+    for (int i = 0; i < depth; i++) {
+        memcpy(pipeline + (size_t)i * (size_t)request_len, request, (size_t)request_len);
+    }
+
+    volatile bool stop = false;
+    LoadgenConn* conns = (LoadgenConn*)calloc((size_t)connections, sizeof(LoadgenConn));
+    pthread_t* threads = (pthread_t*)calloc((size_t)connections, sizeof(pthread_t));
+    if (!conns || !threads) return 1;
+
+    printf("Loadgen: %d connections, %d s, http://%s:%d%s", connections, seconds, host, port, path);
+    if (sources > 1) printf(" (from 127.0.0.1-%d)", sources);
+    if (depth > 1) printf(", pipeline depth %d", depth);
+    printf("\n");
+
+    long long requests_before = 0, syscalls_before = 0;
+    if (metrics && !fetch_metrics(host, port, &requests_before, &syscalls_before)) {
+        fprintf(stderr, "Could not read /metrics; syscall counts disabled\n");
+        metrics = false;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int i = 0; i < connections; i++) {
+        conns[i].host = host;
+        conns[i].port = port;
+        conns[i].source_ip = sources > 1 ? 0x7F000001u + (uint32_t)(i % sources) : 0;
+        conns[i].request = pipeline;
+        conns[i].request_len = (size_t)request_len * (size_t)depth;
+        conns[i].depth = depth;
+        conns[i].stop = &stop;
+        conns[i].latency = (uint64_t*)calloc(LATENCY_BUCKETS, sizeof(uint64_t));
+        if (!conns[i].latency) return 1;
+        pthread_create(&threads[i], NULL, conn_thread, &conns[i]);
+    }
+
+    sleep((unsigned)seconds);
+    stop = true;
+
+    uint64_t requests = 0, bytes = 0, errors = 0, connects = 0, latency_max_us = 0;
+    uint64_t* latency = (uint64_t*)calloc(LATENCY_BUCKETS, sizeof(uint64_t));
+    if (!latency) return 1;
+    for (int i = 0; i < connections; i++) {
+        pthread_join(threads[i], NULL);
+        requests += conns[i].requests;
+        bytes += conns[i].bytes;
+        errors += conns[i].errors;
+        connects += conns[i].connects;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            latency[b] += conns[i].latency[b];
+        }
+        if (conns[i].latency_max_us > latency_max_us) latency_max_us = conns[i].latency_max_us;
+        free(conns[i].latency);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("  Requests:    %llu\n", (unsigned long long)requests);
+    printf("  Req/sec:     %.1f\n", requests / elapsed);
+    printf("  Throughput:  %.2f MB/s\n", bytes / elapsed / (1024.0 * 1024.0));
+    printf("  Connects:    %llu\n", (unsigned long long)connects);
+    printf("  Errors:      %llu\n", (unsigned long long)errors);
+    if (requests > 0) {
+        printf("  Latency:     p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+               latency_percentile(latency, requests, 0.50),
+               latency_percentile(latency, requests, 0.99),
+               latency_max_us / 1000.0);
+    }
+    free(latency);
+
+    long long requests_after = 0, syscalls_after = 0;
+    if (metrics && fetch_metrics(host, port, &requests_after, &syscalls_after)) {
+        /* The server's own count includes the first /metrics request */
+        long long served = requests_after - requests_before;
+        long long syscalls = syscalls_after - syscalls_before;
+        printf("  Syscalls:    %lld\n", syscalls);
+        printf("  Syscalls/req: %.2f\n", served > 0 ? (double)syscalls / (double)served : 0.0);
+    }
+
+    free(threads);
+    free(conns);
+    free(pipeline);
+    return errors > 0 && requests == 0 ? 1 : 0;
+}
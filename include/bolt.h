@@ -5,17 +5,14 @@
  * ⚡ BOLT - High-Performance HTTP Server
  * 
  * A blazingly fast static file server using:
- * - Windows IOCP for async I/O
+ * - Windows IOCP for async I/O (epoll emulation on Linux)
  * - Thread pool for parallel request handling
  * - TransmitFile for zero-copy file transfers
  * - HTTP Keep-Alive for connection reuse
  * - Memory pooling for allocation efficiency
  */
 
-/* Must include winsock2.h before windows.h */
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <windows.h>
+#include "platform.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -44,10 +41,13 @@
 #define BOLT_SEND_TIMEOUT       30000       /* 30 seconds */
 #define BOLT_KEEPALIVE_TIMEOUT  60000       /* 60 seconds idle */
 #define BOLT_REQUEST_TIMEOUT    5000        /* 5 seconds to receive complete headers (prevents Slowloris) */
+#define BOLT_MIN_SEND_RATE      16384       /* Bytes/sec a client must read on top of BOLT_SEND_TIMEOUT */
+#define BOLT_TIMER_TICK_MS      250         /* Timing wheel resolution */
 
 /* Buffers */
 #define BOLT_RECV_BUFFER_SIZE   8192        /* 8 KB receive buffer */
 #define BOLT_SEND_BUFFER_SIZE   65536       /* 64 KB send buffer */
+#define BOLT_SEND_SEGMENTS      16          /* Buffers gathered into one send */
 #define BOLT_MAX_REQUEST_SIZE   16384       /* 16 KB max request */
 #define BOLT_MAX_URI_LENGTH     2048
 #define BOLT_MAX_PATH_LENGTH    512
@@ -66,20 +66,50 @@
 #ifndef BOLT_ENABLE_FILE_CACHE
 #define BOLT_ENABLE_FILE_CACHE 1
 #endif
-#define BOLT_FILE_CACHE_MAX_ENTRY_SIZE  (48 * 1024)       /* headers+body must fit in send buffer */
+#define BOLT_FILE_CACHE_MAX_ENTRY_SIZE  (256 * 1024)      /* headers+body; sent from cache memory */
 #define BOLT_FILE_CACHE_MAX_TOTAL_BYTES (64 * 1024 * 1024)
 #define BOLT_FILE_CACHE_CAPACITY        2048
+#define BOLT_FILE_CACHE_SHARDS          16                /* Independently locked segments (power of 2) */
+#define BOLT_FILE_CACHE_READERS         64                /* Lookup epoch slots, threads share them mod N */
+#define BOLT_FILE_CACHE_LOADERS         2                 /* Threads reading missed files into the cache */
+
+/* Open-file and stat cache (handles shared by concurrent transfers) */
+#define BOLT_OPEN_FILE_CACHE_CAPACITY   512               /* Paths remembered (one open handle each at most) */
+#define BOLT_OPEN_FILE_CACHE_VALID_MS   1000              /* Stat results trusted this long */
+#define BOLT_OPEN_FILE_CACHE_WATCHED_VALID_MS 60000       /* ...while a watcher reports changes */
+#define BOLT_PATH_CACHE_CAPACITY        1024              /* Host + URI resolutions remembered */
+#define BOLT_NEGATIVE_CACHE_CAPACITY    1024              /* ...that ended in 403/404 (~1.3 KB each) */
 
 /* Thread Pool */
 #define BOLT_MIN_THREADS        2
 #define BOLT_MAX_THREADS        64
 #define BOLT_THREADS_PER_CORE   2           /* 2 threads per CPU core */
+#define BOLT_COMPLETION_BATCH_SIZE 64       /* Completions dequeued per wakeup */
+#define BOLT_BATCH_HISTOGRAM_BUCKETS 7      /* 1, 2-3, 4-7, ..., 64+ */
 
 /* File Serving */
 #define BOLT_WEB_ROOT           "public"
 #define BOLT_INDEX_FILE         "index.html"
 #define BOLT_MAX_FILE_SIZE      (100 * 1024 * 1024)  /* 100 MB */
 
+/* Streamed compression (chunked) for text too large to compress in memory */
+#define BOLT_STREAM_READ_SIZE   16384       /* File bytes read per encoder call */
+#define BOLT_STREAM_MAX_ACTIVE  256         /* Concurrent streams; more are sent identity */
+
+/* Compute pool: compression taken off the I/O workers */
+#define BOLT_TASK_MAX_THREADS   64
+#define BOLT_TASK_QUEUE_SIZE    256         /* Jobs per thread's deque; more run inline */
+#define BOLT_TASK_MIN_COMPRESS  4096        /* Smaller files are compressed inline */
+
+/* Load-adaptive compression levels (compression_adapt.h) */
+#define BOLT_ADAPT_INTERVAL_MS      250     /* Load sampled this often */
+#define BOLT_ADAPT_CALM_SAMPLES     8       /* Calmer samples before stepping down a level */
+#define BOLT_ADAPT_QUIET_UTIL       20      /* Worker CPU %: below, and no jobs waiting, quiet */
+#define BOLT_ADAPT_BUSY_UTIL        70      /* ...at or above, busy (fast levels) */
+#define BOLT_ADAPT_OVERLOAD_UTIL    90      /* ...at or above, overloaded (identity) */
+#define BOLT_ADAPT_OVERLOAD_QUEUE   4       /* Jobs waiting per compute thread: overloaded */
+#define BOLT_ADAPT_UPGRADES         4       /* Cached variants recompressed per quiet sample */
+
 /* Memory Pool */
 #define BOLT_POOL_BLOCK_SIZE    4096        /* 4 KB blocks */
 #define BOLT_POOL_INITIAL_BLOCKS 256        /* Pre-allocate 1 MB */
@@ -96,7 +126,8 @@ typedef enum {
     BOLT_OP_RECV,
     BOLT_OP_SEND,
     BOLT_OP_TRANSMIT_FILE,
-    BOLT_OP_DISCONNECT
+    BOLT_OP_DISCONNECT,
+    BOLT_OP_TASK                /* A compute pool job finished (posted, no I/O) */
 } BoltOperationType;
 
 /*============================================================================
@@ -109,6 +140,7 @@ typedef enum {
     BOLT_CONN_PROCESSING,
     BOLT_CONN_SENDING,
     BOLT_CONN_SENDING_FILE,
+    BOLT_CONN_COMPUTING,        /* A job for the response is in the compute pool */
     BOLT_CONN_KEEPALIVE,
     BOLT_CONN_CLOSING,
     BOLT_CONN_CLOSED
@@ -7,6 +7,11 @@
 #include "connection.h"
 #include "memory_pool.h"
 #include "file_cache.h"
+#include "open_file_cache.h"
+#include "path_cache.h"
+#include "fs_watch.h"
+#include "task_pool.h"
+#include "compression_adapt.h"
 #include "config.h"
 #include "logger.h"
 #include "vhost.h"
@@ -34,24 +39,45 @@ struct BoltServer {
     /* Configuration */
     int port;
     const char* web_root;
+    DWORD keepalive_timeout_ms;     /* Idle keep-alive connections are closed after this */
+    DWORD request_timeout_ms;       /* Deadline for a complete request head */
     
     /* Core components */
-    BoltIOCP* iocp;
+    BoltIOCP* iocp;                 /* First event loop */
     BoltThreadPool* thread_pool;
-    BoltConnectionPool* conn_pool;
+    BoltConnectionPool* conn_pool;  /* First loop's connection pool */
     BoltMemoryPool* mem_pool;
     BoltFileCache* file_cache;
+    BoltOpenFileCache* open_file_cache;
+    BoltPathCache* path_cache;
+    BoltPathCache* negative_cache;  /* Resolutions that ended in 403/404 */
+    BoltFsWatch* fs_watch;          /* Invalidates the caches as files change */
+    BoltTaskPool* task_pool;        /* Compute threads for compression, NULL: inline */
+    bool compression_adaptive;      /* Levels follow the load, sampled by the main thread */
+    BoltCompressionAdapt compression_adapt;
+    DWORD open_file_cache_valid_ms; /* Configured TTL, used again if the watcher gives up */
+    bool gzip_static;               /* Serve file.gz to clients accepting gzip */
+    bool brotli_static;             /* Serve file.br to clients accepting br */
+    bool zstd_static;               /* Serve file.zst to clients accepting zstd */
     BoltRateLimiter* rate_limiter;
     BoltLogger* logger;
     BoltVHostManager* vhost_manager;
     BoltRewriteEngine* rewrite_engine;
     BoltProxyConfig* proxy_config;
     
+    /* Event loops: one shared by all workers, or one per worker (reuseport)
+     * each with its own listener and connection pool slice */
+    BoltIOCP** loops;
+    BoltConnectionPool** conn_pools;
+    int num_loops;
+    
     /* State */
     volatile bool running;
     ULONGLONG start_time;
     bool stats_enabled;
     DWORD stats_interval_ms;
+    ULONGLONG adapt_sampled_ms;     /* Last load sample, and worker CPU time then */
+    LONG64 adapt_cpu_us;
     
     /* Statistics */
     volatile LONG64 total_connections;
@@ -88,5 +114,12 @@ void bolt_server_destroy(BoltServer* server);
  */
 void bolt_server_print_stats(BoltServer* server);
 
+/*
+ * Totals across all event loops.
+ */
+LONG bolt_server_active_connections(BoltServer* server);
+int bolt_server_max_connections(BoltServer* server);
+LONG64 bolt_server_io_syscalls(BoltServer* server);
+
 #endif /* BOLT_SERVER_H */
 
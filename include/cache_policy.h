@@ -0,0 +1,102 @@
+#ifndef CACHE_POLICY_H
+#define CACHE_POLICY_H
+
+#include "bolt.h"
+
+/*
+ * S3-FIFO eviction for the file cache.
+ *
+ * New entries enter a small FIFO queue (10% of the byte or entry budget,
+ * whichever binds first). An entry that reaches the tail of the small
+ * queue without having been hit again is evicted, and its key is
+ * remembered in a ghost queue; one that was hit moves to the main queue. Keys found in the ghost queue go straight
+ * to main. The main queue evicts from its tail, giving entries that were
+ * hit since they were last there another round (CLOCK-like).
+ *
+ * One-hit wonders (a crawler walking every page once) therefore churn
+ * through the small queue without displacing the hot set in main. Every
+ * operation is O(1): a hit is an atomic saturating increment of the
+ * node's frequency and needs no lock; insert, remove and evict need the
+ * owner's lock.
+ */
+
+#define BOLT_S3FIFO_MAX_FREQ        3
+#define BOLT_S3FIFO_SMALL_PERCENT   10
+
+typedef enum {
+    BOLT_S3FIFO_NONE = 0,
+    BOLT_S3FIFO_SMALL,
+    BOLT_S3FIFO_MAIN
+} BoltS3FifoQueue;
+
+/* Queue node, embedded in the cached item */
+typedef struct BoltS3Node {
+    struct BoltS3Node* prev;
+    struct BoltS3Node* next;
+    uint32_t hash;              /* Key hash, remembered by the ghost queue */
+    size_t bytes;               /* Charged against the byte budget */
+    volatile LONG freq;         /* Hits since last considered, saturating */
+    BoltS3FifoQueue queue;
+} BoltS3Node;
+
+typedef struct BoltS3Fifo {
+    BoltS3Node small;           /* List heads: insert at next, evict at prev */
+    BoltS3Node main;
+    size_t small_bytes;
+    size_t main_bytes;
+    size_t small_entries;
+    size_t entries;
+    size_t max_bytes;
+    size_t max_entries;
+
+    /* Ghost queue: FIFO of evicted key hashes plus a direct-mapped filter
+     * for O(1) membership (a collision only forgets a ghost early) */
+    uint32_t* ghost_ring;
+    size_t ghost_capacity;
+    size_t ghost_head;
+    uint32_t* ghost_filter;
+    size_t ghost_filter_mask;
+
+    /* Statistics */
+    LONG64 promotions;          /* Small -> main */
+    LONG64 ghost_hits;          /* Re-inserted keys admitted straight to main */
+    LONG64 evictions;
+} BoltS3Fifo;
+
+/*
+ * Initialize a policy for at most max_bytes and max_entries.
+ */
+bool bolt_s3fifo_init(BoltS3Fifo* policy, size_t max_bytes, size_t max_entries);
+
+/*
+ * Free the ghost queue. Linked nodes are left to their owner.
+ */
+void bolt_s3fifo_destroy(BoltS3Fifo* policy);
+
+/*
+ * Record a hit on a linked node.
+ */
+void bolt_s3fifo_hit(BoltS3Node* node);
+
+/*
+ * Check whether inserting `bytes` more needs an eviction first.
+ */
+bool bolt_s3fifo_full(const BoltS3Fifo* policy, size_t bytes);
+
+/*
+ * Link a new node (hash and bytes set by the caller).
+ */
+void bolt_s3fifo_insert(BoltS3Fifo* policy, BoltS3Node* node);
+
+/*
+ * Unlink a node without remembering it (e.g. a stale entry being replaced).
+ */
+void bolt_s3fifo_remove(BoltS3Fifo* policy, BoltS3Node* node);
+
+/*
+ * Pick a victim, unlink it and return it; the caller frees the item.
+ * Returns NULL if nothing is linked.
+ */
+BoltS3Node* bolt_s3fifo_evict(BoltS3Fifo* policy);
+
+#endif /* CACHE_POLICY_H */
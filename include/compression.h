@@ -11,17 +11,26 @@
 typedef enum {
     BOLT_COMPRESS_NONE = 0,
     BOLT_COMPRESS_GZIP = 1,
-    BOLT_COMPRESS_DEFLATE = 2
+    BOLT_COMPRESS_DEFLATE = 2,
+    BOLT_COMPRESS_BROTLI = 3,
+    BOLT_COMPRESS_ZSTD = 4
 } BoltCompressionType;
 
+#define BOLT_COMPRESS_TYPES 5   /* Including NONE */
+
 /*
  * Compression configuration.
  */
 typedef struct {
     bool enabled;
-    int level;  /* 1-9, 6 is default */
+    int level;  /* gzip/deflate: 1-9, 6 is default */
+    int brotli_level;   /* 0-11, 5 is default */
+    int zstd_level;     /* 1-19, 3 is default */
     size_t min_size;  /* Minimum file size to compress (default: 256 bytes) */
     BoltCompressionType preferred_type;
+    /* Server preference, best first, ending at NONE. Breaks ties between
+     * codings the client accepts with equal q-values. */
+    BoltCompressionType preference[BOLT_COMPRESS_TYPES];
 } BoltCompressionConfig;
 
 /*
@@ -34,13 +43,165 @@ typedef struct {
 } BoltCompressedData;
 
 /*
- * Parse Accept-Encoding header and determine best compression type.
+ * Parse Accept-Encoding header and determine best compression type: the
+ * highest q-value among the codings this build can produce, ties going
+ * to the earlier one in config->preference.
  * Returns BOLT_COMPRESS_NONE if client doesn't support compression or
  * compression is disabled.
  */
 BoltCompressionType compression_parse_accept_encoding(const char* accept_encoding,
                                                        const BoltCompressionConfig* config);
 
+/*
+ * Pick among `count` candidate codings by the client's q-values, ties
+ * going to the earlier candidate. Availability is not checked (the
+ * candidates may be precompressed files). NONE if none is acceptable.
+ */
+BoltCompressionType compression_negotiate(const char* accept_encoding,
+                                          const BoltCompressionType* candidates,
+                                          size_t count);
+
+/*
+ * Check whether an Accept-Encoding header allows a content-coding
+ * ("gzip", "br"): listed by name or by "*", and not with q=0.
+ */
+bool compression_accepts(const char* accept_encoding, const char* coding);
+
+/*
+ * Content-coding token of a type ("gzip", "br", ...), NULL for NONE.
+ */
+const char* compression_coding_name(BoltCompressionType type);
+
+/*
+ * Whether this build can produce a coding (zlib, brotli, zstd found).
+ */
+bool compression_available(BoltCompressionType type);
+
+/*
+ * Server load as the adaptive controller sees it (compression_adapt.h).
+ * It picks the levels below.
+ */
+typedef enum {
+    BOLT_LOAD_QUIET = 0,        /* Stored variants at the best level */
+    BOLT_LOAD_NORMAL = 1,       /* Configured levels */
+    BOLT_LOAD_BUSY = 2,         /* Fast levels */
+    BOLT_LOAD_OVERLOAD = 3      /* Fast levels, no compression on the request path */
+} BoltLoadLevel;
+
+#define BOLT_LOAD_LEVELS 4
+
+void compression_set_load(BoltLoadLevel load);
+BoltLoadLevel compression_load(void);
+
+/*
+ * Name of a load level ("quiet", ...).
+ */
+const char* compression_load_name(BoltLoadLevel load);
+
+/*
+ * Level with the smallest output for a coding: gzip/deflate 9, br 11,
+ * zstd 19 (higher zstd levels want windows browsers may refuse).
+ */
+int compression_best_level(BoltCompressionType type);
+
+/*
+ * Level for compressing a response now: the configured one, or the
+ * coding's fast level (never above the configured one) when busy.
+ */
+int compression_level(const BoltCompressionConfig* config, BoltCompressionType type);
+
+/*
+ * Level for a variant that is stored and sent many times (file cache):
+ * the coding's best level (never below the configured one) when quiet,
+ * else as compression_level.
+ */
+int compression_stored_level(const BoltCompressionConfig* config, BoltCompressionType type);
+
+/*
+ * Whether the request path should send identity instead of compressing,
+ * because the server is overloaded. Counts the responses it turns away.
+ */
+bool compression_overloaded(void);
+
+/*
+ * Responses sent identity by compression_overloaded() since launch.
+ */
+LONG64 compression_shed_count(void);
+
+/*
+ * Compress data into a coding at `level` (clamped to the coding's range),
+ * in a buffer of its own.
+ * Returns true on success, false on failure.
+ * Caller must free compressed_data->data using free().
+ */
+bool compression_compress(BoltCompressionType type,
+                          const char* input, size_t input_size,
+                          BoltCompressedData* compressed_data,
+                          int level);
+
+/*
+ * Incremental encoder for responses too large to compress in one piece.
+ * br and zstd windows are capped at 256 KB (deflate's is 32 KB), so a
+ * stream costs hundreds of KB rather than the megabytes of their defaults.
+ * The context comes from the calling thread's pool and goes back to the
+ * pool of the thread that destroys the stream.
+ */
+typedef struct BoltCompressStream BoltCompressStream;
+
+/*
+ * Start a stream in a coding at `level`. NULL if the coding is not
+ * available or allocation fails.
+ */
+BoltCompressStream* compression_stream_create(BoltCompressionType type, int level);
+
+/*
+ * Feed input and collect output. Consumes up to in_len bytes (*consumed)
+ * and writes up to out_size bytes (*produced). With finish set, no more
+ * input follows: call again until *done to flush the end of the stream.
+ * Returns false on an encoder error.
+ */
+bool compression_stream_write(BoltCompressStream* stream,
+                              const char* in, size_t in_len, size_t* consumed,
+                              char* out, size_t out_size, size_t* produced,
+                              bool finish, bool* done);
+
+void compression_stream_destroy(BoltCompressStream* stream);
+
+/*
+ * Worst-case compressed size of input_size bytes in a coding (0 if the
+ * coding is not available).
+ */
+size_t compression_bound(BoltCompressionType type, size_t input_size);
+
+/*
+ * Compress into the caller's buffer, e.g. straight into a send buffer.
+ * Returns false if it does not fit or the coding is not available.
+ */
+bool compression_compress_into(BoltCompressionType type,
+                               const char* input, size_t input_size,
+                               char* out, size_t out_size, size_t* out_len,
+                               int level);
+
+/*
+ * Compress into the calling thread's scratch buffer, which is reused
+ * (never shrunk) and valid until the thread compresses into it again.
+ * Returns NULL on failure.
+ */
+const char* compression_compress_scratch(BoltCompressionType type,
+                                         const char* input, size_t input_size,
+                                         size_t* out_len, int level);
+
+/*
+ * Free the calling thread's idle encoder contexts and scratch buffer
+ * (at thread exit).
+ */
+void compression_release_thread_contexts(void);
+
+/*
+ * Encoder contexts made, and reset for reuse instead, since launch.
+ */
+void compression_context_stats(LONG64* created, LONG64* reused);
+
 /*
  * Compress data using gzip.
  * Returns true on success, false on failure.
@@ -56,9 +217,13 @@ bool compression_gzip(const char* input, size_t input_size,
 bool compression_should_compress(const char* content_type, const BoltCompressionConfig* config);
 
 /*
- * Get default compression config.
+ * Get default compression config (as set by compression_set_default_config).
  */
 BoltCompressionConfig compression_get_default_config(void);
 
-#endif /* COMPRESSION_H */
+/*
+ * Replace the server-wide compression config (at startup, from bolt.conf).
+ */
+void compression_set_default_config(const BoltCompressionConfig* config);
 
+#endif /* COMPRESSION_H */
@@ -0,0 +1,50 @@
+#ifndef COMPRESSION_ADAPT_H
+#define COMPRESSION_ADAPT_H
+
+#include "bolt.h"
+#include "compression.h"
+
+/*
+ * Load-adaptive compression levels.
+ *
+ * Every BOLT_ADAPT_INTERVAL_MS the server samples the I/O workers' CPU
+ * utilization (their thread CPU time over the cores they can use) and how
+ * many jobs wait in the compute pool. The controller maps each sample to a
+ * load level and sets it with compression_set_load(). A rise takes effect
+ * at once. A fall takes BOLT_ADAPT_CALM_SAMPLES calmer samples in a row
+ * and goes one level at a time, so a lull between bursts does not bring
+ * slow levels back.
+ */
+typedef struct {
+    BoltLoadLevel load;
+    int calm;                   /* Calmer samples in a row */
+
+    /* Last sample */
+    int utilization;            /* Worker CPU, percent */
+    LONG queued;                /* Compute jobs waiting */
+
+    /* Statistics */
+    LONG64 samples;
+    LONG64 raised;              /* Level changes up (toward overload) */
+    LONG64 lowered;
+} BoltCompressionAdapt;
+
+/*
+ * Start at BOLT_LOAD_NORMAL.
+ */
+void compression_adapt_init(BoltCompressionAdapt* adapt);
+
+/*
+ * Load level a sample calls for on its own: workers at `utilization`
+ * percent CPU, `queued` jobs waiting for `compute_threads`.
+ */
+BoltLoadLevel compression_adapt_target(int utilization, LONG queued, int compute_threads);
+
+/*
+ * Feed a sample; returns the level now in force (also applied with
+ * compression_set_load()).
+ */
+BoltLoadLevel compression_adapt_update(BoltCompressionAdapt* adapt, int utilization,
+                                       LONG queued, int compute_threads);
+
+#endif /* COMPRESSION_ADAPT_H */
@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include "bolt.h"
+#include "compression.h"
 #include <stdbool.h>
 
 /*
@@ -13,6 +14,9 @@ typedef struct BoltConfig {
     char bind_address[64];  /* Empty = INADDR_ANY */
     int worker_threads;         /* 0 = auto-detect */
     int max_connections;
+    bool reuseport;             /* One listener + event loop per worker */
+    bool worker_cpu_affinity;   /* Pin worker i to core i */
+    int compute_threads;        /* Compression threads: 0 = one per core, -1 = none (inline) */
     
     /* File serving */
     char web_root[512];
@@ -23,6 +27,13 @@ typedef struct BoltConfig {
     bool gzip_enabled;
     int gzip_level;
     size_t gzip_min_size;
+    int brotli_level;
+    int zstd_level;
+    BoltCompressionType compression_order[BOLT_COMPRESS_TYPES];  /* Ends at NONE */
+    bool gzip_static;       /* Serve precompressed file.gz siblings */
+    bool brotli_static;     /* Serve precompressed file.br siblings */
+    bool zstd_static;       /* Serve precompressed file.zst siblings */
+    bool compression_adaptive;  /* Levels follow the load (compression_adapt.h) */
     
     /* Logging */
     char access_log_path[512];
@@ -39,6 +50,11 @@ typedef struct BoltConfig {
     /* Features */
     bool enable_dir_listing;
     bool enable_file_cache;
+    bool enable_open_file_cache;
+    DWORD open_file_cache_valid_ms;
+    bool enable_fs_watch;
+    bool enable_path_cache;
+    bool enable_negative_cache;
     
     /* TLS/SSL */
     bool tls_enabled;
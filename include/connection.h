@@ -4,6 +4,9 @@
 #include "bolt.h"
 #include "iocp.h"
 #include "http.h"
+#include "timer_wheel.h"
+#include "open_file_cache.h"
+#include "task_pool.h"
 
 /*
  * Connection state machine for managing HTTP connections.
@@ -32,17 +35,37 @@ struct BoltConnection {
     
     /* HTTP state */
     HttpRequest request;
+    size_t request_length;             /* recv_buffer bytes taken by the current request */
+    char request_end_byte;             /* Next request's first byte, replaced by a NUL */
     bool keep_alive;
     int requests_served;
     
+    /* Pipelining */
+    bool pipelining;                   /* More requests buffered: stage the response */
+    bool request_deferred;             /* Response did not fit behind the staged ones */
+    size_t send_staged;                /* Bytes staged for earlier requests */
+    
+    /* Gathered send: runs of send_buffer and cached responses, in order */
+    WSABUF send_segments[BOLT_SEND_SEGMENTS];
+    int send_segment_count;
+    size_t send_buffer_used;           /* send_buffer bytes the segments point into */
+    void* send_refs[BOLT_SEND_SEGMENTS];  /* Cached responses held until the send is done */
+    int send_ref_count;
+    
     /* File transfer state */
     HANDLE file_handle;
+    BoltOpenFile* open_file;           /* Reference owning file_handle, if shared */
     size_t file_size;
     size_t file_offset;
+    struct BoltSendStream* stream;     /* Compressed chunked transfer, if any */
+    BoltTask task;                     /* Compute pool job for the response */
     
     /* Timing */
     ULONGLONG connect_time;
     ULONGLONG last_activity;
+    ULONGLONG deadline;                /* Current state's deadline, 0 if none */
+    BoltTimer timer;                   /* Deadline in the accepting worker's wheel */
+    BoltTimerWheel* timers;            /* That wheel (NULL: no enforced deadlines) */
     
     /* Client IP address (for rate limiting) */
     uint32_t client_ip;
@@ -50,6 +73,8 @@ struct BoltConnection {
     /* Pool management */
     int arena_id;
     struct BoltConnection* next_free;  /* For connection pool */
+    struct BoltConnectionPool* pool;   /* Pool (slice) this connection belongs to */
+    BoltIOCP* iocp;                    /* Event loop the socket is associated with */
     
     /* Statistics */
     size_t bytes_received;
@@ -100,6 +125,11 @@ void bolt_conn_reset(BoltConnection* conn);
  */
 void bolt_conn_close(BoltConnection* conn);
 
+/*
+ * Release the file being transferred (closing it unless it is shared).
+ */
+void bolt_conn_close_file(BoltConnection* conn);
+
 /*
  * Handle state transition.
  */
@@ -110,6 +140,17 @@ void bolt_conn_set_state(BoltConnection* conn, BoltConnectionState state);
  */
 bool bolt_conn_is_timed_out(BoltConnection* conn, DWORD timeout_ms);
 
+/*
+ * Check if the deadline of the current state has passed.
+ */
+bool bolt_conn_deadline_passed(BoltConnection* conn);
+
+/*
+ * Timing wheel callback: the connection missed its deadline. Aborts the
+ * outstanding operation so its completion closes the connection.
+ */
+void bolt_conn_timer_expired(BoltTimer* timer, void* context);
+
 /*
  * Process received data (parse HTTP request).
  */
@@ -120,5 +161,31 @@ bool bolt_conn_process_recv(BoltConnection* conn, DWORD bytes_received);
  */
 void bolt_conn_handle_request(BoltConnection* conn);
 
+/*
+ * Handle the completed request and every complete request pipelined
+ * behind it in recv_buffer, in order. Responses built in the send buffer
+ * are staged and go out with the last one in a single send.
+ * Returns the number of requests answered.
+ */
+int bolt_conn_handle_pipeline(BoltConnection* conn);
+
+/*
+ * The current request's response does not fit behind the staged ones:
+ * the pipeline loop sends those and answers the request again once they
+ * are out.
+ */
+bool bolt_conn_defer_request(BoltConnection* conn);
+
+/*
+ * Post the staged segments as one gathered send.
+ */
+bool bolt_conn_post_staged(BoltConnection* conn);
+
+/*
+ * Copy the segments not yet sent (from send_offset on) into out.
+ * Returns the number of segments written, at most max.
+ */
+int bolt_conn_send_vector(BoltConnection* conn, WSABUF* out, int max);
+
 #endif /* CONNECTION_H */
 
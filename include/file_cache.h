@@ -2,12 +2,31 @@
 #define FILE_CACHE_H
 
 #include "bolt.h"
+#include "compression.h"
 #include <stddef.h>
 #include <time.h>
 
 /*
  * Small-file cache for mixed-site performance.
  * Caches small assets in memory to avoid disk + open/close overhead.
+ * Eviction is S3-FIFO (see cache_policy.h): constant time, and a crawler
+ * touching every page once does not flush the hot set.
+ *
+ * The cache is split into up to BOLT_FILE_CACHE_SHARDS segments by path
+ * hash, each with its own lock and an equal share of the entry and byte
+ * budgets. Only fills, refreshes and evictions take a shard's lock; hits
+ * are lock-free, with unlinked responses reclaimed by epoch once no
+ * lookup can still be reading them.
+ *
+ * A miss reads the file outside any lock, and only one read per path is
+ * in flight (single-flight). With loader threads started, the read is
+ * handed to them and the miss returns at once, so request workers never
+ * wait on the disk for a fill.
+ *
+ * A file can be held in one variant per content-encoding the clients
+ * accept. Compressed variants are compressed once, by the fill (on a
+ * loader thread when they run), and carry their own headers: Content-
+ * Encoding, an ETag tagged with the encoding, and Vary: Accept-Encoding.
  */
 
 typedef struct BoltFileCache BoltFileCache;
@@ -17,18 +36,47 @@ typedef struct {
     size_t headers_len;
     const char* body;
     size_t body_len;
+    void* ref;          /* Reference keeping headers/body alive */
 } BoltCachedResponse;
 
+typedef struct {
+    size_t shards;
+    size_t entries;
+    size_t bytes;
+    LONG64 hits;
+    LONG64 misses;
+    LONG64 evictions;
+    LONG64 promotions;      /* Re-used while new, moved to the main queue */
+    LONG64 ghost_hits;      /* Recently evicted, re-admitted to the main queue */
+    LONG64 fills;           /* Files read into the cache */
+    LONG64 compressions;    /* ...of which stored compressed */
+    LONG64 fill_fallbacks;  /* Misses served from disk while their file was loading */
+    LONG64 invalidations;   /* Responses dropped because their file changed */
+    LONG64 upgrades;        /* Variants recompressed at a better level */
+} BoltFileCacheStats;
+
 BoltFileCache* bolt_file_cache_create(size_t capacity, size_t max_total_bytes);
 void bolt_file_cache_destroy(BoltFileCache* cache);
 
+/*
+ * Start `count` loader threads to read missed files in the background.
+ * Without loaders, the request that misses reads the file itself.
+ */
+bool bolt_file_cache_start_loaders(BoltFileCache* cache, int count);
+
 /*
  * Lookup a cached response for a given filepath. If not present or stale, may load it.
- * Returns true if a cached (or newly cached) response is available.
+ * Returns true if a cached (or newly cached) response is available. Returns
+ * false while the file is being loaded by another request or a loader
+ * thread; the caller then sends it from the file.
  *
  * Notes:
  * - Only caches files <= BOLT_FILE_CACHE_MAX_ENTRY_SIZE (including headers).
  * - Uses file mtime+size to validate staleness.
+ * - The caller holds a reference (out->ref) to an immutable response.
+ *   Eviction or refresh only unlinks it from the cache; its memory stays
+ *   valid until the last reference is released, so it can be sent from
+ *   directly.
  */
 bool bolt_file_cache_get(BoltFileCache* cache,
                          const char* filepath,
@@ -37,6 +85,44 @@ bool bolt_file_cache_get(BoltFileCache* cache,
                          size_t file_size,
                          BoltCachedResponse* out);
 
+/*
+ * Same as bolt_file_cache_get for the variant of the file sent to clients
+ * that negotiated `encoding`. If compressing fails or does not shrink the
+ * file, the variant holds the identity body.
+ */
+bool bolt_file_cache_get_encoded(BoltFileCache* cache,
+                                 const char* filepath,
+                                 const char* content_type,
+                                 BoltCompressionType encoding,
+                                 time_t mtime,
+                                 size_t file_size,
+                                 BoltCachedResponse* out);
+
+/*
+ * Release a reference taken by bolt_file_cache_get. NULL is ignored.
+ */
+void bolt_file_cache_release(BoltFileCache* cache, void* ref);
+
+/*
+ * Drop a path's cached responses (all variants), e.g. because the file changed on disk.
+ * Sends still holding it are unaffected.
+ */
+void bolt_file_cache_invalidate(BoltFileCache* cache, const char* filepath);
+
+/*
+ * Snapshot occupancy and hit/eviction counters.
+ */
+void bolt_file_cache_stats(BoltFileCache* cache, BoltFileCacheStats* stats);
+
+/*
+ * Queue recompression of cached variants compressed below the level they
+ * would get now (compression_stored_level()), e.g. filled while the server
+ * was busy, on the loader threads; at most max_fills waiting at a time.
+ * Picks up where the last call stopped; one caller at a time. Returns the
+ * fills queued (0 without loaders).
+ */
+size_t bolt_file_cache_upgrade(BoltFileCache* cache, size_t max_fills);
+
 #endif /* FILE_CACHE_H */
 
 
@@ -3,7 +3,8 @@
 
 #include "bolt.h"
 #include "connection.h"
-#include <windows.h>
+#include "file_cache.h"
+#include "compression.h"
 
 /*
  * High-performance file sender using TransmitFile (zero-copy).
@@ -18,6 +19,25 @@ typedef struct {
     bool keep_alive;
 } BoltFileSend;
 
+/*
+ * A file compressed on the fly into chunked responses. Each step reads
+ * the file and encodes it into the connection's send buffer until that
+ * is full (on a compute thread when the pool has room), then posts it;
+ * the next step starts on the send completion, so a slow client holds
+ * back reading and encoding, and a stream never holds more than the send
+ * buffer, one read and the encoder.
+ */
+typedef struct BoltSendStream {
+    HANDLE file;                        /* Private handle, read sequentially */
+    size_t remaining;                   /* File bytes not read yet */
+    BoltCompressStream* encoder;
+    size_t in_pos;                      /* Unencoded bytes: input[in_pos..in_len) */
+    size_t in_len;
+    size_t offset;                      /* Send buffer offset of the chunk being encoded */
+    bool finished;                      /* Last chunk is in the posted send */
+    char input[BOLT_STREAM_READ_SIZE];
+} BoltSendStream;
+
 /*
  * Send a file using TransmitFile (zero-copy).
  * Returns true if transmission started, false on error.
@@ -36,6 +56,54 @@ bool bolt_send_response(BoltConnection* conn,
                         const char* headers, size_t header_len,
                         const char* body, size_t body_len);
 
+/*
+ * Space in the send buffer to write a body into directly (e.g. compress
+ * it there), leaving room for headers of up to 1 KB in front. NULL if
+ * the buffer is full.
+ */
+char* bolt_send_body_space(BoltConnection* conn, size_t* room);
+
+/*
+ * Send body_len bytes written at bolt_send_body_space, after the headers,
+ * which are the only bytes copied.
+ */
+bool bolt_send_body_in_place(BoltConnection* conn,
+                             const char* headers, size_t header_len,
+                             size_t body_len);
+
+/*
+ * Send a cached response straight from cache memory (gathered send, no
+ * copy). Takes over cached->ref: it is held until the send completes or
+ * the connection closes, and is released here on failure.
+ */
+bool bolt_send_cached(BoltConnection* conn, const BoltCachedResponse* cached);
+
+/*
+ * Start sending a file compressed in `type` with Transfer-Encoding:
+ * chunked; the headers must announce both. Returns false, with nothing
+ * sent, when the stream cannot start (too many streams, file or encoder
+ * unavailable): the caller then sends the file as is.
+ */
+bool bolt_send_stream(BoltConnection* conn, const char* filepath,
+                      const char* headers, size_t header_len,
+                      BoltCompressionType type, int level);
+
+/*
+ * Post the stream's next chunks once the previous send has completed.
+ */
+bool bolt_send_stream_next(BoltConnection* conn);
+
+/*
+ * Free a connection's stream, if any.
+ */
+void bolt_send_stream_release(BoltConnection* conn);
+
+/*
+ * Streams in progress, and started since launch.
+ */
+LONG bolt_send_stream_active(void);
+LONG64 bolt_send_stream_total(void);
+
 /*
  * Send just headers (for HEAD requests or 304 responses).
  */
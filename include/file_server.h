@@ -1,7 +1,7 @@
 #ifndef FILE_SERVER_H
 #define FILE_SERVER_H
 
-#include <winsock2.h>
+#include "platform.h"
 #include "http.h"
 
 /* Forward declaration (Bolt async path) */
@@ -0,0 +1,65 @@
+#ifndef FS_WATCH_H
+#define FS_WATCH_H
+
+#include "bolt.h"
+
+/*
+ * Filesystem change notifications for the web roots.
+ *
+ * A watcher thread follows each root recursively (inotify on Linux,
+ * ReadDirectoryChangesW on Windows) and reports changes to a callback,
+ * which invalidates whatever caches are keyed by those paths. Paths are
+ * reported as root + separator + relative path, the form
+ * utils_sanitize_path_with_root() produces, so they match cache keys.
+ *
+ * Roots on network filesystems (NFS, SMB, FUSE...) are refused: changes
+ * made by other machines are not reported there, so callers keep relying
+ * on a TTL for them.
+ */
+
+#define BOLT_FS_WATCH_MAX_ROOTS 16
+
+typedef enum {
+    BOLT_FS_CHANGED,    /* A file was created, modified, deleted or renamed */
+    BOLT_FS_RESCAN,     /* Anything may have changed (directory moved, queue overflow) */
+    BOLT_FS_LOST        /* Changes can no longer be followed (root removed, out of watches) */
+} BoltFsWatchEvent;
+
+/* Called on the watcher thread; path is NULL except for BOLT_FS_CHANGED */
+typedef void (*BoltFsWatchCallback)(void* context, BoltFsWatchEvent event, const char* path);
+
+typedef struct BoltFsWatch BoltFsWatch;
+
+typedef struct {
+    size_t roots;
+    size_t watches;         /* Directories followed */
+    LONG64 events;          /* Changes reported */
+    LONG64 rescans;
+} BoltFsWatchStats;
+
+BoltFsWatch* bolt_fs_watch_create(BoltFsWatchCallback callback, void* context);
+
+/*
+ * Stop the watcher thread and release all watches. No callback runs
+ * after this returns.
+ */
+void bolt_fs_watch_destroy(BoltFsWatch* watch);
+
+/*
+ * Follow a directory tree. Returns false if it cannot be watched
+ * (missing, network filesystem, out of watches, unsupported platform).
+ * Roots are added before bolt_fs_watch_start().
+ */
+bool bolt_fs_watch_add_root(BoltFsWatch* watch, const char* root);
+
+/*
+ * Start reporting changes. Returns false if the thread cannot start.
+ */
+bool bolt_fs_watch_start(BoltFsWatch* watch);
+
+/*
+ * Snapshot statistics (zeroed for a NULL watcher).
+ */
+void bolt_fs_watch_stats(BoltFsWatch* watch, BoltFsWatchStats* out);
+
+#endif /* FS_WATCH_H */
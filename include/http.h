@@ -1,7 +1,7 @@
 #ifndef HTTP_H
 #define HTTP_H
 
-#include <winsock2.h>
+#include "platform.h"
 #include <stdbool.h>
 
 /*
@@ -40,22 +40,98 @@ typedef struct {
     bool valid;        /* True if range is valid */
 } HttpRange;
 
-/* Parsed HTTP Request */
+/*
+ * Request headers the server reads. The tokenizer maps names to these
+ * case-insensitively; other headers are validated and skipped.
+ */
+typedef enum {
+    HTTP_HEADER_HOST,
+    HTTP_HEADER_CONNECTION,
+    HTTP_HEADER_CONTENT_LENGTH,
+    HTTP_HEADER_ACCEPT_ENCODING,
+    HTTP_HEADER_IF_NONE_MATCH,
+    HTTP_HEADER_IF_MODIFIED_SINCE,
+    HTTP_HEADER_RANGE,
+    HTTP_HEADER_REFERER,
+    HTTP_HEADER_USER_AGENT,
+    HTTP_HEADER_TRANSFER_ENCODING,
+    HTTP_HEADER_COUNT,
+    HTTP_HEADER_OTHER = HTTP_HEADER_COUNT
+} HttpHeaderId;
+
+/* Bytes of the request buffer; data is NULL if the header is absent */
+typedef struct {
+    const char* data;
+    size_t len;
+} HttpSlice;
+
+/*
+ * Parsed HTTP Request. Nothing is copied: the path and header values are
+ * slices of the buffer given to http_parse_request(), which terminates
+ * each in place, so they are also C strings for as long as the buffer
+ * holds the request.
+ */
 typedef struct {
     HttpMethod method;
-    char uri[2048];
-    char if_none_match[64];    /* For ETag caching */
-    char if_modified_since[64]; /* For Last-Modified caching */
-    char accept_encoding[128];  /* For compression support */
+    const char* uri;            /* Path, without the query string */
+    size_t uri_len;
+    HttpSlice headers[HTTP_HEADER_COUNT];   /* By HttpHeaderId, first occurrence */
     HttpRange range;            /* For Range requests */
+    size_t head_length;         /* Request line to blank line; 0: incomplete */
+    unsigned char version_minor; /* 0 for HTTP/1.0 (no chunked responses), 1 for HTTP/1.1 */
     bool valid;
+    
+    /* Bytes replaced by the terminators, for http_request_restore() */
+    char uri_end;
+    char header_end[HTTP_HEADER_COUNT];
 } HttpRequest;
 
 /*
- * Parse an HTTP request from raw data.
- * Returns parsed request structure.
+ * An empty, invalid request (uri "").
+ */
+void http_request_init(HttpRequest* req);
+
+/*
+ * Parse the request head at the start of raw, in one pass: request line,
+ * then header lines up to the blank line (CRLF or bare LF). head_length
+ * stays 0 while the head is incomplete, and raw is left untouched. Once
+ * it is complete, valid says whether the request can be served; a
+ * malformed line, a control character in a value or a repeated Host or
+ * Content-Length makes it invalid.
+ */
+HttpRequest http_parse_request(char* raw, size_t length);
+
+/*
+ * Length of the head at the start of raw, through the blank line that
+ * ends it, as http_parse_request() would find it; 0 while it has not all
+ * arrived. Only line ends are looked at, and raw is not modified.
+ */
+size_t http_head_length(const char* raw, size_t length);
+
+/*
+ * Put back the bytes the parser replaced with terminators, so the head
+ * can be parsed again. The request is left empty.
+ */
+void http_request_restore(HttpRequest* req);
+
+/*
+ * Header a name refers to, ignoring case: HTTP_HEADER_OTHER if the server
+ * does not read it.
+ */
+HttpHeaderId http_header_id(const char* name, size_t len);
+
+/*
+ * Value of a header, or NULL if the request does not have it.
+ */
+static inline const char* http_header(const HttpRequest* req, HttpHeaderId id) {
+    return req->headers[id].data;
+}
+
+/*
+ * Whether a comma-separated header value lists a token, ignoring case
+ * ("Connection: Keep-Alive, Close" lists "close").
  */
-HttpRequest http_parse_request(const char* raw_request, size_t length);
+bool http_slice_has_token(HttpSlice value, const char* token);
 
 /*
  * Send an HTTP error response.
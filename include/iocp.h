@@ -2,12 +2,23 @@
 #define IOCP_H
 
 #include "bolt.h"
-#include <mswsock.h>
 
 /*
  * IOCP (I/O Completion Port) wrapper for high-performance async I/O.
+ *
+ * The backend is selected at build time. On Windows this is a thin layer
+ * over IOCP/AcceptEx/TransmitFile (src/iocp.c). On Linux the same API is
+ * emulated with a one-shot epoll readiness loop (src/iocp_epoll.c): posting
+ * an operation arms the socket, and the worker that dequeues the readiness
+ * event performs the non-blocking syscall and reports it as a completion.
+ * Building with BOLT_IO_URING selects the io_uring engine instead
+ * (src/iocp_uring.c), which is completion-based like IOCP.
  */
 
+#ifdef _WIN32
+
+#include <mswsock.h>
+
 /* Extended overlapped structure for tracking operations */
 typedef struct BoltOverlapped {
     OVERLAPPED overlapped;      /* Must be first! */
@@ -34,41 +45,187 @@ typedef struct BoltIOCP {
     SOCKET* accept_sockets;
     int num_accepts;
     
+    volatile LONG64 syscalls;   /* Winsock/IOCP calls issued */
+    volatile bool running;
+} BoltIOCP;
+
+#else /* POSIX backends */
+
+/* Scatter/gather element (same layout role as the Winsock WSABUF) */
+typedef struct WSABUF {
+    ULONG len;
+    char* buf;
+} WSABUF;
+
+/* Extended overlapped structure for tracking operations */
+typedef struct BoltOverlapped {
+    BoltOperationType op_type;
+    int accept_index;           /* O(1) mapping for accept completions */
+    BoltConnection* connection;
+    WSABUF wsa_buf;
+    
+    /* TransmitFile emulation state */
+    size_t file_end;            /* Offset one past the last byte to send */
+    size_t transferred;         /* Bytes sent so far for this operation */
+    int step;                   /* io_uring: internal read/send step in flight */
+    size_t pipe_bytes;          /* io_uring: spliced into the pipe, not yet sent */
+    struct BoltOverlapped* posted_next;  /* epoll: queued by bolt_iocp_post_completion */
+    
+    char buffer[BOLT_ACCEPT_BUFFER_SIZE];  /* Peer address for accepts */
+} BoltOverlapped;
+
+#ifdef BOLT_IO_URING
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* io_uring context */
+typedef struct BoltIOCP {
+    int ring_fd;
+    
+    /* Submission queue (shared by all workers, guarded by sq_lock) */
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    struct io_uring_sqe* sqes;
+    CRITICAL_SECTION sq_lock;
+    
+    /* Completion queue (reaped by all workers, head advanced with CAS) */
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+    
+    /* Ring mappings */
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    
+    SOCKET listen_socket;       /* Listening socket */
+    bool multishot_accept;      /* One armed accept yields many completions */
+    
+    /* Hand-off slots for accepted sockets (re-posted by the worker) */
+    BoltOverlapped* accept_overlaps;
+    SOCKET* accept_sockets;
+    int num_accepts;
+    int* free_accepts;
+    int num_free_accepts;
+    CRITICAL_SECTION accept_lock;
+    
+    /* Registered files/buffers, one slot per pooled connection */
+    BoltConnection* conns;
+    int num_conns;
+    SOCKET* fixed_sockets;      /* Socket installed in each file slot */
+    bool* fixed_buffers;        /* Send buffer registered for each slot */
+    uint16_t* conn_gen;         /* Bumped on dissociate to drop stale CQEs */
+    int* splice_pipes;          /* Pipe pair per slot for file->socket splice */
+    struct BoltUringSendMsg* send_msgs;  /* Gathered send descriptor per slot */
+    bool files_registered;
+    bool buffers_registered;
+    
+    volatile LONG64 syscalls;   /* io_uring_enter/register calls */
     volatile bool running;
 } BoltIOCP;
 
+#else /* epoll */
+
+/* epoll context */
+typedef struct BoltIOCP {
+    int epoll_fd;               /* epoll instance shared by all workers */
+    int wake_fd;                /* eventfd used to wake workers on shutdown */
+    SOCKET listen_socket;       /* Listening socket (non-blocking) */
+    
+    /* Accept slots; a slot is free once re-posted by the worker */
+    BoltOverlapped* accept_overlaps;
+    SOCKET* accept_sockets;
+    int num_accepts;
+    int* free_accepts;          /* Stack of posted (free) accept slots */
+    int num_free_accepts;
+    bool listen_armed;
+    CRITICAL_SECTION accept_lock;
+    
+    /* Completions posted from other threads, handed out on wake_fd reads */
+    BoltOverlapped* posted_head;
+    BoltOverlapped* posted_tail;
+    CRITICAL_SECTION posted_lock;
+    
+    volatile LONG64 syscalls;   /* epoll/socket syscalls issued */
+    volatile bool running;
+} BoltIOCP;
+
+#endif /* BOLT_IO_URING */
+
+#endif /* _WIN32 */
+
+struct BoltConnectionPool;
+
 /*
  * Initialize IOCP subsystem.
+ * With reuse_port the listener is bound with SO_REUSEPORT so several loops
+ * can each own a listener on the same port and the kernel spreads incoming
+ * connections across them (POSIX only; ignored on Windows).
  * Returns IOCP handle on success, NULL on failure.
  */
-BoltIOCP* bolt_iocp_create(int port, int num_accept_posts);
+BoltIOCP* bolt_iocp_create(int port, int num_accept_posts, bool reuse_port);
 
 /*
  * Destroy IOCP and cleanup.
  */
 void bolt_iocp_destroy(BoltIOCP* iocp);
 
+/*
+ * Hand the connection pool to the backend so it can set up per-connection
+ * resources (io_uring registered files/buffers). No-op elsewhere.
+ */
+bool bolt_iocp_register_pool(BoltIOCP* iocp, struct BoltConnectionPool* pool);
+
 /*
  * Associate a socket with the IOCP.
  */
 bool bolt_iocp_associate(BoltIOCP* iocp, SOCKET socket, void* completion_key);
 
+/*
+ * Drop per-connection backend state before the connection's socket is
+ * closed. No-op for IOCP and epoll.
+ */
+void bolt_iocp_dissociate(BoltIOCP* iocp, BoltConnection* conn);
+
 /*
  * Post an accept operation.
  */
 bool bolt_iocp_post_accept(BoltIOCP* iocp, int accept_index);
 
+/*
+ * Finish an accept completion: apply per-socket options and return the
+ * accepted socket. The peer IPv4 address is stored in *client_ip (0 if
+ * unknown). Returns INVALID_SOCKET if the accept failed.
+ */
+SOCKET bolt_iocp_finish_accept(BoltIOCP* iocp, BoltOverlapped* overlapped,
+                               DWORD bytes_transferred, uint32_t* client_ip);
+
 /*
  * Post a receive operation.
  */
 bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn);
 
 /*
- * Post a send operation.
+ * Post a send operation (data is copied into the send buffer unless it
+ * already is the send buffer).
  */
 bool bolt_iocp_post_send(BoltIOCP* iocp, BoltConnection* conn, 
                          const char* data, size_t len);
 
+/*
+ * Post (or re-post) a gathered send of conn->send_segments from
+ * send_offset to send_remaining. Segments may point outside the send
+ * buffer and must stay valid until the send completes.
+ */
+bool bolt_iocp_repost_send(BoltIOCP* iocp, BoltConnection* conn);
+
 /*
  * Post a TransmitFile operation (zero-copy).
  * If range_start and range_length are non-zero, only that range is sent.
@@ -78,19 +235,59 @@ bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
                                    const char* headers, size_t header_len,
                                    size_t range_start, size_t range_length);
 
+/*
+ * Abort the connection's outstanding operation so it completes as failed
+ * and the normal completion path closes the connection (used on timeouts).
+ * The socket stays open; the caller guarantees it is not closed meanwhile.
+ */
+bool bolt_iocp_abort(BoltIOCP* iocp, BoltConnection* conn);
+
 /*
  * Post disconnect for connection reuse.
  */
 bool bolt_iocp_post_disconnect(BoltIOCP* iocp, BoltConnection* conn);
 
 /*
- * Get completion status (called by worker threads).
+ * Wake one worker blocked in bolt_iocp_get_completions(). The worker sees
+ * a completion with a NULL overlapped (used for shutdown).
  */
-bool bolt_iocp_get_completion(BoltIOCP* iocp, 
-                               DWORD* bytes_transferred,
-                               ULONG_PTR* completion_key,
-                               BoltOverlapped** overlapped,
-                               DWORD timeout_ms);
+bool bolt_iocp_post_wakeup(BoltIOCP* iocp);
 
-#endif /* IOCP_H */
+/*
+ * Queue a completion for overlapped without any I/O, from any thread
+ * (e.g. a compute pool job that finished). A worker dequeues it like
+ * the completion of an operation on the connection, with 0 bytes.
+ */
+bool bolt_iocp_post_completion(BoltIOCP* iocp, BoltOverlapped* overlapped);
+
+/*
+ * Name of the compiled-in backend ("iocp", "epoll" or "io_uring").
+ */
+const char* bolt_iocp_backend_name(void);
+
+/* One dequeued completion */
+typedef struct BoltCompletion {
+    BoltOverlapped* overlapped;     /* NULL for a wakeup */
+    ULONG_PTR completion_key;
+    DWORD bytes_transferred;        /* 0 for a failed operation */
+    uint32_t generation;            /* io_uring: connection slot generation */
+} BoltCompletion;
+
+/*
+ * Dequeue a batch of completions (called by worker threads): waits up to
+ * timeout_ms for the first, then takes up to max_entries that are ready in
+ * the same kernel transition (GetQueuedCompletionStatusEx, one epoll_wait,
+ * or one sweep of the io_uring CQ ring).
+ * Returns the number of entries filled, 0 on timeout.
+ */
+int bolt_iocp_get_completions(BoltIOCP* iocp, BoltCompletion* entries,
+                              int max_entries, DWORD timeout_ms);
 
+/*
+ * Check that a dequeued completion still belongs to the live connection.
+ * An earlier entry of the same batch may have closed and recycled it
+ * (io_uring can hold several CQEs per connection); always true elsewhere.
+ */
+bool bolt_iocp_completion_current(BoltIOCP* iocp, const BoltCompletion* entry);
+
+#endif /* IOCP_H */
@@ -0,0 +1,100 @@
+#ifndef OPEN_FILE_CACHE_H
+#define OPEN_FILE_CACHE_H
+
+#include "bolt.h"
+#include "utils.h"
+
+/*
+ * Open-file and stat cache (nginx's open_file_cache).
+ *
+ * Remembers stat results and open handles by path, so a request for a
+ * file seen recently costs no stat() and no open()/close(). Entries are
+ * trusted for `valid_ms` after their last stat; the next lookup after
+ * that stats the path again and drops the handle if size or mtime
+ * changed. A filesystem watcher (fs_watch.h) can invalidate entries as
+ * files change, allowing a much longer `valid_ms`. Missing paths are not
+ * remembered.
+ *
+ * Handles are reference counted: the cache holds one reference and each
+ * transfer using the handle holds another, so eviction or revalidation
+ * only unlinks a handle and the last transfer closes it. Transfers read
+ * at explicit offsets (TransmitFile offset, sendfile/splice/pread), so
+ * concurrent transfers can share one handle.
+ *
+ * The cache is split into shards by path hash, each with its own lock
+ * and LRU list; a full shard evicts its least recently used entry.
+ */
+
+typedef struct BoltOpenFileCache BoltOpenFileCache;
+
+/* Shared open handle */
+typedef struct BoltOpenFile {
+    HANDLE handle;
+    size_t size;                /* Size when opened */
+    volatile LONG refs;
+} BoltOpenFile;
+
+typedef struct {
+    size_t entries;
+    size_t handles;             /* Entries holding an open handle */
+    LONG64 hits;                /* Lookups answered without stat() */
+    LONG64 misses;
+    LONG64 opens;               /* Handles opened */
+    LONG64 revalidations;       /* Expired entries stat'ed again */
+    LONG64 evictions;
+    LONG64 invalidations;       /* Entries dropped on a change notification */
+} BoltOpenFileCacheStats;
+
+/*
+ * Create a cache of at most `capacity` paths, each trusted for
+ * `valid_ms` after it was last checked.
+ */
+BoltOpenFileCache* bolt_open_file_cache_create(size_t capacity, DWORD valid_ms);
+
+/*
+ * Destroy the cache. Handles still used by transfers stay open until
+ * those transfers release them.
+ */
+void bolt_open_file_cache_destroy(BoltOpenFileCache* cache);
+
+/*
+ * Stat a path through the cache (same result as utils_get_file_info).
+ * With a NULL cache, stats the path directly.
+ */
+FileInfo bolt_open_file_cache_stat(BoltOpenFileCache* cache, const char* path);
+
+/*
+ * Get a referenced open handle for a regular file, opening it on first
+ * use. Returns NULL if the file cannot be opened. The caller releases it
+ * with bolt_open_file_release().
+ */
+BoltOpenFile* bolt_open_file_cache_open(BoltOpenFileCache* cache, const char* path);
+
+/*
+ * Drop a reference; the last one closes the handle.
+ */
+void bolt_open_file_release(BoltOpenFile* file);
+
+/*
+ * Change how long entries are trusted after their last stat (e.g. longer
+ * while a filesystem watcher pushes invalidations).
+ */
+void bolt_open_file_cache_set_valid(BoltOpenFileCache* cache, DWORD valid_ms);
+
+/*
+ * Forget a path, e.g. on a change notification. Transfers still using its
+ * handle are unaffected.
+ */
+void bolt_open_file_cache_invalidate(BoltOpenFileCache* cache, const char* path);
+
+/*
+ * Forget every path (directory renamed, lost notifications...).
+ */
+void bolt_open_file_cache_invalidate_all(BoltOpenFileCache* cache);
+
+/*
+ * Snapshot statistics (zeroed for a NULL cache).
+ */
+void bolt_open_file_cache_stats(BoltOpenFileCache* cache, BoltOpenFileCacheStats* out);
+
+#endif /* OPEN_FILE_CACHE_H */
@@ -0,0 +1,100 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include "bolt.h"
+#include "utils.h"
+
+/*
+ * Resolved-path cache.
+ *
+ * Maps a request's raw Host header and URI to what the request pipeline
+ * (rewrite rules, virtual host lookup, path sanitizing, stat, index file
+ * probing, MIME type) decided for it: a file to serve with its stat
+ * result, content type and validators, a redirect, or an error status.
+ * A hit skips that whole pipeline.
+ *
+ * The server keeps errors (403, 404) in a second, separate instance, the
+ * negative cache, so scanners probing random URIs evict each other
+ * rather than the files that are actually served.
+ *
+ * Results depend on the filesystem and the configuration, so they are
+ * trusted for `valid_ms` (like the open-file cache) and all of them are
+ * dropped at once by bolt_path_cache_invalidate_all() when a file
+ * changes or the configuration is reloaded. Dropping is a generation
+ * bump; stale entries are skipped and reused lazily.
+ */
+
+#define BOLT_PATH_CACHE_MAX_KEY 512     /* Host + URI; longer requests are not cached */
+
+typedef struct BoltPathCache BoltPathCache;
+
+typedef enum {
+    BOLT_RESOLVED_FILE,
+    BOLT_RESOLVED_REDIRECT,
+    BOLT_RESOLVED_ERROR
+} BoltResolvedKind;
+
+/* Precompressed siblings of a file (app.js.br, app.js.zst, app.js.gz), in preference order */
+typedef enum {
+    BOLT_SIDECAR_BR,
+    BOLT_SIDECAR_ZSTD,
+    BOLT_SIDECAR_GZIP,
+    BOLT_SIDECAR_COUNT
+} BoltSidecar;
+
+typedef struct {
+    BoltResolvedKind kind;
+    int status;                         /* 301/302 redirect, 403/404 error */
+    FileInfo info;                      /* Stat result of the file */
+    FileInfo sidecars[BOLT_SIDECAR_COUNT]; /* Stat results of its precompressed siblings */
+    char path[BOLT_MAX_PATH_LENGTH];    /* File to serve, or redirect Location */
+    char content_type[128];
+    char validators[192];               /* ETag, Last-Modified, Cache-Control lines */
+} BoltResolvedPath;
+
+typedef struct {
+    size_t entries;
+    LONG64 hits;
+    LONG64 misses;
+    LONG64 evictions;
+    LONG64 invalidations;       /* Times every entry was dropped */
+} BoltPathCacheStats;
+
+/*
+ * Create a cache of at most `capacity` requests, each trusted for
+ * `valid_ms` after it was resolved.
+ */
+BoltPathCache* bolt_path_cache_create(size_t capacity, DWORD valid_ms);
+
+void bolt_path_cache_destroy(BoltPathCache* cache);
+
+/*
+ * Copy a request's resolution into `out`. On a miss, `out_generation`
+ * gets the generation to pass to bolt_path_cache_insert().
+ */
+bool bolt_path_cache_lookup(BoltPathCache* cache, const char* host, const char* uri,
+                            BoltResolvedPath* out, LONG64* out_generation);
+
+/*
+ * Remember a resolution made since the lookup that returned
+ * `generation`. Dropped if the cache was invalidated in between.
+ */
+void bolt_path_cache_insert(BoltPathCache* cache, const char* host, const char* uri,
+                            const BoltResolvedPath* resolved, LONG64 generation);
+
+/*
+ * Change how long resolutions are trusted.
+ */
+void bolt_path_cache_set_valid(BoltPathCache* cache, DWORD valid_ms);
+
+/*
+ * Forget every resolution (file changed, configuration reloaded).
+ */
+void bolt_path_cache_invalidate_all(BoltPathCache* cache);
+
+/*
+ * Snapshot statistics (zeroed for a NULL cache).
+ */
+void bolt_path_cache_stats(BoltPathCache* cache, BoltPathCacheStats* out);
+
+#endif /* PATH_CACHE_H */
@@ -0,0 +1,240 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/*
+ * Platform layer.
+ *
+ * On Windows this is just the Winsock/Win32 headers. On POSIX systems it
+ * maps the small subset of Win32 types and calls used by the portable
+ * modules (connection, cache, pools, logger...) onto pthreads, GCC atomics
+ * and file descriptors so those modules compile unchanged. The event
+ * backend itself is selected at build time: src/iocp.c (IOCP) on Windows,
+ * src/iocp_epoll.c (epoll) on Linux, or src/iocp_uring.c (io_uring) on
+ * Linux when built with BOLT_IO_URING.
+ */
+
+#ifdef _WIN32
+
+/* Must include winsock2.h before windows.h */
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+#define BOLT_PATH_SEP     '\\'
+#define BOLT_PATH_SEP_STR "\\"
+
+#else /* POSIX */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define BOLT_PATH_SEP     '/'
+#define BOLT_PATH_SEP_STR "/"
+
+/* Basic Win32 types */
+typedef uint32_t            DWORD;
+typedef long                LONG;
+typedef unsigned long       ULONG;
+typedef long long           LONG64;
+typedef unsigned long long  ULONGLONG;
+typedef uintptr_t           ULONG_PTR;
+typedef int                 BOOL;
+typedef void*               LPVOID;
+typedef void*               HANDLE;
+
+typedef struct {
+    long long QuadPart;
+} LARGE_INTEGER;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#define WINAPI
+#define INFINITE        0xFFFFFFFFu
+#define WAIT_TIMEOUT    ETIMEDOUT
+
+/* Sockets */
+typedef int SOCKET;
+#define INVALID_SOCKET  (-1)
+#define SOCKET_ERROR    (-1)
+#define SD_BOTH         SHUT_RDWR
+#define closesocket(s)  close(s)
+
+static inline int WSAGetLastError(void) { return errno; }
+static inline DWORD GetLastError(void) { return (DWORD)errno; }
+
+/* File handles are file descriptors stored in a HANDLE */
+#define INVALID_HANDLE_VALUE      ((HANDLE)(intptr_t)-1)
+#define BOLT_HANDLE_TO_FD(h)      ((int)(intptr_t)(h))
+#define BOLT_FD_TO_HANDLE(fd)     ((HANDLE)(intptr_t)(fd))
+
+#define GENERIC_READ              0x80000000u
+#define FILE_SHARE_READ           0x00000001u
+#define FILE_SHARE_WRITE          0x00000002u
+#define FILE_SHARE_DELETE         0x00000004u
+#define OPEN_EXISTING             3u
+#define FILE_ATTRIBUTE_NORMAL     0x00000080u
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000u
+
+static inline HANDLE CreateFileA(const char* path, DWORD access, DWORD share,
+                                 void* security, DWORD disposition,
+                                 DWORD flags, HANDLE template_file) {
+    (void)access; (void)share; (void)security; (void)disposition; (void)template_file;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return INVALID_HANDLE_VALUE;
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (flags & FILE_FLAG_SEQUENTIAL_SCAN) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#else
+    (void)flags;
+#endif
+    return BOLT_FD_TO_HANDLE(fd);
+}
+
+static inline BOOL ReadFile(HANDLE file, void* buffer, DWORD to_read,
+                            DWORD* bytes_read, void* overlapped) {
+    (void)overlapped;
+    size_t total = 0;
+    while (total < to_read) {
+        ssize_t n = read(BOLT_HANDLE_TO_FD(file), (char*)buffer + total, to_read - total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return FALSE;
+        if (n == 0) break;  /* EOF */
+        total += (size_t)n;
+    }
+    if (bytes_read) *bytes_read = (DWORD)total;
+    return TRUE;
+}
+
+static inline BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size) {
+    struct stat st;
+    if (fstat(BOLT_HANDLE_TO_FD(file), &st) != 0) return FALSE;
+    size->QuadPart = (long long)st.st_size;
+    return TRUE;
+}
+
+static inline BOOL CloseHandle(HANDLE file) {
+    return close(BOLT_HANDLE_TO_FD(file)) == 0;
+}
+
+static inline BOOL CreateDirectoryA(const char* path, void* security) {
+    (void)security;
+    return mkdir(path, 0755) == 0;
+}
+
+/* CRT names */
+#define _stat           stat
+#define _S_IFDIR        S_IFDIR
+#define _strnicmp       strncasecmp
+
+static inline void* _aligned_malloc(size_t size, size_t alignment) {
+    void* p = NULL;
+    return posix_memalign(&p, alignment, size) == 0 ? p : NULL;
+}
+
+static inline void _aligned_free(void* p) {
+    free(p);
+}
+
+/* Time */
+static inline ULONGLONG GetTickCount64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONGLONG)ts.tv_sec * 1000ull + (ULONGLONG)ts.tv_nsec / 1000000ull;
+}
+
+static inline void Sleep(DWORD ms) {
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+/* Locks */
+typedef pthread_mutex_t  CRITICAL_SECTION;
+typedef pthread_rwlock_t SRWLOCK;
+
+static inline void InitializeCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_init(cs, NULL); }
+static inline void DeleteCriticalSection(CRITICAL_SECTION* cs)     { pthread_mutex_destroy(cs); }
+static inline void EnterCriticalSection(CRITICAL_SECTION* cs)      { pthread_mutex_lock(cs); }
+static inline void LeaveCriticalSection(CRITICAL_SECTION* cs)      { pthread_mutex_unlock(cs); }
+
+static inline void InitializeSRWLock(SRWLOCK* l)          { pthread_rwlock_init(l, NULL); }
+static inline void AcquireSRWLockShared(SRWLOCK* l)       { pthread_rwlock_rdlock(l); }
+static inline void ReleaseSRWLockShared(SRWLOCK* l)       { pthread_rwlock_unlock(l); }
+static inline void AcquireSRWLockExclusive(SRWLOCK* l)    { pthread_rwlock_wrlock(l); }
+static inline void ReleaseSRWLockExclusive(SRWLOCK* l)    { pthread_rwlock_unlock(l); }
+
+/* Condition variables (Win32 has no destroy call; these are never torn down) */
+typedef pthread_cond_t CONDITION_VARIABLE;
+
+static inline void InitializeConditionVariable(CONDITION_VARIABLE* cv) { pthread_cond_init(cv, NULL); }
+static inline void WakeConditionVariable(CONDITION_VARIABLE* cv)       { pthread_cond_signal(cv); }
+static inline void WakeAllConditionVariable(CONDITION_VARIABLE* cv)    { pthread_cond_broadcast(cv); }
+static inline BOOL SleepConditionVariableCS(CONDITION_VARIABLE* cv, CRITICAL_SECTION* cs, DWORD ms) {
+    if (ms == INFINITE) return pthread_cond_wait(cv, cs) == 0;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cv, cs, &ts) == 0;
+}
+
+/* Interlocked operations (return the new value, like Win32) */
+static inline LONG InterlockedIncrement(volatile LONG* p) {
+    return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+static inline LONG InterlockedDecrement(volatile LONG* p) {
+    return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+static inline LONG InterlockedExchange(volatile LONG* p, LONG v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+static inline LONG InterlockedCompareExchange(volatile LONG* p, LONG v, LONG cmp) {
+    __atomic_compare_exchange_n(p, &cmp, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+static inline LONG64 InterlockedIncrement64(volatile LONG64* p) {
+    return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+static inline LONG64 InterlockedDecrement64(volatile LONG64* p) {
+    return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+static inline LONG64 InterlockedAdd64(volatile LONG64* p, LONG64 v) {
+    return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+}
+static inline void MemoryBarrier(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif /* _WIN32 */
+
+/* Thread-local storage (MinGW and GCC both accept __thread) */
+#ifdef _MSC_VER
+#define BOLT_THREAD_LOCAL __declspec(thread)
+#else
+#define BOLT_THREAD_LOCAL __thread
+#endif
+
+#endif /* PLATFORM_H */
@@ -0,0 +1,70 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include "bolt.h"
+
+/*
+ * Compute pool for CPU-bound work (compression) that would otherwise run
+ * on the I/O worker that took the completion and hold up every other
+ * connection behind it in the queue.
+ *
+ * One thread per core, each with its own deque. Submitters spread jobs
+ * over the deques; a thread takes the oldest job of its own deque and,
+ * when that is empty, steals the newest from another. A finished job is
+ * posted back to the connection's event loop as a BOLT_OP_TASK
+ * completion, so the response is sent from an I/O worker as usual.
+ */
+
+typedef struct BoltTaskPool BoltTaskPool;
+
+/*
+ * A connection's job; at most one per connection, while the connection
+ * is in BOLT_CONN_COMPUTING.
+ */
+typedef struct BoltTask {
+    bool (*run)(BoltConnection* conn);          /* On a compute thread: the result */
+    void (*complete)(BoltConnection* conn);     /* Back on the loop; NULL: answer the request again */
+    bool ok;                                    /* run's result */
+    bool ready;                                 /* A result waits for the request */
+
+    /* Small file compressed for the request: path, coding, size, output */
+    char path[BOLT_MAX_PATH_LENGTH];
+    int type;
+    int level;
+    size_t size;
+    char* out;
+    size_t out_size;
+    size_t out_len;
+} BoltTask;
+
+/*
+ * Start `threads` compute threads (capped at BOLT_TASK_MAX_THREADS).
+ * NULL on failure.
+ */
+BoltTaskPool* bolt_task_pool_create(int threads);
+
+/*
+ * Stop the threads. Jobs still queued are dropped: call this once the
+ * I/O workers have stopped.
+ */
+void bolt_task_pool_destroy(BoltTaskPool* pool);
+
+/*
+ * Hand the connection to the pool: it enters BOLT_CONN_COMPUTING and
+ * run executes on a compute thread, then complete (or the request again)
+ * on one of its loop's workers. Like a posted send, the connection is no
+ * longer the caller's once this returns true. False (no pool, queues
+ * full) leaves everything as it was: the caller does the work inline.
+ */
+bool bolt_task_submit(BoltTaskPool* pool, BoltConnection* conn,
+                      bool (*run)(BoltConnection* conn),
+                      void (*complete)(BoltConnection* conn));
+
+/*
+ * Compute threads; jobs submitted, taken from another thread's deque,
+ * and turned away (run inline) since launch; jobs waiting now.
+ */
+void bolt_task_pool_stats(BoltTaskPool* pool, int* threads, LONG64* submitted,
+                          LONG64* stolen, LONG64* inlined, LONG* queued);
+
+#endif /* TASK_POOL_H */
@@ -2,30 +2,52 @@
 #define THREADPOOL_H
 
 #include "bolt.h"
+#include "iocp.h"
+#include "timer_wheel.h"
 
 /*
  * High-performance thread pool using IOCP as the work queue.
- * Workers pull completions directly from the IOCP.
+ * Workers pull completions directly from the IOCP (epoll on Linux).
+ *
+ * With a single event loop every worker waits on the same port. With one
+ * loop per worker (SO_REUSEPORT listeners) each worker owns its loop and
+ * connection pool slice, so a connection never leaves the worker that
+ * accepted it.
  */
 
+struct BoltConnectionPool;
+
 /* Worker thread info */
 typedef struct BoltWorker {
+#ifdef _WIN32
     HANDLE thread;
+#else
+    pthread_t thread;
+    bool thread_started;
+#endif
     DWORD thread_id;
     int worker_id;
+    int cpu;                    /* Core the worker is pinned to, -1 if none */
     volatile bool running;
     
+    /* Event loop and connection pool this worker serves */
+    BoltIOCP* iocp;
+    struct BoltConnectionPool* conn_pool;
+    BoltTimerWheel* timers;     /* Deadlines of connections this worker accepted */
+    
     /* Statistics */
     volatile LONG64 requests_handled;
     volatile LONG64 bytes_sent;
     volatile LONG64 bytes_received;
+    volatile LONG64 completions;
+    volatile LONG64 batch_histogram[BOLT_BATCH_HISTOGRAM_BUCKETS];  /* Completions per dequeue */
 } BoltWorker;
 
 /* Thread pool */
 struct BoltThreadPool {
     BoltWorker* workers;
     int num_workers;
-    HANDLE iocp;  /* Shared IOCP handle */
+    BoltIOCP* iocp;  /* First event loop (the shared one with a single loop) */
     volatile bool shutdown;
     
     /* Pool statistics */
@@ -34,9 +56,12 @@ struct BoltThreadPool {
 
 /*
  * Create thread pool with specified number of workers.
- * iocp is the completion port workers will wait on.
+ * Worker i waits on loops[i % num_loops] and takes connections from
+ * pools[i % num_loops]; pass a single loop for the shared model. With
+ * pin_cores, worker i is bound to core i % CPU count.
  */
-BoltThreadPool* bolt_threadpool_create(HANDLE iocp, int num_workers);
+BoltThreadPool* bolt_threadpool_create(BoltIOCP** loops, struct BoltConnectionPool** pools,
+                                       int num_loops, int num_workers, bool pin_cores);
 
 /*
  * Shutdown and destroy the thread pool.
@@ -57,5 +82,25 @@ void bolt_threadpool_stats(BoltThreadPool* pool,
                            LONG64* bytes_sent,
                            LONG64* bytes_received);
 
+/*
+ * Get the completion batch size histogram summed over all workers.
+ * histogram must hold BOLT_BATCH_HISTOGRAM_BUCKETS entries; bucket k
+ * counts dequeues that returned 2^k .. 2^(k+1)-1 completions.
+ */
+void bolt_threadpool_batch_stats(BoltThreadPool* pool, LONG64* histogram,
+                                 LONG64* completions);
+
+/*
+ * Get the number of connections aborted by a timeout (keep-alive idle,
+ * request head, or send deadline) across all workers.
+ */
+LONG64 bolt_threadpool_timeouts(BoltThreadPool* pool);
+
+/*
+ * Get the CPU time (user and kernel, microseconds) the worker threads
+ * have used so far.
+ */
+LONG64 bolt_threadpool_cpu_us(BoltThreadPool* pool);
+
 #endif /* THREADPOOL_H */
 
@@ -0,0 +1,84 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "bolt.h"
+
+/*
+ * Hierarchical timing wheel for connection deadlines.
+ *
+ * Timers are intrusive list nodes, so arming, re-arming and cancelling are
+ * O(1) with no allocation. Level 0 has one slot per tick; each higher level
+ * covers 64 slots of the level below and is cascaded down as time reaches
+ * it, so advancing costs O(1) per tick plus the timers that actually move
+ * or fire, independent of how many connections sit idle.
+ *
+ * Each worker owns a wheel. Other threads may arm or cancel timers on it;
+ * the wheel lock serializes them with expiry, so the expiry callback can
+ * safely touch the timer's owner as long as the owner cancels its timer
+ * before tearing down what the callback uses.
+ */
+
+#define BOLT_TIMER_WHEEL_BITS   6
+#define BOLT_TIMER_WHEEL_SLOTS  (1 << BOLT_TIMER_WHEEL_BITS)
+#define BOLT_TIMER_WHEEL_MASK   (BOLT_TIMER_WHEEL_SLOTS - 1)
+#define BOLT_TIMER_WHEEL_LEVELS 4
+
+struct BoltTimerWheel;
+
+/* Timer node, embedded in its owner (e.g. BoltConnection) */
+typedef struct BoltTimer {
+    struct BoltTimer* prev;
+    struct BoltTimer* next;
+    ULONGLONG expires;              /* Tick the timer fires at */
+    struct BoltTimerWheel* wheel;   /* Wheel it is linked into, NULL if idle */
+} BoltTimer;
+
+/* Called with the wheel lock held; must not arm or cancel timers */
+typedef void (*BoltTimerCallback)(BoltTimer* timer, void* context);
+
+/* Timing wheel */
+typedef struct BoltTimerWheel {
+    BoltTimer slots[BOLT_TIMER_WHEEL_LEVELS][BOLT_TIMER_WHEEL_SLOTS];  /* List heads */
+    ULONGLONG current_tick;
+    DWORD tick_ms;
+    BoltTimerCallback callback;
+    void* context;
+    CRITICAL_SECTION lock;
+
+    /* Statistics */
+    volatile LONG armed;            /* Timers currently linked */
+    volatile LONG64 expired;        /* Timers fired since creation */
+} BoltTimerWheel;
+
+/*
+ * Create a wheel with the given tick length, starting at now_ms.
+ * callback runs for every timer that expires.
+ */
+BoltTimerWheel* bolt_timer_wheel_create(DWORD tick_ms, ULONGLONG now_ms,
+                                        BoltTimerCallback callback, void* context);
+
+/*
+ * Destroy a wheel. Linked timers are dropped without firing.
+ */
+void bolt_timer_wheel_destroy(BoltTimerWheel* wheel);
+
+/*
+ * Arm (or re-arm) a timer to fire timeout_ms after now_ms.
+ * Deadlines are rounded up to the next tick.
+ */
+void bolt_timer_arm(BoltTimerWheel* wheel, BoltTimer* timer,
+                    ULONGLONG now_ms, DWORD timeout_ms);
+
+/*
+ * Cancel a timer. Safe on a timer that is not armed. Once this returns the
+ * callback is not running for it and will not run.
+ */
+void bolt_timer_cancel(BoltTimerWheel* wheel, BoltTimer* timer);
+
+/*
+ * Advance the wheel to now_ms and fire every timer that expired.
+ * Returns the number of timers fired.
+ */
+int bolt_timer_wheel_advance(BoltTimerWheel* wheel, ULONGLONG now_ms);
+
+#endif /* TIMER_WHEEL_H */
@@ -154,6 +154,133 @@ BoltServer* bolt_server_create(int port) {
     return bolt_server_create_with_config(&config);
 }
 
+/*
+ * Apply a filesystem change to every cache keyed by path. The file
+ * cache needs no rescan: it checks size and mtime from the stat cache.
+ * Resolutions go last, so one made from a stale stat cannot be kept.
+ */
+static void server_fs_changed(void* context, BoltFsWatchEvent event, const char* path) {
+    BoltServer* server = (BoltServer*)context;
+
+    switch (event) {
+        case BOLT_FS_CHANGED:
+            bolt_open_file_cache_invalidate(server->open_file_cache, path);
+            bolt_file_cache_invalidate(server->file_cache, path);
+            bolt_path_cache_invalidate_all(server->path_cache);
+            bolt_path_cache_invalidate_all(server->negative_cache);
+            break;
+        case BOLT_FS_LOST:
+            bolt_open_file_cache_set_valid(server->open_file_cache,
+                                           server->open_file_cache_valid_ms);
+            bolt_path_cache_set_valid(server->path_cache, server->open_file_cache_valid_ms);
+            bolt_path_cache_set_valid(server->negative_cache, server->open_file_cache_valid_ms);
+            bolt_open_file_cache_invalidate_all(server->open_file_cache);
+            bolt_path_cache_invalidate_all(server->path_cache);
+            bolt_path_cache_invalidate_all(server->negative_cache);
+            BOLT_ERROR("File watcher stopped, revalidating cached files every %lu ms",
+                       (unsigned long)server->open_file_cache_valid_ms);
+            break;
+        case BOLT_FS_RESCAN:
+            bolt_open_file_cache_invalidate_all(server->open_file_cache);
+            bolt_path_cache_invalidate_all(server->path_cache);
+            bolt_path_cache_invalidate_all(server->negative_cache);
+            break;
+    }
+}
+
+/*
+ * Watch the web root and virtual host roots. While every root is watched,
+ * stat results are trusted much longer; otherwise the configured TTL
+ * stays in charge.
+ */
+static void start_fs_watch(BoltServer* server) {
+    server->fs_watch = bolt_fs_watch_create(server_fs_changed, server);
+    if (!server->fs_watch) return;
+
+    bool watched = bolt_fs_watch_add_root(server->fs_watch, server->web_root);
+    for (BoltVHost* vhost = server->vhost_manager->vhosts; vhost && watched; vhost = vhost->next) {
+        watched = bolt_fs_watch_add_root(server->fs_watch, vhost->root);
+    }
+
+    if (!watched || !bolt_fs_watch_start(server->fs_watch)) {
+        printf("  File watcher unavailable, revalidating cached files every %lu ms\n",
+               (unsigned long)server->open_file_cache_valid_ms);
+        bolt_fs_watch_destroy(server->fs_watch);
+        server->fs_watch = NULL;
+        return;
+    }
+
+    if (server->open_file_cache_valid_ms < BOLT_OPEN_FILE_CACHE_WATCHED_VALID_MS) {
+        bolt_open_file_cache_set_valid(server->open_file_cache, BOLT_OPEN_FILE_CACHE_WATCHED_VALID_MS);
+        bolt_path_cache_set_valid(server->path_cache, BOLT_OPEN_FILE_CACHE_WATCHED_VALID_MS);
+        bolt_path_cache_set_valid(server->negative_cache, BOLT_OPEN_FILE_CACHE_WATCHED_VALID_MS);
+    }
+}
+
+/*
+ * Create the connection pool slices, one per event loop.
+ */
+static bool create_conn_pools(BoltServer* server, int max_conns, int num_loops) {
+    server->conn_pools = (BoltConnectionPool**)calloc(num_loops, sizeof(BoltConnectionPool*));
+    if (!server->conn_pools) return false;
+    server->num_loops = num_loops;
+    
+    int per_loop = max_conns / num_loops;
+    if (per_loop < 1) per_loop = 1;
+    for (int i = 0; i < num_loops; i++) {
+        /* First slice takes the remainder */
+        int capacity = i == 0 ? max_conns - per_loop * (num_loops - 1) : per_loop;
+        if (capacity < 1) capacity = 1;
+        server->conn_pools[i] = bolt_conn_pool_create(capacity);
+        if (!server->conn_pools[i]) return false;
+    }
+    server->conn_pool = server->conn_pools[0];
+    return true;
+}
+
+static void destroy_conn_pools(BoltServer* server) {
+    if (!server->conn_pools) return;
+    for (int i = 0; i < server->num_loops; i++) {
+        bolt_conn_pool_destroy(server->conn_pools[i]);
+    }
+    free(server->conn_pools);
+    server->conn_pools = NULL;
+    server->conn_pool = NULL;
+}
+
+/*
+ * Create the event loops. A single loop is shared by all workers; with
+ * several, each gets its own SO_REUSEPORT listener on the same port.
+ */
+static bool create_loops(BoltServer* server, int port, int num_threads) {
+    int num_loops = server->num_loops;
+    server->loops = (BoltIOCP**)calloc(num_loops, sizeof(BoltIOCP*));
+    if (!server->loops) return false;
+    
+    int accept_posts = num_loops == 1 ? num_threads * 2 : 2;
+    for (int i = 0; i < num_loops; i++) {
+        server->loops[i] = bolt_iocp_create(port, accept_posts, num_loops > 1);
+        if (!server->loops[i]) return false;
+        
+        /* Let the backend register per-connection resources (best effort) */
+        bolt_iocp_register_pool(server->loops[i], server->conn_pools[i]);
+    }
+    server->iocp = server->loops[0];
+    return true;
+}
+
+static void destroy_loops(BoltServer* server) {
+    if (!server->loops) return;
+    for (int i = 0; i < server->num_loops; i++) {
+        if (server->loops[i]) {
+            bolt_iocp_destroy(server->loops[i]);
+        }
+    }
+    free(server->loops);
+    server->loops = NULL;
+    server->iocp = NULL;
+}
+
 /*
  * Create Bolt server with configuration.
  */
@@ -168,6 +295,26 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     
     server->port = config->port;
     server->web_root = config->web_root[0] ? config->web_root : BOLT_WEB_ROOT;
+    server->keepalive_timeout_ms = config->keepalive_timeout_ms;
+    server->request_timeout_ms = config->request_timeout_ms;
+    server->open_file_cache_valid_ms = config->open_file_cache_valid_ms;
+    server->gzip_static = config->gzip_static;
+    server->brotli_static = config->brotli_static;
+    server->zstd_static = config->zstd_static;
+    
+    /* On-the-fly compression settings, shared by the file cache fills */
+    BoltCompressionConfig compression = compression_get_default_config();
+    compression.enabled = config->gzip_enabled;
+    compression.level = config->gzip_level;
+    compression.min_size = config->gzip_min_size;
+    compression.brotli_level = config->brotli_level;
+    compression.zstd_level = config->zstd_level;
+    memcpy(compression.preference, config->compression_order, sizeof(compression.preference));
+    compression.preferred_type = compression.preference[0];
+    compression_set_default_config(&compression);
+    server->compression_adaptive = config->compression_adaptive;
+    compression_adapt_init(&server->compression_adapt);
+    compression_set_load(BOLT_LOAD_NORMAL);
     server->running = false;
     server->stats_enabled = false;
     server->stats_interval_ms = 1000;
@@ -179,12 +326,23 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     if (num_threads < BOLT_MIN_THREADS) num_threads = BOLT_MIN_THREADS;
     if (num_threads > BOLT_MAX_THREADS) num_threads = BOLT_MAX_THREADS;
     
+    /* Event loop model */
+    int num_loops = 1;
+    if (config->reuseport) {
+#ifdef _WIN32
+        printf("  reuseport is not available with IOCP; using one shared loop\n");
+#else
+        num_loops = num_threads;
+#endif
+    }
+    
     printf("\n");
     printf("  ⚡ BOLT - High Performance HTTP Server\n");
     printf("  ==========================================\n");
     printf("  Version:    %s\n", BOLT_VERSION_STRING);
     printf("  CPU Cores:  %d\n", cpu_count);
     printf("  Threads:    %d\n", num_threads);
+    printf("  Loops:      %d (%s)\n", num_loops, num_loops > 1 ? "per worker" : "shared");
     printf("  ==========================================\n\n");
     
     /* Create memory pool */
@@ -199,9 +357,9 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     /* Create connection pool */
     int max_conns = config->max_connections > 0 ? config->max_connections : BOLT_MAX_CONNECTIONS;
     printf("  [2/6] Creating connection pool (%d connections)...\n", max_conns);
-    server->conn_pool = bolt_conn_pool_create(max_conns);
-    if (!server->conn_pool) {
+    if (!create_conn_pools(server, max_conns, num_loops)) {
         BOLT_ERROR("Failed to create connection pool");
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -210,6 +368,29 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     /* Create small file cache */
     if (config->enable_file_cache) {
         server->file_cache = bolt_file_cache_create(BOLT_FILE_CACHE_CAPACITY, BOLT_FILE_CACHE_MAX_TOTAL_BYTES);
+        if (server->file_cache &&
+            !bolt_file_cache_start_loaders(server->file_cache, BOLT_FILE_CACHE_LOADERS)) {
+            BOLT_ERROR("Failed to start file cache loaders, filling on misses");
+        }
+    }
+
+    /* Create open-file and stat cache */
+    if (config->enable_open_file_cache) {
+        server->open_file_cache = bolt_open_file_cache_create(BOLT_OPEN_FILE_CACHE_CAPACITY,
+                                                              config->open_file_cache_valid_ms);
+    }
+
+    /* Create resolved-path cache (trusted as long as stat results) */
+    if (config->enable_path_cache) {
+        server->path_cache = bolt_path_cache_create(BOLT_PATH_CACHE_CAPACITY,
+                                                    config->open_file_cache_valid_ms);
+    }
+
+    /* Create negative cache for 403/404 outcomes (same TTL, kept apart so
+     * scanners cannot evict real resolutions) */
+    if (config->enable_negative_cache) {
+        server->negative_cache = bolt_path_cache_create(BOLT_NEGATIVE_CACHE_CAPACITY,
+                                                        config->open_file_cache_valid_ms);
     }
 
     /* Create rate limiter */
@@ -217,7 +398,10 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     if (!server->rate_limiter) {
         BOLT_ERROR("Failed to create rate limiter");
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -229,7 +413,10 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
         BOLT_ERROR("Failed to create virtual host manager");
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -242,7 +429,10 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
         vhost_manager_destroy(server->vhost_manager);
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -256,7 +446,10 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
         vhost_manager_destroy(server->vhost_manager);
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -272,7 +465,10 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
         vhost_manager_destroy(server->vhost_manager);
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -280,16 +476,19 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
 
     /* Create IOCP */
     printf("  [4/6] Initializing IOCP on port %d...\n", config->port);
-    server->iocp = bolt_iocp_create(config->port, num_threads * 2);
-    if (!server->iocp) {
+    if (!create_loops(server, config->port, num_threads)) {
         BOLT_ERROR("Failed to create IOCP");
+        destroy_loops(server);
         logger_destroy(server->logger);
         proxy_config_destroy(server->proxy_config);
         rewrite_engine_destroy(server->rewrite_engine);
         vhost_manager_destroy(server->vhost_manager);
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
@@ -298,31 +497,95 @@ BoltServer* bolt_server_create_with_config(const BoltConfig* config) {
     /* Set global reference before creating thread pool */
     g_bolt_server = server;
     
+    /* Compute threads take compression off the workers (not fatal: the
+     * workers then compress inline) */
+    int compute_threads = config->compute_threads == 0 ? cpu_count : config->compute_threads;
+    if (compute_threads > BOLT_TASK_MAX_THREADS) compute_threads = BOLT_TASK_MAX_THREADS;
+    if (compute_threads > 0) {
+        server->task_pool = bolt_task_pool_create(compute_threads);
+        if (!server->task_pool) {
+            BOLT_ERROR("Failed to start compute threads, compressing inline");
+        }
+    }
+    
     /* Create thread pool */
-    printf("  [6/6] Starting %d worker threads...\n", num_threads);
-    server->thread_pool = bolt_threadpool_create(server->iocp->handle, num_threads);
+    printf("  [6/6] Starting %d worker threads (%d compute)...\n", num_threads,
+           server->task_pool ? compute_threads : 0);
+    server->thread_pool = bolt_threadpool_create(server->loops, server->conn_pools, num_loops,
+                                                 num_threads, config->worker_cpu_affinity);
     if (!server->thread_pool) {
         BOLT_ERROR("Failed to create thread pool");
+        bolt_task_pool_destroy(server->task_pool);
         logger_destroy(server->logger);
         proxy_config_destroy(server->proxy_config);
         rewrite_engine_destroy(server->rewrite_engine);
         vhost_manager_destroy(server->vhost_manager);
         g_bolt_server = NULL;
-        bolt_iocp_destroy(server->iocp);
+        destroy_loops(server);
         bolt_rate_limiter_destroy(server->rate_limiter);
         if (server->file_cache) bolt_file_cache_destroy(server->file_cache);
-        bolt_conn_pool_destroy(server->conn_pool);
+        if (server->open_file_cache) bolt_open_file_cache_destroy(server->open_file_cache);
+        if (server->path_cache) bolt_path_cache_destroy(server->path_cache);
+        if (server->negative_cache) bolt_path_cache_destroy(server->negative_cache);
+        destroy_conn_pools(server);
         bolt_pool_destroy(server->mem_pool);
         free(server);
         return NULL;
     }
     
+    /* Follow file changes (not fatal: the caches fall back to their TTL) */
+    if (config->enable_fs_watch &&
+        (server->file_cache || server->open_file_cache || server->path_cache ||
+         server->negative_cache)) {
+        start_fs_watch(server);
+    }
+
     server->start_time = GetTickCount64();
+    server->adapt_sampled_ms = server->start_time;
+    server->adapt_cpu_us = bolt_threadpool_cpu_us(server->thread_pool);
     server->running = true;
     
     return server;
 }
 
+/*
+ * Sample the load and let the controller set compression levels; while
+ * quiet, recompress cached variants that were filled at lower levels.
+ */
+static void adapt_compression(BoltServer* server) {
+    ULONGLONG now = GetTickCount64();
+    LONG64 cpu_us = bolt_threadpool_cpu_us(server->thread_pool);
+    ULONGLONG elapsed_ms = now - server->adapt_sampled_ms;
+    LONG64 used_us = cpu_us - server->adapt_cpu_us;
+    server->adapt_sampled_ms = now;
+    server->adapt_cpu_us = cpu_us;
+    
+    /* Workers beyond the core count cannot add utilization */
+    int cores = server->thread_pool ? server->thread_pool->num_workers : 0;
+    if (cores > bolt_get_cpu_count()) cores = bolt_get_cpu_count();
+    if (elapsed_ms == 0 || cores <= 0) return;
+    
+    LONG64 percent = used_us / 10 / (LONG64)elapsed_ms / cores;
+    if (percent > 100) percent = 100;
+    if (percent < 0) percent = 0;
+    
+    int compute_threads;
+    LONG queued;
+    bolt_task_pool_stats(server->task_pool, &compute_threads, NULL, NULL, NULL, &queued);
+    
+    BoltLoadLevel before = server->compression_adapt.load;
+    BoltLoadLevel load = compression_adapt_update(&server->compression_adapt, (int)percent,
+                                                  queued, compute_threads);
+    if (load != before) {
+        BOLT_LOG("Compression load %s -> %s (workers at %d%% CPU, %ld jobs waiting)",
+                 compression_load_name(before), compression_load_name(load),
+                 (int)percent, (long)queued);
+    }
+    if (load == BOLT_LOAD_QUIET) {
+        bolt_file_cache_upgrade(server->file_cache, BOLT_ADAPT_UPGRADES);
+    }
+}
+
 /*
  * Run the server.
  */
@@ -341,10 +604,21 @@ void bolt_server_run(BoltServer* server) {
     printf("  ==========================================\n\n");
     
     /* Main thread can do periodic tasks while workers handle requests */
+    ULONGLONG next_stats = GetTickCount64() + server->stats_interval_ms;
     while (server->running) {
-        Sleep(server->stats_interval_ms);
-        if (server->stats_enabled) {
+        DWORD sleep_ms = server->compression_adaptive ? BOLT_ADAPT_INTERVAL_MS
+                                                      : server->stats_interval_ms;
+        if (server->stats_enabled && server->stats_interval_ms < sleep_ms) {
+            sleep_ms = server->stats_interval_ms;
+        }
+        Sleep(sleep_ms);
+        
+        if (server->compression_adaptive) {
+            adapt_compression(server);
+        }
+        if (server->stats_enabled && GetTickCount64() >= next_stats) {
             bolt_server_print_stats(server);
+            next_stats = GetTickCount64() + server->stats_interval_ms;
         }
     }
 }
@@ -357,8 +631,10 @@ void bolt_server_stop(BoltServer* server) {
         printf("\n  Shutting down Bolt...\n");
         server->running = false;
         
-        if (server->iocp) {
-            server->iocp->running = false;
+        for (int i = 0; i < server->num_loops; i++) {
+            if (server->loops && server->loops[i]) {
+                server->loops[i]->running = false;
+            }
         }
     }
 }
@@ -373,20 +649,24 @@ void bolt_server_destroy(BoltServer* server) {
     server->running = false;
     
     /* Destroy in reverse order of creation */
+    /* No invalidation may run once the caches go */
+    bolt_fs_watch_destroy(server->fs_watch);
+    server->fs_watch = NULL;
+
     printf("  Stopping worker threads...\n");
     if (server->thread_pool) {
         bolt_threadpool_destroy(server->thread_pool);
     }
     
+    /* After the workers, the only submitters; jobs still queued are dropped */
+    bolt_task_pool_destroy(server->task_pool);
+    server->task_pool = NULL;
+    
     printf("  Closing IOCP...\n");
-    if (server->iocp) {
-        bolt_iocp_destroy(server->iocp);
-    }
+    destroy_loops(server);
     
     printf("  Releasing connections...\n");
-    if (server->conn_pool) {
-        bolt_conn_pool_destroy(server->conn_pool);
-    }
+    destroy_conn_pools(server);
     
     printf("  Freeing memory pool...\n");
     if (server->mem_pool) {
@@ -397,6 +677,21 @@ void bolt_server_destroy(BoltServer* server) {
         bolt_file_cache_destroy(server->file_cache);
         server->file_cache = NULL;
     }
+
+    if (server->open_file_cache) {
+        bolt_open_file_cache_destroy(server->open_file_cache);
+        server->open_file_cache = NULL;
+    }
+
+    if (server->path_cache) {
+        bolt_path_cache_destroy(server->path_cache);
+        server->path_cache = NULL;
+    }
+
+    if (server->negative_cache) {
+        bolt_path_cache_destroy(server->negative_cache);
+        server->negative_cache = NULL;
+    }
     
     if (server->rate_limiter) {
         bolt_rate_limiter_destroy(server->rate_limiter);
@@ -444,7 +739,43 @@ void bolt_server_print_stats(BoltServer* server) {
     printf("  Requests:   %lld (%.1f req/sec)\n", total_requests, rps);
     printf("  Sent:       %.2f MB\n", bytes_sent / (1024.0 * 1024.0));
     printf("  Received:   %.2f MB\n", bytes_received / (1024.0 * 1024.0));
-    printf("  Active:     %ld connections\n", server->conn_pool->active_count);
+    printf("  Active:     %ld connections\n", bolt_server_active_connections(server));
     printf("  =========================\n");
 }
 
+/*
+ * Active connections across all loops.
+ */
+LONG bolt_server_active_connections(BoltServer* server) {
+    LONG active = 0;
+    if (!server || !server->conn_pools) return 0;
+    for (int i = 0; i < server->num_loops; i++) {
+        active += server->conn_pools[i]->active_count;
+    }
+    return active;
+}
+
+/*
+ * Connection capacity across all loops.
+ */
+int bolt_server_max_connections(BoltServer* server) {
+    int capacity = 0;
+    if (!server || !server->conn_pools) return 0;
+    for (int i = 0; i < server->num_loops; i++) {
+        capacity += server->conn_pools[i]->capacity;
+    }
+    return capacity;
+}
+
+/*
+ * I/O syscalls (or IOCP calls) issued by all loops.
+ */
+LONG64 bolt_server_io_syscalls(BoltServer* server) {
+    LONG64 syscalls = 0;
+    if (!server || !server->loops) return 0;
+    for (int i = 0; i < server->num_loops; i++) {
+        syscalls += server->loops[i]->syscalls;
+    }
+    return syscalls;
+}
+
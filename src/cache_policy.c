@@ -0,0 +1,219 @@
+#include "../include/cache_policy.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void list_init(BoltS3Node* head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static void list_unlink(BoltS3Node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+static void list_push(BoltS3Node* head, BoltS3Node* node) {
+    node->prev = head;
+    node->next = head->next;
+    head->next->prev = node;
+    head->next = node;
+}
+
+/*
+ * Link a node into a queue and charge its bytes there.
+ */
+static void queue_push(BoltS3Fifo* policy, BoltS3Node* node, BoltS3FifoQueue queue) {
+    node->queue = queue;
+    if (queue == BOLT_S3FIFO_SMALL) {
+        list_push(&policy->small, node);
+        policy->small_bytes += node->bytes;
+        policy->small_entries++;
+    } else {
+        list_push(&policy->main, node);
+        policy->main_bytes += node->bytes;
+    }
+}
+
+static void queue_unlink(BoltS3Fifo* policy, BoltS3Node* node) {
+    if (node->queue == BOLT_S3FIFO_SMALL) {
+        policy->small_bytes -= node->bytes;
+        policy->small_entries--;
+    } else {
+        policy->main_bytes -= node->bytes;
+    }
+    list_unlink(node);
+    node->queue = BOLT_S3FIFO_NONE;
+}
+
+/*
+ * Remember an evicted key. The ring slot being overwritten forgets the
+ * oldest ghost, unless its filter slot has been reused since.
+ */
+static void ghost_add(BoltS3Fifo* policy, uint32_t hash) {
+    if (hash == 0) return;  /* 0 marks an empty slot */
+
+    uint32_t oldest = policy->ghost_ring[policy->ghost_head];
+    if (oldest) {
+        uint32_t* slot = &policy->ghost_filter[oldest & policy->ghost_filter_mask];
+        if (*slot == oldest) *slot = 0;
+    }
+
+    policy->ghost_ring[policy->ghost_head] = hash;
+    policy->ghost_head = (policy->ghost_head + 1) % policy->ghost_capacity;
+    policy->ghost_filter[hash & policy->ghost_filter_mask] = hash;
+}
+
+/*
+ * Check for and consume a ghost.
+ */
+static bool ghost_take(BoltS3Fifo* policy, uint32_t hash) {
+    uint32_t* slot = &policy->ghost_filter[hash & policy->ghost_filter_mask];
+    if (hash == 0 || *slot != hash) return false;
+    *slot = 0;
+    return true;
+}
+
+/*
+ * Initialize policy.
+ */
+bool bolt_s3fifo_init(BoltS3Fifo* policy, size_t max_bytes, size_t max_entries) {
+    if (!policy || max_bytes == 0 || max_entries == 0) return false;
+
+    memset(policy, 0, sizeof(*policy));
+    list_init(&policy->small);
+    list_init(&policy->main);
+    policy->max_bytes = max_bytes;
+    policy->max_entries = max_entries;
+
+    /* As many ghosts as live entries; filter at <= 50% load */
+    size_t filter_size = 1;
+    while (filter_size < max_entries * 2) filter_size <<= 1;
+
+    policy->ghost_capacity = max_entries;
+    policy->ghost_ring = (uint32_t*)calloc(max_entries, sizeof(uint32_t));
+    policy->ghost_filter = (uint32_t*)calloc(filter_size, sizeof(uint32_t));
+    policy->ghost_filter_mask = filter_size - 1;
+    if (!policy->ghost_ring || !policy->ghost_filter) {
+        bolt_s3fifo_destroy(policy);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Destroy policy.
+ */
+void bolt_s3fifo_destroy(BoltS3Fifo* policy) {
+    if (!policy) return;
+
+    free(policy->ghost_ring);
+    free(policy->ghost_filter);
+    policy->ghost_ring = NULL;
+    policy->ghost_filter = NULL;
+}
+
+/*
+ * Record a hit. Lookups do not hold the owner's lock, so bump atomically.
+ */
+void bolt_s3fifo_hit(BoltS3Node* node) {
+    if (!node) return;
+
+    LONG freq = node->freq;
+    while (freq < BOLT_S3FIFO_MAX_FREQ) {
+        LONG seen = InterlockedCompareExchange(&node->freq, freq + 1, freq);
+        if (seen == freq) break;
+        freq = seen;
+    }
+}
+
+/*
+ * Check capacity.
+ */
+bool bolt_s3fifo_full(const BoltS3Fifo* policy, size_t bytes) {
+    if (!policy) return false;
+
+    size_t used = policy->small_bytes + policy->main_bytes;
+    return policy->entries >= policy->max_entries ||
+           bytes > policy->max_bytes - (used < policy->max_bytes ? used : policy->max_bytes);
+}
+
+/*
+ * Link a new node.
+ */
+void bolt_s3fifo_insert(BoltS3Fifo* policy, BoltS3Node* node) {
+    if (!policy || !node) return;
+
+    InterlockedExchange(&node->freq, 0);
+    if (ghost_take(policy, node->hash)) {
+        policy->ghost_hits++;
+        queue_push(policy, node, BOLT_S3FIFO_MAIN);
+    } else {
+        queue_push(policy, node, BOLT_S3FIFO_SMALL);
+    }
+    policy->entries++;
+}
+
+/*
+ * Unlink a node.
+ */
+void bolt_s3fifo_remove(BoltS3Fifo* policy, BoltS3Node* node) {
+    if (!policy || !node || node->queue == BOLT_S3FIFO_NONE) return;
+
+    queue_unlink(policy, node);
+    policy->entries--;
+}
+
+/*
+ * Pick and unlink a victim.
+ */
+BoltS3Node* bolt_s3fifo_evict(BoltS3Fifo* policy) {
+    if (!policy) return NULL;
+
+    /* Small is over its share by bytes or by count, whichever binds */
+    size_t small_bytes_target = policy->max_bytes / 100 * BOLT_S3FIFO_SMALL_PERCENT;
+    size_t small_entries_target = policy->max_entries / 100 * BOLT_S3FIFO_SMALL_PERCENT;
+    if (small_entries_target == 0) small_entries_target = 1;
+
+    /* Each pass either evicts, promotes out of small, or spends one unit
+     * of a main entry's frequency, so the loop is bounded */
+    for (;;) {
+        bool small_empty = policy->small.next == &policy->small;
+        bool main_empty = policy->main.next == &policy->main;
+        if (small_empty && main_empty) return NULL;
+
+        if (!small_empty && (policy->small_bytes >= small_bytes_target ||
+                             policy->small_entries >= small_entries_target || main_empty)) {
+            BoltS3Node* node = policy->small.prev;
+            queue_unlink(policy, node);
+
+            if (node->freq > 0) {
+                /* Hit while on probation: keep it */
+                InterlockedExchange(&node->freq, 0);
+                queue_push(policy, node, BOLT_S3FIFO_MAIN);
+                policy->promotions++;
+                continue;
+            }
+
+            ghost_add(policy, node->hash);
+            policy->entries--;
+            policy->evictions++;
+            return node;
+        }
+
+        BoltS3Node* node = policy->main.prev;
+        queue_unlink(policy, node);
+
+        if (node->freq > 0) {
+            InterlockedDecrement(&node->freq);
+            queue_push(policy, node, BOLT_S3FIFO_MAIN);
+            continue;
+        }
+
+        policy->entries--;
+        policy->evictions++;
+        return node;
+    }
+}
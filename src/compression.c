@@ -16,54 +16,228 @@
 #define HAVE_ZLIB 0
 #endif
 
+/* Brotli and zstd encoders, likewise optional */
+#if __has_include(<brotli/encode.h>)
+#include <brotli/encode.h>
+#define HAVE_BROTLI 1
+#else
+#define HAVE_BROTLI 0
+#endif
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define HAVE_ZSTD 1
+#else
+#define HAVE_ZSTD 0
+#endif
+
+#define CONTEXTS_IDLE_MAX 4             /* Idle contexts kept per coding and thread */
+#define CONTEXT_BLOCKS 32               /* br allocations kept per context */
+#define LEVEL_FAST 1                    /* Every coding's fastest level that still pays */
+
+static BoltCompressionConfig g_config = {
+    .enabled = true,
+    .level = 6,  /* Good balance between speed and compression */
+    .brotli_level = 5,  /* Smaller than gzip -6 at similar speed */
+    .zstd_level = 3,
+    .min_size = 256,  /* Don't compress very small files */
+    .preferred_type = BOLT_COMPRESS_BROTLI,
+    .preference = { BOLT_COMPRESS_BROTLI, BOLT_COMPRESS_ZSTD, BOLT_COMPRESS_GZIP,
+                    BOLT_COMPRESS_DEFLATE, BOLT_COMPRESS_NONE }
+};
+
 /*
  * Get default compression config.
  */
 BoltCompressionConfig compression_get_default_config(void) {
-    BoltCompressionConfig config = {
-        .enabled = true,
-        .level = 6,  /* Good balance between speed and compression */
-        .min_size = 256,  /* Don't compress very small files */
-        .preferred_type = BOLT_COMPRESS_GZIP
-    };
-    return config;
+    return g_config;
 }
 
 /*
- * Parse Accept-Encoding header and determine best compression type.
+ * Replace the server-wide compression config.
  */
-BoltCompressionType compression_parse_accept_encoding(const char* accept_encoding,
-                                                       const BoltCompressionConfig* config) {
-    if (!accept_encoding || !config || !config->enabled) {
-        return BOLT_COMPRESS_NONE;
+void compression_set_default_config(const BoltCompressionConfig* config) {
+    if (config) {
+        g_config = *config;
     }
+}
+
+const char* compression_coding_name(BoltCompressionType type) {
+    switch (type) {
+        case BOLT_COMPRESS_GZIP:    return "gzip";
+        case BOLT_COMPRESS_DEFLATE: return "deflate";
+        case BOLT_COMPRESS_BROTLI:  return "br";
+        case BOLT_COMPRESS_ZSTD:    return "zstd";
+        default:                    return NULL;
+    }
+}
+
+bool compression_available(BoltCompressionType type) {
+    switch (type) {
+        case BOLT_COMPRESS_GZIP:
+        case BOLT_COMPRESS_DEFLATE: return HAVE_ZLIB;
+        case BOLT_COMPRESS_BROTLI:  return HAVE_BROTLI;
+        case BOLT_COMPRESS_ZSTD:    return HAVE_ZSTD;
+        default:                    return false;
+    }
+}
+
+/* Load level set by the adaptive controller, and what it turned away */
+static volatile LONG g_load = BOLT_LOAD_NORMAL;
+static volatile LONG64 g_shed;
+
+void compression_set_load(BoltLoadLevel load) {
+    if (load < BOLT_LOAD_QUIET || load > BOLT_LOAD_OVERLOAD) load = BOLT_LOAD_NORMAL;
+    InterlockedExchange(&g_load, (LONG)load);
+}
+
+BoltLoadLevel compression_load(void) {
+    return (BoltLoadLevel)g_load;
+}
+
+const char* compression_load_name(BoltLoadLevel load) {
+    switch (load) {
+        case BOLT_LOAD_QUIET:    return "quiet";
+        case BOLT_LOAD_NORMAL:   return "normal";
+        case BOLT_LOAD_BUSY:     return "busy";
+        case BOLT_LOAD_OVERLOAD: return "overload";
+        default:                 return "unknown";
+    }
+}
+
+static int configured_level(const BoltCompressionConfig* config, BoltCompressionType type) {
+    if (!config) config = &g_config;
+    switch (type) {
+        case BOLT_COMPRESS_BROTLI: return config->brotli_level;
+        case BOLT_COMPRESS_ZSTD:   return config->zstd_level;
+        default:                   return config->level;
+    }
+}
+
+int compression_best_level(BoltCompressionType type) {
+    switch (type) {
+        case BOLT_COMPRESS_BROTLI: return 11;
+        case BOLT_COMPRESS_ZSTD:   return 19;
+        default:                   return 9;
+    }
+}
+
+int compression_level(const BoltCompressionConfig* config, BoltCompressionType type) {
+    int level = configured_level(config, type);
+    if (g_load >= BOLT_LOAD_BUSY && level > LEVEL_FAST) {
+        level = LEVEL_FAST;
+    }
+    return level;
+}
+
+int compression_stored_level(const BoltCompressionConfig* config, BoltCompressionType type) {
+    int level = compression_level(config, type);
+    if (g_load == BOLT_LOAD_QUIET && level < compression_best_level(type)) {
+        level = compression_best_level(type);
+    }
+    return level;
+}
+
+bool compression_overloaded(void) {
+    if (g_load != BOLT_LOAD_OVERLOAD) return false;
+    InterlockedIncrement64(&g_shed);
+    return true;
+}
+
+LONG64 compression_shed_count(void) {
+    return g_shed;
+}
+
+/*
+ * q-value of a coding in an Accept-Encoding header: its own element, else
+ * the "*" element, else -1 (not acceptable at all).
+ */
+static double coding_quality(const char* accept_encoding, const char* coding) {
+    size_t coding_len = strlen(coding);
+    double wildcard = -1.0;
+    const char* p = accept_encoding;
     
-#if !HAVE_ZLIB
-    /* Compression not available if zlib not found */
-    return BOLT_COMPRESS_NONE;
-#endif
-    
-    /* Case-insensitive search for supported encodings */
-    char lower[256];
-    size_t len = strlen(accept_encoding);
-    if (len >= sizeof(lower)) len = sizeof(lower) - 1;
+    while (*p) {
+        /* One "name;q=value" element */
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        const char* name = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') p++;
+        size_t name_len = (size_t)(p - name);
+        
+        double q = 1.0;
+        const char* end = strchr(p, ',');
+        if (!end) end = p + strlen(p);
+        const char* q_param = p;
+        while ((q_param = strchr(q_param, ';')) != NULL && q_param < end) {
+            q_param++;
+            while (*q_param == ' ' || *q_param == '\t') q_param++;
+            if ((q_param[0] == 'q' || q_param[0] == 'Q') && q_param[1] == '=') {
+                q = atof(q_param + 2);
+            }
+        }
+        p = end;
+        
+        if (name_len == coding_len && _strnicmp(name, coding, coding_len) == 0) {
+            return q;
+        }
+        if (name_len == 1 && name[0] == '*') {
+            wildcard = q;
+        }
+    }
     
-    for (size_t i = 0; i < len; i++) {
-        lower[i] = (char)tolower((unsigned char)accept_encoding[i]);
+    return wildcard;
+}
+
+/*
+ * Check whether an Accept-Encoding header allows a content-coding.
+ */
+bool compression_accepts(const char* accept_encoding, const char* coding) {
+    if (!accept_encoding || !coding) {
+        return false;
+    }
+    return coding_quality(accept_encoding, coding) > 0.0;
+}
+
+BoltCompressionType compression_negotiate(const char* accept_encoding,
+                                          const BoltCompressionType* candidates,
+                                          size_t count) {
+    if (!accept_encoding || !candidates) {
+        return BOLT_COMPRESS_NONE;
     }
-    lower[len] = '\0';
     
-    /* Check for gzip (preferred) */
-    if (strstr(lower, "gzip") != NULL) {
-        return BOLT_COMPRESS_GZIP;
+    BoltCompressionType best = BOLT_COMPRESS_NONE;
+    double best_q = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        const char* name = compression_coding_name(candidates[i]);
+        if (!name) continue;
+        double q = coding_quality(accept_encoding, name);
+        if (q > best_q) {
+            best = candidates[i];
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+/*
+ * Parse Accept-Encoding header and determine best compression type.
+ */
+BoltCompressionType compression_parse_accept_encoding(const char* accept_encoding,
+                                                       const BoltCompressionConfig* config) {
+    if (!accept_encoding || !config || !config->enabled) {
+        return BOLT_COMPRESS_NONE;
     }
     
-    /* Check for deflate */
-    if (strstr(lower, "deflate") != NULL) {
-        return BOLT_COMPRESS_DEFLATE;
+    /* Server preference, limited to what this build can produce */
+    BoltCompressionType candidates[BOLT_COMPRESS_TYPES];
+    size_t count = 0;
+    for (size_t i = 0; i < BOLT_COMPRESS_TYPES && config->preference[i] != BOLT_COMPRESS_NONE; i++) {
+        if (compression_available(config->preference[i])) {
+            candidates[count++] = config->preference[i];
+        }
     }
     
-    return BOLT_COMPRESS_NONE;
+    return compression_negotiate(accept_encoding, candidates, count);
 }
 
 /*
@@ -106,76 +280,474 @@ bool compression_should_compress(const char* content_type, const BoltCompression
     return false;
 }
 
+/*
+ * Encoder contexts. Creating one costs about 256 KB of zlib state (more
+ * for br), so each thread keeps idle contexts per coding and resets them
+ * for the next response instead. A context is lent to one response at a
+ * time, whole (one-shot) or chunk by chunk (stream); a stream may end on
+ * another thread, whose pool then takes the context.
+ */
+struct BoltCompressStream {
+    BoltCompressionType type;
+    int level;
+    bool done;
+#if HAVE_ZLIB
+    bool zlib_ready;
+    z_stream zlib;
+#endif
+#if HAVE_BROTLI
+    BrotliEncoderState* brotli;
+    /* Blocks freed by the previous encoder state, handed to the next:
+     * br has no reset, but its allocations repeat */
+    void* blocks[CONTEXT_BLOCKS];
+    int block_count;
+#endif
+#if HAVE_ZSTD
+    ZSTD_CCtx* zstd;
+#endif
+    struct BoltCompressStream* next;   /* Idle list */
+};
+
+typedef struct {
+    BoltCompressStream* idle[BOLT_COMPRESS_TYPES];
+    int idle_count[BOLT_COMPRESS_TYPES];
+    char* scratch;                      /* compression_compress_scratch() output */
+    size_t scratch_size;
+} ThreadContexts;
+
+static BOLT_THREAD_LOCAL ThreadContexts g_thread_contexts;
+static volatile LONG64 g_contexts_created = 0;
+static volatile LONG64 g_contexts_reused = 0;
+
+/* Window for br and zstd streams: 256 KB instead of their 4-8 MB defaults */
+#define STREAM_WINDOW_LOG 18
+
+#if HAVE_BROTLI
+/* Block header keeps the size, and the alignment malloc gives */
+#define BLOCK_HEADER 16
+
+static size_t block_size(void* block) {
+    return *(size_t*)block;
+}
+
+static void* block_alloc(void* opaque, size_t size) {
+    BoltCompressStream* context = (BoltCompressStream*)opaque;
+    
+    /* Best fit among the kept blocks, wasting at most half of it */
+    int best = -1;
+    for (int i = 0; i < context->block_count; i++) {
+        size_t have = block_size(context->blocks[i]);
+        if (have >= size && have / 2 <= size &&
+            (best < 0 || have < block_size(context->blocks[best]))) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        void* block = context->blocks[best];
+        context->blocks[best] = context->blocks[--context->block_count];
+        return (char*)block + BLOCK_HEADER;
+    }
+    
+    void* block = malloc(size + BLOCK_HEADER);
+    if (!block) return NULL;
+    *(size_t*)block = size;
+    return (char*)block + BLOCK_HEADER;
+}
+
+static void block_free(void* opaque, void* address) {
+    BoltCompressStream* context = (BoltCompressStream*)opaque;
+    if (!address) return;
+    
+    void* block = (char*)address - BLOCK_HEADER;
+    if (context->block_count < CONTEXT_BLOCKS) {
+        context->blocks[context->block_count++] = block;
+    } else {
+        free(block);
+    }
+}
+#endif
+
+static void context_destroy(BoltCompressStream* context) {
+#if HAVE_ZLIB
+    if (context->zlib_ready) {
+        deflateEnd(&context->zlib);
+    }
+#endif
+#if HAVE_BROTLI
+    if (context->brotli) {
+        BrotliEncoderDestroyInstance(context->brotli);
+    }
+    for (int i = 0; i < context->block_count; i++) {
+        free(context->blocks[i]);
+    }
+#endif
+#if HAVE_ZSTD
+    if (context->zstd) {
+        ZSTD_freeCCtx(context->zstd);
+    }
+#endif
+    free(context);
+}
+
+/*
+ * Ready a context for a new response at `level`. size_hint is the input
+ * size of a one-shot compression, 0 for a stream (capped window).
+ */
+static bool context_prepare(BoltCompressStream* context, int level, size_t size_hint) {
+    context->done = false;
+    
+    switch (context->type) {
 #if HAVE_ZLIB
+        case BOLT_COMPRESS_GZIP:
+        case BOLT_COMPRESS_DEFLATE:
+            if (level < 1) level = 1;
+            if (level > 9) level = 9;
+            if (!context->zlib_ready) {
+                /* windowBits 31 writes a gzip wrapper, 15 the zlib one "deflate" names */
+                if (deflateInit2(&context->zlib, level, Z_DEFLATED,
+                                 context->type == BOLT_COMPRESS_GZIP ? 31 : 15,
+                                 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    return false;
+                }
+                context->zlib_ready = true;
+            } else {
+                if (deflateReset(&context->zlib) != Z_OK) return false;
+                if (level != context->level &&
+                    deflateParams(&context->zlib, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    return false;
+                }
+            }
+            context->level = level;
+            return true;
+#endif
+#if HAVE_BROTLI
+        case BOLT_COMPRESS_BROTLI: {
+            if (level < BROTLI_MIN_QUALITY) level = BROTLI_MIN_QUALITY;
+            if (level > BROTLI_MAX_QUALITY) level = BROTLI_MAX_QUALITY;
+            
+            /* Window just large enough for a one-shot input, as
+             * BrotliEncoderCompress picks it */
+            int window = STREAM_WINDOW_LOG;
+            if (size_hint > 0) {
+                window = BROTLI_MIN_WINDOW_BITS;
+                while (window < BROTLI_DEFAULT_WINDOW && ((size_t)1 << window) < size_hint) {
+                    window++;
+                }
+            }
+            
+            if (context->brotli) {
+                BrotliEncoderDestroyInstance(context->brotli);
+            }
+            context->brotli = BrotliEncoderCreateInstance(block_alloc, block_free, context);
+            context->level = level;
+            return context->brotli &&
+                   BrotliEncoderSetParameter(context->brotli, BROTLI_PARAM_QUALITY, (uint32_t)level) &&
+                   BrotliEncoderSetParameter(context->brotli, BROTLI_PARAM_LGWIN, (uint32_t)window) &&
+                   BrotliEncoderSetParameter(context->brotli, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT) &&
+                   (size_hint == 0 || size_hint > (1u << 30) ||
+                    BrotliEncoderSetParameter(context->brotli, BROTLI_PARAM_SIZE_HINT, (uint32_t)size_hint));
+        }
+#endif
+#if HAVE_ZSTD
+        case BOLT_COMPRESS_ZSTD:
+            if (level < 1) level = 1;
+            if (level > 19) level = 19;  /* 20+ want windows browsers may refuse */
+            if (!context->zstd) {
+                context->zstd = ZSTD_createCCtx();
+                if (!context->zstd) return false;
+            } else {
+                ZSTD_CCtx_reset(context->zstd, ZSTD_reset_session_and_parameters);
+            }
+            context->level = level;
+            return !ZSTD_isError(ZSTD_CCtx_setParameter(context->zstd, ZSTD_c_compressionLevel, level)) &&
+                   !ZSTD_isError(ZSTD_CCtx_setParameter(context->zstd, ZSTD_c_windowLog,
+                                                        size_hint == 0 ? STREAM_WINDOW_LOG : 0));
+#endif
+        default:
+            (void)level;
+            (void)size_hint;
+            return false;
+    }
+}
+
 /*
- * Compress data using gzip (zlib implementation).
+ * Take an idle context of the calling thread, or make one.
  */
-bool compression_gzip(const char* input, size_t input_size,
-                      BoltCompressedData* compressed_data,
-                      int level) {
-    if (!input || !compressed_data || input_size == 0) {
-        return false;
+static BoltCompressStream* context_acquire(BoltCompressionType type, int level, size_t size_hint) {
+    if (!compression_available(type)) {
+        return NULL;
     }
     
-    /* Validate compression level */
-    if (level < 1) level = 1;
-    if (level > 9) level = 9;
+    ThreadContexts* contexts = &g_thread_contexts;
+    BoltCompressStream* context = contexts->idle[type];
+    if (context) {
+        contexts->idle[type] = context->next;
+        contexts->idle_count[type]--;
+        InterlockedIncrement64(&g_contexts_reused);
+    } else {
+        context = (BoltCompressStream*)calloc(1, sizeof(BoltCompressStream));
+        if (!context) {
+            return NULL;
+        }
+        context->type = type;
+        InterlockedIncrement64(&g_contexts_created);
+    }
     
-    /* Estimate compressed size (usually smaller, but allocate more for safety) */
-    size_t dest_size = input_size + (input_size / 10) + 12;
-    char* dest = (char*)malloc(dest_size);
-    if (!dest) {
-        return false;
+    if (!context_prepare(context, level, size_hint)) {
+        context_destroy(context);
+        return NULL;
+    }
+    return context;
+}
+
+/*
+ * Return a context to the calling thread's idle list.
+ */
+static void context_release(BoltCompressStream* context) {
+    ThreadContexts* contexts = &g_thread_contexts;
+    if (contexts->idle_count[context->type] >= CONTEXTS_IDLE_MAX) {
+        context_destroy(context);
+        return;
+    }
+    context->next = contexts->idle[context->type];
+    contexts->idle[context->type] = context;
+    contexts->idle_count[context->type]++;
+}
+
+BoltCompressStream* compression_stream_create(BoltCompressionType type, int level) {
+    return context_acquire(type, level, 0);
+}
+
+bool compression_stream_write(BoltCompressStream* stream,
+                              const char* in, size_t in_len, size_t* consumed,
+                              char* out, size_t out_size, size_t* produced,
+                              bool finish, bool* done) {
+    *consumed = 0;
+    *produced = 0;
+    *done = stream->done;
+    if (stream->done) {
+        return true;
     }
     
-    z_stream stream;
-    memset(&stream, 0, sizeof(stream));
+    switch (stream->type) {
+#if HAVE_ZLIB
+        case BOLT_COMPRESS_GZIP:
+        case BOLT_COMPRESS_DEFLATE: {
+            stream->zlib.next_in = (Bytef*)in;
+            stream->zlib.avail_in = (uInt)in_len;
+            stream->zlib.next_out = (Bytef*)out;
+            stream->zlib.avail_out = (uInt)out_size;
+            int ret = deflate(&stream->zlib, finish ? Z_FINISH : Z_NO_FLUSH);
+            *consumed = in_len - stream->zlib.avail_in;
+            *produced = out_size - stream->zlib.avail_out;
+            if (ret == Z_STREAM_END) {
+                stream->done = true;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                return false;  /* Z_BUF_ERROR: no progress possible, not fatal */
+            }
+            break;
+        }
+#endif
+#if HAVE_BROTLI
+        case BOLT_COMPRESS_BROTLI: {
+            size_t avail_in = in_len;
+            const uint8_t* next_in = (const uint8_t*)in;
+            size_t avail_out = out_size;
+            uint8_t* next_out = (uint8_t*)out;
+            if (!BrotliEncoderCompressStream(stream->brotli,
+                                             finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS,
+                                             &avail_in, &next_in, &avail_out, &next_out, NULL)) {
+                return false;
+            }
+            *consumed = in_len - avail_in;
+            *produced = out_size - avail_out;
+            if (finish && BrotliEncoderIsFinished(stream->brotli)) {
+                stream->done = true;
+            }
+            break;
+        }
+#endif
+#if HAVE_ZSTD
+        case BOLT_COMPRESS_ZSTD: {
+            ZSTD_inBuffer input = { in, in_len, 0 };
+            ZSTD_outBuffer output = { out, out_size, 0 };
+            size_t left = ZSTD_compressStream2(stream->zstd, &output, &input,
+                                               finish ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(left)) {
+                return false;
+            }
+            *consumed = input.pos;
+            *produced = output.pos;
+            if (finish && left == 0) {
+                stream->done = true;
+            }
+            break;
+        }
+#endif
+        default:
+            (void)in; (void)in_len; (void)out; (void)out_size; (void)finish;
+            return false;
+    }
     
-    /* Initialize zlib with gzip format */
-    if (deflateInit2(&stream, level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
-        free(dest);
+    *done = stream->done;
+    return true;
+}
+
+void compression_stream_destroy(BoltCompressStream* stream) {
+    if (stream) {
+        context_release(stream);
+    }
+}
+
+/*
+ * Worst-case output size for `input_size` bytes in a coding.
+ */
+size_t compression_bound(BoltCompressionType type, size_t input_size) {
+    switch (type) {
+#if HAVE_ZLIB
+        case BOLT_COMPRESS_GZIP:
+        case BOLT_COMPRESS_DEFLATE:
+            return (size_t)compressBound((uLong)input_size) + 18;  /* gzip wrapper */
+#endif
+#if HAVE_BROTLI
+        case BOLT_COMPRESS_BROTLI:
+            return BrotliEncoderMaxCompressedSize(input_size);
+#endif
+#if HAVE_ZSTD
+        case BOLT_COMPRESS_ZSTD:
+            return ZSTD_compressBound(input_size);
+#endif
+        default:
+            (void)input_size;
+            return 0;
+    }
+}
+
+/*
+ * One-shot compression into a caller's buffer, with a pooled context.
+ */
+bool compression_compress_into(BoltCompressionType type,
+                               const char* input, size_t input_size,
+                               char* out, size_t out_size, size_t* out_len,
+                               int level) {
+    if (!input || !out || !out_len || input_size == 0) {
+        return false;
+    }
+    
+    BoltCompressStream* context = context_acquire(type, level, input_size);
+    if (!context) {
         return false;
     }
     
-    stream.next_in = (Bytef*)input;
-    stream.avail_in = (uInt)input_size;
-    stream.next_out = (Bytef*)dest;
-    stream.avail_out = (uInt)dest_size;
+    size_t in_pos = 0;
+    size_t written = 0;
+    bool done = false;
+    bool ok = true;
+    while (ok && !done) {
+        size_t consumed = 0;
+        size_t produced = 0;
+        ok = compression_stream_write(context, input + in_pos, input_size - in_pos, &consumed,
+                                      out + written, out_size - written, &produced,
+                                      true, &done);
+        in_pos += consumed;
+        written += produced;
+        if (!done && consumed == 0 && produced == 0) {
+            ok = false;  /* Output full */
+        }
+    }
     
-    /* Compress */
-    int ret = deflate(&stream, Z_FINISH);
+    context_release(context);
+    *out_len = written;
+    return ok && done;
+}
+
+/*
+ * One-shot compression into the calling thread's scratch buffer.
+ */
+const char* compression_compress_scratch(BoltCompressionType type,
+                                         const char* input, size_t input_size,
+                                         size_t* out_len, int level) {
+    size_t bound = compression_bound(type, input_size);
+    if (bound == 0) {
+        return NULL;
+    }
     
-    if (ret == Z_STREAM_END) {
-        /* Success - resize buffer to actual size */
-        size_t compressed_size = dest_size - stream.avail_out;
-        char* resized = (char*)realloc(dest, compressed_size);
-        if (resized) {
-            compressed_data->data = resized;
-            compressed_data->size = compressed_size;
-            compressed_data->type = BOLT_COMPRESS_GZIP;
-            deflateEnd(&stream);
-            return true;
+    ThreadContexts* contexts = &g_thread_contexts;
+    if (contexts->scratch_size < bound) {
+        char* grown = (char*)realloc(contexts->scratch, bound);
+        if (!grown) {
+            return NULL;
         }
+        contexts->scratch = grown;
+        contexts->scratch_size = bound;
     }
     
-    deflateEnd(&stream);
-    free(dest);
-    return false;
+    if (!compression_compress_into(type, input, input_size,
+                                   contexts->scratch, contexts->scratch_size, out_len, level)) {
+        return NULL;
+    }
+    return contexts->scratch;
 }
 
-#else
 /*
- * Compression not available - zlib not found.
- * Install zlib via MinGW package manager: pacman -S mingw-w64-x86_64-zlib
+ * Compress data into any supported coding, in a buffer of its own.
+ */
+bool compression_compress(BoltCompressionType type,
+                          const char* input, size_t input_size,
+                          BoltCompressedData* compressed_data,
+                          int level) {
+    if (!input || !compressed_data || input_size == 0) {
+        return false;
+    }
+    
+    size_t bound = compression_bound(type, input_size);
+    char* dest = bound > 0 ? (char*)malloc(bound) : NULL;
+    if (!dest) {
+        return false;
+    }
+    
+    size_t written = 0;
+    if (!compression_compress_into(type, input, input_size, dest, bound, &written, level)) {
+        free(dest);
+        return false;
+    }
+    
+    /* Success - resize buffer to actual size */
+    char* resized = (char*)realloc(dest, written);
+    compressed_data->data = resized ? resized : dest;
+    compressed_data->size = written;
+    compressed_data->type = type;
+    return true;
+}
+
+/*
+ * Compress data using gzip.
  */
 bool compression_gzip(const char* input, size_t input_size,
                       BoltCompressedData* compressed_data,
                       int level) {
-    (void)input;
-    (void)input_size;
-    (void)compressed_data;
-    (void)level;
-    return false;
+    return compression_compress(BOLT_COMPRESS_GZIP, input, input_size, compressed_data, level);
+}
+
+/*
+ * Free the calling thread's idle contexts and scratch buffer.
+ */
+void compression_release_thread_contexts(void) {
+    ThreadContexts* contexts = &g_thread_contexts;
+    for (int type = 0; type < BOLT_COMPRESS_TYPES; type++) {
+        while (contexts->idle[type]) {
+            BoltCompressStream* context = contexts->idle[type];
+            contexts->idle[type] = context->next;
+            context_destroy(context);
+        }
+        contexts->idle_count[type] = 0;
+    }
+    free(contexts->scratch);
+    contexts->scratch = NULL;
+    contexts->scratch_size = 0;
 }
-#endif
 
+void compression_context_stats(LONG64* created, LONG64* reused) {
+    if (created) *created = g_contexts_created;
+    if (reused) *reused = g_contexts_reused;
+}
@@ -0,0 +1,53 @@
+#include "../include/compression_adapt.h"
+#include <string.h>
+
+void compression_adapt_init(BoltCompressionAdapt* adapt) {
+    if (!adapt) return;
+    memset(adapt, 0, sizeof(*adapt));
+    adapt->load = BOLT_LOAD_NORMAL;
+}
+
+BoltLoadLevel compression_adapt_target(int utilization, LONG queued, int compute_threads) {
+    /* Without a pool, queued jobs are not a signal; one per thread
+     * waiting means the pool is saturated */
+    LONG per_thread = compute_threads > 0 ? (LONG)compute_threads : 0;
+
+    if (utilization >= BOLT_ADAPT_OVERLOAD_UTIL ||
+        (per_thread > 0 && queued >= BOLT_ADAPT_OVERLOAD_QUEUE * per_thread)) {
+        return BOLT_LOAD_OVERLOAD;
+    }
+    if (utilization >= BOLT_ADAPT_BUSY_UTIL || (per_thread > 0 && queued >= per_thread)) {
+        return BOLT_LOAD_BUSY;
+    }
+    if (utilization < BOLT_ADAPT_QUIET_UTIL && queued == 0) {
+        return BOLT_LOAD_QUIET;
+    }
+    return BOLT_LOAD_NORMAL;
+}
+
+BoltLoadLevel compression_adapt_update(BoltCompressionAdapt* adapt, int utilization,
+                                       LONG queued, int compute_threads) {
+    if (!adapt) return compression_load();
+
+    BoltLoadLevel target = compression_adapt_target(utilization, queued, compute_threads);
+    adapt->utilization = utilization;
+    adapt->queued = queued;
+    adapt->samples++;
+
+    if (target > adapt->load) {
+        adapt->load = target;
+        adapt->calm = 0;
+        adapt->raised++;
+    } else if (target < adapt->load) {
+        if (++adapt->calm >= BOLT_ADAPT_CALM_SAMPLES) {
+            adapt->load = (BoltLoadLevel)(adapt->load - 1);
+            adapt->calm = 0;
+            adapt->lowered++;
+        }
+    } else {
+        adapt->calm = 0;
+    }
+
+    compression_set_load(adapt->load);
+    return adapt->load;
+}
@@ -108,6 +108,17 @@ static bool parse_config_line(BoltConfig* config, const char* line) {
         }
     } else if (strcmp(key, "max_connections") == 0) {
         config->max_connections = atoi(value);
+    } else if (strcmp(key, "reuseport") == 0) {
+        config->reuseport = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "worker_cpu_affinity") == 0) {
+        config->worker_cpu_affinity = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "compute_threads") == 0) {
+        if (strcmp(value, "auto") == 0) {
+            config->compute_threads = 0;
+        } else {
+            int threads = atoi(value);  /* "off" and 0 as well */
+            config->compute_threads = threads > 0 ? threads : -1;
+        }
     } else if (strcmp(key, "index") == 0 || strcmp(key, "index_file") == 0) {
         strncpy(config->index_file, value, sizeof(config->index_file) - 1);
         config->index_file[sizeof(config->index_file) - 1] = '\0';
@@ -120,6 +131,37 @@ static bool parse_config_line(BoltConfig* config, const char* line) {
         if (config->gzip_level > 9) config->gzip_level = 9;
     } else if (strcmp(key, "gzip_min_size") == 0) {
         config->gzip_min_size = (size_t)atoi(value);
+    } else if (strcmp(key, "brotli_level") == 0) {
+        config->brotli_level = atoi(value);
+        if (config->brotli_level < 0) config->brotli_level = 0;
+        if (config->brotli_level > 11) config->brotli_level = 11;
+    } else if (strcmp(key, "zstd_level") == 0) {
+        config->zstd_level = atoi(value);
+        if (config->zstd_level < 1) config->zstd_level = 1;
+        if (config->zstd_level > 19) config->zstd_level = 19;
+    } else if (strcmp(key, "compression_order") == 0) {
+        /* Space- or comma-separated codings, best first */
+        int count = 0;
+        char* token = strtok(value, " ,");
+        while (token && count < BOLT_COMPRESS_TYPES - 1) {
+            for (int t = BOLT_COMPRESS_GZIP; t < BOLT_COMPRESS_TYPES; t++) {
+                const char* name = compression_coding_name((BoltCompressionType)t);
+                if (name && strcmp(token, name) == 0) {
+                    config->compression_order[count++] = (BoltCompressionType)t;
+                    break;
+                }
+            }
+            token = strtok(NULL, " ,");
+        }
+        config->compression_order[count] = BOLT_COMPRESS_NONE;
+    } else if (strcmp(key, "gzip_static") == 0) {
+        config->gzip_static = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "brotli_static") == 0) {
+        config->brotli_static = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "zstd_static") == 0) {
+        config->zstd_static = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "compression_adaptive") == 0) {
+        config->compression_adaptive = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
     } else if (strcmp(key, "access_log") == 0) {
         strncpy(config->access_log_path, value, sizeof(config->access_log_path) - 1);
         config->access_log_path[sizeof(config->access_log_path) - 1] = '\0';
@@ -141,6 +183,16 @@ static bool parse_config_line(BoltConfig* config, const char* line) {
         config->enable_dir_listing = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
     } else if (strcmp(key, "enable_file_cache") == 0) {
         config->enable_file_cache = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "open_file_cache") == 0) {
+        config->enable_open_file_cache = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "open_file_cache_valid") == 0) {
+        config->open_file_cache_valid_ms = (DWORD)atoi(value) * 1000;
+    } else if (strcmp(key, "fs_watch") == 0) {
+        config->enable_fs_watch = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "path_cache") == 0) {
+        config->enable_path_cache = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
+    } else if (strcmp(key, "negative_cache") == 0) {
+        config->enable_negative_cache = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
     } else if (strcmp(key, "ssl") == 0 || strcmp(key, "tls") == 0 || strcmp(key, "tls_enabled") == 0) {
         config->tls_enabled = (strcmp(value, "on") == 0 || strcmp(value, "1") == 0);
     } else if (strcmp(key, "ssl_certificate") == 0 || strcmp(key, "tls_certificate") == 0) {
@@ -166,6 +218,9 @@ void config_load_defaults(BoltConfig* config) {
     config->bind_address[0] = '\0';  /* Empty = INADDR_ANY */
     config->worker_threads = 0;  /* Auto-detect */
     config->max_connections = BOLT_MAX_CONNECTIONS;
+    config->reuseport = false;
+    config->worker_cpu_affinity = false;
+    config->compute_threads = 0;  /* One per core */
     
     strncpy(config->web_root, DEFAULT_WEB_ROOT, sizeof(config->web_root) - 1);
     strncpy(config->index_file, DEFAULT_INDEX_FILE, sizeof(config->index_file) - 1);
@@ -174,6 +229,14 @@ void config_load_defaults(BoltConfig* config) {
     config->gzip_enabled = true;
     config->gzip_level = 6;
     config->gzip_min_size = 256;
+    BoltCompressionConfig compression = compression_get_default_config();
+    config->brotli_level = compression.brotli_level;
+    config->zstd_level = compression.zstd_level;
+    memcpy(config->compression_order, compression.preference, sizeof(config->compression_order));
+    config->gzip_static = true;
+    config->brotli_static = true;
+    config->zstd_static = true;
+    config->compression_adaptive = true;
     
     strncpy(config->access_log_path, DEFAULT_ACCESS_LOG, sizeof(config->access_log_path) - 1);
     strncpy(config->error_log_path, DEFAULT_ERROR_LOG, sizeof(config->error_log_path) - 1);
@@ -186,6 +249,11 @@ void config_load_defaults(BoltConfig* config) {
     
     config->enable_dir_listing = false;
     config->enable_file_cache = true;
+    config->enable_open_file_cache = true;
+    config->open_file_cache_valid_ms = BOLT_OPEN_FILE_CACHE_VALID_MS;
+    config->enable_fs_watch = true;
+    config->enable_path_cache = true;
+    config->enable_negative_cache = true;
     
     config->tls_enabled = false;
     config->tls_cert_file[0] = '\0';
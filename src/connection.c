@@ -3,8 +3,11 @@
 #include "../include/bolt_server.h"
 #include "../include/iocp.h"
 #include "../include/file_server.h"
+#include "../include/file_cache.h"
+#include "../include/file_sender.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 
 /* Forward declaration for rate limiter */
@@ -13,6 +16,12 @@ void bolt_rate_limiter_decrement(BoltRateLimiter* limiter, uint32_t ip);
 /* Global server reference */
 BoltServer* g_bolt_server = NULL;
 
+/* Sends posted, jobs handed to the compute pool and connections closed
+ * by this thread. Each hands the connection on (its completion may run
+ * on another worker at once), so the pipeline loop checks it before
+ * touching the connection again. */
+static BOLT_THREAD_LOCAL LONG g_conn_handoffs;
+
 /*
  * Create connection pool.
  */
@@ -39,6 +48,7 @@ BoltConnectionPool* bolt_conn_pool_create(int capacity) {
         pool->connections[i].state = BOLT_CONN_CLOSED;
         pool->connections[i].file_handle = INVALID_HANDLE_VALUE;
         pool->connections[i].next_free = pool->free_list;
+        pool->connections[i].pool = pool;
         pool->free_list = &pool->connections[i];
         
         /* Allocate buffers */
@@ -62,9 +72,7 @@ void bolt_conn_pool_destroy(BoltConnectionPool* pool) {
         if (pool->connections[i].socket != INVALID_SOCKET) {
             closesocket(pool->connections[i].socket);
         }
-        if (pool->connections[i].file_handle != INVALID_HANDLE_VALUE) {
-            CloseHandle(pool->connections[i].file_handle);
-        }
+        bolt_conn_close_file(&pool->connections[i]);
         _aligned_free(pool->connections[i].recv_buffer);
         _aligned_free(pool->connections[i].send_buffer);
     }
@@ -132,18 +140,29 @@ void bolt_conn_init(BoltConnection* conn, SOCKET socket, int arena_id) {
     conn->send_remaining = 0;
     
     /* Reset HTTP state */
-    memset(&conn->request, 0, sizeof(conn->request));
+    http_request_init(&conn->request);
+    conn->request_length = 0;
     conn->keep_alive = true;  /* Default to keep-alive */
     conn->requests_served = 0;
+    conn->pipelining = false;
+    conn->request_deferred = false;
+    conn->send_staged = 0;
+    conn->send_segment_count = 0;
+    conn->send_buffer_used = 0;
+    conn->send_ref_count = 0;
     
     /* Reset file state */
     conn->file_handle = INVALID_HANDLE_VALUE;
+    conn->open_file = NULL;
+    conn->stream = NULL;
+    conn->task.ready = false;
     conn->file_size = 0;
     conn->file_offset = 0;
     
     /* Timing */
     conn->connect_time = GetTickCount64();
     conn->last_activity = conn->connect_time;
+    conn->deadline = 0;
     
     /* Statistics */
     conn->bytes_received = 0;
@@ -156,27 +175,89 @@ void bolt_conn_init(BoltConnection* conn, SOCKET socket, int arena_id) {
     conn->send_overlapped.connection = conn;
 }
 
+/*
+ * Forget the last send's segments and release the cached responses it
+ * referenced.
+ */
+static void conn_release_send(BoltConnection* conn) {
+    for (int i = 0; i < conn->send_ref_count; i++) {
+        bolt_file_cache_release(g_bolt_server ? g_bolt_server->file_cache : NULL,
+                                conn->send_refs[i]);
+    }
+    conn->send_ref_count = 0;
+    conn->send_segment_count = 0;
+    conn->send_buffer_used = 0;
+}
+
+/*
+ * Drop the current request from recv_buffer, keeping the bytes of any
+ * requests pipelined behind it.
+ */
+static void conn_consume_request(BoltConnection* conn) {
+    size_t used = conn->request_length;
+    if (used > 0 && used <= conn->recv_offset) {
+        conn->recv_buffer[used] = conn->request_end_byte;
+        memmove(conn->recv_buffer, conn->recv_buffer + used, conn->recv_offset - used);
+        conn->recv_offset -= used;
+    }
+    conn->recv_buffer[conn->recv_offset] = '\0';
+    conn->request_length = 0;
+    http_request_init(&conn->request);
+    conn->task.ready = false;
+}
+
+/*
+ * Check whether a complete request head follows the current request,
+ * ending where the parser will find it ends (CRLF or bare LF lines).
+ */
+static bool conn_next_request_ready(BoltConnection* conn) {
+    size_t start = conn->request_length;
+    if (start == 0 || start >= conn->recv_offset) return false;
+    
+    /* The next head's first byte sits behind the current request's NUL */
+    char* next = conn->recv_buffer + start;
+    *next = conn->request_end_byte;
+    bool ready = http_head_length(next, conn->recv_offset - start) > 0;
+    *next = '\0';
+    return ready;
+}
+
 /*
  * Reset connection for keep-alive reuse.
  */
 void bolt_conn_reset(BoltConnection* conn) {
     if (!conn) return;
     
-    conn->state = BOLT_CONN_READING;
-    conn->recv_offset = 0;
+    conn_consume_request(conn);
     conn->send_offset = 0;
     conn->send_remaining = 0;
+    conn->send_staged = 0;
+    conn->pipelining = false;
+    conn->request_deferred = false;
+    conn_release_send(conn);
     
-    memset(&conn->request, 0, sizeof(conn->request));
-    
-    if (conn->file_handle != INVALID_HANDLE_VALUE) {
-        CloseHandle(conn->file_handle);
-        conn->file_handle = INVALID_HANDLE_VALUE;
-    }
+    bolt_conn_close_file(conn);
     conn->file_size = 0;
     conn->file_offset = 0;
     
-    conn->last_activity = GetTickCount64();
+    /* Idle until the next request starts */
+    bolt_conn_set_state(conn, BOLT_CONN_KEEPALIVE);
+}
+
+/*
+ * Release the file being transferred.
+ */
+void bolt_conn_close_file(BoltConnection* conn) {
+    if (!conn) return;
+    
+    if (conn->open_file) {
+        bolt_open_file_release(conn->open_file);
+        conn->open_file = NULL;
+    } else if (conn->file_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(conn->file_handle);
+    }
+    conn->file_handle = INVALID_HANDLE_VALUE;
+    bolt_send_stream_release(conn);
 }
 
 /*
@@ -185,28 +266,107 @@ void bolt_conn_reset(BoltConnection* conn) {
 void bolt_conn_close(BoltConnection* conn) {
     if (!conn) return;
     
+    g_conn_handoffs++;
     conn->state = BOLT_CONN_CLOSED;
+    conn->deadline = 0;
+    
+    /* Must precede closesocket: expiry may be aborting this socket */
+    if (conn->timers) {
+        bolt_timer_cancel(conn->timers, &conn->timer);
+    }
     
     if (conn->socket != INVALID_SOCKET) {
+        /* Release backend registrations (io_uring fixed file slot) */
+        if (conn->iocp) {
+            bolt_iocp_dissociate(conn->iocp, conn);
+        }
+        
         /* Graceful shutdown */
         shutdown(conn->socket, SD_BOTH);
         closesocket(conn->socket);
         conn->socket = INVALID_SOCKET;
     }
     
-    if (conn->file_handle != INVALID_HANDLE_VALUE) {
-        CloseHandle(conn->file_handle);
-        conn->file_handle = INVALID_HANDLE_VALUE;
+    conn_release_send(conn);
+    
+    bolt_conn_close_file(conn);
+}
+
+/*
+ * Deadline (ms from now) that goes with a state, 0 for none.
+ */
+static DWORD conn_state_timeout(BoltConnection* conn, BoltConnectionState state) {
+    switch (state) {
+        case BOLT_CONN_READING:
+            return g_bolt_server ? g_bolt_server->request_timeout_ms : BOLT_REQUEST_TIMEOUT;
+            
+        case BOLT_CONN_KEEPALIVE:
+            return g_bolt_server ? g_bolt_server->keepalive_timeout_ms : BOLT_KEEPALIVE_TIMEOUT;
+            
+        case BOLT_CONN_SENDING:
+        case BOLT_CONN_SENDING_FILE: {
+            size_t pending = 0;
+            if (state == BOLT_CONN_SENDING) {
+                if (conn->send_remaining > conn->send_offset) {
+                    pending = conn->send_remaining - conn->send_offset;
+                }
+            } else if (conn->file_size > conn->file_offset) {
+                pending = conn->file_size - conn->file_offset;
+            }
+            ULONGLONG ms = BOLT_SEND_TIMEOUT + (ULONGLONG)pending * 1000 / BOLT_MIN_SEND_RATE;
+            return ms > 0x7FFFFFFF ? 0x7FFFFFFF : (DWORD)ms;
+        }
+        
+        default:
+            return 0;
     }
 }
 
 /*
- * Set connection state.
+ * Set connection state and arm the deadline that goes with it:
+ * - READING: the whole request head within the request timeout, counted
+ *   from its first byte and not extended by trickled data (Slowloris).
+ * - KEEPALIVE: idle time allowed before the next request starts.
+ * - SENDING, SENDING_FILE: the send timeout plus time to move the pending
+ *   bytes at BOLT_MIN_SEND_RATE; re-armed on progress, so a client that
+ *   reads too slowly is dropped.
+ * Other states have no deadline; COMPUTING has nothing to abort.
  */
 void bolt_conn_set_state(BoltConnection* conn, BoltConnectionState state) {
-    if (conn) {
-        conn->state = state;
-        conn->last_activity = GetTickCount64();
+    if (!conn) return;
+    
+    if (state == BOLT_CONN_SENDING || state == BOLT_CONN_SENDING_FILE ||
+        state == BOLT_CONN_COMPUTING) {
+        g_conn_handoffs++;
+    }
+    ULONGLONG now = GetTickCount64();
+    conn->state = state;
+    conn->last_activity = now;
+    
+    DWORD timeout = conn_state_timeout(conn, state);
+    if (timeout == 0) {
+        conn->deadline = 0;
+        if (conn->timers) {
+            bolt_timer_cancel(conn->timers, &conn->timer);
+        }
+        return;
+    }
+    
+    conn->deadline = now + timeout;
+    if (conn->timers) {
+        bolt_timer_arm(conn->timers, &conn->timer, now, timeout);
+    }
+}
+
+/*
+ * Timer expiry (runs under the wheel lock, so the socket is still open).
+ */
+void bolt_conn_timer_expired(BoltTimer* timer, void* context) {
+    BOLT_UNUSED(context);
+    
+    BoltConnection* conn = (BoltConnection*)((char*)timer - offsetof(BoltConnection, timer));
+    if (conn->socket != INVALID_SOCKET && conn->iocp) {
+        bolt_iocp_abort(conn->iocp, conn);
     }
 }
 
@@ -220,6 +380,15 @@ bool bolt_conn_is_timed_out(BoltConnection* conn, DWORD timeout_ms) {
     return (now - conn->last_activity) > timeout_ms;
 }
 
+/*
+ * Check the current state's deadline.
+ */
+bool bolt_conn_deadline_passed(BoltConnection* conn) {
+    if (!conn) return true;
+    
+    return conn->deadline != 0 && GetTickCount64() >= conn->deadline;
+}
+
 /*
  * Process received data.
  * SECURITY: Includes timeout check to prevent Slowloris attacks.
@@ -227,8 +396,13 @@ bool bolt_conn_is_timed_out(BoltConnection* conn, DWORD timeout_ms) {
 bool bolt_conn_process_recv(BoltConnection* conn, DWORD bytes_received) {
     if (!conn) return false;
     
+    /* First bytes of the next request on an idle keep-alive connection */
+    if (conn->state == BOLT_CONN_KEEPALIVE) {
+        bolt_conn_set_state(conn, BOLT_CONN_READING);
+    }
+    
     /* Check for request timeout (Slowloris protection) */
-    if (bolt_conn_is_timed_out(conn, BOLT_REQUEST_TIMEOUT)) {
+    if (bolt_conn_deadline_passed(conn)) {
         /* Request taking too long - close connection */
         conn->request.valid = false;
         return true;  /* Return true to trigger error handling */
@@ -245,31 +419,38 @@ bool bolt_conn_process_recv(BoltConnection* conn, DWORD bytes_received) {
         conn->recv_buffer[conn->recv_offset] = '\0';
     }
     
-    /* Check for complete request (end of headers) */
-    char* end_of_headers = strstr(conn->recv_buffer, "\r\n\r\n");
-    if (end_of_headers) {
-        /* Parse the request */
-        conn->request = http_parse_request(conn->recv_buffer, conn->recv_offset);
+    /* Parse the head in one pass; nothing is recorded until it is complete */
+    conn->request = http_parse_request(conn->recv_buffer, conn->recv_offset);
+    if (conn->request.head_length > 0) {
+        /* Bytes past the head belong to pipelined requests: hide them from
+         * the parser and header lookups until this request is answered */
+        conn->request_length = conn->request.head_length;
+        conn->request_end_byte = conn->recv_buffer[conn->request_length];
+        conn->recv_buffer[conn->request_length] = '\0';
         
-        /* Check Connection header for keep-alive */
         if (conn->request.valid) {
             /* HTTP/1.1 defaults to keep-alive */
-            conn->keep_alive = true;
+            conn->keep_alive = !http_slice_has_token(
+                conn->request.headers[HTTP_HEADER_CONNECTION], "close");
             
-            /* Look for Connection: close */
-            char* conn_header = strstr(conn->recv_buffer, "Connection:");
-            if (conn_header) {
-                if (strstr(conn_header, "close")) {
-                    conn->keep_alive = false;
-                }
+            /* Request bodies are not read: close rather than parse one as
+             * the next request. A chunked body has no length up front. */
+            const char* length_header = http_header(&conn->request, HTTP_HEADER_CONTENT_LENGTH);
+            if ((length_header && atol(length_header) > 0) ||
+                http_header(&conn->request, HTTP_HEADER_TRANSFER_ENCODING)) {
+                conn->keep_alive = false;
             }
+        } else {
+            /* Cannot find where the next request starts */
+            conn->keep_alive = false;
         }
         
         return true;  /* Request complete */
     }
     
-    /* Check for buffer overflow */
-    if (conn->recv_offset >= BOLT_MAX_REQUEST_SIZE) {
+    /* Check for buffer overflow (one byte is kept for the terminator) */
+    if (conn->recv_offset >= BOLT_MAX_REQUEST_SIZE ||
+        conn->recv_offset + 1 >= conn->recv_buffer_size) {
         conn->request.valid = false;
         return true;  /* Return true to trigger error handling */
     }
@@ -283,7 +464,7 @@ bool bolt_conn_process_recv(BoltConnection* conn, DWORD bytes_received) {
 void bolt_conn_handle_request(BoltConnection* conn) {
     if (!conn) return;
     
-    conn->state = BOLT_CONN_PROCESSING;
+    bolt_conn_set_state(conn, BOLT_CONN_PROCESSING);
     conn->requests_served++;
     
     /* Log request */
@@ -296,3 +477,115 @@ void bolt_conn_handle_request(BoltConnection* conn) {
     bolt_file_server_handle(conn, &conn->request);
 }
 
+/*
+ * Handle a request and the requests pipelined behind it.
+ */
+int bolt_conn_handle_pipeline(BoltConnection* conn) {
+    if (!conn) return 0;
+    
+    int handled = 0;
+    for (;;) {
+        size_t staged = conn->send_staged;
+        
+        /* Stage this response if another request is ready to follow it */
+        conn->pipelining = conn->keep_alive &&
+                           conn->requests_served + 1 < BOLT_MAX_KEEPALIVE_REQUESTS &&
+                           conn_next_request_ready(conn);
+        LONG handoffs = g_conn_handoffs;
+        bolt_conn_handle_request(conn);
+        
+        if (g_conn_handoffs != handoffs) {
+            /* Posted, computing or closed: the completion may already be
+             * running on another worker, so the connection is no longer ours */
+            handled++;
+            break;
+        }
+        conn->pipelining = false;
+        
+        if (conn->request_deferred) {
+            /* Answered again once the staged responses are sent */
+            conn->request_deferred = false;
+            conn->requests_served--;
+            if (!bolt_conn_post_staged(conn)) {
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            }
+            break;
+        }
+        handled++;
+        
+        /* Nothing was staged: wait for whatever the handler started */
+        if (conn->send_staged <= staged) {
+            break;
+        }
+        
+        /* Staged: move on to the next request */
+        conn_consume_request(conn);
+        if (!bolt_conn_process_recv(conn, 0)) {
+            if (!bolt_conn_post_staged(conn)) {  /* Not reached: the head was complete */
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            }
+            break;
+        }
+    }
+    
+    return handled;
+}
+
+/*
+ * Leave the current request for after the staged responses, which the
+ * pipeline loop then sends.
+ */
+bool bolt_conn_defer_request(BoltConnection* conn) {
+    if (!conn || conn->send_staged == 0) return false;
+    
+    /* Put the request back in front of any that follow it, as received */
+    http_request_restore(&conn->request);
+    if (conn->request_length > 0) {
+        conn->recv_buffer[conn->request_length] = conn->request_end_byte;
+        conn->request_length = 0;
+    }
+    conn->keep_alive = true;  /* The staged responses are all keep-alive */
+    conn->request_deferred = true;
+    
+    return true;
+}
+
+/*
+ * Post the staged segments.
+ */
+bool bolt_conn_post_staged(BoltConnection* conn) {
+    if (!conn || conn->send_staged == 0) return false;
+    
+    /* Enter the sending state before posting: the completion may run on
+     * another worker before this call returns */
+    conn->send_offset = 0;
+    conn->send_remaining = conn->send_staged;
+    conn->send_staged = 0;
+    bolt_conn_set_state(conn, BOLT_CONN_SENDING);
+    
+    return bolt_iocp_repost_send(conn->iocp, conn);
+}
+
+/*
+ * Segments of the pending send past send_offset.
+ */
+int bolt_conn_send_vector(BoltConnection* conn, WSABUF* out, int max) {
+    if (!conn || !out) return 0;
+    
+    size_t skip = conn->send_offset;
+    int count = 0;
+    for (int i = 0; i < conn->send_segment_count && count < max; i++) {
+        WSABUF segment = conn->send_segments[i];
+        if (skip >= segment.len) {
+            skip -= segment.len;
+            continue;
+        }
+        segment.buf += skip;
+        segment.len -= (ULONG)skip;
+        skip = 0;
+        out[count++] = segment;
+    }
+    return count;
+}
@@ -1,33 +1,143 @@
 #include "../include/file_cache.h"
+#include "../include/cache_policy.h"
 #include "../include/utils.h"
-#include <windows.h>
+#include "../include/compression.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct {
-    bool used;
+/* Shards smaller than this would thrash; small caches use fewer shards */
+#define CACHE_MIN_SHARD_ENTRIES 64
+
+/* Loader threads and the fills they may have queued */
+#define CACHE_MAX_LOADERS       8
+#define CACHE_MAX_QUEUED_FILLS  256
+
+/* Slots looked at per bolt_file_cache_upgrade() call */
+#define CACHE_UPGRADE_SCAN      256
+
+/*
+ * Cached response, immutable once published. Its key travels with it so a
+ * lock-free lookup can validate what it found without trusting the slot.
+ * The slot that links it holds one reference and every reader (an
+ * in-flight send) holds another, so eviction only unlinks it; the memory
+ * goes with the last reference.
+ */
+typedef struct CacheObject {
+    volatile LONG refs;
     uint32_t hash;
+    BoltCompressionType encoding;       /* Variant: what the client accepts */
+    int level;                          /* Compression level of the body */
     time_t mtime;
     size_t file_size;
-    size_t total_bytes; /* headers+body */
-    ULONGLONG last_used;
-    char path[BOLT_MAX_PATH_LENGTH];
-    char* headers;
     size_t headers_len;
-    char* body;
     size_t body_len;
+    struct CacheObject* retired_next;   /* Written once unlinked, under the shard lock */
+    LONG retired_epoch;
+    char* path;                         /* Points into data, after the body */
+    char* content_type;                 /* ...after the path, for recompression */
+    char data[];                        /* Headers, body, path, content type */
+} CacheObject;
+
+/*
+ * Cache slot. Slots are never freed while the cache lives, so a lookup
+ * racing with eviction may follow a stale link into a reused or free slot
+ * but never into freed memory. The policy node comes first so a victim
+ * picked by the policy is the entry itself. Unused slots sit on the free
+ * list via hash_next.
+ */
+typedef struct CacheEntry {
+    BoltS3Node node;    /* Key hash and headers+body bytes */
+    struct CacheEntry* volatile hash_next;
+    CacheObject* volatile object;
+    int tried_level;    /* Best level tried for the object (shard lock): raised
+                         * when an upgrade did not make the body smaller */
 } CacheEntry;
 
-struct BoltFileCache {
-    SRWLOCK lock;
+/*
+ * A fill in flight. It stays registered on its shard while the file is
+ * read outside the lock, so concurrent misses on the same path do not
+ * start a second read (single-flight); they send from the file instead.
+ */
+typedef struct CacheFill {
+    struct CacheFill* next;         /* Shard's in-flight list */
+    struct CacheFill* queue_next;   /* Loader queue */
+    uint32_t hash;
+    BoltCompressionType encoding;
+    bool upgrade;                   /* Recompressing a cached variant at a better level */
+    time_t mtime;
+    size_t file_size;
+    char content_type[128];
+    char path[BOLT_MAX_PATH_LENGTH];
+} CacheFill;
+
+/*
+ * Independently locked segment. The lock serializes writers (fills,
+ * refreshes, eviction); hits take no lock.
+ */
+typedef struct {
+    CRITICAL_SECTION lock;
     CacheEntry* entries;
+    CacheEntry* free_list;
+    CacheEntry* volatile* buckets;
+    size_t bucket_mask;
     size_t capacity;
-    size_t max_total_bytes;
-    size_t total_bytes;
+    BoltS3Fifo policy;
+    CacheObject* retired;       /* Unlinked, waiting out in-flight lookups */
+    CacheFill* fills;           /* Files being read for this shard */
+
+    /* Statistics */
+    LONG64 fills_done;
+    LONG64 compressions;        /* Fills that stored a compressed body */
+    LONG64 fill_fallbacks;      /* Misses that found their file already loading */
+    LONG64 invalidations;
+    LONG64 upgrades;            /* Variants replaced by a better compressed copy */
+} CacheShard;
+
+/*
+ * Lookups in flight, counted by epoch parity, plus hit/miss counters.
+ * Threads map onto slots round-robin; each slot has its own cache line.
+ */
+typedef union {
+    struct {
+        volatile LONG active[2];
+        volatile LONG64 hits;
+        volatile LONG64 misses;
+    } r;
+    char pad[BOLT_CACHE_LINE_SIZE];
+} CacheReader;
+
+struct BoltFileCache {
+    CacheShard* shards;
+    size_t shard_mask;
+    CacheReader* readers;
+    volatile LONG epoch;
+
+    /* Loader threads: with any running, misses queue their fill here and
+     * return instead of reading the file themselves */
+    CRITICAL_SECTION queue_lock;
+    CONDITION_VARIABLE queue_ready;
+    CacheFill* queue_head;
+    CacheFill* queue_tail;
+    size_t queue_length;
+    bool stopping;
+    int loader_count;
+
+    /* Where bolt_file_cache_upgrade() goes on looking */
+    size_t upgrade_shard;
+    size_t upgrade_slot;
+#ifdef _WIN32
+    HANDLE loaders[CACHE_MAX_LOADERS];
+#else
+    pthread_t loaders[CACHE_MAX_LOADERS];
+#endif
 };
 
+/* Reader slot of the calling thread, +1 (0 = not yet assigned) */
+static BOLT_THREAD_LOCAL LONG g_reader_slot;
+static volatile LONG g_next_reader_slot;
+
 static uint32_t fnv1a32(const char* s) {
     uint32_t h = 2166136261u;
     while (*s) {
@@ -37,14 +147,33 @@ static uint32_t fnv1a32(const char* s) {
     return h ? h : 1u;
 }
 
+/*
+ * Headers of a cached response. Compressed variants get their own ETag
+ * (the file's, tagged with the encoding) and every response of a
+ * compressible type says it depends on Accept-Encoding.
+ */
 static size_t build_200_headers(char* out, size_t out_sz,
                                const char* content_type,
                                size_t content_length,
-                               time_t mtime) {
+                               size_t file_size,
+                               time_t mtime,
+                               const char* content_encoding,
+                               bool vary) {
     char last_modified[64];
     char etag[64];
+    char encoding_headers[96] = "";
     utils_format_http_date(mtime, last_modified, sizeof(last_modified));
-    snprintf(etag, sizeof(etag), "\"%zx-%lx\"", content_length, (unsigned long)mtime);
+    if (content_encoding) {
+        snprintf(etag, sizeof(etag), "\"%zx-%lx-%s\"", file_size, (unsigned long)mtime,
+                 content_encoding);
+        snprintf(encoding_headers, sizeof(encoding_headers), "Content-Encoding: %s\r\n",
+                 content_encoding);
+    } else {
+        snprintf(etag, sizeof(etag), "\"%zx-%lx\"", file_size, (unsigned long)mtime);
+    }
+    if (vary) {
+        strcat(encoding_headers, "Vary: Accept-Encoding\r\n");
+    }
 
     return (size_t)snprintf(out, out_sz,
         "HTTP/1.1 200 OK\r\n"
@@ -52,6 +181,7 @@ static size_t build_200_headers(char* out, size_t out_sz,
         "Connection: keep-alive\r\n"
         "Keep-Alive: timeout=60, max=1000\r\n"
         "Content-Type: %s\r\n"
+        "%s"
         "Content-Length: %zu\r\n"
         "Cache-Control: public, max-age=3600\r\n"
         "ETag: %s\r\n"
@@ -63,6 +193,7 @@ static size_t build_200_headers(char* out, size_t out_sz,
         "Permissions-Policy: geolocation=(), microphone=(), camera=()\r\n"
         "\r\n",
         content_type ? content_type : "application/octet-stream",
+        encoding_headers,
         content_length,
         etag,
         last_modified
@@ -81,57 +212,494 @@ static bool read_entire_file(const char* filepath, size_t size, char* out_buf) {
 }
 
 BoltFileCache* bolt_file_cache_create(size_t capacity, size_t max_total_bytes) {
+    if (capacity == 0 || max_total_bytes == 0) return NULL;
+
     BoltFileCache* c = (BoltFileCache*)calloc(1, sizeof(BoltFileCache));
     if (!c) return NULL;
-    InitializeSRWLock(&c->lock);
-    c->capacity = capacity;
-    c->max_total_bytes = max_total_bytes;
-    c->entries = (CacheEntry*)calloc(capacity, sizeof(CacheEntry));
-    if (!c->entries) {
+
+    size_t shard_count = BOLT_FILE_CACHE_SHARDS;
+    while (shard_count > 1 && capacity / shard_count < CACHE_MIN_SHARD_ENTRIES) {
+        shard_count >>= 1;
+    }
+    c->shard_mask = shard_count - 1;
+
+    c->shards = (CacheShard*)calloc(shard_count, sizeof(CacheShard));
+    c->readers = (CacheReader*)_aligned_malloc(BOLT_FILE_CACHE_READERS * sizeof(CacheReader),
+                                               BOLT_CACHE_LINE_SIZE);
+    if (!c->shards || !c->readers) {
+        free(c->shards);
+        if (c->readers) _aligned_free(c->readers);
         free(c);
         return NULL;
     }
+    memset(c->readers, 0, BOLT_FILE_CACHE_READERS * sizeof(CacheReader));
+    InitializeCriticalSection(&c->queue_lock);
+    InitializeConditionVariable(&c->queue_ready);
+
+    /* Each shard gets an equal share of both budgets, so the sum stays
+     * within the global limits */
+    size_t shard_capacity = (capacity + shard_count - 1) / shard_count;
+    size_t shard_bytes = max_total_bytes / shard_count;
+    if (shard_bytes == 0) shard_bytes = 1;
+
+    for (size_t i = 0; i < shard_count; i++) {
+        CacheShard* shard = &c->shards[i];
+
+        /* Chains stay at most one long on average */
+        size_t buckets = 1;
+        while (buckets < shard_capacity) buckets <<= 1;
+        shard->bucket_mask = buckets - 1;
+        shard->capacity = shard_capacity;
+
+        shard->entries = (CacheEntry*)calloc(shard_capacity, sizeof(CacheEntry));
+        shard->buckets = (CacheEntry* volatile*)calloc(buckets, sizeof(CacheEntry*));
+        if (!shard->entries || !shard->buckets ||
+            !bolt_s3fifo_init(&shard->policy, shard_bytes, shard_capacity)) {
+            free(shard->entries);
+            free((void*)shard->buckets);
+            shard->entries = NULL;
+            shard->buckets = NULL;
+            bolt_file_cache_destroy(c);
+            return NULL;
+        }
+        InitializeCriticalSection(&shard->lock);
+
+        for (size_t j = shard_capacity; j > 0; j--) {
+            shard->entries[j - 1].hash_next = shard->free_list;
+            shard->free_list = &shard->entries[j - 1];
+        }
+    }
     return c;
 }
 
-static void free_entry(BoltFileCache* cache, CacheEntry* e) {
-    if (!e->used) return;
-    if (e->headers) free(e->headers);
-    if (e->body) free(e->body);
-    if (cache->total_bytes >= e->total_bytes) cache->total_bytes -= e->total_bytes;
-    memset(e, 0, sizeof(*e));
+/*
+ * Take a reference for a reader and describe the response to it.
+ */
+static void object_acquire(CacheObject* object, BoltCachedResponse* out) {
+    InterlockedIncrement(&object->refs);
+    out->headers = object->data;
+    out->headers_len = object->headers_len;
+    out->body = object->data + object->headers_len;
+    out->body_len = object->body_len;
+    out->ref = object;
 }
 
-void bolt_file_cache_destroy(BoltFileCache* cache) {
-    if (!cache) return;
-    AcquireSRWLockExclusive(&cache->lock);
-    for (size_t i = 0; i < cache->capacity; i++) {
-        free_entry(cache, &cache->entries[i]);
+static void object_release(CacheObject* object) {
+    if (InterlockedDecrement(&object->refs) == 0) {
+        free(object);
+    }
+}
+
+static bool object_matches(const CacheObject* object, uint32_t hash, const char* filepath,
+                           BoltCompressionType encoding) {
+    return object && object->hash == hash && object->encoding == encoding &&
+           strcmp(object->path, filepath) == 0;
+}
+
+static CacheShard* shard_for(BoltFileCache* cache, uint32_t hash) {
+    /* Buckets index by the low bits */
+    return &cache->shards[(hash >> 16) & cache->shard_mask];
+}
+
+/*============================================================================
+ * Epoch-based reclamation
+ *
+ * A lookup registers in the current epoch's parity counter of its reader
+ * slot for as long as it touches slots and objects. An unlinked object is
+ * stamped with the epoch it was retired in and keeps its slot reference
+ * until the epoch has advanced twice; the epoch only advances once no
+ * lookup from the previous one is left, so by then no lookup can still be
+ * holding a pointer to it.
+ *============================================================================*/
+
+static CacheReader* reader_enter(BoltFileCache* cache, LONG* parity) {
+    if (g_reader_slot == 0) {
+        ULONG next = (ULONG)InterlockedIncrement(&g_next_reader_slot);
+        g_reader_slot = (LONG)((next - 1) % BOLT_FILE_CACHE_READERS) + 1;
+    }
+    CacheReader* reader = &cache->readers[g_reader_slot - 1];
+
+    /* Retry if the epoch moved between reading and registering */
+    for (;;) {
+        LONG epoch = cache->epoch;
+        InterlockedIncrement(&reader->r.active[epoch & 1]);
+        if (cache->epoch == epoch) {
+            *parity = epoch & 1;
+            return reader;
+        }
+        InterlockedDecrement(&reader->r.active[epoch & 1]);
+    }
+}
+
+static void reader_exit(CacheReader* reader, LONG parity) {
+    InterlockedDecrement(&reader->r.active[parity]);
+}
+
+static void epoch_try_advance(BoltFileCache* cache) {
+    LONG epoch = cache->epoch;
+    LONG previous = (epoch & 1) ^ 1;
+
+    /* Interlocked reads: a lookup's exit must be ordered before anything
+     * this advance lets us free */
+    for (size_t i = 0; i < BOLT_FILE_CACHE_READERS; i++) {
+        if (InterlockedCompareExchange(&cache->readers[i].r.active[previous], 0, 0) != 0) return;
+    }
+    InterlockedCompareExchange(&cache->epoch, (LONG)((ULONG)epoch + 1), epoch);
+}
+
+/*
+ * Drop the slot references of retired objects no lookup can still see.
+ * Caller holds the shard lock.
+ */
+static void shard_reclaim(BoltFileCache* cache, CacheShard* shard) {
+    ULONG epoch = (ULONG)cache->epoch;
+    CacheObject** link = &shard->retired;
+
+    while (*link) {
+        CacheObject* object = *link;
+        if (epoch - (ULONG)object->retired_epoch >= 2) {
+            *link = object->retired_next;
+            object_release(object);
+        } else {
+            link = &object->retired_next;
+        }
     }
-    ReleaseSRWLockExclusive(&cache->lock);
-    free(cache->entries);
-    free(cache);
 }
 
-static CacheEntry* find_slot(BoltFileCache* cache, uint32_t hash, const char* filepath) {
-    size_t idx = (size_t)(hash % cache->capacity);
-    for (size_t probe = 0; probe < cache->capacity; probe++) {
-        CacheEntry* e = &cache->entries[idx];
-        if (!e->used) return e;
-        if (e->hash == hash && strcmp(e->path, filepath) == 0) return e;
-        idx = (idx + 1) % cache->capacity;
+/*
+ * Unlink an entry already detached from the policy, retire its response
+ * and return the slot to the free list. Caller holds the shard lock.
+ */
+static void shard_free_entry(BoltFileCache* cache, CacheShard* shard, CacheEntry* e) {
+    CacheEntry* volatile* link = &shard->buckets[e->node.hash & shard->bucket_mask];
+    while (*link && *link != e) link = &(*link)->hash_next;
+    if (*link) *link = e->hash_next;
+
+    CacheObject* object = e->object;
+    e->object = NULL;
+
+    /* Unlinked before the retire epoch is read */
+    MemoryBarrier();
+
+    if (object) {
+        object->retired_epoch = cache->epoch;
+        object->retired_next = shard->retired;
+        shard->retired = object;
+    }
+
+    e->hash_next = shard->free_list;
+    shard->free_list = e;
+}
+
+/*
+ * Compress a fill's file for its variant. On failure, or when it does not
+ * shrink, the variant is stored with the identity body: still a valid
+ * answer, and the file is not compressed again on every request.
+ */
+static bool fill_compress(const CacheFill* fill, const char* file_data, int level,
+                          BoltCompressedData* compressed) {
+    /* Into the thread's scratch buffer with a pooled encoder; the bytes are
+     * copied into the cache object right after */
+    const char* out = compression_compress_scratch(fill->encoding, file_data, fill->file_size,
+                                                   &compressed->size, level);
+    if (!out || compressed->size >= fill->file_size) {
+        return false;
     }
+    compressed->data = (char*)out;
+    compressed->type = fill->encoding;
+    return true;
+}
+
+/*
+ * Read a fill's file (and compress it for its variant) into a new
+ * response. Runs without any lock held. Variants are compressed at the
+ * level for stored responses, the best one while the server is quiet; an
+ * upgrade is dropped if the quiet ended or the file changed while it was
+ * queued.
+ */
+static CacheObject* fill_load(const CacheFill* fill) {
+    BoltCompressionConfig config = compression_get_default_config();
+    int level = compression_stored_level(&config, fill->encoding);
+    if (fill->upgrade && compression_load() != BOLT_LOAD_QUIET) {
+        return NULL;
+    }
+    if (fill->upgrade) {
+        /* Labelled with the cached variant's mtime and size: the file must
+         * still be that one */
+        FileInfo info = utils_get_file_info(fill->path);
+        if (!info.exists || info.mtime != fill->mtime || info.size != fill->file_size) {
+            return NULL;
+        }
+    }
+
+    char* file_data = NULL;
+    BoltCompressedData compressed = { NULL, 0, BOLT_COMPRESS_NONE };
+    bool is_compressed = false;
+    if (fill->encoding != BOLT_COMPRESS_NONE) {
+        file_data = (char*)malloc(fill->file_size);
+        if (!file_data || !read_entire_file(fill->path, fill->file_size, file_data)) {
+            free(file_data);
+            return NULL;
+        }
+        is_compressed = fill_compress(fill, file_data, level, &compressed);
+    }
+    size_t body_len = is_compressed ? compressed.size : fill->file_size;
+
+    bool vary = fill->encoding != BOLT_COMPRESS_NONE ||
+                compression_should_compress(fill->content_type, &config);
+
+    char header_tmp[1024];
+    size_t hdr_len = build_200_headers(header_tmp, sizeof(header_tmp), fill->content_type,
+                                       body_len, fill->file_size, fill->mtime,
+                                       is_compressed ? compression_coding_name(fill->encoding) : NULL,
+                                       vary);
+    CacheObject* object = NULL;
+    size_t total = 0;
+    size_t path_len = strlen(fill->path);
+    size_t type_len = strlen(fill->content_type);
+    if (hdr_len > 0 && hdr_len < sizeof(header_tmp)) {
+        /* Headers and body share one block so a response is one contiguous run */
+        total = hdr_len + body_len;
+        if (total <= BOLT_FILE_CACHE_MAX_ENTRY_SIZE) {
+            object = (CacheObject*)malloc(sizeof(CacheObject) + total + path_len + 1 +
+                                          type_len + 1);
+        }
+    }
+    if (object) {
+        if (is_compressed) {
+            memcpy(object->data + hdr_len, compressed.data, body_len);
+        } else if (file_data) {
+            memcpy(object->data + hdr_len, file_data, body_len);
+        } else if (!read_entire_file(fill->path, fill->file_size, object->data + hdr_len)) {
+            free(object);
+            object = NULL;
+        }
+    }
+    free(file_data);
+    if (!object) {
+        return NULL;
+    }
+
+    memcpy(object->data, header_tmp, hdr_len);
+    object->headers_len = hdr_len;
+    object->body_len = body_len;
+    object->path = object->data + total;
+    memcpy(object->path, fill->path, path_len + 1);
+    object->content_type = object->path + path_len + 1;
+    memcpy(object->content_type, fill->content_type, type_len + 1);
+    object->hash = fill->hash;
+    object->encoding = fill->encoding;
+    object->level = level;
+    object->mtime = fill->mtime;
+    object->file_size = fill->file_size;
+    object->retired_next = NULL;
+    object->retired_epoch = 0;
+    object->refs = 1;  /* The slot's reference */
+    return object;
+}
+
+/*
+ * End a fill: publish its response (NULL if the load failed) and free it.
+ * With out set, the caller also gets a reference to the response.
+ */
+static bool fill_commit(BoltFileCache* cache, CacheFill* fill, CacheObject* object,
+                        BoltCachedResponse* out) {
+    CacheShard* shard = shard_for(cache, fill->hash);
+    bool published = false;
+
+    EnterCriticalSection(&shard->lock);
+
+    CacheFill** link = &shard->fills;
+    while (*link && *link != fill) link = &(*link)->next;
+    if (*link) *link = fill->next;
+
+    if (object) {
+        size_t total = object->headers_len + object->body_len;
+
+        /* Same variant but stale: replace it */
+        CacheEntry* e = shard->buckets[fill->hash & shard->bucket_mask];
+        while (e && !object_matches(e->object, fill->hash, fill->path, fill->encoding)) {
+            e = e->hash_next;
+        }
+        if (fill->upgrade) {
+            /* The upgrade read the file as it is now but is labelled with
+             * the variant it replaces: only that variant may be replaced */
+            bool current = e && e->object->mtime == fill->mtime &&
+                           e->object->file_size == fill->file_size;
+            if (current && e->object->body_len <= object->body_len) {
+                /* The better level did not help this file: keep the
+                 * smaller body and stop trying */
+                e->tried_level = object->level;
+            }
+            if (!current || e->object->body_len <= object->body_len) {
+                LeaveCriticalSection(&shard->lock);
+                free(object);
+                free(fill);
+                return false;
+            }
+        }
+        if (e) {
+            bolt_s3fifo_remove(&shard->policy, &e->node);
+            shard_free_entry(cache, shard, e);
+        }
+
+        /* Make room, one O(1) eviction at a time */
+        while (bolt_s3fifo_full(&shard->policy, total)) {
+            BoltS3Node* victim = bolt_s3fifo_evict(&shard->policy);
+            if (!victim) break;
+            shard_free_entry(cache, shard, (CacheEntry*)victim);
+        }
+
+        e = shard->free_list;
+        if (e && !bolt_s3fifo_full(&shard->policy, total)) {
+            shard->free_list = e->hash_next;
+
+            /* Commit entry: the object is complete before lookups can reach it */
+            e->node.hash = fill->hash;
+            e->node.bytes = total;
+            e->object = object;
+            e->tried_level = object->level;
+            e->hash_next = shard->buckets[fill->hash & shard->bucket_mask];
+            bolt_s3fifo_insert(&shard->policy, &e->node);
+            MemoryBarrier();
+            shard->buckets[fill->hash & shard->bucket_mask] = e;
+
+            shard->fills_done++;
+            if (object->body_len < fill->file_size) shard->compressions++;
+            if (fill->upgrade) shard->upgrades++;
+            published = true;
+            if (out) object_acquire(object, out);
+        }
+    }
+
+    /* Free what lookups can no longer reach */
+    if (shard->retired) {
+        epoch_try_advance(cache);
+        shard_reclaim(cache, shard);
+    }
+
+    LeaveCriticalSection(&shard->lock);
+
+    if (object && !published) free(object);
+    free(fill);
+    return published && out;
+}
+
+static bool fill_enqueue(BoltFileCache* cache, CacheFill* fill) {
+    EnterCriticalSection(&cache->queue_lock);
+
+    bool queued = !cache->stopping && cache->queue_length < CACHE_MAX_QUEUED_FILLS;
+    if (queued) {
+        if (cache->queue_tail) cache->queue_tail->queue_next = fill;
+        else cache->queue_head = fill;
+        cache->queue_tail = fill;
+        cache->queue_length++;
+        WakeConditionVariable(&cache->queue_ready);
+    }
+
+    LeaveCriticalSection(&cache->queue_lock);
+    return queued;
+}
+
+/*
+ * Loader thread: read queued fills until the cache is destroyed.
+ */
+static void loader_run(BoltFileCache* cache) {
+    for (;;) {
+        EnterCriticalSection(&cache->queue_lock);
+        while (!cache->queue_head && !cache->stopping) {
+            SleepConditionVariableCS(&cache->queue_ready, &cache->queue_lock, INFINITE);
+        }
+        if (cache->stopping) {
+            LeaveCriticalSection(&cache->queue_lock);
+            compression_release_thread_contexts();
+            return;
+        }
+
+        CacheFill* fill = cache->queue_head;
+        cache->queue_head = fill->queue_next;
+        if (!cache->queue_head) cache->queue_tail = NULL;
+        cache->queue_length--;
+        LeaveCriticalSection(&cache->queue_lock);
+
+        fill_commit(cache, fill, fill_load(fill), NULL);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI loader_thread(LPVOID param) {
+    loader_run((BoltFileCache*)param);
+    return 0;
+}
+#else
+static void* loader_thread(void* param) {
+    loader_run((BoltFileCache*)param);
     return NULL;
 }
+#endif
 
-static CacheEntry* find_lru(BoltFileCache* cache) {
-    CacheEntry* best = NULL;
-    for (size_t i = 0; i < cache->capacity; i++) {
-        CacheEntry* e = &cache->entries[i];
-        if (!e->used) return e;
-        if (!best || e->last_used < best->last_used) best = e;
+bool bolt_file_cache_start_loaders(BoltFileCache* cache, int count) {
+    if (!cache || count <= 0 || cache->loader_count > 0) return false;
+    if (count > CACHE_MAX_LOADERS) count = CACHE_MAX_LOADERS;
+
+    for (int i = 0; i < count; i++) {
+#ifdef _WIN32
+        cache->loaders[i] = CreateThread(NULL, 0, loader_thread, cache, 0, NULL);
+        if (!cache->loaders[i]) break;
+#else
+        if (pthread_create(&cache->loaders[i], NULL, loader_thread, cache) != 0) break;
+#endif
+        cache->loader_count++;
     }
-    return best;
+    return cache->loader_count > 0;
+}
+
+void bolt_file_cache_destroy(BoltFileCache* cache) {
+    if (!cache) return;
+
+    /* Stop loaders; fills still queued are dropped */
+    EnterCriticalSection(&cache->queue_lock);
+    cache->stopping = true;
+    WakeAllConditionVariable(&cache->queue_ready);
+    LeaveCriticalSection(&cache->queue_lock);
+
+    for (int i = 0; i < cache->loader_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(cache->loaders[i], INFINITE);
+        CloseHandle(cache->loaders[i]);
+#else
+        pthread_join(cache->loaders[i], NULL);
+#endif
+    }
+    while (cache->queue_head) {
+        CacheFill* fill = cache->queue_head;
+        cache->queue_head = fill->queue_next;
+        free(fill);
+    }
+    DeleteCriticalSection(&cache->queue_lock);
+
+    for (size_t i = 0; i <= cache->shard_mask && cache->shards; i++) {
+        CacheShard* shard = &cache->shards[i];
+        if (!shard->entries) continue;
+
+        for (size_t j = 0; j < shard->capacity; j++) {
+            if (shard->entries[j].object) object_release(shard->entries[j].object);
+        }
+        while (shard->retired) {
+            CacheObject* object = shard->retired;
+            shard->retired = object->retired_next;
+            object_release(object);
+        }
+
+        DeleteCriticalSection(&shard->lock);
+        bolt_s3fifo_destroy(&shard->policy);
+        free((void*)shard->buckets);
+        free(shard->entries);
+    }
+
+    free(cache->shards);
+    if (cache->readers) _aligned_free(cache->readers);
+    free(cache);
 }
 
 bool bolt_file_cache_get(BoltFileCache* cache,
@@ -140,155 +708,245 @@ bool bolt_file_cache_get(BoltFileCache* cache,
                          time_t mtime,
                          size_t file_size,
                          BoltCachedResponse* out) {
+    return bolt_file_cache_get_encoded(cache, filepath, content_type, BOLT_COMPRESS_NONE,
+                                       mtime, file_size, out);
+}
+
+bool bolt_file_cache_get_encoded(BoltFileCache* cache,
+                                 const char* filepath,
+                                 const char* content_type,
+                                 BoltCompressionType encoding,
+                                 time_t mtime,
+                                 size_t file_size,
+                                 BoltCachedResponse* out) {
     if (!cache || !filepath || !out) return false;
 
-    /* Hard limit: body must fit plus headers into the connection send buffer */
+    /* Hard limit: entry size (headers + body) */
     if (file_size == 0 || file_size > (size_t)(BOLT_FILE_CACHE_MAX_ENTRY_SIZE - 1024)) {
         return false;
     }
+    size_t path_len = strlen(filepath);
+    if (path_len >= BOLT_MAX_PATH_LENGTH) return false;
 
     uint32_t h = fnv1a32(filepath);
+    CacheShard* shard = shard_for(cache, h);
 
-    /* Fast path: shared lock lookup */
-    AcquireSRWLockShared(&cache->lock);
-    size_t idx = (size_t)(h % cache->capacity);
-    for (size_t probe = 0; probe < cache->capacity; probe++) {
-        CacheEntry* e = &cache->entries[idx];
-        if (!e->used) break;
-        if (e->hash == h && strcmp(e->path, filepath) == 0) {
-            if (e->mtime == mtime && e->file_size == file_size) {
-                e->last_used = GetTickCount64();
-                out->headers = e->headers;
-                out->headers_len = e->headers_len;
-                out->body = e->body;
-                out->body_len = e->body_len;
-                ReleaseSRWLockShared(&cache->lock);
-                return true;
-            }
-            break;
+    /* Fast path: lock-free lookup. Links may change under us; a walk that
+     * strays into reused slots just ends in a miss, bounded by capacity. */
+    LONG parity;
+    CacheReader* reader = reader_enter(cache, &parity);
+    CacheEntry* e = shard->buckets[h & shard->bucket_mask];
+    for (size_t steps = 0; e && steps < shard->capacity; steps++) {
+        CacheObject* object = e->object;
+        if (object_matches(object, h, filepath, encoding) &&
+            object->mtime == mtime && object->file_size == file_size) {
+            bolt_s3fifo_hit(&e->node);
+            object_acquire(object, out);
+            InterlockedIncrement64(&reader->r.hits);
+            reader_exit(reader, parity);
+            return true;
         }
-        idx = (idx + 1) % cache->capacity;
-    }
-    ReleaseSRWLockShared(&cache->lock);
-
-    /* Slow path: exclusive lock load/refresh */
-    AcquireSRWLockExclusive(&cache->lock);
-
-    /* Re-check: another thread may have loaded it while we waited for exclusive lock */
-    idx = (size_t)(h % cache->capacity);
-    for (size_t probe = 0; probe < cache->capacity; probe++) {
-        CacheEntry* check_e = &cache->entries[idx];
-        if (!check_e->used) break;
-        if (check_e->hash == h && strcmp(check_e->path, filepath) == 0) {
-            if (check_e->mtime == mtime && check_e->file_size == file_size) {
-                /* Another thread loaded it - use it */
-                check_e->last_used = GetTickCount64();
-                out->headers = check_e->headers;
-                out->headers_len = check_e->headers_len;
-                out->body = check_e->body;
-                out->body_len = check_e->body_len;
-                ReleaseSRWLockExclusive(&cache->lock);
-                return true;
-            }
-            break;
-        }
-        idx = (idx + 1) % cache->capacity;
+        e = e->hash_next;
     }
+    InterlockedIncrement64(&reader->r.misses);
+    reader_exit(reader, parity);
 
-    CacheEntry* e = find_slot(cache, h, filepath);
-    if (!e) {
-        ReleaseSRWLockExclusive(&cache->lock);
+    /* Headers are under 1 KB; skip files that cannot fit this shard */
+    if (file_size + 1024 > shard->policy.max_bytes) {
         return false;
     }
 
-    /* If occupied by same path but stale, free it first */
-    if (e->used && e->hash == h && strcmp(e->path, filepath) == 0) {
-        free_entry(cache, e);
-    } else if (e->used) {
-        /* Collision slot filled by other key; evict LRU instead */
-        CacheEntry* victim = find_lru(cache);
-        if (!victim) {
-            ReleaseSRWLockExclusive(&cache->lock);
+    EnterCriticalSection(&shard->lock);
+
+    /* Re-check: another thread may have loaded it since the lookup */
+    e = shard->buckets[h & shard->bucket_mask];
+    while (e && !object_matches(e->object, h, filepath, encoding)) e = e->hash_next;
+    if (e && e->object->mtime == mtime && e->object->file_size == file_size) {
+        bolt_s3fifo_hit(&e->node);
+        object_acquire(e->object, out);
+        LeaveCriticalSection(&shard->lock);
+        return true;
+    }
+
+    /* Single-flight: one read per variant at a time */
+    for (CacheFill* f = shard->fills; f; f = f->next) {
+        if (f->hash == h && f->encoding == encoding && strcmp(f->path, filepath) == 0) {
+            shard->fill_fallbacks++;
+            LeaveCriticalSection(&shard->lock);
             return false;
         }
-        free_entry(cache, victim);
-        e = victim;
     }
 
-    /* Build headers */
-    char header_tmp[1024];
-    size_t hdr_len = build_200_headers(header_tmp, sizeof(header_tmp), content_type, file_size, mtime);
-    if (hdr_len == 0 || hdr_len >= sizeof(header_tmp)) {
-        ReleaseSRWLockExclusive(&cache->lock);
+    CacheFill* fill = (CacheFill*)malloc(sizeof(CacheFill));
+    if (!fill) {
+        LeaveCriticalSection(&shard->lock);
         return false;
     }
+    fill->queue_next = NULL;
+    fill->hash = h;
+    fill->encoding = encoding;
+    fill->upgrade = false;
+    fill->mtime = mtime;
+    fill->file_size = file_size;
+    snprintf(fill->content_type, sizeof(fill->content_type), "%s",
+             content_type ? content_type : "application/octet-stream");
+    memcpy(fill->path, filepath, path_len + 1);
+    fill->next = shard->fills;
+    shard->fills = fill;
 
-    /* Check for integer overflow before addition */
-    if (hdr_len > SIZE_MAX - file_size) {
-        ReleaseSRWLockExclusive(&cache->lock);
-        return false;
-    }
-    size_t total = hdr_len + file_size;
-    if (total > BOLT_FILE_CACHE_MAX_ENTRY_SIZE) {
-        ReleaseSRWLockExclusive(&cache->lock);
+    LeaveCriticalSection(&shard->lock);
+
+    /* Hand the read to a loader; this request is sent from the file */
+    if (cache->loader_count > 0) {
+        if (!fill_enqueue(cache, fill)) {
+            fill_commit(cache, fill, NULL, NULL);
+        }
         return false;
     }
 
-    /* Enforce total cache cap - check for overflow */
-    if (cache->total_bytes > SIZE_MAX - total) {
-        ReleaseSRWLockExclusive(&cache->lock);
-        return false;
+    /* No loaders: read it here, still outside the lock */
+    return fill_commit(cache, fill, fill_load(fill), out);
+}
+
+void bolt_file_cache_invalidate(BoltFileCache* cache, const char* filepath) {
+    if (!cache || !filepath) return;
+
+    uint32_t h = fnv1a32(filepath);
+    CacheShard* shard = shard_for(cache, h);
+
+    /* Every variant of the file */
+    EnterCriticalSection(&shard->lock);
+    CacheEntry* e = shard->buckets[h & shard->bucket_mask];
+    while (e) {
+        CacheEntry* next = e->hash_next;
+        CacheObject* object = e->object;
+        if (object && object->hash == h && strcmp(object->path, filepath) == 0) {
+            bolt_s3fifo_remove(&shard->policy, &e->node);
+            shard_free_entry(cache, shard, e);
+            shard->invalidations++;
+        }
+        e = next;
     }
-    while (cache->total_bytes + total > cache->max_total_bytes) {
-        CacheEntry* victim = find_lru(cache);
-        if (!victim || (!victim->used && victim == e)) break;
-        if (victim->used) free_entry(cache, victim);
-        else break;
+    if (shard->retired) {
+        epoch_try_advance(cache);
+        shard_reclaim(cache, shard);
     }
+    LeaveCriticalSection(&shard->lock);
+}
 
-    /* Allocate and read file */
-    char* body = (char*)malloc(file_size);
-    if (!body) {
-        ReleaseSRWLockExclusive(&cache->lock);
-        return false;
+/*
+ * Register a fill recompressing a cached variant, unless one for the
+ * variant is already in flight. Caller holds the shard lock.
+ */
+static CacheFill* upgrade_fill(CacheShard* shard, const CacheObject* object) {
+    for (CacheFill* f = shard->fills; f; f = f->next) {
+        if (f->hash == object->hash && f->encoding == object->encoding &&
+            strcmp(f->path, object->path) == 0) {
+            return NULL;
+        }
     }
-    if (!read_entire_file(filepath, file_size, body)) {
-        free(body);
-        ReleaseSRWLockExclusive(&cache->lock);
-        return false;
+
+    CacheFill* fill = (CacheFill*)malloc(sizeof(CacheFill));
+    if (!fill) return NULL;
+    fill->queue_next = NULL;
+    fill->hash = object->hash;
+    fill->encoding = object->encoding;
+    fill->upgrade = true;
+    fill->mtime = object->mtime;
+    fill->file_size = object->file_size;
+    snprintf(fill->content_type, sizeof(fill->content_type), "%s", object->content_type);
+    snprintf(fill->path, sizeof(fill->path), "%s", object->path);
+    fill->next = shard->fills;
+    shard->fills = fill;
+    return fill;
+}
+
+size_t bolt_file_cache_upgrade(BoltFileCache* cache, size_t max_fills) {
+    if (!cache || cache->loader_count == 0 || max_fills == 0) return 0;
+
+    /* Keep it in the background: never more than max_fills waiting */
+    EnterCriticalSection(&cache->queue_lock);
+    size_t waiting = cache->queue_length;
+    LeaveCriticalSection(&cache->queue_lock);
+    if (waiting >= max_fills) return 0;
+    max_fills -= waiting;
+
+    CacheFill* fills = NULL;
+    size_t found = 0;
+    size_t scanned = 0;
+    while (scanned < CACHE_UPGRADE_SCAN && found < max_fills) {
+        CacheShard* shard = &cache->shards[cache->upgrade_shard];
+
+        EnterCriticalSection(&shard->lock);
+        while (cache->upgrade_slot < shard->capacity &&
+               scanned < CACHE_UPGRADE_SCAN && found < max_fills) {
+            CacheEntry* e = &shard->entries[cache->upgrade_slot++];
+            CacheObject* object = e->object;
+            scanned++;
+
+            /* Compressed variants below the level they would get now */
+            if (!object || object->encoding == BOLT_COMPRESS_NONE ||
+                object->body_len >= object->file_size ||
+                e->tried_level >= compression_stored_level(NULL, object->encoding)) {
+                continue;
+            }
+            CacheFill* fill = upgrade_fill(shard, object);
+            if (fill) {
+                fill->queue_next = fills;
+                fills = fill;
+                found++;
+            }
+        }
+        if (cache->upgrade_slot >= shard->capacity) {
+            cache->upgrade_slot = 0;
+            cache->upgrade_shard = (cache->upgrade_shard + 1) & cache->shard_mask;
+        }
+        LeaveCriticalSection(&shard->lock);
     }
 
-    char* headers = (char*)malloc(hdr_len);
-    if (!headers) {
-        free(body);
-        ReleaseSRWLockExclusive(&cache->lock);
-        return false;
+    while (fills) {
+        CacheFill* fill = fills;
+        fills = fill->queue_next;
+        fill->queue_next = NULL;
+        if (!fill_enqueue(cache, fill)) {
+            fill_commit(cache, fill, NULL, NULL);
+            found--;
+        }
     }
-    memcpy(headers, header_tmp, hdr_len);
-
-    /* Commit entry */
-    memset(e, 0, sizeof(*e));
-    e->used = true;
-    e->hash = h;
-    e->mtime = mtime;
-    e->file_size = file_size;
-    e->headers = headers;
-    e->headers_len = hdr_len;
-    e->body = body;
-    e->body_len = file_size;
-    e->total_bytes = total;
-    e->last_used = GetTickCount64();
-    strncpy(e->path, filepath, sizeof(e->path) - 1);
-
-    cache->total_bytes += total;
-
-    out->headers = e->headers;
-    out->headers_len = e->headers_len;
-    out->body = e->body;
-    out->body_len = e->body_len;
-
-    ReleaseSRWLockExclusive(&cache->lock);
-    return true;
+    return found;
 }
 
+void bolt_file_cache_release(BoltFileCache* cache, void* ref) {
+    BOLT_UNUSED(cache);
+    if (!ref) return;
 
+    object_release((CacheObject*)ref);
+}
+
+void bolt_file_cache_stats(BoltFileCache* cache, BoltFileCacheStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask; i++) {
+        CacheShard* shard = &cache->shards[i];
+        EnterCriticalSection(&shard->lock);
+        stats->entries += shard->policy.entries;
+        stats->bytes += shard->policy.small_bytes + shard->policy.main_bytes;
+        stats->evictions += shard->policy.evictions;
+        stats->promotions += shard->policy.promotions;
+        stats->ghost_hits += shard->policy.ghost_hits;
+        stats->fills += shard->fills_done;
+        stats->compressions += shard->compressions;
+        stats->fill_fallbacks += shard->fill_fallbacks;
+        stats->invalidations += shard->invalidations;
+        stats->upgrades += shard->upgrades;
+        LeaveCriticalSection(&shard->lock);
+    }
+
+    for (size_t i = 0; i < BOLT_FILE_CACHE_READERS; i++) {
+        stats->hits += cache->readers[i].r.hits;
+        stats->misses += cache->readers[i].r.misses;
+    }
+    stats->shards = cache->shard_mask + 1;
+}
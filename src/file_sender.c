@@ -2,8 +2,59 @@
 #include "../include/bolt_server.h"
 #include "../include/iocp.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/* Streams in progress (capped at BOLT_STREAM_MAX_ACTIVE) and started */
+static volatile LONG g_active_streams = 0;
+static volatile LONG64 g_total_streams = 0;
+
+/* "xxxx\r\n" before each chunk: 4 hex digits cover the 64 KB send buffer */
+#define CHUNK_HEADER_LEN 6
+#define CHUNK_TRAILER_LEN 2             /* "\r\n" after the data */
+#define LAST_CHUNK "0\r\n\r\n"
+#define LAST_CHUNK_LEN 5
+
+/* Send buffer kept free for headers in front of a body written in place */
+#define SEND_HEADER_ROOM 1024
+
+/*
+ * Append a segment to the staged send, extending the last one when the
+ * data follows it directly (consecutive send_buffer runs).
+ * Returns false if no segment slot is left.
+ */
+static bool stage_segment(BoltConnection* conn, const char* data, size_t len) {
+    if (len == 0) return true;
+    
+    int count = conn->send_segment_count;
+    if (count > 0) {
+        WSABUF* last = &conn->send_segments[count - 1];
+        if (last->buf + last->len == data) {
+            last->len += (ULONG)len;
+            conn->send_staged += len;
+            return true;
+        }
+    }
+    if (count == BOLT_SEND_SEGMENTS) return false;
+    
+    conn->send_segments[count].buf = (char*)data;
+    conn->send_segments[count].len = (ULONG)len;
+    conn->send_segment_count = count + 1;
+    conn->send_staged += len;
+    return true;
+}
+
+/*
+ * Send the staged segments now, or leave them for a later response when
+ * more pipelined requests follow.
+ */
+static bool finish_staged(BoltConnection* conn) {
+    if (conn->pipelining) {
+        return true;
+    }
+    return bolt_conn_post_staged(conn);
+}
+
 /*
  * Open file for TransmitFile.
  */
@@ -47,12 +98,13 @@ bool bolt_send_file(BoltConnection* conn, const char* filepath,
                     const HttpRange* range) {
     if (!conn || !filepath || !g_bolt_server) return false;
     
-    size_t file_size = 0;
-    HANDLE file = bolt_open_file(filepath, &file_size);
-    
-    if (file == INVALID_HANDLE_VALUE) {
+    /* Shared handle from the open-file cache (a private one without it) */
+    BoltOpenFile* open_file = bolt_open_file_cache_open(g_bolt_server->open_file_cache, filepath);
+    if (!open_file) {
         return false;
     }
+    HANDLE file = open_file->handle;
+    size_t file_size = open_file->size;
     
     /* Determine range to send */
     size_t range_start = 0;
@@ -64,7 +116,7 @@ bool bolt_send_file(BoltConnection* conn, const char* filepath,
         
         /* Validate range */
         if (range_start >= file_size || range_length == 0) {
-            CloseHandle(file);
+            bolt_open_file_release(open_file);
             return false;
         }
         if (range_start + range_length > file_size) {
@@ -75,9 +127,36 @@ bool bolt_send_file(BoltConnection* conn, const char* filepath,
         range_length = file_size;
     }
     
+    /* Responses staged for earlier pipelined requests go out ahead of
+     * the file headers, as long as they are one run of the send buffer */
+    size_t staged = conn->send_staged;
+    if (staged > 0) {
+        bool contiguous = conn->send_segment_count == 1 &&
+                          conn->send_segments[0].buf == conn->send_buffer;
+        if (!contiguous || header_len > conn->send_buffer_size - staged) {
+            bolt_open_file_release(open_file);
+            return bolt_conn_defer_request(conn);
+        }
+        if (headers && header_len > 0) {
+            memcpy(conn->send_buffer + staged, headers, header_len);
+        }
+        headers = conn->send_buffer;
+        header_len += staged;
+        conn->send_staged = 0;
+        conn->send_segment_count = 0;
+        conn->send_buffer_used = 0;
+    }
+    
+    /* Enter the sending state before posting: the completion may run on
+     * another worker before this call returns */
+    conn->open_file = open_file;
+    conn->file_size = file_size;
+    conn->file_offset = range_start;
+    bolt_conn_set_state(conn, BOLT_CONN_SENDING_FILE);
+    
     /* Post TransmitFile operation */
     bool result = bolt_iocp_post_transmit_file(
-        g_bolt_server->iocp,
+        conn->iocp,
         conn,
         file,
         file_size,
@@ -88,12 +167,10 @@ bool bolt_send_file(BoltConnection* conn, const char* filepath,
     );
     
     if (!result) {
-        CloseHandle(file);
-        conn->file_handle = INVALID_HANDLE_VALUE;
+        bolt_conn_close_file(conn);
         return false;
     }
     
-    conn->state = BOLT_CONN_SENDING_FILE;
     return true;
 }
 
@@ -110,33 +187,267 @@ bool bolt_send_response(BoltConnection* conn,
         return false;
     }
     
-    /* Calculate total size */
+    /* Calculate total size; append after any staged responses */
     size_t total_len = header_len + body_len;
-    if (total_len > conn->send_buffer_size) {
+    char* dest = conn->send_buffer + conn->send_buffer_used;
+    if (total_len > conn->send_buffer_size - conn->send_buffer_used ||
+        (conn->send_segment_count == BOLT_SEND_SEGMENTS &&
+         conn->send_segments[BOLT_SEND_SEGMENTS - 1].buf +
+         conn->send_segments[BOLT_SEND_SEGMENTS - 1].len != dest)) {
+        if (conn->send_staged > 0) {
+            return bolt_conn_defer_request(conn);
+        }
         return false;  /* Too large */
     }
     
     /* Copy to send buffer */
     if (headers && header_len > 0) {
-        memcpy(conn->send_buffer, headers, header_len);
+        memcpy(dest, headers, header_len);
     }
     if (body && body_len > 0) {
-        memcpy(conn->send_buffer + header_len, body, body_len);
+        memcpy(dest + header_len, body, body_len);
     }
+    conn->send_buffer_used += total_len;
+    stage_segment(conn, dest, total_len);
     
-    /* Post send operation */
-    bool result = bolt_iocp_post_send(
-        g_bolt_server->iocp,
-        conn,
-        conn->send_buffer,
-        total_len
-    );
+    return finish_staged(conn);
+}
+
+/*
+ * Free send buffer space for a body written in place, after room for its
+ * headers.
+ */
+char* bolt_send_body_space(BoltConnection* conn, size_t* room) {
+    if (!conn || !room) return NULL;
+    
+    size_t used = conn->send_buffer_used + SEND_HEADER_ROOM;
+    if (used >= conn->send_buffer_size) {
+        *room = 0;
+        return NULL;
+    }
+    *room = conn->send_buffer_size - used;
+    return conn->send_buffer + used;
+}
+
+/*
+ * Send a body already in the send buffer (at bolt_send_body_space),
+ * copying only the headers in front of it.
+ */
+bool bolt_send_body_in_place(BoltConnection* conn,
+                             const char* headers, size_t header_len,
+                             size_t body_len) {
+    if (!conn || !g_bolt_server || header_len > SEND_HEADER_ROOM) return false;
+    
+    char* body = conn->send_buffer + conn->send_buffer_used + SEND_HEADER_ROOM;
+    char* dest = body - header_len;
+    if (conn->send_segment_count == BOLT_SEND_SEGMENTS &&
+        conn->send_segments[BOLT_SEND_SEGMENTS - 1].buf +
+        conn->send_segments[BOLT_SEND_SEGMENTS - 1].len != dest) {
+        if (conn->send_staged > 0) {
+            return bolt_conn_defer_request(conn);
+        }
+        return false;
+    }
+    
+    memcpy(dest, headers, header_len);
+    conn->send_buffer_used = (size_t)(body + body_len - conn->send_buffer);
+    stage_segment(conn, dest, header_len + body_len);
     
-    if (result) {
-        conn->state = BOLT_CONN_SENDING;
+    return finish_staged(conn);
+}
+
+/*
+ * Send cached headers and body without copying them.
+ */
+bool bolt_send_cached(BoltConnection* conn, const BoltCachedResponse* cached) {
+    if (!conn || !cached || !g_bolt_server) return false;
+    
+    /* Needs two segments and a reference slot */
+    if (conn->send_segment_count > BOLT_SEND_SEGMENTS - 2 ||
+        conn->send_ref_count == BOLT_SEND_SEGMENTS) {
+        bolt_file_cache_release(g_bolt_server->file_cache, cached->ref);
+        if (conn->send_staged > 0) {
+            return bolt_conn_defer_request(conn);
+        }
+        return false;
     }
     
-    return result;
+    if (cached->ref) {
+        conn->send_refs[conn->send_ref_count++] = cached->ref;
+    }
+    stage_segment(conn, cached->headers, cached->headers_len);
+    stage_segment(conn, cached->body, cached->body_len);
+    
+    return finish_staged(conn);
+}
+
+/*
+ * Encode the next part of the stream into the send buffer from
+ * stream->offset on, as one chunk (plus the last chunk once the file is
+ * done), and stage it. Runs on a compute thread when the pool takes it.
+ */
+static bool stream_encode(BoltConnection* conn) {
+    BoltSendStream* stream = conn->stream;
+    size_t offset = stream->offset;
+    char* chunk = conn->send_buffer + offset;
+    char* data = chunk + CHUNK_HEADER_LEN;
+    size_t room = conn->send_buffer_size - offset -
+                  CHUNK_HEADER_LEN - CHUNK_TRAILER_LEN - LAST_CHUNK_LEN;
+    if (room > 0xFFFF) room = 0xFFFF;
+    
+    size_t produced_total = 0;
+    bool done = false;
+    while (produced_total < room && !done) {
+        /* Refill the input once the encoder has taken all of it */
+        if (stream->in_pos == stream->in_len && stream->remaining > 0) {
+            DWORD want = (DWORD)(stream->remaining < sizeof(stream->input) ?
+                                 stream->remaining : sizeof(stream->input));
+            DWORD got = 0;
+            if (!ReadFile(stream->file, stream->input, want, &got, NULL)) {
+                return false;
+            }
+            /* A file that shrank mid-transfer just ends the stream early */
+            stream->remaining = got == 0 ? 0 : stream->remaining - got;
+            stream->in_pos = 0;
+            stream->in_len = got;
+        }
+    
+        bool finish = stream->remaining == 0 && stream->in_pos == stream->in_len;
+        size_t consumed = 0;
+        size_t produced = 0;
+        if (!compression_stream_write(stream->encoder,
+                                      stream->input + stream->in_pos,
+                                      stream->in_len - stream->in_pos, &consumed,
+                                      data + produced_total, room - produced_total, &produced,
+                                      finish, &done)) {
+            return false;
+        }
+        if (consumed == 0 && produced == 0 && !done) {
+            return false;  /* Encoder made no progress with room left */
+        }
+        stream->in_pos += consumed;
+        produced_total += produced;
+    }
+    
+    size_t len = offset;
+    if (produced_total > 0) {
+        char size_line[24];
+        snprintf(size_line, sizeof(size_line), "%04zx\r\n", produced_total);
+        memcpy(chunk, size_line, CHUNK_HEADER_LEN);
+        len += CHUNK_HEADER_LEN + produced_total;
+        memcpy(conn->send_buffer + len, "\r\n", CHUNK_TRAILER_LEN);
+        len += CHUNK_TRAILER_LEN;
+    }
+    if (done) {
+        memcpy(conn->send_buffer + len, LAST_CHUNK, LAST_CHUNK_LEN);
+        len += LAST_CHUNK_LEN;
+        stream->finished = true;
+    }
+    
+    conn->send_segment_count = 0;
+    conn->send_buffer_used = len;
+    stage_segment(conn, conn->send_buffer, len);
+    return true;
+}
+
+/*
+ * Compute pool completion: send what the job encoded.
+ */
+static void stream_encoded(BoltConnection* conn) {
+    if (!conn->task.ok || !bolt_conn_post_staged(conn)) {
+        bolt_conn_close(conn);
+        bolt_conn_release(conn->pool, conn);
+    }
+}
+
+/*
+ * Encode and post the next chunks: on a compute thread, or here if the
+ * pool does not take them.
+ */
+static bool stream_post(BoltConnection* conn, size_t offset) {
+    conn->stream->offset = offset;
+    if (bolt_task_submit(g_bolt_server->task_pool, conn, stream_encode, stream_encoded)) {
+        return true;
+    }
+    return stream_encode(conn) && bolt_conn_post_staged(conn);
+}
+
+/*
+ * Start a compressed chunked transfer.
+ */
+bool bolt_send_stream(BoltConnection* conn, const char* filepath,
+                      const char* headers, size_t header_len,
+                      BoltCompressionType type, int level) {
+    if (!conn || !filepath || !headers || !g_bolt_server) return false;
+    
+    /* Sent on its own: earlier pipelined responses go out first */
+    if (conn->send_staged > 0) {
+        return bolt_conn_defer_request(conn);
+    }
+    if (header_len > conn->send_buffer_size / 2) {
+        return false;
+    }
+    
+    if (InterlockedIncrement(&g_active_streams) > BOLT_STREAM_MAX_ACTIVE) {
+        InterlockedDecrement(&g_active_streams);
+        return false;
+    }
+    
+    BoltSendStream* stream = (BoltSendStream*)malloc(sizeof(BoltSendStream));
+    if (!stream) {
+        InterlockedDecrement(&g_active_streams);
+        return false;
+    }
+    stream->in_pos = 0;
+    stream->in_len = 0;
+    stream->finished = false;
+    stream->encoder = compression_stream_create(type, level);
+    stream->file = bolt_open_file(filepath, &stream->remaining);
+    conn->stream = stream;
+    if (!stream->encoder || stream->file == INVALID_HANDLE_VALUE) {
+        bolt_send_stream_release(conn);
+        return false;
+    }
+    InterlockedIncrement64(&g_total_streams);
+    
+    memcpy(conn->send_buffer, headers, header_len);
+    if (!stream_post(conn, header_len)) {
+        bolt_send_stream_release(conn);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Next chunks after a completed send.
+ */
+bool bolt_send_stream_next(BoltConnection* conn) {
+    if (!conn || !conn->stream || conn->stream->finished) return false;
+    return stream_post(conn, 0);
+}
+
+/*
+ * Release a connection's stream.
+ */
+void bolt_send_stream_release(BoltConnection* conn) {
+    BoltSendStream* stream = conn ? conn->stream : NULL;
+    if (!stream) return;
+    
+    conn->stream = NULL;
+    if (stream->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(stream->file);
+    }
+    compression_stream_destroy(stream->encoder);
+    free(stream);
+    InterlockedDecrement(&g_active_streams);
+}
+
+LONG bolt_send_stream_active(void) {
+    return g_active_streams;
+}
+
+LONG64 bolt_send_stream_total(void) {
+    return g_total_streams;
 }
 
 /*
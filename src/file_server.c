@@ -6,6 +6,8 @@
 #include "../include/http.h"
 #include "../include/file_sender.h"
 #include "../include/file_cache.h"
+#include "../include/open_file_cache.h"
+#include "../include/path_cache.h"
 #include "../include/compression.h"
 #include "../include/metrics.h"
 #include "../include/vhost.h"
@@ -14,9 +16,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <windows.h>
 #include <time.h>
-#include <ws2tcpip.h>
 
 /*
  * Check if a cached response is still valid.
@@ -27,20 +27,22 @@ static bool check_cache_valid(const HttpRequest* request, const FileInfo* info)
     }
     
     /* Check ETag */
-    if (request->if_none_match[0]) {
+    const char* if_none_match = http_header(request, HTTP_HEADER_IF_NONE_MATCH);
+    if (if_none_match) {
         char current_etag[64];
         utils_generate_etag(info, current_etag, sizeof(current_etag));
-        if (strcmp(request->if_none_match, current_etag) == 0) {
+        if (strcmp(if_none_match, current_etag) == 0) {
             return true;
         }
     }
     
     /* Check If-Modified-Since (basic comparison) */
-    if (request->if_modified_since[0]) {
+    const char* if_modified_since = http_header(request, HTTP_HEADER_IF_MODIFIED_SINCE);
+    if (if_modified_since) {
         /* For simplicity, just compare the date strings */
         char current_date[64];
         utils_format_http_date(info->mtime, current_date, sizeof(current_date));
-        if (strcmp(request->if_modified_since, current_date) == 0) {
+        if (strcmp(if_modified_since, current_date) == 0) {
             return true;
         }
     }
@@ -49,9 +51,11 @@ static bool check_cache_valid(const HttpRequest* request, const FileInfo* info)
 }
 
 /*
- * Send cache headers for a file.
+ * Send cache headers for a file. A precompressed representation passes
+ * its content-coding, which tags the ETag.
  */
-static void build_cache_headers(const FileInfo* info, char* buffer, size_t buffer_size) {
+static void build_cache_headers(const FileInfo* info, const char* coding,
+                                char* buffer, size_t buffer_size) {
     if (!info || !buffer || buffer_size < 128) {
         buffer[0] = '\0';
         return;
@@ -62,6 +66,10 @@ static void build_cache_headers(const FileInfo* info, char* buffer, size_t buffe
     
     utils_generate_etag(info, etag, sizeof(etag));
     utils_format_http_date(info->mtime, last_modified, sizeof(last_modified));
+    if (coding) {
+        size_t len = strlen(etag);
+        snprintf(etag + len - 1, sizeof(etag) - len + 1, "-%s\"", coding);
+    }
     
     snprintf(buffer, buffer_size,
              "ETag: %s\r\n"
@@ -116,7 +124,7 @@ bool file_server_serve_file(SOCKET client, const char* filepath,
     
     /* Build cache headers */
     char cache_headers[256];
-    build_cache_headers(&info, cache_headers, sizeof(cache_headers));
+    build_cache_headers(&info, NULL, cache_headers, sizeof(cache_headers));
     
     /* Open the file */
     FILE* file = fopen(filepath, "rb");
@@ -337,7 +345,11 @@ void file_server_handle(SOCKET client, const HttpRequest* request) {
     if (info.is_directory) {
         /* Try to serve index.html first */
         char index_path[BOLT_MAX_PATH_LENGTH];
-        snprintf(index_path, sizeof(index_path), "%s\\" BOLT_INDEX_FILE, filepath);
+        if (snprintf(index_path, sizeof(index_path), "%s" BOLT_PATH_SEP_STR BOLT_INDEX_FILE,
+                     filepath) >= (int)sizeof(index_path)) {
+            http_send_error(client, HTTP_404_NOT_FOUND);  /* Too long to be served */
+            return;
+        }
         
         FileInfo index_info = utils_get_file_info(index_path);
         if (index_info.exists && !index_info.is_directory) {
@@ -356,46 +368,6 @@ void file_server_handle(SOCKET client, const HttpRequest* request) {
  * Bolt async fast-path
  * ========================= */
 
-/*
- * Extract a header value from the request buffer.
- */
-static void extract_header_from_buffer(const char* request, const char* header_name,
-                                       char* out_value, size_t out_size) {
-    out_value[0] = '\0';
-    
-    /* Find the header */
-    const char* header_start = strstr(request, header_name);
-    if (!header_start) {
-        return;
-    }
-    
-    /* Skip header name and colon */
-    const char* value_start = header_start + strlen(header_name);
-    if (*value_start == ':') {
-        value_start++;
-    }
-    
-    /* Skip whitespace */
-    while (*value_start == ' ' || *value_start == '\t') {
-        value_start++;
-    }
-    
-    /* Find end of line */
-    const char* value_end = value_start;
-    while (*value_end && *value_end != '\r' && *value_end != '\n') {
-        value_end++;
-    }
-    
-    /* Copy value */
-    size_t value_len = value_end - value_start;
-    if (value_len >= out_size) {
-        value_len = out_size - 1;
-    }
-    
-    strncpy(out_value, value_start, value_len);
-    out_value[value_len] = '\0';
-}
-
 /*
  * Sanitize header value to prevent header injection.
  */
@@ -415,22 +387,52 @@ static size_t sanitize_header_value(const char* value, char* out, size_t out_siz
     return len;
 }
 
+/*
+ * Sanitize a block of header lines: like sanitize_header_value, but the
+ * CRLF ending each line is kept.
+ */
+static size_t sanitize_header_lines(const char* lines, char* out, size_t out_size) {
+    if (!lines || !out || out_size == 0) return 0;
+
+    size_t len = 0;
+    for (const char* p = lines; *p && len < out_size - 2; p++) {
+        if (p[0] == '\r' && p[1] == '\n') {
+            out[len++] = '\r';
+            out[len++] = '\n';
+            p++;
+            continue;
+        }
+        char c = *p;
+        if (c == '\r' || c == '\n' || (c < 0x20 && c != '\t')) {
+            continue;
+        }
+        out[len++] = c;
+    }
+    out[len] = '\0';
+    return len;
+}
+
 static size_t build_headers_206(char* out, size_t out_sz,
                                 const char* content_type,
                                 size_t range_start,
                                 size_t range_end,
                                 size_t file_size,
                                 const char* extra_headers,
-                                bool keep_alive) {
+                                bool keep_alive,
+                                const char* content_encoding) {
     /* Sanitize header values */
     char safe_ct[256] = "application/octet-stream";
     char safe_extra[512] = "";
+    char safe_encoding[64] = "";
     
     if (content_type) {
         sanitize_header_value(content_type, safe_ct, sizeof(safe_ct));
     }
     if (extra_headers && *extra_headers) {
-        sanitize_header_value(extra_headers, safe_extra, sizeof(safe_extra));
+        sanitize_header_lines(extra_headers, safe_extra, sizeof(safe_extra));
+    }
+    if (content_encoding && *content_encoding) {
+        sanitize_header_value(content_encoding, safe_encoding, sizeof(safe_encoding));
     }
     
     size_t range_length = range_end - range_start + 1;
@@ -440,11 +442,18 @@ static size_t build_headers_206(char* out, size_t out_sz,
         "Server: " BOLT_SERVER_NAME "\r\n"
         "Connection: %s\r\n"
         "Keep-Alive: timeout=60, max=1000\r\n"
-        "Content-Type: %s\r\n"
+        "Content-Type: %s\r\n",
+        keep_alive ? "keep-alive" : "close",
+        safe_ct);
+    
+    if (safe_encoding[0]) {
+        offset += snprintf(out + offset, out_sz - offset,
+            "Content-Encoding: %s\r\n", safe_encoding);
+    }
+    
+    offset += snprintf(out + offset, out_sz - offset,
         "Content-Range: bytes %zu-%zu/%zu\r\n"
         "Content-Length: %zu\r\n",
-        keep_alive ? "keep-alive" : "close",
-        safe_ct,
         range_start, range_end, file_size,
         range_length);
     
@@ -461,6 +470,38 @@ static size_t build_headers_206(char* out, size_t out_sz,
     return (size_t)offset;
 }
 
+/* build_headers_200 content_length of a streamed (chunked) body */
+#define CHUNKED_LENGTH SIZE_MAX
+
+/* A small file read for compression without the file cache */
+static BOLT_THREAD_LOCAL char g_small_file[BOLT_SEND_BUFFER_SIZE / 2];
+
+/*
+ * Read a small file whole into the calling thread's buffer.
+ */
+static bool read_small_file(const char* filepath, size_t size) {
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD bytes_read = 0;
+    bool read_ok = ReadFile(file, g_small_file, (DWORD)size, &bytes_read, NULL) &&
+                   bytes_read == size;
+    CloseHandle(file);
+    return read_ok;
+}
+
+/*
+ * Compute pool job: read and compress a small file into the send buffer.
+ */
+static bool compress_small_file(BoltConnection* conn) {
+    BoltTask* task = &conn->task;
+    return read_small_file(task->path, task->size) &&
+           compression_compress_into((BoltCompressionType)task->type, g_small_file, task->size,
+                                     task->out, task->out_size, &task->out_len, task->level);
+}
+
 static size_t build_headers_200(char* out, size_t out_sz,
                                 const char* content_type,
                                 size_t content_length,
@@ -476,7 +517,7 @@ static size_t build_headers_200(char* out, size_t out_sz,
         sanitize_header_value(content_type, safe_ct, sizeof(safe_ct));
     }
     if (extra_headers && *extra_headers) {
-        sanitize_header_value(extra_headers, safe_extra, sizeof(safe_extra));
+        sanitize_header_lines(extra_headers, safe_extra, sizeof(safe_extra));
     }
     if (content_encoding && *content_encoding) {
         sanitize_header_value(content_encoding, safe_encoding, sizeof(safe_encoding));
@@ -496,8 +537,14 @@ static size_t build_headers_200(char* out, size_t out_sz,
             "Content-Encoding: %s\r\n", safe_encoding);
     }
     
+    if (content_length == CHUNKED_LENGTH) {
+        offset += snprintf(out + offset, out_sz - offset, "Transfer-Encoding: chunked\r\n");
+    } else {
+        offset += snprintf(out + offset, out_sz - offset,
+            "Content-Length: %zu\r\n", content_length);
+    }
+    
     offset += snprintf(out + offset, out_sz - offset,
-        "Content-Length: %zu\r\n"
         "%s"
         "X-Frame-Options: DENY\r\n"
         "X-Content-Type-Options: nosniff\r\n"
@@ -505,7 +552,6 @@ static size_t build_headers_200(char* out, size_t out_sz,
         "Referrer-Policy: strict-origin-when-cross-origin\r\n"
         "Permissions-Policy: geolocation=(), microphone=(), camera=()\r\n"
         "\r\n",
-        content_length,
         safe_extra);
     
     return (size_t)offset;
@@ -558,8 +604,193 @@ void send_error_async(BoltConnection* conn, HttpStatus status) {
     /* If this fails, close connection (worker will release on completion path) */
     if (!bolt_send_response(conn, headers, hdr_len, body, (size_t)body_len)) {
         bolt_conn_close(conn);
-        bolt_conn_release(g_bolt_server->conn_pool, conn);
+        bolt_conn_release(conn->pool, conn);
+    }
+}
+
+/*
+ * Prebuilt 403/404 responses (keep-alive and close variants), formatted
+ * once by whichever request needs them first and sent straight from this
+ * memory. Requests racing the first one format their own.
+ */
+typedef struct {
+    volatile LONG state;        /* 0 empty, 1 building, 2 ready */
+    size_t len;
+    char data[640];
+} PrebuiltError;
+
+static PrebuiltError g_prebuilt_errors[2][2];   /* [403, 404][close, keep-alive] */
+
+static void send_prebuilt_error(BoltConnection* conn, HttpStatus status) {
+    PrebuiltError* prebuilt =
+        &g_prebuilt_errors[status == HTTP_404_NOT_FOUND][conn->keep_alive ? 1 : 0];
+
+    if (prebuilt->state != 2) {
+        if (InterlockedCompareExchange(&prebuilt->state, 1, 0) != 0) {
+            send_error_async(conn, status);
+            return;
+        }
+        int body_len = snprintf(NULL, 0, "%d %s\n", status, http_status_text(status));
+        size_t hdr_len = build_headers_status(prebuilt->data, sizeof(prebuilt->data), status,
+                                              "text/plain; charset=utf-8",
+                                              (size_t)body_len, conn->keep_alive);
+        snprintf(prebuilt->data + hdr_len, sizeof(prebuilt->data) - hdr_len,
+                 "%d %s\n", status, http_status_text(status));
+        prebuilt->len = hdr_len + (size_t)body_len;
+        MemoryBarrier();
+        prebuilt->state = 2;
+    }
+
+    BoltCachedResponse response = { prebuilt->data, prebuilt->len, NULL, 0, NULL };
+    if (!bolt_send_cached(conn, &response)) {
+        bolt_conn_close(conn);
+        bolt_conn_release(conn->pool, conn);
+    }
+}
+
+/* Precompressed siblings, by BoltSidecar: file suffix and content-coding */
+static const char* const g_sidecar_suffix[BOLT_SIDECAR_COUNT] = { ".br", ".zst", ".gz" };
+static const BoltCompressionType g_sidecar_type[BOLT_SIDECAR_COUNT] = {
+    BOLT_COMPRESS_BROTLI, BOLT_COMPRESS_ZSTD, BOLT_COMPRESS_GZIP
+};
+
+static bool sidecar_enabled(BoltSidecar sidecar) {
+    if (!g_bolt_server) return false;
+    switch (sidecar) {
+        case BOLT_SIDECAR_BR:   return g_bolt_server->brotli_static;
+        case BOLT_SIDECAR_ZSTD: return g_bolt_server->zstd_static;
+        default:                return g_bolt_server->gzip_static;
+    }
+}
+
+/*
+ * Map a request onto the filesystem: rewrite rules, virtual host, path
+ * sanitizing, stat, index file, precompressed siblings, content type and
+ * validators. The result
+ * depends only on the host, the URI, the configuration and the files,
+ * so it can be cached. A forbidden or missing path resolves to an error
+ * (negative-cached). Returns false once it has answered the request
+ * itself (413, directory listing).
+ */
+static bool resolve_request(BoltConnection* conn, const HttpRequest* request,
+                            const char* host_header, BoltResolvedPath* out) {
+    memset(out, 0, sizeof(*out));
+    out->kind = BOLT_RESOLVED_FILE;
+
+    /* Apply rewrite rules */
+    char rewritten_uri[2048];
+    bool was_rewritten = false;
+    if (g_bolt_server && g_bolt_server->rewrite_engine) {
+        was_rewritten = rewrite_apply(g_bolt_server->rewrite_engine, request->uri,
+                                      rewritten_uri, sizeof(rewritten_uri));
+    }
+    
+    const char* uri_to_use = was_rewritten ? rewritten_uri : request->uri;
+    
+    /* Check for redirect */
+    if (was_rewritten && g_bolt_server && g_bolt_server->rewrite_engine) {
+        BoltRewriteRule* rule = g_bolt_server->rewrite_engine->rules;
+        while (rule) {
+            if (rewrite_match_pattern(rule->pattern, request->uri)) {
+                if (rule->type == REWRITE_REDIRECT_301 || rule->type == REWRITE_REDIRECT_302) {
+                    out->kind = BOLT_RESOLVED_REDIRECT;
+                    out->status = (rule->type == REWRITE_REDIRECT_301) ? 301 : 302;
+                    sanitize_header_value(rewritten_uri, out->path, sizeof(out->path));
+                    return true;
+                }
+                break;
+            }
+            rule = rule->next;
+        }
+    }
+    
+    /* Determine virtual host */
+    BoltVHost* vhost = NULL;
+    if (g_bolt_server && g_bolt_server->vhost_manager) {
+        vhost = vhost_find(g_bolt_server->vhost_manager, host_header);
+        if (!vhost) {
+            vhost = vhost_get_default(g_bolt_server->vhost_manager);
+        }
+    }
+    
+    /* Determine web root */
+    const char* web_root = g_bolt_server ? g_bolt_server->web_root : BOLT_WEB_ROOT;
+    if (vhost && vhost->root[0]) {
+        web_root = vhost->root;
+    }
+    
+    char* filepath = out->path;
+    if (!utils_sanitize_path_with_root(uri_to_use, web_root, filepath, sizeof(out->path))) {
+        out->kind = BOLT_RESOLVED_ERROR;
+        out->status = HTTP_403_FORBIDDEN;
+        return true;
+    }
+
+    BoltOpenFileCache* open_files = g_bolt_server ? g_bolt_server->open_file_cache : NULL;
+    FileInfo info = bolt_open_file_cache_stat(open_files, filepath);
+    if (!info.exists) {
+        out->kind = BOLT_RESOLVED_ERROR;
+        out->status = HTTP_404_NOT_FOUND;
+        return true;
+    }
+
+    if (info.is_directory) {
+        /* Try index file */
+        char index_path[BOLT_MAX_PATH_LENGTH];
+        if (snprintf(index_path, sizeof(index_path), "%s" BOLT_PATH_SEP_STR BOLT_INDEX_FILE,
+                     filepath) >= (int)sizeof(index_path)) {
+            out->kind = BOLT_RESOLVED_ERROR;    /* Too long to be served */
+            out->status = HTTP_404_NOT_FOUND;
+            return true;
+        }
+        FileInfo index_info = bolt_open_file_cache_stat(open_files, index_path);
+        if (index_info.exists && !index_info.is_directory) {
+            strcpy(filepath, index_path);  /* Same size as out->path */
+            info = index_info;
+        } else {
+#if BOLT_ENABLE_DIR_LISTING
+            /* Not performance critical (disabled by default) */
+            file_server_serve_directory(conn->socket, filepath, request->uri);
+            return false;
+#else
+            out->kind = BOLT_RESOLVED_ERROR;
+            out->status = HTTP_404_NOT_FOUND;
+            return true;
+#endif
+        }
+    }
+
+    if (info.size > BOLT_MAX_FILE_SIZE) {
+        send_error_async(conn, HTTP_413_PAYLOAD_TOO_LARGE);
+        return false;
+    }
+    out->info = info;
+
+    /* app.js.br / app.js.gz built next to app.js; older ones are ignored */
+    for (int i = 0; i < BOLT_SIDECAR_COUNT; i++) {
+        char sidecar_path[BOLT_MAX_PATH_LENGTH];
+        if (!sidecar_enabled((BoltSidecar)i) ||
+            snprintf(sidecar_path, sizeof(sidecar_path), "%s%s", filepath,
+                     g_sidecar_suffix[i]) >= (int)sizeof(sidecar_path)) {
+            continue;
+        }
+        FileInfo sidecar = bolt_open_file_cache_stat(open_files, sidecar_path);
+        if (sidecar.exists && !sidecar.is_directory && sidecar.mtime >= info.mtime) {
+            out->sidecars[i] = sidecar;
+        }
+    }
+
+    const char* ext = utils_get_extension(filepath);
+    const char* mime_type = mime_get_type(ext);
+    if (mime_is_text(mime_type)) {
+        snprintf(out->content_type, sizeof(out->content_type), "%s; charset=utf-8", mime_type);
+    } else {
+        strncpy(out->content_type, mime_type, sizeof(out->content_type) - 1);
+        out->content_type[sizeof(out->content_type) - 1] = '\0';
     }
+
+    build_cache_headers(&info, NULL, out->validators, sizeof(out->validators));
+    return true;
 }
 
 void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
@@ -573,7 +804,7 @@ void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
 
     /* Handle metrics endpoint */
     if (metrics_is_endpoint(request->uri)) {
-        char metrics_json[2048];
+        char metrics_json[4096];
         size_t json_len = 0;
         if (metrics_generate_json(g_bolt_server, metrics_json, sizeof(metrics_json), &json_len)) {
             char headers[512];
@@ -606,7 +837,7 @@ void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
             "\r\n");
         if (!bolt_send_headers_only(conn, headers, hdr_len)) {
             bolt_conn_close(conn);
-            bolt_conn_release(g_bolt_server->conn_pool, conn);
+            bolt_conn_release(conn->pool, conn);
         }
         return;
     }
@@ -628,206 +859,242 @@ void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
             "\r\n");
         if (!bolt_send_headers_only(conn, headers, hdr_len)) {
             bolt_conn_close(conn);
-            bolt_conn_release(g_bolt_server->conn_pool, conn);
+            bolt_conn_release(conn->pool, conn);
         }
         return;
     }
 
-    /* Apply rewrite rules */
-    char rewritten_uri[2048];
-    bool was_rewritten = false;
-    if (g_bolt_server && g_bolt_server->rewrite_engine) {
-        was_rewritten = rewrite_apply(g_bolt_server->rewrite_engine, request->uri,
-                                      rewritten_uri, sizeof(rewritten_uri));
+    /* Host only matters once virtual hosts are configured */
+    const char* host_header = "";
+    if (g_bolt_server && g_bolt_server->vhost_manager && g_bolt_server->vhost_manager->vhosts) {
+        const char* host = http_header(request, HTTP_HEADER_HOST);
+        if (host) host_header = host;
     }
-    
-    const char* uri_to_use = was_rewritten ? rewritten_uri : request->uri;
-    
-    /* Check for redirect */
-    if (was_rewritten && g_bolt_server && g_bolt_server->rewrite_engine) {
-        BoltRewriteRule* rule = g_bolt_server->rewrite_engine->rules;
-        while (rule) {
-            if (rewrite_match_pattern(rule->pattern, request->uri)) {
-                if (rule->type == REWRITE_REDIRECT_301 || rule->type == REWRITE_REDIRECT_302) {
-                    int status = (rule->type == REWRITE_REDIRECT_301) ? 301 : 302;
-                    char headers[512];
-                    size_t hdr_len = snprintf(headers, sizeof(headers),
-                        "HTTP/1.1 %d %s\r\n"
-                        "Server: " BOLT_SERVER_NAME "\r\n"
-                        "Location: %s\r\n"
-                        "Content-Length: 0\r\n"
-                        "\r\n",
-                        status, status == 301 ? "Moved Permanently" : "Found",
-                        rewritten_uri);
-                    if (bolt_send_headers_only(conn, headers, hdr_len)) {
-                        return;
-                    }
-                }
-                break;
-            }
-            rule = rule->next;
+
+    /* Hot requests skip resolution entirely, and so do repeated misses */
+    BoltPathCache* paths = g_bolt_server ? g_bolt_server->path_cache : NULL;
+    BoltPathCache* negatives = g_bolt_server ? g_bolt_server->negative_cache : NULL;
+    BoltResolvedPath resolved;
+    LONG64 generation;
+    LONG64 negative_generation;
+    if (!bolt_path_cache_lookup(paths, host_header, request->uri, &resolved, &generation) &&
+        !bolt_path_cache_lookup(negatives, host_header, request->uri, &resolved,
+                                &negative_generation)) {
+        if (!resolve_request(conn, request, host_header, &resolved)) {
+            return;
         }
-    }
-    
-    /* Determine virtual host */
-    BoltVHost* vhost = NULL;
-    if (g_bolt_server && g_bolt_server->vhost_manager) {
-        char host_header[256];
-        extract_header_from_buffer(conn->recv_buffer, "Host", host_header, sizeof(host_header));
-        vhost = vhost_find(g_bolt_server->vhost_manager, host_header);
-        if (!vhost) {
-            vhost = vhost_get_default(g_bolt_server->vhost_manager);
+        if (resolved.kind == BOLT_RESOLVED_ERROR) {
+            bolt_path_cache_insert(negatives, host_header, request->uri, &resolved,
+                                   negative_generation);
+        } else {
+            bolt_path_cache_insert(paths, host_header, request->uri, &resolved, generation);
         }
     }
-    
-    /* Determine web root */
-    const char* web_root = g_bolt_server ? g_bolt_server->web_root : BOLT_WEB_ROOT;
-    if (vhost && vhost->root[0]) {
-        web_root = vhost->root;
-    }
-    
-    char filepath[BOLT_MAX_PATH_LENGTH];
-    if (!utils_sanitize_path_with_root(uri_to_use, web_root, filepath, sizeof(filepath))) {
-        send_error_async(conn, HTTP_403_FORBIDDEN);
+
+    if (resolved.kind == BOLT_RESOLVED_ERROR) {
+        send_prebuilt_error(conn, (HttpStatus)resolved.status);
         return;
     }
 
-    FileInfo info = utils_get_file_info(filepath);
-    if (!info.exists) {
-        send_error_async(conn, HTTP_404_NOT_FOUND);
+    if (resolved.kind == BOLT_RESOLVED_REDIRECT) {
+        char headers[512];
+        size_t hdr_len = snprintf(headers, sizeof(headers),
+            "HTTP/1.1 %d %s\r\n"
+            "Server: " BOLT_SERVER_NAME "\r\n"
+            "Location: %s\r\n"
+            "Content-Length: 0\r\n"
+            "\r\n",
+            resolved.status,
+            resolved.status == 301 ? "Moved Permanently" : "Found",
+            resolved.path);
+        if (!bolt_send_headers_only(conn, headers, hdr_len)) {
+            bolt_conn_close(conn);
+            bolt_conn_release(conn->pool, conn);
+        }
         return;
     }
 
-    if (info.is_directory) {
-        /* Try index file */
-        char index_path[BOLT_MAX_PATH_LENGTH];
-        snprintf(index_path, sizeof(index_path), "%s\\" BOLT_INDEX_FILE, filepath);
-        FileInfo index_info = utils_get_file_info(index_path);
-        if (index_info.exists && !index_info.is_directory) {
-            strncpy(filepath, index_path, sizeof(filepath) - 1);
-            filepath[sizeof(filepath) - 1] = '\0';
-            info = index_info;
-        } else {
-#if BOLT_ENABLE_DIR_LISTING
-            /* Not performance critical (disabled by default) */
-            file_server_serve_directory(conn->socket, filepath, request->uri);
-            return;
-#else
-            send_error_async(conn, HTTP_404_NOT_FOUND);
-            return;
-#endif
+    const char* filepath = resolved.path;
+    const char* content_type = resolved.content_type;
+    const char* cache_headers = resolved.validators;
+    FileInfo info = resolved.info;
+
+    /* Range requests are served from the (shared) file handle */
+    const char* range_header = http_header(request, HTTP_HEADER_RANGE);
+    if (!range_header) range_header = "";
+    const char* accept_encoding = http_header(request, HTTP_HEADER_ACCEPT_ENCODING);
+
+    /* A precompressed sibling the client accepts is sent as is, from the
+     * file (ranges apply to the compressed representation) */
+    const char* sidecar_coding = NULL;
+    char sidecar_path[BOLT_MAX_PATH_LENGTH];
+    char sidecar_validators[sizeof(resolved.validators)];
+    BoltCompressionType sidecar_types[BOLT_SIDECAR_COUNT];
+    size_t sidecar_count = 0;
+    for (int i = 0; i < BOLT_SIDECAR_COUNT; i++) {
+        if (resolved.sidecars[i].exists) {
+            sidecar_types[sidecar_count++] = g_sidecar_type[i];
         }
     }
-
-    if (info.size > BOLT_MAX_FILE_SIZE) {
-        send_error_async(conn, HTTP_413_PAYLOAD_TOO_LARGE);
-        return;
+    bool has_sidecar = sidecar_count > 0;
+    BoltCompressionType sidecar_type = has_sidecar ?
+        compression_negotiate(accept_encoding, sidecar_types, sidecar_count) :
+        BOLT_COMPRESS_NONE;
+    for (int i = 0; i < BOLT_SIDECAR_COUNT; i++) {
+        if (sidecar_type == BOLT_COMPRESS_NONE || g_sidecar_type[i] != sidecar_type) continue;
+        snprintf(sidecar_path, sizeof(sidecar_path), "%s%s", resolved.path, g_sidecar_suffix[i]);
+        build_cache_headers(&resolved.sidecars[i], compression_coding_name(g_sidecar_type[i]),
+                            sidecar_validators, sizeof(sidecar_validators));
+        sidecar_coding = compression_coding_name(g_sidecar_type[i]);
+        filepath = sidecar_path;
+        cache_headers = sidecar_validators;
+        info = resolved.sidecars[i];
     }
 
-    const char* ext = utils_get_extension(filepath);
-    const char* mime_type = mime_get_type(ext);
-    char content_type[128];
-    if (mime_is_text(mime_type)) {
-        snprintf(content_type, sizeof(content_type), "%s; charset=utf-8", mime_type);
-    } else {
-        strncpy(content_type, mime_type, sizeof(content_type) - 1);
-        content_type[sizeof(content_type) - 1] = '\0';
+    /* Negotiate the encoding; ranges are served from the identity file */
+    BoltCompressionConfig comp_config = compression_get_default_config();
+    BoltCompressionType comp_type = BOLT_COMPRESS_NONE;
+    bool compressible = compression_should_compress(content_type, &comp_config);
+    if (compressible && !sidecar_coding && info.size >= comp_config.min_size &&
+        range_header[0] == '\0') {
+        comp_type = compression_parse_accept_encoding(accept_encoding, &comp_config);
     }
 
-    /* Small-file cache for mixed-site performance */
+    /* Compressible types vary by Accept-Encoding, whichever variant is sent */
+    char extra_headers[256];
+    snprintf(extra_headers, sizeof(extra_headers), "%s%s", cache_headers,
+             compressible || has_sidecar ? "Vary: Accept-Encoding\r\n" : "");
+
+    /* Small-file cache for mixed-site performance. It holds one variant per
+     * encoding, compressed once per file version. */
+    BoltFileCache* file_cache = NULL;
 #if BOLT_ENABLE_FILE_CACHE
-    if (g_bolt_server && g_bolt_server->file_cache &&
-        request->method != HTTP_HEAD) {
+    file_cache = g_bolt_server ? g_bolt_server->file_cache : NULL;
+#endif
+    if (file_cache && !sidecar_coding && range_header[0] == '\0') {
         BoltCachedResponse cached;
-        if (bolt_file_cache_get(g_bolt_server->file_cache,
-                                filepath,
-                                content_type,
-                                info.mtime,
-                                info.size,
-                                &cached)) {
-            if (!bolt_send_response(conn, cached.headers, cached.headers_len,
-                                    cached.body, cached.body_len)) {
+        if (bolt_file_cache_get_encoded(file_cache,
+                                        filepath,
+                                        content_type,
+                                        comp_type,
+                                        info.mtime,
+                                        info.size,
+                                        &cached)) {
+            if (request->method == HTTP_HEAD) {
+                cached.body_len = 0;
+            }
+            if (!bolt_send_cached(conn, &cached)) {
                 bolt_conn_close(conn);
-                bolt_conn_release(g_bolt_server->conn_pool, conn);
+                bolt_conn_release(conn->pool, conn);
             }
             return;
         }
     }
-#endif
 
-    /* Check if compression should be applied */
-    BoltCompressionConfig comp_config = compression_get_default_config();
-    BoltCompressionType comp_type = BOLT_COMPRESS_NONE;
-    const char* content_encoding = NULL;
-    bool should_compress = false;
-    
-    if (compression_should_compress(content_type, &comp_config) &&
-        info.size >= comp_config.min_size) {
-        comp_type = compression_parse_accept_encoding(request->accept_encoding, &comp_config);
-        if (comp_type == BOLT_COMPRESS_GZIP) {
-            content_encoding = "gzip";
-            should_compress = true;
-        }
-    }
-    
-    /* For small files that fit in send buffer, compress in memory */
-    if (should_compress && info.size <= BOLT_SEND_BUFFER_SIZE / 2) {
-        /* Read file into memory */
-        HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
-                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (file != INVALID_HANDLE_VALUE) {
-            char* file_data = (char*)malloc(info.size);
-            if (file_data) {
-                DWORD bytes_read = 0;
-                if (ReadFile(file, file_data, (DWORD)info.size, &bytes_read, NULL) &&
-                    bytes_read == info.size) {
-                    /* Compress */
-                    BoltCompressedData compressed;
-                    if (compression_gzip(file_data, info.size, &compressed, comp_config.level)) {
-                        /* Build headers with compression */
-                        char cache_headers[256];
-                        build_cache_headers(&info, cache_headers, sizeof(cache_headers));
-                        
-                        char headers[1024];
-                        size_t hdr_len = build_headers_200(headers, sizeof(headers),
-                                                           content_type,
-                                                           compressed.size,
-                                                           cache_headers,
-                                                           conn->keep_alive,
-                                                           content_encoding);
-                        
-                        if (request->method == HTTP_HEAD) {
-                            free(compressed.data);
-                            free(file_data);
-                            CloseHandle(file);
-                            if (!bolt_send_headers_only(conn, headers, hdr_len)) {
-                                bolt_conn_close(conn);
-                                bolt_conn_release(g_bolt_server->conn_pool, conn);
-                            }
-                            return;
-                        }
-                        
-                        /* Send compressed data */
-                        if (bolt_send_response(conn, headers, hdr_len,
-                                               compressed.data, compressed.size)) {
-                            free(compressed.data);
-                            free(file_data);
-                            CloseHandle(file);
-                            return;
-                        }
-                        free(compressed.data);
-                    }
+    /* Overloaded: nothing is compressed on the request path, and what the
+     * cache does not hold yet is sent as is */
+    if (comp_type != BOLT_COMPRESS_NONE && !conn->task.ready &&
+        (!file_cache || info.size > BOLT_SEND_BUFFER_SIZE / 2) && compression_overloaded()) {
+        comp_type = BOLT_COMPRESS_NONE;
+    }
+
+    /* Without the cache, compress small files in memory for this request,
+     * straight into the send buffer with a pooled encoder: on a compute
+     * thread, which answers the request again once it is done, unless the
+     * file is tiny or the pool is busy. With the cache, a miss is sent as
+     * is while the variant is being filled. */
+    if (comp_type != BOLT_COMPRESS_NONE && !file_cache && info.size <= BOLT_SEND_BUFFER_SIZE / 2) {
+        BoltTask* task = &conn->task;
+        int level = compression_level(&comp_config, comp_type);
+        size_t room = 0;
+        char* body = bolt_send_body_space(conn, &room);
+        size_t compressed_len = 0;
+        bool read_ok = true;
+        bool compressed = false;
+        
+        if (task->ready) {
+            /* The compute pool's result, if it is still this file's */
+            task->ready = false;
+            compressed = task->ok && body && task->out == body &&
+                         task->type == (int)comp_type && task->size == info.size &&
+                         strcmp(task->path, filepath) == 0;
+            compressed_len = task->out_len;
+        } else {
+            if (body && info.size >= BOLT_TASK_MIN_COMPRESS &&
+                strlen(filepath) < sizeof(task->path)) {
+                strcpy(task->path, filepath);
+                task->type = (int)comp_type;
+                task->level = level;
+                task->size = info.size;
+                task->out = body;
+                task->out_size = room;
+                if (bolt_task_submit(g_bolt_server ? g_bolt_server->task_pool : NULL,
+                                     conn, compress_small_file, NULL)) {
+                    return;
                 }
-                free(file_data);
             }
-            CloseHandle(file);
+            read_ok = read_small_file(filepath, info.size);
+            compressed = read_ok && body &&
+                         compression_compress_into(comp_type, g_small_file, info.size,
+                                                   body, room, &compressed_len, level);
+        }
+        
+        if (compressed) {
+            /* Build headers with compression */
+            char headers[1024];
+            size_t hdr_len = build_headers_200(headers, sizeof(headers),
+                                               content_type,
+                                               compressed_len,
+                                               extra_headers,
+                                               conn->keep_alive,
+                                               compression_coding_name(comp_type));
+            
+            bool sent = request->method == HTTP_HEAD
+                ? bolt_send_headers_only(conn, headers, hdr_len)
+                : bolt_send_body_in_place(conn, headers, hdr_len, compressed_len);
+            if (!sent) {
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            }
+            return;
+        }
+        if (read_ok && conn->send_staged > 0) {
+            /* No room left behind the staged responses: retry once they are sent */
+            bolt_conn_defer_request(conn);
+            return;
         }
         /* Fall through to uncompressed send if compression failed */
     }
+
+    /* Larger text is compressed while it is sent, in chunks (HTTP/1.1 only) */
+    if (comp_type != BOLT_COMPRESS_NONE && request->version_minor >= 1 &&
+        info.size > BOLT_SEND_BUFFER_SIZE / 2) {
+        const char* coding = compression_coding_name(comp_type);
+        char stream_validators[sizeof(resolved.validators)];
+        char stream_extra[256];
+        build_cache_headers(&info, coding, stream_validators, sizeof(stream_validators));
+        snprintf(stream_extra, sizeof(stream_extra), "%sVary: Accept-Encoding\r\n",
+                 stream_validators);
+        
+        char headers[1024];
+        size_t hdr_len = build_headers_200(headers, sizeof(headers), content_type,
+                                           CHUNKED_LENGTH, stream_extra,
+                                           conn->keep_alive, coding);
+        if (request->method == HTTP_HEAD) {
+            if (!bolt_send_headers_only(conn, headers, hdr_len)) {
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            }
+            return;
+        }
+        if (bolt_send_stream(conn, filepath, headers, hdr_len, comp_type,
+                             compression_level(&comp_config, comp_type))) {
+            return;
+        }
+        /* Too many streams or no encoder: send the file as is */
+    }
     
     /* Parse Range header if present */
-    char range_header[128];
-    extract_header_from_buffer(conn->recv_buffer, "Range", range_header, sizeof(range_header));
     HttpRange range = { 0, SIZE_MAX, false };
     
     if (range_header[0] != '\0') {
@@ -844,16 +1111,12 @@ void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
                 info.size);
             if (!bolt_send_headers_only(conn, headers, hdr_len)) {
                 bolt_conn_close(conn);
-                bolt_conn_release(g_bolt_server->conn_pool, conn);
+                bolt_conn_release(conn->pool, conn);
             }
             return;
         }
     }
     
-    /* Build cache headers (generated per request for non-cached path) */
-    char cache_headers[256];
-    build_cache_headers(&info, cache_headers, sizeof(cache_headers));
-
     char headers[1024];
     size_t hdr_len;
     
@@ -864,22 +1127,23 @@ void bolt_file_server_handle(BoltConnection* conn, const HttpRequest* request) {
                                     range.start,
                                     range.end,
                                     info.size,
-                                    cache_headers,
-                                    conn->keep_alive);
+                                    extra_headers,
+                                    conn->keep_alive,
+                                    sidecar_coding);
     } else {
         /* Full file request */
         hdr_len = build_headers_200(headers, sizeof(headers),
                                     content_type,
                                     info.size,
-                                    cache_headers,
+                                    extra_headers,
                                     conn->keep_alive,
-                                    NULL);
+                                    sidecar_coding);
     }
 
     if (request->method == HTTP_HEAD) {
         if (!bolt_send_headers_only(conn, headers, hdr_len)) {
             bolt_conn_close(conn);
-            bolt_conn_release(g_bolt_server->conn_pool, conn);
+            bolt_conn_release(conn->pool, conn);
         }
         return;
     }
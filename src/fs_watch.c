@@ -0,0 +1,524 @@
+#include "../include/fs_watch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/vfs.h>
+#include <poll.h>
+#include <dirent.h>
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | \
+                    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/* Watched directory; inotify reports events by watch descriptor */
+typedef struct {
+    int wd;
+    bool root;
+    char path[BOLT_MAX_PATH_LENGTH];
+} WatchDir;
+#elif defined(_WIN32)
+#define WATCH_FILTER (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | \
+                      FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | \
+                      FILE_NOTIFY_CHANGE_ATTRIBUTES)
+
+/* Watched tree; one ReadDirectoryChangesW covers the whole subtree */
+typedef struct {
+    HANDLE dir;
+    HANDLE event;
+    OVERLAPPED overlapped;
+    char path[BOLT_MAX_PATH_LENGTH];
+    DWORD buffer[16384];        /* 64 KB, DWORD-aligned as the API requires */
+} WatchRoot;
+#endif
+
+struct BoltFsWatch {
+    BoltFsWatchCallback callback;
+    void* context;
+    size_t roots;
+    bool started;
+    bool lost;                  /* BOLT_FS_LOST already reported */
+
+    /* Statistics */
+    volatile LONG watches;
+    volatile LONG64 events;
+    volatile LONG64 rescans;
+
+#if defined(__linux__)
+    int fd;
+    int stop_fd;
+    WatchDir* dirs;             /* Owned by the watcher thread once started */
+    size_t dir_count;
+    size_t dir_capacity;
+    pthread_t thread;
+#elif defined(_WIN32)
+    WatchRoot* root_watches[BOLT_FS_WATCH_MAX_ROOTS];
+    HANDLE stop_event;
+    HANDLE thread;
+#endif
+};
+
+/*
+ * Join a directory and a name the way utils_sanitize_path_with_root()
+ * joins the web root and the URI, so reported paths match cache keys.
+ */
+static bool path_join(char* out, size_t out_size, const char* dir, const char* name) {
+    size_t len = strlen(dir);
+    bool sep = len > 0 && dir[len - 1] != '/' && dir[len - 1] != '\\';
+    int n = snprintf(out, out_size, "%s%s%s", dir, sep ? BOLT_PATH_SEP_STR : "", name);
+    return n > 0 && (size_t)n < out_size;
+}
+
+static void report_changed(BoltFsWatch* watch, const char* path) {
+    InterlockedIncrement64(&watch->events);
+    watch->callback(watch->context, BOLT_FS_CHANGED, path);
+}
+
+static void report_rescan(BoltFsWatch* watch) {
+    InterlockedIncrement64(&watch->rescans);
+    watch->callback(watch->context, BOLT_FS_RESCAN, NULL);
+}
+
+static void report_lost(BoltFsWatch* watch) {
+    if (watch->lost) return;
+    watch->lost = true;
+    watch->callback(watch->context, BOLT_FS_LOST, NULL);
+}
+
+#if defined(__linux__)
+
+/*============================================================================
+ * inotify backend
+ *
+ * inotify is not recursive: every directory under a root gets its own
+ * watch, added as directories appear and dropped as they go.
+ *============================================================================*/
+
+/* Filesystems whose remote changes inotify never sees */
+static bool is_network_fs(const char* path) {
+    struct statfs st;
+    if (statfs(path, &st) != 0) return true;
+
+    switch ((unsigned long)st.f_type) {
+        case 0x6969UL:          /* NFS */
+        case 0x517BUL:          /* SMB */
+        case 0xFF534D42UL:      /* CIFS */
+        case 0xFE534D42UL:      /* SMB2 */
+        case 0x65735546UL:      /* FUSE (sshfs, s3fs...) */
+        case 0x01021997UL:      /* 9P */
+        case 0x5346414FUL:      /* AFS */
+        case 0x73757245UL:      /* Coda */
+        case 0x564CUL:          /* NCP */
+            return true;
+        default:
+            return false;
+    }
+}
+
+static WatchDir* dir_find(BoltFsWatch* watch, int wd) {
+    for (size_t i = 0; i < watch->dir_count; i++) {
+        if (watch->dirs[i].wd == wd) return &watch->dirs[i];
+    }
+    return NULL;
+}
+
+static void dir_remove(BoltFsWatch* watch, WatchDir* dir) {
+    *dir = watch->dirs[--watch->dir_count];
+    InterlockedExchange(&watch->watches, (LONG)watch->dir_count);
+}
+
+static bool dir_add(BoltFsWatch* watch, const char* path, bool root) {
+    int wd = inotify_add_watch(watch->fd, path, WATCH_MASK);
+    if (wd < 0) return false;
+
+    /* Same directory reached again (moved back): just follow the new path */
+    WatchDir* dir = dir_find(watch, wd);
+    if (!dir) {
+        if (watch->dir_count == watch->dir_capacity) {
+            size_t capacity = watch->dir_capacity ? watch->dir_capacity * 2 : 64;
+            WatchDir* dirs = (WatchDir*)realloc(watch->dirs, capacity * sizeof(WatchDir));
+            if (!dirs) {
+                inotify_rm_watch(watch->fd, wd);
+                return false;
+            }
+            watch->dirs = dirs;
+            watch->dir_capacity = capacity;
+        }
+        dir = &watch->dirs[watch->dir_count++];
+        dir->wd = wd;
+        dir->root = root;
+        InterlockedExchange(&watch->watches, (LONG)watch->dir_count);
+    }
+    snprintf(dir->path, sizeof(dir->path), "%s", path);
+    return true;
+}
+
+/*
+ * Watch a directory and everything below it. Symlinked directories are
+ * not followed.
+ */
+static bool watch_tree(BoltFsWatch* watch, const char* path, bool root) {
+    if (!dir_add(watch, path, root)) {
+        return errno == ENOENT && !root;  /* Already gone again: nothing to follow */
+    }
+
+    DIR* dir = opendir(path);
+    if (!dir) return errno == ENOENT && !root;
+
+    bool ok = true;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        char child[BOLT_MAX_PATH_LENGTH];
+        if (!path_join(child, sizeof(child), path, name)) continue;  /* Too long to be served */
+
+        bool is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = lstat(child, &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (is_dir) ok = watch_tree(watch, child, false);
+    }
+    closedir(dir);
+    return ok;
+}
+
+/* Stop following a directory that moved away, and everything below it */
+static void watch_forget_tree(BoltFsWatch* watch, const char* path) {
+    size_t len = strlen(path);
+    for (size_t i = 0; i < watch->dir_count; ) {
+        const char* p = watch->dirs[i].path;
+        if (strncmp(p, path, len) == 0 && (p[len] == '\0' || p[len] == BOLT_PATH_SEP)) {
+            inotify_rm_watch(watch->fd, watch->dirs[i].wd);
+            dir_remove(watch, &watch->dirs[i]);
+        } else {
+            i++;
+        }
+    }
+}
+
+static void watch_handle(BoltFsWatch* watch, const struct inotify_event* ev) {
+    if (ev->mask & IN_Q_OVERFLOW) {
+        report_rescan(watch);
+        return;
+    }
+
+    WatchDir* dir = dir_find(watch, ev->wd);
+    if (!dir) return;
+
+    if (ev->mask & IN_IGNORED) {
+        bool root = dir->root;
+        dir_remove(watch, dir);
+        if (root) report_lost(watch);
+        return;
+    }
+    if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        /* A subdirectory's parent reports it; a root has no watched parent */
+        if (dir->root) report_lost(watch);
+        return;
+    }
+    if (ev->len == 0) return;
+
+    char path[BOLT_MAX_PATH_LENGTH];
+    if (!path_join(path, sizeof(path), dir->path, ev->name)) return;
+
+    if (ev->mask & IN_ISDIR) {
+        if (ev->mask & IN_MOVED_FROM) {
+            watch_forget_tree(watch, path);
+        }
+        if ((ev->mask & (IN_CREATE | IN_MOVED_TO)) && !watch_tree(watch, path, false)) {
+            report_lost(watch);
+        }
+        /* Every path below it changed */
+        report_rescan(watch);
+        return;
+    }
+
+    report_changed(watch, path);
+}
+
+static void* watch_thread(void* param) {
+    BoltFsWatch* watch = (BoltFsWatch*)param;
+    char buffer[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = {
+        { watch->fd, POLLIN, 0 },
+        { watch->stop_fd, POLLIN, 0 }
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) return NULL;
+
+        ssize_t n = read(watch->fd, buffer, sizeof(buffer));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) break;
+
+        for (char* p = buffer; p < buffer + n; ) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            watch_handle(watch, ev);
+        }
+    }
+
+    report_lost(watch);
+    return NULL;
+}
+
+BoltFsWatch* bolt_fs_watch_create(BoltFsWatchCallback callback, void* context) {
+    if (!callback) return NULL;
+
+    BoltFsWatch* watch = (BoltFsWatch*)calloc(1, sizeof(BoltFsWatch));
+    if (!watch) return NULL;
+    watch->callback = callback;
+    watch->context = context;
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (watch->fd < 0 || watch->stop_fd < 0) {
+        if (watch->fd >= 0) close(watch->fd);
+        if (watch->stop_fd >= 0) close(watch->stop_fd);
+        free(watch);
+        return NULL;
+    }
+    return watch;
+}
+
+void bolt_fs_watch_destroy(BoltFsWatch* watch) {
+    if (!watch) return;
+
+    if (watch->started) {
+        uint64_t one = 1;
+        if (write(watch->stop_fd, &one, sizeof(one)) == (ssize_t)sizeof(one)) {
+            pthread_join(watch->thread, NULL);
+        }
+    }
+    close(watch->fd);
+    close(watch->stop_fd);
+    free(watch->dirs);
+    free(watch);
+}
+
+bool bolt_fs_watch_add_root(BoltFsWatch* watch, const char* root) {
+    if (!watch || !root || watch->started || watch->roots == BOLT_FS_WATCH_MAX_ROOTS) return false;
+    if (is_network_fs(root)) return false;
+
+    if (!watch_tree(watch, root, true)) {
+        watch_forget_tree(watch, root);
+        return false;
+    }
+    watch->roots++;
+    return true;
+}
+
+bool bolt_fs_watch_start(BoltFsWatch* watch) {
+    if (!watch || watch->started || watch->roots == 0) return false;
+
+    watch->started = pthread_create(&watch->thread, NULL, watch_thread, watch) == 0;
+    return watch->started;
+}
+
+#elif defined(_WIN32)
+
+/*============================================================================
+ * ReadDirectoryChangesW backend
+ *
+ * One overlapped, subtree-wide read per root; a completion with no data
+ * means the change buffer overflowed.
+ *============================================================================*/
+
+static bool is_network_path(const char* path) {
+    char full[MAX_PATH];
+    DWORD len = GetFullPathNameA(path, sizeof(full), full, NULL);
+    if (len == 0 || len >= sizeof(full)) return true;
+    if (full[0] == '\\' && full[1] == '\\') return true;  /* UNC share */
+
+    char drive[4] = { full[0], ':', '\\', '\0' };
+    return GetDriveTypeA(drive) == DRIVE_REMOTE;
+}
+
+static bool root_arm(WatchRoot* root) {
+    memset(&root->overlapped, 0, sizeof(root->overlapped));
+    root->overlapped.hEvent = root->event;
+    return ReadDirectoryChangesW(root->dir, root->buffer, sizeof(root->buffer), TRUE,
+                                 WATCH_FILTER, NULL, &root->overlapped, NULL) != 0;
+}
+
+static void root_close(WatchRoot* root) {
+    if (root->dir != INVALID_HANDLE_VALUE) {
+        DWORD bytes;
+        CancelIoEx(root->dir, &root->overlapped);
+        GetOverlappedResult(root->dir, &root->overlapped, &bytes, TRUE);
+        CloseHandle(root->dir);
+    }
+    if (root->event) CloseHandle(root->event);
+    free(root);
+}
+
+static void root_dispatch(BoltFsWatch* watch, WatchRoot* root) {
+    bool rescan = false;
+    FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*)root->buffer;
+
+    for (;;) {
+        char name[BOLT_MAX_PATH_LENGTH];
+        char path[BOLT_MAX_PATH_LENGTH];
+        int len = WideCharToMultiByte(CP_UTF8, 0, info->FileName,
+                                      (int)(info->FileNameLength / sizeof(WCHAR)),
+                                      name, (int)sizeof(name) - 1, NULL, NULL);
+        if (len > 0) {
+            name[len] = '\0';
+            if (path_join(path, sizeof(path), root->path, name)) {
+                report_changed(watch, path);
+            }
+        }
+
+        /* A removed or renamed name may have been a directory */
+        if (info->Action == FILE_ACTION_REMOVED ||
+            info->Action == FILE_ACTION_RENAMED_OLD_NAME ||
+            info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+            rescan = true;
+        }
+
+        if (info->NextEntryOffset == 0) break;
+        info = (FILE_NOTIFY_INFORMATION*)((char*)info + info->NextEntryOffset);
+    }
+
+    if (rescan) report_rescan(watch);
+}
+
+static DWORD WINAPI watch_thread(LPVOID param) {
+    BoltFsWatch* watch = (BoltFsWatch*)param;
+    HANDLE handles[BOLT_FS_WATCH_MAX_ROOTS + 1];
+    DWORD count = (DWORD)watch->roots + 1;
+
+    handles[0] = watch->stop_event;
+    for (size_t i = 0; i < watch->roots; i++) {
+        handles[i + 1] = watch->root_watches[i]->event;
+    }
+
+    for (;;) {
+        DWORD wait = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+        if (wait == WAIT_OBJECT_0) return 0;
+        if (wait < WAIT_OBJECT_0 + 1 || wait >= WAIT_OBJECT_0 + count) break;
+
+        WatchRoot* root = watch->root_watches[wait - WAIT_OBJECT_0 - 1];
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(root->dir, &root->overlapped, &bytes, FALSE)) break;
+
+        if (bytes == 0) {
+            report_rescan(watch);   /* Overflow: the changes were dropped */
+        } else {
+            root_dispatch(watch, root);
+        }
+        if (!root_arm(root)) break;
+    }
+
+    report_lost(watch);
+    return 0;
+}
+
+BoltFsWatch* bolt_fs_watch_create(BoltFsWatchCallback callback, void* context) {
+    if (!callback) return NULL;
+
+    BoltFsWatch* watch = (BoltFsWatch*)calloc(1, sizeof(BoltFsWatch));
+    if (!watch) return NULL;
+    watch->callback = callback;
+    watch->context = context;
+
+    watch->stop_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!watch->stop_event) {
+        free(watch);
+        return NULL;
+    }
+    return watch;
+}
+
+void bolt_fs_watch_destroy(BoltFsWatch* watch) {
+    if (!watch) return;
+
+    if (watch->started) {
+        SetEvent(watch->stop_event);
+        WaitForSingleObject(watch->thread, INFINITE);
+        CloseHandle(watch->thread);
+    }
+    for (size_t i = 0; i < watch->roots; i++) {
+        root_close(watch->root_watches[i]);
+    }
+    CloseHandle(watch->stop_event);
+    free(watch);
+}
+
+bool bolt_fs_watch_add_root(BoltFsWatch* watch, const char* root_path) {
+    if (!watch || !root_path || watch->started || watch->roots == BOLT_FS_WATCH_MAX_ROOTS) return false;
+    if (is_network_path(root_path)) return false;
+
+    WatchRoot* root = (WatchRoot*)calloc(1, sizeof(WatchRoot));
+    if (!root) return false;
+    snprintf(root->path, sizeof(root->path), "%s", root_path);
+
+    root->dir = CreateFileA(root_path, FILE_LIST_DIRECTORY,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING,
+                            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    root->event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (root->dir == INVALID_HANDLE_VALUE || !root->event || !root_arm(root)) {
+        root_close(root);
+        return false;
+    }
+
+    watch->root_watches[watch->roots++] = root;
+    InterlockedIncrement(&watch->watches);
+    return true;
+}
+
+bool bolt_fs_watch_start(BoltFsWatch* watch) {
+    if (!watch || watch->started || watch->roots == 0) return false;
+
+    watch->thread = CreateThread(NULL, 0, watch_thread, watch, 0, NULL);
+    watch->started = watch->thread != NULL;
+    return watch->started;
+}
+
+#else
+
+/* No notification API: callers rely on their TTL */
+
+BoltFsWatch* bolt_fs_watch_create(BoltFsWatchCallback callback, void* context) {
+    BOLT_UNUSED(callback);
+    BOLT_UNUSED(context);
+    return NULL;
+}
+
+void bolt_fs_watch_destroy(BoltFsWatch* watch) {
+    BOLT_UNUSED(watch);
+}
+
+bool bolt_fs_watch_add_root(BoltFsWatch* watch, const char* root) {
+    BOLT_UNUSED(watch);
+    BOLT_UNUSED(root);
+    return false;
+}
+
+bool bolt_fs_watch_start(BoltFsWatch* watch) {
+    BOLT_UNUSED(watch);
+    return false;
+}
+
+#endif
+
+void bolt_fs_watch_stats(BoltFsWatch* watch, BoltFsWatchStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!watch) return;
+
+    out->roots = watch->roots;
+    out->watches = (size_t)watch->watches;
+    out->events = watch->events;
+    out->rescans = watch->rescans;
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 
 /*
  * Status code to text mapping.
@@ -65,159 +66,309 @@ static size_t sanitize_header_value(const char* value, char* out, size_t out_siz
     return len;
 }
 
+/* Names of the headers in HttpHeaderId order, lowercase */
+static const char* const g_header_names[HTTP_HEADER_COUNT] = {
+    "host",
+    "connection",
+    "content-length",
+    "accept-encoding",
+    "if-none-match",
+    "if-modified-since",
+    "range",
+    "referer",
+    "user-agent",
+    "transfer-encoding"
+};
+
+static char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+/* Header name characters (RFC 9110 tchar), by byte; 0x80 and up are not */
+static const unsigned char g_token_chars[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 10 */
+    0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0,   /* 20 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,   /* 30 */
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   /* 40 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1,   /* 50 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   /* 60 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 0   /* 70 */
+};
+
 /*
- * Extract a header value from the request.
+ * First byte from p that is below 0x20 or DEL, or end. Eight bytes at a
+ * time: header values are most of a head, and the first such byte is
+ * nearly always the CR ending the line.
  */
-static void extract_header(const char* request, const char* header_name,
-                          char* out_value, size_t out_size) {
-    out_value[0] = '\0';
-    
-    /* Find the header */
-    const char* header_start = strstr(request, header_name);
-    if (!header_start) {
-        return;
+static const char* find_control_char(const char* p, const char* end) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+    while (end - p >= 8) {
+        uint64_t x;
+        memcpy(&x, p, 8);
+        uint64_t del = x ^ (ones * 0x7f);
+        /* Borrows only run upwards, so the lowest flagged byte is a real one */
+        uint64_t found = ((x - ones * 0x20) & ~x & highs) | ((del - ones) & ~del & highs);
+        if (found) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            break;  /* The byte loop below finds it */
+#else
+            return p + (__builtin_ctzll(found) >> 3);
+#endif
+        }
+        p += 8;
     }
-    
-    /* Skip header name and colon */
-    const char* value_start = header_start + strlen(header_name);
-    if (*value_start == ':') {
-        value_start++;
+    while (p < end && (unsigned char)*p >= 0x20 && *p != 0x7f) p++;
+    return p;
+}
+
+HttpHeaderId http_header_id(const char* name, size_t len) {
+    if (!name) return HTTP_HEADER_OTHER;
+    
+    /* At most one known name per length, except 10 and 17 */
+    HttpHeaderId id;
+    switch (len) {
+        case 4:  id = HTTP_HEADER_HOST; break;
+        case 5:  id = HTTP_HEADER_RANGE; break;
+        case 7:  id = HTTP_HEADER_REFERER; break;
+        case 10: id = ascii_lower(name[0]) == 'c' ? HTTP_HEADER_CONNECTION : HTTP_HEADER_USER_AGENT; break;
+        case 13: id = HTTP_HEADER_IF_NONE_MATCH; break;
+        case 14: id = HTTP_HEADER_CONTENT_LENGTH; break;
+        case 15: id = HTTP_HEADER_ACCEPT_ENCODING; break;
+        case 17: id = ascii_lower(name[0]) == 'i' ? HTTP_HEADER_IF_MODIFIED_SINCE : HTTP_HEADER_TRANSFER_ENCODING; break;
+        default: return HTTP_HEADER_OTHER;
     }
     
-    /* Skip whitespace */
-    while (*value_start == ' ' || *value_start == '\t') {
-        value_start++;
+    const char* known = g_header_names[id];
+    for (size_t i = 0; i < len; i++) {
+        if (ascii_lower(name[i]) != known[i]) return HTTP_HEADER_OTHER;
     }
-    
-    /* Find end of line */
-    const char* value_end = value_start;
-    while (*value_end && *value_end != '\r' && *value_end != '\n') {
-        value_end++;
+    return id;
+}
+
+bool http_slice_has_token(HttpSlice value, const char* token) {
+    if (!value.data || !token) return false;
+    size_t token_len = strlen(token);
+    
+    const char* p = value.data;
+    const char* end = value.data + value.len;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        const char* item = p;
+        while (p < end && *p != ',') p++;
+        const char* item_end = p;
+        while (item_end > item && (item_end[-1] == ' ' || item_end[-1] == '\t')) item_end--;
+        
+        if ((size_t)(item_end - item) == token_len) {
+            size_t i = 0;
+            while (i < token_len && ascii_lower(item[i]) == ascii_lower(token[i])) i++;
+            if (i == token_len) return true;
+        }
     }
-    
-    /* Copy and sanitize value */
-    size_t value_len = value_end - value_start;
-    if (value_len >= out_size) {
-        value_len = out_size - 1;
+    return false;
+}
+
+void http_request_init(HttpRequest* req) {
+    memset(req, 0, sizeof(*req));
+    req->method = HTTP_UNKNOWN;
+    req->uri = "";
+    req->range.end = SIZE_MAX;
+}
+
+/*
+ * Parse "METHOD URI HTTP/1.x" (line without its line ending).
+ */
+static bool parse_request_line(const char* line, const char* end, HttpRequest* req) {
+    const char* p = line;
+    while (p < end && *p != ' ') p++;
+    if (p >= end) return false;
+    req->method = parse_method(line, (size_t)(p - line));
+    
+    /* Path up to the query string; the URI up to the next space */
+    const char* uri = ++p;
+    const char* path_end = NULL;
+    while (p < end && *p != ' ') {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x21 || c == 0x7f) return false;
+        if (c == '?' && !path_end) path_end = p;
+        p++;
     }
+    if (p == uri || p >= end) return false;  /* No version: HTTP/0.9 is not served */
+    if (!path_end) path_end = p;
     
-    char temp[256];
-    size_t temp_len = value_len < sizeof(temp) ? value_len : sizeof(temp) - 1;
-    strncpy(temp, value_start, temp_len);
-    temp[temp_len] = '\0';
+    req->uri = uri;
+    req->uri_len = (size_t)(path_end - uri);
+    if (req->uri_len > BOLT_MAX_URI_LENGTH) return false;
     
-    /* Sanitize to prevent header injection */
-    sanitize_header_value(temp, out_value, out_size);
+    /* HTTP/1.0 or HTTP/1.1 only: reject HTTP/1.2+ and malformed */
+    while (p < end && *p == ' ') p++;
+    if (end - p != 8 || strncmp(p, "HTTP/1.", 7) != 0 || (p[7] != '0' && p[7] != '1')) {
+        return false;
+    }
+    req->version_minor = (unsigned char)(p[7] - '0');
+    return true;
 }
 
+typedef enum {
+    LINE_OK,
+    LINE_BAD,
+    LINE_INCOMPLETE
+} LineResult;
+
 /*
- * Parse an HTTP request.
+ * Parse one "Name: value" line at *cursor, moving the cursor past its line
+ * ending, and record the value if the server reads the header. The scan
+ * for control characters in the value is what finds the line ending.
  */
-HttpRequest http_parse_request(const char* raw_request, size_t length) {
-    HttpRequest req = { HTTP_UNKNOWN, "", "", "", "", { 0, SIZE_MAX, false }, false };
-    
-    if (!raw_request || length == 0) {
-        return req;
+static LineResult parse_header_line(const char** cursor, const char* end, HttpRequest* req) {
+    const char* line = *cursor;
+    const char* p = line;
+    while (p < end && g_token_chars[(unsigned char)*p]) p++;
+    if (p >= end) return LINE_INCOMPLETE;
+    if (p == line || *p != ':') return LINE_BAD;  /* Also no space before the colon */
+    HttpHeaderId id = http_header_id(line, (size_t)(p - line));
+    
+    p++;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char* value = p;
+    for (;;) {
+        p = find_control_char(p, end);
+        if (p >= end) return LINE_INCOMPLETE;
+        if (*p != '\t') break;
+        p++;
     }
-    
-    /* Find the first line end */
-    const char* line_end = strstr(raw_request, "\r\n");
-    if (!line_end) {
-        line_end = strstr(raw_request, "\n");
-        if (!line_end) {
-            return req;
-        }
-    }
-    
-    /* Parse: METHOD URI HTTP/VERSION */
-    const char* method_start = raw_request;
-    const char* method_end = method_start;
-    while (method_end < line_end && *method_end != ' ') {
-        method_end++;
+    const char* value_end = p;
+    if (*p == '\r') {
+        if (p + 1 >= end) return LINE_INCOMPLETE;
+        if (p[1] != '\n') return LINE_BAD;
+        p += 2;
+    } else if (*p == '\n') {
+        p++;
+    } else {
+        return LINE_BAD;
     }
-    
-    if (method_end >= line_end) {
-        return req;
+    *cursor = p;
+    
+    while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t')) value_end--;
+    if (id == HTTP_HEADER_OTHER) return LINE_OK;
+    HttpSlice* slot = &req->headers[id];
+    if (slot->data) {
+        /* Two lengths or two hosts cannot be reconciled safely */
+        return id != HTTP_HEADER_HOST && id != HTTP_HEADER_CONTENT_LENGTH ? LINE_OK : LINE_BAD;
     }
-    
-    req.method = parse_method(method_start, method_end - method_start);
-    
-    /* Skip space */
-    const char* uri_start = method_end + 1;
-    
-    /* Find full URI end (space) */
-    const char* full_uri_end = uri_start;
-    while (full_uri_end < line_end && *full_uri_end != ' ') {
-        full_uri_end++;
+    slot->data = value;
+    slot->len = (size_t)(value_end - value);
+    return LINE_OK;
+}
+
+/*
+ * Skip to just past the blank line ending the head; NULL if it has not
+ * arrived. For heads already found malformed, which are not parsed further.
+ */
+static const char* skip_head(const char* p, const char* end) {
+    for (;;) {
+        const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (!newline) return NULL;
+        bool blank = newline == p || (newline == p + 1 && *p == '\r');
+        p = newline + 1;
+        if (blank) return p;
     }
+}
+
+size_t http_head_length(const char* raw, size_t length) {
+    if (!raw || length == 0) return 0;
+    
+    /* The request line never ends the head, even if it is empty */
+    const char* end = raw + length;
+    const char* newline = (const char*)memchr(raw, '\n', length);
+    if (!newline) return 0;
+    const char* head_end = skip_head(newline + 1, end);
+    return head_end ? (size_t)(head_end - raw) : 0;
+}
+
+/*
+ * Parse an HTTP request head in one pass over the buffer.
+ */
+HttpRequest http_parse_request(char* raw_request, size_t length) {
+    HttpRequest req;
+    http_request_init(&req);
     
-    /* Find path end (stop at ? or space) */
-    const char* path_end = uri_start;
-    while (path_end < full_uri_end && *path_end != '?') {
-        path_end++;
+    if (!raw_request || length == 0) {
+        return req;
     }
     
-    /* Validate HTTP version (required for security) */
-    const char* version_start = full_uri_end;
-    while (version_start < line_end && *version_start == ' ') {
-        version_start++;
+    const char* p = raw_request;
+    const char* end = raw_request + length;
+    const char* newline = (const char*)memchr(p, '\n', length);
+    if (!newline) {
+        return req;
     }
-    
-    if (version_start < line_end) {
-        /* Check for HTTP/1.0 or HTTP/1.1 */
-        if (strncmp(version_start, "HTTP/1.", 7) == 0) {
-            char version_char = version_start[7];
-            if (version_char != '0' && version_char != '1') {
-                return req;  /* Invalid HTTP version - reject HTTP/1.2+ and malformed */
+    const char* line_end = (newline > p && newline[-1] == '\r') ? newline - 1 : newline;
+    LineResult result = parse_request_line(p, line_end, &req) ? LINE_OK : LINE_BAD;
+    p = newline + 1;
+    
+    /* Header lines up to the blank line */
+    while (result == LINE_OK) {
+        if (p < end && *p == '\n') {
+            p++;
+            break;
+        }
+        if (p < end && *p == '\r') {
+            if (p + 1 >= end) {
+                result = LINE_INCOMPLETE;
+                break;
+            }
+            if (p[1] == '\n') {
+                p += 2;
+                break;
             }
-        } else {
-            /* No valid HTTP version found - could be HTTP/0.9 or malformed */
-            /* For security, require HTTP/1.0 or HTTP/1.1 */
-            return req;
         }
-    } else {
-        /* No version found - reject HTTP/0.9 */
-        return req;
+        result = parse_header_line(&p, end, &req);
     }
     
-    /* Copy URI (path only, stripped of query string) */
-    size_t uri_len = path_end - uri_start;
-    if (uri_len >= sizeof(req.uri)) {
-        uri_len = sizeof(req.uri) - 1;
+    if (result == LINE_BAD) {
+        /* Malformed: only where the head ends is of use, once it is known */
+        const char* head_end = skip_head(p, end);
+        http_request_init(&req);
+        if (head_end) req.head_length = (size_t)(head_end - raw_request);
+        return req;
     }
-    
-    strncpy(req.uri, uri_start, uri_len);
-    req.uri[uri_len] = '\0';
-    
-    /* Check URI length */
-    if (uri_len > BOLT_MAX_URI_LENGTH) {
-        return req;  /* Keep valid = false */
+    if (result == LINE_INCOMPLETE) {
+        /* Nothing recorded may be used yet */
+        http_request_init(&req);
+        return req;
+    }
+    req.head_length = (size_t)(p - raw_request);
+    
+    /* Terminate the path and the values in place */
+    char* uri = raw_request + (req.uri - raw_request);
+    req.uri_end = uri[req.uri_len];
+    uri[req.uri_len] = '\0';
+    for (int id = 0; id < HTTP_HEADER_COUNT; id++) {
+        if (!req.headers[id].data) continue;
+        char* value = raw_request + (req.headers[id].data - raw_request);
+        req.header_end[id] = value[req.headers[id].len];
+        value[req.headers[id].len] = '\0';
     }
     
-    /* Extract caching headers */
-    extract_header(raw_request, "If-None-Match", 
-                   req.if_none_match, sizeof(req.if_none_match));
-    extract_header(raw_request, "If-Modified-Since",
-                   req.if_modified_since, sizeof(req.if_modified_since));
-    
-    /* Extract Accept-Encoding for compression */
-    extract_header(raw_request, "Accept-Encoding",
-                   req.accept_encoding, sizeof(req.accept_encoding));
-    
-    /* Extract Range header (will be parsed later when file size is known) */
-    char range_header[128];
-    extract_header(raw_request, "Range", range_header, sizeof(range_header));
-    
-    /* Store range header string for later parsing (we need file size first) */
-    /* For now, initialize range as invalid - will be parsed in file_server */
-    req.range.valid = false;
-    req.range.start = 0;
-    req.range.end = SIZE_MAX;
-    
+    /* The Range header is parsed in file_server once the size is known */
     req.valid = true;
     return req;
 }
 
+void http_request_restore(HttpRequest* req) {
+    if (!req || !req->valid) return;
+    
+    ((char*)req->uri)[req->uri_len] = req->uri_end;
+    for (int id = 0; id < HTTP_HEADER_COUNT; id++) {
+        if (req->headers[id].data) {
+            ((char*)req->headers[id].data)[req->headers[id].len] = req->header_end[id];
+        }
+    }
+    http_request_init(req);
+}
+
 /*
  * Send HTTP response headers.
  * SECURITY: All header values are sanitized to prevent header injection.
@@ -27,10 +27,13 @@ static void* load_extension_function(SOCKET socket, GUID* guid) {
 /*
  * Create IOCP subsystem.
  */
-BoltIOCP* bolt_iocp_create(int port, int num_accept_posts) {
+BoltIOCP* bolt_iocp_create(int port, int num_accept_posts, bool reuse_port) {
     WSADATA wsa_data;
     struct sockaddr_in addr;
     
+    /* One completion port already scales across cores; no port sharding */
+    BOLT_UNUSED(reuse_port);
+    
     /* Initialize Winsock */
     if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
         BOLT_ERROR("WSAStartup failed: %d", WSAGetLastError());
@@ -192,6 +195,23 @@ bool bolt_iocp_associate(BoltIOCP* iocp, SOCKET socket, void* completion_key) {
     return result != NULL;
 }
 
+/*
+ * No per-connection registration needed for IOCP.
+ */
+bool bolt_iocp_register_pool(BoltIOCP* iocp, struct BoltConnectionPool* pool) {
+    BOLT_UNUSED(iocp);
+    BOLT_UNUSED(pool);
+    return true;
+}
+
+/*
+ * Nothing to drop: closing the socket detaches it from the port.
+ */
+void bolt_iocp_dissociate(BoltIOCP* iocp, BoltConnection* conn) {
+    BOLT_UNUSED(iocp);
+    BOLT_UNUSED(conn);
+}
+
 /*
  * Post an AcceptEx operation.
  */
@@ -217,6 +237,7 @@ bool bolt_iocp_post_accept(BoltIOCP* iocp, int accept_index) {
     overlap->accept_index = accept_index;
     
     /* Post AcceptEx */
+    InterlockedIncrement64(&iocp->syscalls);
     DWORD bytes_received = 0;
     BOOL result = iocp->AcceptEx(
         iocp->listen_socket,
@@ -239,11 +260,56 @@ bool bolt_iocp_post_accept(BoltIOCP* iocp, int accept_index) {
     return true;
 }
 
+/*
+ * Finish an AcceptEx completion.
+ */
+SOCKET bolt_iocp_finish_accept(BoltIOCP* iocp, BoltOverlapped* overlapped,
+                               DWORD bytes_transferred, uint32_t* client_ip) {
+    int accept_idx = overlapped->accept_index;
+    if (accept_idx < 0 || accept_idx >= iocp->num_accepts) {
+        return INVALID_SOCKET;
+    }
+    
+    SOCKET client_socket = iocp->accept_sockets[accept_idx];
+    *client_ip = 0;
+    
+    /* Extract client IP from AcceptEx buffer */
+    if (iocp->GetAcceptExSockaddrs) {
+        struct sockaddr_in* local_addr = NULL;
+        struct sockaddr_in* remote_addr = NULL;
+        int local_len = 0;
+        int remote_len = 0;
+        
+        iocp->GetAcceptExSockaddrs(
+            overlapped->buffer,
+            bytes_transferred,
+            sizeof(struct sockaddr_in) + 16,
+            sizeof(struct sockaddr_in) + 16,
+            (struct sockaddr**)&local_addr, &local_len,
+            (struct sockaddr**)&remote_addr, &remote_len
+        );
+        if (remote_addr) {
+            *client_ip = remote_addr->sin_addr.s_addr;
+        }
+    }
+    
+    /* Inherit socket options from listen socket */
+    if (setsockopt(client_socket, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
+                   (char*)&iocp->listen_socket, sizeof(iocp->listen_socket)) == SOCKET_ERROR) {
+        return INVALID_SOCKET;
+    }
+    
+    /* Disable Nagle */
+    int opt = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&opt, sizeof(opt));
+    
+    return client_socket;
+}
+
 /*
  * Post a receive operation.
  */
 bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn) {
-    BOLT_UNUSED(iocp);
     if (!conn) return false;
     
     BoltOverlapped* overlap = &conn->recv_overlapped;
@@ -251,11 +317,12 @@ bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn) {
     overlap->op_type = BOLT_OP_RECV;
     overlap->connection = conn;
     overlap->wsa_buf.buf = conn->recv_buffer + conn->recv_offset;
-    overlap->wsa_buf.len = (ULONG)(conn->recv_buffer_size - conn->recv_offset);
+    overlap->wsa_buf.len = (ULONG)(conn->recv_buffer_size - conn->recv_offset - 1);  /* Room for the terminator */
     
     DWORD flags = 0;
     DWORD bytes_received = 0;
     
+    InterlockedIncrement64(&iocp->syscalls);
     int result = WSARecv(conn->socket, &overlap->wsa_buf, 1,
                          &bytes_received, &flags,
                          &overlap->overlapped, NULL);
@@ -272,7 +339,6 @@ bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn) {
  */
 bool bolt_iocp_post_send(BoltIOCP* iocp, BoltConnection* conn,
                          const char* data, size_t len) {
-    BOLT_UNUSED(iocp);
     if (!conn || !data || len == 0) return false;
     
     /* Copy data to send buffer if needed */
@@ -283,21 +349,38 @@ bool bolt_iocp_post_send(BoltIOCP* iocp, BoltConnection* conn,
         memcpy(conn->send_buffer, data, len);
     }
     
+    conn->send_segments[0].buf = conn->send_buffer;
+    conn->send_segments[0].len = (ULONG)len;
+    conn->send_segment_count = 1;
+    conn->send_buffer_used = len;
     conn->send_remaining = len;
     conn->send_offset = 0;
     
+    return bolt_iocp_repost_send(iocp, conn);
+}
+
+/*
+ * Re-post an async send for remaining bytes (correct OVERLAPPED usage).
+ * The pending segments go out as one gathered WSASend.
+ */
+bool bolt_iocp_repost_send(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+    if (conn->send_offset >= conn->send_remaining) return true;
+
     BoltOverlapped* overlap = &conn->send_overlapped;
     memset(&overlap->overlapped, 0, sizeof(OVERLAPPED));
     overlap->op_type = BOLT_OP_SEND;
     overlap->connection = conn;
-    overlap->wsa_buf.buf = conn->send_buffer;
-    overlap->wsa_buf.len = (ULONG)len;
-    
+
+    /* WSASend captures the WSABUF array before returning */
+    WSABUF segments[BOLT_SEND_SEGMENTS];
+    int count = bolt_conn_send_vector(conn, segments, BOLT_SEND_SEGMENTS);
+    if (count == 0) return false;
+
     DWORD bytes_sent = 0;
-    
-    int result = WSASend(conn->socket, &overlap->wsa_buf, 1,
-                         &bytes_sent, 0,
-                         &overlap->overlapped, NULL);
+    InterlockedIncrement64(&iocp->syscalls);
+    int result = WSASend(conn->socket, segments, (DWORD)count,
+                         &bytes_sent, 0, &overlap->overlapped, NULL);
     
     if (result == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING) {
         return false;
@@ -339,8 +422,12 @@ bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
     
     conn->file_offset = actual_start;
     
+    /* The start offset goes in the OVERLAPPED rather than the handle's
+     * file pointer, since concurrent transfers may share one handle */
     BoltOverlapped* overlap = &conn->send_overlapped;
     memset(&overlap->overlapped, 0, sizeof(OVERLAPPED));
+    overlap->overlapped.Offset = (DWORD)((ULONGLONG)actual_start & 0xFFFFFFFFu);
+    overlap->overlapped.OffsetHigh = (DWORD)((ULONGLONG)actual_start >> 32);
     overlap->op_type = BOLT_OP_TRANSMIT_FILE;
     overlap->connection = conn;
     
@@ -348,7 +435,9 @@ bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
     TRANSMIT_FILE_BUFFERS tfb = {0};
     if (headers && header_len > 0) {
         /* Copy headers to connection buffer */
-        memcpy(conn->send_buffer, headers, header_len);
+        if (headers != conn->send_buffer) {
+            memcpy(conn->send_buffer, headers, header_len);
+        }
         tfb.Head = conn->send_buffer;
         tfb.HeadLength = (DWORD)header_len;
     }
@@ -360,11 +449,12 @@ bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
     }
     
     /* TransmitFile with range support */
+    InterlockedIncrement64(&iocp->syscalls);
     BOOL result = iocp->TransmitFile(
         conn->socket,
         file,
         (DWORD)actual_length,  /* Number of bytes to transmit */
-        (DWORD)actual_start,    /* Offset from start of file */
+        0,                      /* Default send size */
         &overlap->overlapped,
         headers ? &tfb : NULL,
         flags
@@ -378,6 +468,17 @@ bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
     return true;
 }
 
+/*
+ * Abort outstanding I/O: cancelled operations complete with
+ * ERROR_OPERATION_ABORTED.
+ */
+bool bolt_iocp_abort(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn || conn->socket == INVALID_SOCKET) return false;
+    
+    InterlockedIncrement64(&iocp->syscalls);
+    return CancelIoEx((HANDLE)conn->socket, NULL) != 0;
+}
+
 /*
  * Post disconnect for reuse.
  */
@@ -389,6 +490,7 @@ bool bolt_iocp_post_disconnect(BoltIOCP* iocp, BoltConnection* conn) {
     overlap->op_type = BOLT_OP_DISCONNECT;
     overlap->connection = conn;
     
+    InterlockedIncrement64(&iocp->syscalls);
     BOOL result = iocp->DisconnectEx(conn->socket, &overlap->overlapped,
                                       TF_REUSE_SOCKET, 0);
     
@@ -400,33 +502,70 @@ bool bolt_iocp_post_disconnect(BoltIOCP* iocp, BoltConnection* conn) {
 }
 
 /*
- * Get completion from IOCP.
+ * Wake a worker blocked on the completion port.
  */
-bool bolt_iocp_get_completion(BoltIOCP* iocp,
-                               DWORD* bytes_transferred,
-                               ULONG_PTR* completion_key,
-                               BoltOverlapped** overlapped,
-                               DWORD timeout_ms) {
-    OVERLAPPED* ovl = NULL;
-    
-    BOOL result = GetQueuedCompletionStatus(
-        iocp->handle,
-        bytes_transferred,
-        completion_key,
-        &ovl,
-        timeout_ms
-    );
+bool bolt_iocp_post_wakeup(BoltIOCP* iocp) {
+    InterlockedIncrement64(&iocp->syscalls);
+    return PostQueuedCompletionStatus(iocp->handle, 0, 0, NULL) != 0;
+}
+
+/*
+ * Post a completion packet for the overlapped.
+ */
+bool bolt_iocp_post_completion(BoltIOCP* iocp, BoltOverlapped* overlapped) {
+    if (!overlapped) return false;
     
-    *overlapped = (BoltOverlapped*)ovl;
+    memset(&overlapped->overlapped, 0, sizeof(OVERLAPPED));
+    InterlockedIncrement64(&iocp->syscalls);
+    return PostQueuedCompletionStatus(iocp->handle, 0, (ULONG_PTR)overlapped->connection,
+                                      &overlapped->overlapped) != 0;
+}
+
+/*
+ * One completion per operation: a batch never holds a stale entry.
+ */
+bool bolt_iocp_completion_current(BoltIOCP* iocp, const BoltCompletion* entry) {
+    (void)iocp;
+    (void)entry;
+    return true;
+}
+
+/*
+ * Backend name for metrics.
+ */
+const char* bolt_iocp_backend_name(void) {
+    return "iocp";
+}
+
+/*
+ * Get a batch of completions from IOCP.
+ */
+int bolt_iocp_get_completions(BoltIOCP* iocp, BoltCompletion* entries,
+                              int max_entries, DWORD timeout_ms) {
+    OVERLAPPED_ENTRY events[BOLT_COMPLETION_BATCH_SIZE];
+    ULONG removed = 0;
     
-    if (!result) {
-        if (ovl == NULL) {
-            /* Timeout or error with no overlapped */
-            return false;
+    if (max_entries > BOLT_COMPLETION_BATCH_SIZE) max_entries = BOLT_COMPLETION_BATCH_SIZE;
+    
+    InterlockedIncrement64(&iocp->syscalls);
+    if (!GetQueuedCompletionStatusEx(iocp->handle, events, (ULONG)max_entries,
+                                     &removed, timeout_ms, FALSE)) {
+        return 0;  /* Timeout */
+    }
+    
+    for (ULONG i = 0; i < removed; i++) {
+        OVERLAPPED* ovl = events[i].lpOverlapped;
+        entries[i].overlapped = (BoltOverlapped*)ovl;
+        entries[i].completion_key = events[i].lpCompletionKey;
+        entries[i].bytes_transferred = events[i].dwNumberOfBytesTransferred;
+        entries[i].generation = 0;
+        
+        /* Per-operation status is the NTSTATUS left in OVERLAPPED.Internal */
+        if (ovl && (LONG)ovl->Internal < 0) {
+            entries[i].bytes_transferred = 0;
         }
-        /* Error with overlapped - still return it for cleanup */
     }
     
-    return true;
+    return (int)removed;
 }
 
@@ -0,0 +1,755 @@
+#include "../include/iocp.h"
+#include "../include/connection.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+
+/*
+ * epoll backend for the iocp.h API (Linux).
+ *
+ * Every socket is registered EPOLLONESHOT with data.ptr pointing at the
+ * BoltOverlapped of its single pending operation. Posting an operation
+ * re-arms the socket; the worker that dequeues the readiness event performs
+ * the non-blocking syscall and hands the result back to the thread pool as
+ * if it were an IOCP completion. One-shot arming guarantees that only one
+ * worker touches a connection at a time, matching the IOCP model.
+ */
+
+/* Max file bytes sent per writable wakeup before yielding the worker */
+#define BOLT_EPOLL_SENDFILE_BURST   (1024 * 1024)
+
+/* Sentinels stored in epoll_event.data.ptr for the non-connection fds */
+static char g_listen_tag;
+static char g_wake_tag;
+
+/*
+ * Arm fd for one readiness notification delivering ptr.
+ */
+static bool arm_fd(BoltIOCP* iocp, int fd, void* ptr, uint32_t events) {
+    struct epoll_event ev;
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = ptr;
+
+    InterlockedIncrement64(&iocp->syscalls);
+    if (epoll_ctl(iocp->epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0) {
+        return true;
+    }
+    if (errno == ENOENT) {
+        InterlockedIncrement64(&iocp->syscalls);
+        return epoll_ctl(iocp->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+    return false;
+}
+
+/*
+ * Create epoll subsystem.
+ */
+BoltIOCP* bolt_iocp_create(int port, int num_accept_posts, bool reuse_port) {
+    struct sockaddr_in addr;
+
+    BoltIOCP* iocp = (BoltIOCP*)calloc(1, sizeof(BoltIOCP));
+    if (!iocp) {
+        return NULL;
+    }
+    iocp->epoll_fd = -1;
+    iocp->wake_fd = -1;
+    iocp->listen_socket = INVALID_SOCKET;
+    InitializeCriticalSection(&iocp->accept_lock);
+    InitializeCriticalSection(&iocp->posted_lock);
+
+    /* Create epoll instance and wakeup eventfd */
+    iocp->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (iocp->epoll_fd < 0) {
+        BOLT_ERROR("epoll_create1 failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    iocp->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+    if (iocp->wake_fd < 0) {
+        BOLT_ERROR("eventfd failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &g_wake_tag;
+    if (epoll_ctl(iocp->epoll_fd, EPOLL_CTL_ADD, iocp->wake_fd, &ev) != 0) {
+        BOLT_ERROR("Failed to register wakeup eventfd: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Create listening socket */
+    iocp->listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                 IPPROTO_TCP);
+    if (iocp->listen_socket == INVALID_SOCKET) {
+        BOLT_ERROR("socket failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Set socket options */
+    int opt = 1;
+    setsockopt(iocp->listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(iocp->listen_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    if (reuse_port &&
+        setsockopt(iocp->listen_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0) {
+        BOLT_ERROR("SO_REUSEPORT failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Bind */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons((uint16_t)port);
+
+    if (bind(iocp->listen_socket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        BOLT_ERROR("Bind failed: %d (port %d may be in use)", errno, port);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Listen */
+    if (listen(iocp->listen_socket, BOLT_BACKLOG) == SOCKET_ERROR) {
+        BOLT_ERROR("Listen failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Register listen socket disarmed; posting an accept arms it */
+    ev.events = 0;
+    ev.data.ptr = &g_listen_tag;
+    if (epoll_ctl(iocp->epoll_fd, EPOLL_CTL_ADD, iocp->listen_socket, &ev) != 0) {
+        BOLT_ERROR("Failed to register listen socket with epoll");
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Pre-allocate accept structures */
+    iocp->num_accepts = num_accept_posts;
+    iocp->accept_overlaps = (BoltOverlapped*)calloc(num_accept_posts, sizeof(BoltOverlapped));
+    iocp->accept_sockets = (SOCKET*)malloc(num_accept_posts * sizeof(SOCKET));
+    iocp->free_accepts = (int*)malloc(num_accept_posts * sizeof(int));
+
+    if (!iocp->accept_overlaps || !iocp->accept_sockets || !iocp->free_accepts) {
+        BOLT_ERROR("Failed to allocate accept structures");
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Initialize accept slots */
+    for (int i = 0; i < num_accept_posts; i++) {
+        iocp->accept_sockets[i] = INVALID_SOCKET;
+        iocp->accept_overlaps[i].op_type = BOLT_OP_ACCEPT;
+        iocp->accept_overlaps[i].accept_index = i;
+    }
+
+    /* Post initial accepts */
+    for (int i = 0; i < num_accept_posts; i++) {
+        if (!bolt_iocp_post_accept(iocp, i)) {
+            BOLT_ERROR("Failed to post initial accept %d", i);
+        }
+    }
+
+    iocp->running = true;
+    return iocp;
+}
+
+/*
+ * Destroy epoll subsystem.
+ */
+void bolt_iocp_destroy(BoltIOCP* iocp) {
+    if (!iocp) return;
+
+    iocp->running = false;
+
+    /* Close accept sockets */
+    if (iocp->accept_sockets) {
+        for (int i = 0; i < iocp->num_accepts; i++) {
+            if (iocp->accept_sockets[i] != INVALID_SOCKET) {
+                closesocket(iocp->accept_sockets[i]);
+            }
+        }
+        free(iocp->accept_sockets);
+    }
+
+    free(iocp->accept_overlaps);
+    free(iocp->free_accepts);
+
+    if (iocp->listen_socket != INVALID_SOCKET) {
+        closesocket(iocp->listen_socket);
+    }
+    if (iocp->wake_fd >= 0) {
+        close(iocp->wake_fd);
+    }
+    if (iocp->epoll_fd >= 0) {
+        close(iocp->epoll_fd);
+    }
+
+    DeleteCriticalSection(&iocp->accept_lock);
+    DeleteCriticalSection(&iocp->posted_lock);
+    free(iocp);
+}
+
+/*
+ * No per-connection registration needed for epoll.
+ */
+bool bolt_iocp_register_pool(BoltIOCP* iocp, struct BoltConnectionPool* pool) {
+    BOLT_UNUSED(iocp);
+    BOLT_UNUSED(pool);
+    return true;
+}
+
+/*
+ * Register socket with epoll (disarmed until an operation is posted).
+ */
+bool bolt_iocp_associate(BoltIOCP* iocp, SOCKET socket, void* completion_key) {
+    BOLT_UNUSED(completion_key);
+
+    struct epoll_event ev;
+    ev.events = 0;
+    ev.data.ptr = NULL;
+    InterlockedIncrement64(&iocp->syscalls);
+    return epoll_ctl(iocp->epoll_fd, EPOLL_CTL_ADD, socket, &ev) == 0 || errno == EEXIST;
+}
+
+/*
+ * Nothing to drop: closing the socket removes it from the epoll set.
+ */
+void bolt_iocp_dissociate(BoltIOCP* iocp, BoltConnection* conn) {
+    BOLT_UNUSED(iocp);
+    BOLT_UNUSED(conn);
+}
+
+/*
+ * Post an accept: return the slot to the free stack and arm the listener.
+ */
+bool bolt_iocp_post_accept(BoltIOCP* iocp, int accept_index) {
+    if (accept_index < 0 || accept_index >= iocp->num_accepts) {
+        return false;
+    }
+
+    iocp->accept_sockets[accept_index] = INVALID_SOCKET;
+
+    bool ok = true;
+    EnterCriticalSection(&iocp->accept_lock);
+    iocp->free_accepts[iocp->num_free_accepts++] = accept_index;
+    if (!iocp->listen_armed) {
+        ok = arm_fd(iocp, iocp->listen_socket, &g_listen_tag, EPOLLIN);
+        iocp->listen_armed = ok;
+    }
+    LeaveCriticalSection(&iocp->accept_lock);
+
+    if (!ok) {
+        BOLT_ERROR("Failed to arm listen socket: %d", errno);
+    }
+    return ok;
+}
+
+/*
+ * Accept one pending connection into a free slot.
+ * Returns the slot's overlapped, or NULL if nothing was accepted.
+ */
+static BoltOverlapped* accept_ready(BoltIOCP* iocp) {
+    EnterCriticalSection(&iocp->accept_lock);
+    iocp->listen_armed = false;
+    if (iocp->num_free_accepts == 0) {
+        /* All slots busy; the next post_accept re-arms the listener */
+        LeaveCriticalSection(&iocp->accept_lock);
+        return NULL;
+    }
+    int accept_index = iocp->free_accepts[--iocp->num_free_accepts];
+    if (iocp->num_free_accepts > 0) {
+        /* Let another worker pick up further pending connections */
+        iocp->listen_armed = arm_fd(iocp, iocp->listen_socket, &g_listen_tag, EPOLLIN);
+    }
+    LeaveCriticalSection(&iocp->accept_lock);
+
+    BoltOverlapped* overlap = &iocp->accept_overlaps[accept_index];
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+
+    InterlockedIncrement64(&iocp->syscalls);
+    SOCKET client_socket = accept4(iocp->listen_socket, (struct sockaddr*)&peer, &peer_len,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_socket == INVALID_SOCKET) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED) {
+            BOLT_ERROR("accept4 failed: %d", errno);
+        }
+        bolt_iocp_post_accept(iocp, accept_index);
+        return NULL;
+    }
+
+    iocp->accept_sockets[accept_index] = client_socket;
+    memcpy(overlap->buffer, &peer, sizeof(peer));
+    return overlap;
+}
+
+/*
+ * Finish an accept completion.
+ */
+SOCKET bolt_iocp_finish_accept(BoltIOCP* iocp, BoltOverlapped* overlapped,
+                               DWORD bytes_transferred, uint32_t* client_ip) {
+    BOLT_UNUSED(bytes_transferred);
+
+    int accept_idx = overlapped->accept_index;
+    if (accept_idx < 0 || accept_idx >= iocp->num_accepts) {
+        return INVALID_SOCKET;
+    }
+
+    SOCKET client_socket = iocp->accept_sockets[accept_idx];
+    struct sockaddr_in peer;
+    memcpy(&peer, overlapped->buffer, sizeof(peer));
+    *client_ip = peer.sin_addr.s_addr;
+
+    /* Disable Nagle */
+    int opt = 1;
+    InterlockedIncrement64(&iocp->syscalls);
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    return client_socket;
+}
+
+/*
+ * Post a receive operation.
+ */
+bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+
+    BoltOverlapped* overlap = &conn->recv_overlapped;
+    overlap->op_type = BOLT_OP_RECV;
+    overlap->connection = conn;
+    overlap->wsa_buf.buf = conn->recv_buffer + conn->recv_offset;
+    overlap->wsa_buf.len = (ULONG)(conn->recv_buffer_size - conn->recv_offset - 1);  /* Room for the terminator */
+
+    return arm_fd(iocp, conn->socket, overlap, EPOLLIN);
+}
+
+/*
+ * Post a send operation.
+ */
+bool bolt_iocp_post_send(BoltIOCP* iocp, BoltConnection* conn,
+                         const char* data, size_t len) {
+    if (!conn || !data || len == 0) return false;
+
+    /* Copy data to send buffer if needed */
+    if (data != conn->send_buffer) {
+        if (len > conn->send_buffer_size) {
+            return false;
+        }
+        memcpy(conn->send_buffer, data, len);
+    }
+
+    conn->send_segments[0].buf = conn->send_buffer;
+    conn->send_segments[0].len = (ULONG)len;
+    conn->send_segment_count = 1;
+    conn->send_buffer_used = len;
+    conn->send_remaining = len;
+    conn->send_offset = 0;
+
+    return bolt_iocp_repost_send(iocp, conn);
+}
+
+/*
+ * Re-post a send for the remaining bytes.
+ */
+bool bolt_iocp_repost_send(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+    if (conn->send_offset >= conn->send_remaining) return true;
+
+    /* The segments are gathered from send_offset when the socket is ready */
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_SEND;
+    overlap->connection = conn;
+
+    return arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+}
+
+/*
+ * Post TransmitFile (emulated: headers, then sendfile() of the range).
+ * Supports range requests via range_start and range_length.
+ */
+bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
+                                   HANDLE file, size_t file_size,
+                                   const char* headers, size_t header_len,
+                                   size_t range_start, size_t range_length) {
+    if (!conn || file == INVALID_HANDLE_VALUE) return false;
+    if (header_len > conn->send_buffer_size) return false;
+
+    conn->file_handle = file;
+    conn->file_size = file_size;
+
+    /* Determine actual range to send */
+    size_t actual_start = 0;
+    size_t actual_length = file_size;
+
+    if (range_length > 0) {
+        /* Range request */
+        actual_start = range_start;
+        actual_length = range_length;
+
+        /* Validate range */
+        if (actual_start >= file_size) {
+            return false;  /* Invalid range */
+        }
+        if (actual_start + actual_length > file_size) {
+            actual_length = file_size - actual_start;  /* Clamp to file end */
+        }
+    }
+
+    conn->file_offset = actual_start;
+
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_TRANSMIT_FILE;
+    overlap->connection = conn;
+    overlap->file_end = actual_start + actual_length;
+    overlap->transferred = 0;
+
+    /* Headers go out of the connection's send buffer first */
+    if (headers && header_len > 0 && headers != conn->send_buffer) {
+        memcpy(conn->send_buffer, headers, header_len);
+    }
+    overlap->wsa_buf.buf = conn->send_buffer;
+    overlap->wsa_buf.len = headers ? (ULONG)header_len : 0;
+
+    return arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+}
+
+/*
+ * Abort outstanding I/O: shutdown makes the armed socket ready with
+ * EOF/EPIPE, so the pending recv or send completes as failed.
+ */
+bool bolt_iocp_abort(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn || conn->socket == INVALID_SOCKET) return false;
+
+    InterlockedIncrement64(&iocp->syscalls);
+    return shutdown(conn->socket, SD_BOTH) == 0;
+}
+
+/*
+ * Post disconnect: shut the socket down and complete once epoll reports it.
+ */
+bool bolt_iocp_post_disconnect(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_DISCONNECT;
+    overlap->connection = conn;
+
+    shutdown(conn->socket, SD_BOTH);
+    return arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+}
+
+/*
+ * Wake a worker blocked in epoll_wait.
+ */
+bool bolt_iocp_post_wakeup(BoltIOCP* iocp) {
+    uint64_t one = 1;
+    InterlockedIncrement64(&iocp->syscalls);
+    return write(iocp->wake_fd, &one, sizeof(one)) == (ssize_t)sizeof(one);
+}
+
+/*
+ * Post a completion: queue the overlapped, then wake a worker. Each
+ * wake_fd read takes one queued entry, or none for a plain wakeup.
+ */
+bool bolt_iocp_post_completion(BoltIOCP* iocp, BoltOverlapped* overlapped) {
+    if (!overlapped) return false;
+
+    EnterCriticalSection(&iocp->posted_lock);
+    overlapped->posted_next = NULL;
+    if (iocp->posted_tail) {
+        iocp->posted_tail->posted_next = overlapped;
+    } else {
+        iocp->posted_head = overlapped;
+    }
+    iocp->posted_tail = overlapped;
+    LeaveCriticalSection(&iocp->posted_lock);
+
+    return bolt_iocp_post_wakeup(iocp);
+}
+
+/*
+ * Take the oldest posted completion, NULL if there is none.
+ */
+static BoltOverlapped* take_posted(BoltIOCP* iocp) {
+    EnterCriticalSection(&iocp->posted_lock);
+    BoltOverlapped* overlapped = iocp->posted_head;
+    if (overlapped) {
+        iocp->posted_head = overlapped->posted_next;
+        if (!iocp->posted_head) {
+            iocp->posted_tail = NULL;
+        }
+    }
+    LeaveCriticalSection(&iocp->posted_lock);
+    return overlapped;
+}
+
+/*
+ * Send from buf until done or the socket would block.
+ * Returns bytes sent, or -1 on a hard error (would-block is not an error).
+ */
+static ssize_t send_some(BoltIOCP* iocp, SOCKET socket, const char* buf, size_t len, int flags) {
+    size_t sent = 0;
+    while (sent < len) {
+        InterlockedIncrement64(&iocp->syscalls);
+        ssize_t n = send(socket, buf + sent, len - sent, flags | MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return -1;
+    }
+    return (ssize_t)sent;
+}
+
+/*
+ * Gathered send of the connection's pending segments until done or the
+ * socket would block. Returns bytes sent, or -1 on a hard error.
+ */
+static ssize_t send_segments_some(BoltIOCP* iocp, BoltConnection* conn) {
+    WSABUF segments[BOLT_SEND_SEGMENTS];
+    struct iovec iov[BOLT_SEND_SEGMENTS];
+    int count = bolt_conn_send_vector(conn, segments, BOLT_SEND_SEGMENTS);
+    for (int i = 0; i < count; i++) {
+        iov[i].iov_base = segments[i].buf;
+        iov[i].iov_len = segments[i].len;
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (size_t)count;
+
+    size_t sent = 0;
+    while (msg.msg_iovlen > 0) {
+        InterlockedIncrement64(&iocp->syscalls);
+        ssize_t n = sendmsg(conn->socket, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return -1;
+        sent += (size_t)n;
+
+        /* Drop what went out */
+        size_t left = (size_t)n;
+        while (msg.msg_iovlen > 0 && left >= msg.msg_iov->iov_len) {
+            left -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (char*)msg.msg_iov->iov_base + left;
+            msg.msg_iov->iov_len -= left;
+        }
+    }
+    return (ssize_t)sent;
+}
+
+/*
+ * Continue an emulated TransmitFile: headers with MSG_MORE so they share a
+ * segment with the first body bytes, then sendfile() straight from the page
+ * cache. Progress lives in conn->file_offset, so a send that would block
+ * just re-arms EPOLLOUT and resumes there.
+ * Returns true when the operation completed (or failed), false if re-armed.
+ */
+static bool transmit_ready(BoltIOCP* iocp, BoltOverlapped* overlap, DWORD* bytes) {
+    BoltConnection* conn = overlap->connection;
+
+    /* Headers */
+    if (overlap->wsa_buf.len > 0) {
+        int flags = conn->file_offset < overlap->file_end ? MSG_MORE : 0;
+        ssize_t n = send_some(iocp, conn->socket, overlap->wsa_buf.buf, overlap->wsa_buf.len, flags);
+        if (n < 0) {
+            *bytes = 0;
+            return true;
+        }
+        overlap->wsa_buf.buf += n;
+        overlap->wsa_buf.len -= (ULONG)n;
+        overlap->transferred += (size_t)n;
+        if (overlap->wsa_buf.len > 0) {
+            return !arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+        }
+    }
+
+    /* File body; a fast reader gets at most one burst per wakeup so a large
+     * file cannot monopolize the worker */
+    size_t burst = 0;
+    while (conn->file_offset < overlap->file_end) {
+        if (burst >= BOLT_EPOLL_SENDFILE_BURST) {
+            return !arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+        }
+
+        size_t chunk = overlap->file_end - conn->file_offset;
+        if (chunk > BOLT_EPOLL_SENDFILE_BURST) chunk = BOLT_EPOLL_SENDFILE_BURST;
+
+        off_t offset = (off_t)conn->file_offset;
+        InterlockedIncrement64(&iocp->syscalls);
+        ssize_t n = sendfile(conn->socket, BOLT_HANDLE_TO_FD(conn->file_handle), &offset, chunk);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return !arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+        }
+        if (n <= 0) {
+            *bytes = 0;  /* Send error, or file truncated underneath us */
+            return true;
+        }
+
+        conn->file_offset += (size_t)n;
+        overlap->transferred += (size_t)n;
+        burst += (size_t)n;
+        if ((size_t)n < chunk && conn->file_offset < overlap->file_end) {
+            /* Socket buffer full: resume from file_offset when writable */
+            return !arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+        }
+    }
+
+    *bytes = (DWORD)overlap->transferred;
+    return true;
+}
+
+/*
+ * Perform the I/O for a ready operation.
+ * Returns true when a completion should be reported, false if re-armed.
+ */
+static bool perform_ready(BoltIOCP* iocp, BoltOverlapped* overlap, DWORD* bytes) {
+    BoltConnection* conn = overlap->connection;
+    *bytes = 0;
+
+    switch (overlap->op_type) {
+        case BOLT_OP_RECV: {
+            for (;;) {
+                InterlockedIncrement64(&iocp->syscalls);
+                ssize_t n = recv(conn->socket, overlap->wsa_buf.buf, overlap->wsa_buf.len, 0);
+                if (n >= 0) {
+                    *bytes = (DWORD)n;
+                    return true;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return !arm_fd(iocp, conn->socket, overlap, EPOLLIN);
+                }
+                return true;  /* Hard error: report 0 bytes */
+            }
+        }
+
+        case BOLT_OP_SEND: {
+            ssize_t n = send_segments_some(iocp, conn);
+            if (n == 0) {
+                return !arm_fd(iocp, conn->socket, overlap, EPOLLOUT);
+            }
+            *bytes = n > 0 ? (DWORD)n : 0;
+            return true;
+        }
+
+        case BOLT_OP_TRANSMIT_FILE:
+            return transmit_ready(iocp, overlap, bytes);
+
+        case BOLT_OP_DISCONNECT:
+        default:
+            return true;
+    }
+}
+
+/*
+ * One completion per operation: a batch never holds a stale entry.
+ */
+bool bolt_iocp_completion_current(BoltIOCP* iocp, const BoltCompletion* entry) {
+    (void)iocp;
+    (void)entry;
+    return true;
+}
+
+/*
+ * Backend name for metrics.
+ */
+const char* bolt_iocp_backend_name(void) {
+    return "epoll";
+}
+
+/*
+ * Get a batch of completions from epoll: every ready event from one
+ * epoll_wait() is turned into a completion before returning.
+ */
+int bolt_iocp_get_completions(BoltIOCP* iocp, BoltCompletion* entries,
+                              int max_entries, DWORD timeout_ms) {
+    struct epoll_event events[BOLT_COMPLETION_BATCH_SIZE];
+    ULONGLONG deadline = GetTickCount64() + timeout_ms;
+
+    if (max_entries > BOLT_COMPLETION_BATCH_SIZE) max_entries = BOLT_COMPLETION_BATCH_SIZE;
+
+    for (;;) {
+        int wait_ms = -1;
+        if (timeout_ms != INFINITE) {
+            ULONGLONG now = GetTickCount64();
+            wait_ms = now >= deadline ? 0 : (int)(deadline - now);
+        }
+
+        InterlockedIncrement64(&iocp->syscalls);
+        int n = epoll_wait(iocp->epoll_fd, events, max_entries, wait_ms);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        if (n == 0) {
+            return 0;  /* Timeout */
+        }
+
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            BoltCompletion* entry = &entries[count];
+            entry->overlapped = NULL;
+            entry->completion_key = 0;
+            entry->bytes_transferred = 0;
+            entry->generation = 0;
+
+            if (events[i].data.ptr == &g_wake_tag) {
+                uint64_t value;
+                InterlockedIncrement64(&iocp->syscalls);
+                if (read(iocp->wake_fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+                    /* A posted completion, or a wakeup: NULL overlapped */
+                    entry->overlapped = take_posted(iocp);
+                    if (entry->overlapped) {
+                        entry->completion_key = (ULONG_PTR)entry->overlapped->connection;
+                    }
+                    count++;
+                }
+                continue;  /* Otherwise another worker took it */
+            }
+
+            if (events[i].data.ptr == &g_listen_tag) {
+                entry->overlapped = accept_ready(iocp);
+                if (entry->overlapped) {
+                    count++;
+                }
+                continue;
+            }
+
+            BoltOverlapped* overlap = (BoltOverlapped*)events[i].data.ptr;
+            BoltConnection* conn = overlap ? overlap->connection : NULL;
+            if (!conn || conn->socket == INVALID_SOCKET) {
+                continue;  /* Stale event for a connection closed meanwhile */
+            }
+
+            DWORD bytes = 0;
+            if (perform_ready(iocp, overlap, &bytes)) {
+                entry->overlapped = overlap;
+                entry->completion_key = (ULONG_PTR)conn;
+                entry->bytes_transferred = bytes;
+                count++;
+            }
+        }
+
+        if (count > 0) {
+            return count;
+        }
+    }
+}
@@ -0,0 +1,1184 @@
+#include "../include/iocp.h"
+#include "../include/connection.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+
+/*
+ * io_uring backend for the iocp.h API (Linux, build with BOLT_IO_URING).
+ *
+ * io_uring is completion-based like IOCP, so operations map directly onto
+ * SQEs and the thread pool sees the same completions it gets on Windows.
+ * All workers share one ring: posting an operation only fills an SQE, and
+ * it is submitted by the next io_uring_enter() that a worker makes to wait
+ * for completions, so a keep-alive request costs roughly one syscall per
+ * completion instead of one per readiness event plus one per I/O call.
+ *
+ * - Accept is a single multishot SQE; accepted sockets are handed to
+ *   workers through the accept slots the thread pool already re-posts.
+ * - Connection sockets and send buffers are installed in the ring's
+ *   registered file/buffer tables (one slot per pooled connection), so
+ *   sends use IORING_OP_WRITE_FIXED on a fixed file. A send gathered from
+ *   several segments (cache memory, pipelined responses) is one SENDMSG.
+ * - Receives are single-shot, straight into conn->recv_buffer: the request
+ *   path parses in place and relies on one outstanding op per connection,
+ *   which multishot recv with provided buffers would break.
+ * - TransmitFile sends the headers (MSG_MORE), then splices the body
+ *   file -> pipe -> socket through a per-connection pipe, so body bytes
+ *   never pass through user space. Without a pipe it falls back to an
+ *   async read/send chain through the send buffer.
+ */
+
+#define BOLT_URING_SQ_ENTRIES   1024
+#define BOLT_URING_CQ_ENTRIES   16384   /* Every connection may have an op in flight */
+
+/* SENDMSG descriptor; the kernel may read it until the send completes */
+struct BoltUringSendMsg {
+    struct msghdr msg;
+    struct iovec iov[BOLT_SEND_SEGMENTS];
+};
+
+/* user_data values that are not BoltOverlapped pointers */
+#define URING_TAG_WAKEUP        0ull
+#define URING_TAG_ACCEPT        1ull
+
+/* user_data = overlapped pointer | connection generation << 48 */
+#define URING_PTR_MASK          0x0000FFFFFFFFFFFFull
+#define URING_GEN_SHIFT         48
+
+/* TransmitFile steps (BoltOverlapped.step) */
+enum {
+    URING_STEP_NONE = 0,
+    URING_STEP_SEND_HEADERS,
+    URING_STEP_READ,
+    URING_STEP_SEND_BODY,
+    URING_STEP_SPLICE_IN,
+    URING_STEP_SPLICE_OUT
+};
+
+/* Bytes moved per file->pipe splice (the default pipe capacity) */
+#define BOLT_URING_SPLICE_CHUNK (64 * 1024)
+
+static int uring_setup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(BoltIOCP* iocp, unsigned to_submit, unsigned min_complete,
+                       unsigned flags, void* arg, size_t arg_size) {
+    InterlockedIncrement64(&iocp->syscalls);
+    return (int)syscall(__NR_io_uring_enter, iocp->ring_fd, to_submit, min_complete,
+                        flags, arg, arg_size);
+}
+
+static int uring_register(BoltIOCP* iocp, unsigned opcode, void* arg, unsigned nr_args) {
+    InterlockedIncrement64(&iocp->syscalls);
+    return (int)syscall(__NR_io_uring_register, iocp->ring_fd, opcode, arg, nr_args);
+}
+
+/*
+ * Number of SQEs queued but not yet consumed by the kernel. io_uring_enter()
+ * skips waiting when it submits fewer than to_submit, so this is what every
+ * enter passes rather than the ring size.
+ */
+static unsigned pending_submissions(BoltIOCP* iocp) {
+    return __atomic_load_n(iocp->sq_tail, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(iocp->sq_head, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Submit SQEs queued by any worker without waiting.
+ */
+static void flush_submissions(BoltIOCP* iocp) {
+    unsigned pending = pending_submissions(iocp);
+    if (pending > 0) {
+        uring_enter(iocp, pending, 0, 0, NULL, 0);
+    }
+}
+
+/*
+ * Reserve the next SQE. Returns with sq_lock held; call commit_sqe().
+ */
+static struct io_uring_sqe* get_sqe(BoltIOCP* iocp) {
+    for (;;) {
+        EnterCriticalSection(&iocp->sq_lock);
+        unsigned tail = *iocp->sq_tail;
+        unsigned head = __atomic_load_n(iocp->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head < iocp->sq_entries) {
+            struct io_uring_sqe* sqe = &iocp->sqes[tail & iocp->sq_mask];
+            memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+        LeaveCriticalSection(&iocp->sq_lock);
+
+        /* Submission queue full: push it to the kernel and retry */
+        flush_submissions(iocp);
+    }
+}
+
+static void commit_sqe(BoltIOCP* iocp) {
+    __atomic_store_n(iocp->sq_tail, *iocp->sq_tail + 1, __ATOMIC_RELEASE);
+    LeaveCriticalSection(&iocp->sq_lock);
+}
+
+/*
+ * Pop up to max CQEs. Workers reap concurrently: the slots are copied
+ * first and only kept if advancing the head past them succeeds.
+ */
+static int reap_cqes(BoltIOCP* iocp, struct io_uring_cqe* out, int max) {
+    for (;;) {
+        unsigned head = __atomic_load_n(iocp->cq_head, __ATOMIC_ACQUIRE);
+        unsigned tail = __atomic_load_n(iocp->cq_tail, __ATOMIC_ACQUIRE);
+        unsigned ready = tail - head;
+        if (ready == 0) {
+            return 0;
+        }
+        if (ready > (unsigned)max) ready = (unsigned)max;
+        for (unsigned i = 0; i < ready; i++) {
+            out[i] = iocp->cqes[(head + i) & iocp->cq_mask];
+        }
+        if (__atomic_compare_exchange_n(iocp->cq_head, &head, head + ready, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return (int)ready;
+        }
+    }
+}
+
+/*
+ * Index of conn in the registered connection table, or -1.
+ */
+static int conn_index(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!iocp->conns || conn < iocp->conns || conn >= iocp->conns + iocp->num_conns) {
+        return -1;
+    }
+    return (int)(conn - iocp->conns);
+}
+
+/*
+ * Point an SQE at the connection's socket (fixed file when registered)
+ * and tag it with the overlapped and the connection's generation.
+ */
+static int prep_conn_sqe(BoltIOCP* iocp, struct io_uring_sqe* sqe,
+                         BoltConnection* conn, BoltOverlapped* overlap) {
+    int idx = conn_index(iocp, conn);
+    uint64_t gen = 0;
+
+    sqe->fd = conn->socket;
+    if (idx >= 0) {
+        gen = __atomic_load_n(&iocp->conn_gen[idx], __ATOMIC_RELAXED);
+        if (iocp->fixed_sockets[idx] == conn->socket) {
+            sqe->fd = idx;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+    }
+    sqe->user_data = (uint64_t)(uintptr_t)overlap | (gen << URING_GEN_SHIFT);
+    return idx;
+}
+
+/*
+ * Queue a send of overlap->wsa_buf. Data in conn->send_buffer goes out
+ * with WRITE_FIXED from the registered buffer.
+ */
+static void queue_send(BoltIOCP* iocp, BoltConnection* conn, BoltOverlapped* overlap,
+                       bool more) {
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    int idx = prep_conn_sqe(iocp, sqe, conn, overlap);
+
+    bool in_buffer = overlap->wsa_buf.buf >= conn->send_buffer &&
+                     overlap->wsa_buf.buf < conn->send_buffer + conn->send_buffer_size;
+    sqe->addr = (uint64_t)(uintptr_t)overlap->wsa_buf.buf;
+    sqe->len = overlap->wsa_buf.len;
+    if (idx >= 0 && iocp->fixed_buffers[idx] && in_buffer && !more) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->buf_index = (uint16_t)idx;
+        sqe->off = 0;
+    } else {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+    }
+    commit_sqe(iocp);
+}
+
+/*
+ * Queue one SENDMSG for several segments, described in the slot's
+ * descriptor.
+ */
+static void queue_sendmsg(BoltIOCP* iocp, BoltConnection* conn, BoltOverlapped* overlap,
+                          const WSABUF* segments, int count, int idx) {
+    struct BoltUringSendMsg* send_msg = &iocp->send_msgs[idx];
+    for (int i = 0; i < count; i++) {
+        send_msg->iov[i].iov_base = segments[i].buf;
+        send_msg->iov[i].iov_len = segments[i].len;
+    }
+    memset(&send_msg->msg, 0, sizeof(send_msg->msg));
+    send_msg->msg.msg_iov = send_msg->iov;
+    send_msg->msg.msg_iovlen = (size_t)count;
+
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, conn, overlap);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->addr = (uint64_t)(uintptr_t)&send_msg->msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    commit_sqe(iocp);
+}
+
+/*
+ * Pipe pair used to splice this connection's file bodies, created on first
+ * use. Returns the pipe's fds in fds[0] (read end) and fds[1], or false if
+ * the connection has to fall back to read/send through its buffer.
+ */
+static bool get_splice_pipe(BoltIOCP* iocp, BoltConnection* conn, int** fds) {
+    int idx = conn_index(iocp, conn);
+    if (idx < 0 || !iocp->splice_pipes) return false;
+
+    int* pipe_fds = &iocp->splice_pipes[idx * 2];
+    if (pipe_fds[0] < 0) {
+        InterlockedIncrement64(&iocp->syscalls);
+        if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+            pipe_fds[0] = pipe_fds[1] = -1;  /* Out of fds: use the buffer path */
+            return false;
+        }
+    }
+    *fds = pipe_fds;
+    return true;
+}
+
+/*
+ * Close a connection's splice pipe. Used when a transfer is abandoned part
+ * way, since the pipe may still hold file bytes meant for the old response.
+ */
+static void drop_splice_pipe(BoltIOCP* iocp, int idx) {
+    int* pipe_fds = &iocp->splice_pipes[idx * 2];
+    if (pipe_fds[0] >= 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        pipe_fds[0] = pipe_fds[1] = -1;
+    }
+}
+
+/*
+ * Queue a splice between the file and the connection's pipe (SPLICE_IN)
+ * or between the pipe and the socket (SPLICE_OUT). The page cache pages
+ * are moved by reference; no body bytes are copied through user space.
+ */
+static void queue_splice(BoltIOCP* iocp, BoltConnection* conn, BoltOverlapped* overlap,
+                         int* pipe_fds, int step) {
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, conn, overlap);
+    sqe->opcode = IORING_OP_SPLICE;
+    overlap->step = step;
+
+    if (step == URING_STEP_SPLICE_IN) {
+        size_t chunk = overlap->file_end - conn->file_offset;
+        if (chunk > BOLT_URING_SPLICE_CHUNK) chunk = BOLT_URING_SPLICE_CHUNK;
+
+        sqe->flags &= (uint8_t)~IOSQE_FIXED_FILE;
+        sqe->splice_fd_in = BOLT_HANDLE_TO_FD(conn->file_handle);
+        sqe->splice_off_in = conn->file_offset;
+        sqe->fd = pipe_fds[1];
+        sqe->off = (uint64_t)-1;
+        sqe->len = (uint32_t)chunk;
+        sqe->splice_flags = SPLICE_F_MOVE;
+    } else {
+        /* sqe->fd is already the (possibly fixed) socket */
+        sqe->splice_fd_in = pipe_fds[0];
+        sqe->splice_off_in = (uint64_t)-1;
+        sqe->off = (uint64_t)-1;
+        sqe->len = (uint32_t)overlap->pipe_bytes;
+        sqe->splice_flags = SPLICE_F_MOVE;
+        if (conn->file_offset + overlap->pipe_bytes < overlap->file_end) {
+            sqe->splice_flags |= SPLICE_F_MORE;
+        }
+    }
+    commit_sqe(iocp);
+}
+
+/*
+ * Queue the next body step: splice when the connection has a pipe,
+ * otherwise an async read of the next chunk into the send buffer.
+ */
+static void queue_file_body(BoltIOCP* iocp, BoltConnection* conn, BoltOverlapped* overlap) {
+    int* pipe_fds;
+    if (get_splice_pipe(iocp, conn, &pipe_fds)) {
+        queue_splice(iocp, conn, overlap, pipe_fds, URING_STEP_SPLICE_IN);
+        return;
+    }
+
+    size_t chunk = overlap->file_end - conn->file_offset;
+    if (chunk > conn->send_buffer_size) chunk = conn->send_buffer_size;
+
+    overlap->step = URING_STEP_READ;
+
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, conn, overlap);  /* For user_data */
+    sqe->opcode = IORING_OP_READ;
+    sqe->flags &= (uint8_t)~IOSQE_FIXED_FILE;
+    sqe->fd = BOLT_HANDLE_TO_FD(conn->file_handle);
+    sqe->addr = (uint64_t)(uintptr_t)conn->send_buffer;
+    sqe->len = (uint32_t)chunk;
+    sqe->off = conn->file_offset;
+    commit_sqe(iocp);
+}
+
+/*
+ * Arm the listener (multishot when the kernel supports it).
+ */
+static void queue_accept(BoltIOCP* iocp) {
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = iocp->listen_socket;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (iocp->multishot_accept) {
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    }
+    sqe->user_data = URING_TAG_ACCEPT;
+    commit_sqe(iocp);
+}
+
+/*
+ * Create io_uring subsystem.
+ */
+BoltIOCP* bolt_iocp_create(int port, int num_accept_posts, bool reuse_port) {
+    struct sockaddr_in addr;
+
+    BoltIOCP* iocp = (BoltIOCP*)calloc(1, sizeof(BoltIOCP));
+    if (!iocp) {
+        return NULL;
+    }
+    iocp->ring_fd = -1;
+    iocp->listen_socket = INVALID_SOCKET;
+    iocp->multishot_accept = true;
+    InitializeCriticalSection(&iocp->sq_lock);
+    InitializeCriticalSection(&iocp->accept_lock);
+
+    /* Create the ring */
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+    params.cq_entries = BOLT_URING_CQ_ENTRIES;
+    iocp->ring_fd = uring_setup(BOLT_URING_SQ_ENTRIES, &params);
+    if (iocp->ring_fd < 0 && errno == EINVAL) {
+        /* Older kernel: retry without SUBMIT_ALL */
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = BOLT_URING_CQ_ENTRIES;
+        iocp->ring_fd = uring_setup(BOLT_URING_SQ_ENTRIES, &params);
+    }
+    if (iocp->ring_fd < 0) {
+        BOLT_ERROR("io_uring_setup failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        BOLT_ERROR("io_uring: kernel lacks IORING_FEAT_EXT_ARG (need Linux 5.11+)");
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Map the rings */
+    iocp->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    iocp->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (iocp->cq_ring_size > iocp->sq_ring_size) iocp->sq_ring_size = iocp->cq_ring_size;
+        iocp->cq_ring_size = iocp->sq_ring_size;
+    }
+
+    iocp->sq_ring = mmap(NULL, iocp->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, iocp->ring_fd, IORING_OFF_SQ_RING);
+    if (iocp->sq_ring == MAP_FAILED) {
+        iocp->sq_ring = NULL;
+        BOLT_ERROR("io_uring: failed to map SQ ring: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        iocp->cq_ring = iocp->sq_ring;
+    } else {
+        iocp->cq_ring = mmap(NULL, iocp->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, iocp->ring_fd, IORING_OFF_CQ_RING);
+        if (iocp->cq_ring == MAP_FAILED) {
+            iocp->cq_ring = NULL;
+            BOLT_ERROR("io_uring: failed to map CQ ring: %d", errno);
+            bolt_iocp_destroy(iocp);
+            return NULL;
+        }
+    }
+
+    iocp->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    iocp->sqes = (struct io_uring_sqe*)mmap(NULL, iocp->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, iocp->ring_fd,
+                                            IORING_OFF_SQES);
+    if (iocp->sqes == MAP_FAILED) {
+        iocp->sqes = NULL;
+        BOLT_ERROR("io_uring: failed to map SQEs: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    char* sq = (char*)iocp->sq_ring;
+    char* cq = (char*)iocp->cq_ring;
+    iocp->sq_head = (unsigned*)(sq + params.sq_off.head);
+    iocp->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    iocp->sq_array = (unsigned*)(sq + params.sq_off.array);
+    iocp->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    iocp->sq_entries = *(unsigned*)(sq + params.sq_off.ring_entries);
+    iocp->cq_head = (unsigned*)(cq + params.cq_off.head);
+    iocp->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    iocp->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    iocp->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    /* SQ index array is the identity; SQEs are used in ring order */
+    for (unsigned i = 0; i < iocp->sq_entries; i++) {
+        iocp->sq_array[i] = i;
+    }
+
+    /* Create listening socket */
+    iocp->listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (iocp->listen_socket == INVALID_SOCKET) {
+        BOLT_ERROR("socket failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Set socket options */
+    int opt = 1;
+    setsockopt(iocp->listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(iocp->listen_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    if (reuse_port &&
+        setsockopt(iocp->listen_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0) {
+        BOLT_ERROR("SO_REUSEPORT failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Bind */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons((uint16_t)port);
+
+    if (bind(iocp->listen_socket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        BOLT_ERROR("Bind failed: %d (port %d may be in use)", errno, port);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Listen */
+    if (listen(iocp->listen_socket, BOLT_BACKLOG) == SOCKET_ERROR) {
+        BOLT_ERROR("Listen failed: %d", errno);
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    /* Hand-off slots for accepted sockets. A worker can hold a whole batch
+     * of accept completions at once, so every post gets a batch of slots. */
+    int num_slots = num_accept_posts * BOLT_COMPLETION_BATCH_SIZE;
+    iocp->num_accepts = num_slots;
+    iocp->accept_overlaps = (BoltOverlapped*)calloc(num_slots, sizeof(BoltOverlapped));
+    iocp->accept_sockets = (SOCKET*)malloc(num_slots * sizeof(SOCKET));
+    iocp->free_accepts = (int*)malloc(num_slots * sizeof(int));
+
+    if (!iocp->accept_overlaps || !iocp->accept_sockets || !iocp->free_accepts) {
+        BOLT_ERROR("Failed to allocate accept structures");
+        bolt_iocp_destroy(iocp);
+        return NULL;
+    }
+
+    for (int i = 0; i < num_slots; i++) {
+        iocp->accept_sockets[i] = INVALID_SOCKET;
+        iocp->accept_overlaps[i].op_type = BOLT_OP_ACCEPT;
+        iocp->accept_overlaps[i].accept_index = i;
+        bolt_iocp_post_accept(iocp, i);
+    }
+
+    /* One armed accept serves every incoming connection */
+    iocp->running = true;
+    queue_accept(iocp);
+    flush_submissions(iocp);
+
+    return iocp;
+}
+
+/*
+ * Destroy io_uring subsystem.
+ */
+void bolt_iocp_destroy(BoltIOCP* iocp) {
+    if (!iocp) return;
+
+    iocp->running = false;
+
+    if (iocp->accept_sockets) {
+        for (int i = 0; i < iocp->num_accepts; i++) {
+            if (iocp->accept_sockets[i] != INVALID_SOCKET) {
+                closesocket(iocp->accept_sockets[i]);
+            }
+        }
+        free(iocp->accept_sockets);
+    }
+    free(iocp->accept_overlaps);
+    free(iocp->free_accepts);
+
+    free(iocp->fixed_sockets);
+    free(iocp->fixed_buffers);
+    free(iocp->conn_gen);
+    free(iocp->send_msgs);
+
+    if (iocp->splice_pipes) {
+        for (int i = 0; i < iocp->num_conns; i++) {
+            drop_splice_pipe(iocp, i);
+        }
+        free(iocp->splice_pipes);
+    }
+
+    if (iocp->listen_socket != INVALID_SOCKET) {
+        closesocket(iocp->listen_socket);
+    }
+
+    if (iocp->sqes) {
+        munmap(iocp->sqes, iocp->sqes_size);
+    }
+    if (iocp->cq_ring && iocp->cq_ring != iocp->sq_ring) {
+        munmap(iocp->cq_ring, iocp->cq_ring_size);
+    }
+    if (iocp->sq_ring) {
+        munmap(iocp->sq_ring, iocp->sq_ring_size);
+    }
+    if (iocp->ring_fd >= 0) {
+        close(iocp->ring_fd);  /* Cancels anything still in flight */
+    }
+
+    DeleteCriticalSection(&iocp->sq_lock);
+    DeleteCriticalSection(&iocp->accept_lock);
+    free(iocp);
+}
+
+/*
+ * Create sparse registered file and buffer tables, one slot per pooled
+ * connection. Either table may be unavailable (old kernel, RLIMIT_NOFILE,
+ * RLIMIT_MEMLOCK); the affected ops then fall back to plain fds/buffers.
+ */
+bool bolt_iocp_register_pool(BoltIOCP* iocp, struct BoltConnectionPool* pool) {
+    if (!iocp || !pool) return false;
+
+    int count = pool->capacity;
+    iocp->fixed_sockets = (SOCKET*)malloc(count * sizeof(SOCKET));
+    iocp->fixed_buffers = (bool*)calloc(count, sizeof(bool));
+    iocp->conn_gen = (uint16_t*)calloc(count, sizeof(uint16_t));
+    iocp->splice_pipes = (int*)malloc(count * 2 * sizeof(int));
+    iocp->send_msgs = (struct BoltUringSendMsg*)calloc(count, sizeof(struct BoltUringSendMsg));
+    if (!iocp->fixed_sockets || !iocp->fixed_buffers || !iocp->conn_gen ||
+        !iocp->splice_pipes || !iocp->send_msgs) {
+        free(iocp->fixed_sockets);
+        free(iocp->fixed_buffers);
+        free(iocp->conn_gen);
+        free(iocp->splice_pipes);
+        free(iocp->send_msgs);
+        iocp->fixed_sockets = NULL;
+        iocp->fixed_buffers = NULL;
+        iocp->conn_gen = NULL;
+        iocp->splice_pipes = NULL;
+        iocp->send_msgs = NULL;
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        iocp->fixed_sockets[i] = INVALID_SOCKET;
+        iocp->splice_pipes[i * 2] = iocp->splice_pipes[i * 2 + 1] = -1;
+    }
+    iocp->conns = pool->connections;
+    iocp->num_conns = count;
+
+    /* The file table is bounded by RLIMIT_NOFILE; a server sized for
+     * `count` connections needs that many descriptors anyway, plus a file
+     * and a splice pipe per connection sending a file. */
+    rlim_t want = (rlim_t)count * 4 + 64;
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < want) {
+        rl.rlim_cur = rl.rlim_max < want ? rl.rlim_max : want;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = (uint32_t)count;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    iocp->files_registered =
+        uring_register(iocp, IORING_REGISTER_FILES2, &reg, sizeof(reg)) == 0;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = (uint32_t)count;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    iocp->buffers_registered =
+        uring_register(iocp, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg)) == 0;
+
+    if (!iocp->files_registered || !iocp->buffers_registered) {
+        BOLT_ERROR("io_uring: registered %s unavailable, using plain %s",
+                   iocp->files_registered ? "buffers" : "files",
+                   iocp->files_registered ? "buffers" : "descriptors");
+    }
+    return true;
+}
+
+/*
+ * Install a new connection's socket (and, first time round, its send
+ * buffer) in the connection's registered slot.
+ */
+bool bolt_iocp_associate(BoltIOCP* iocp, SOCKET socket, void* completion_key) {
+    BoltConnection* conn = (BoltConnection*)completion_key;
+    int idx = conn ? conn_index(iocp, conn) : -1;
+    if (idx < 0) return true;
+
+    if (iocp->files_registered) {
+        int fd = socket;
+        struct io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = (uint32_t)idx;
+        update.fds = (uint64_t)(uintptr_t)&fd;
+        if (uring_register(iocp, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1) {
+            iocp->fixed_sockets[idx] = socket;
+        }
+    }
+
+    if (iocp->buffers_registered && !iocp->fixed_buffers[idx]) {
+        struct iovec iov = { conn->send_buffer, conn->send_buffer_size };
+        struct io_uring_rsrc_update2 update;
+        memset(&update, 0, sizeof(update));
+        update.offset = (uint32_t)idx;
+        update.data = (uint64_t)(uintptr_t)&iov;
+        update.nr = 1;
+        if (uring_register(iocp, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) == 1) {
+            iocp->fixed_buffers[idx] = true;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Drop a connection's fixed file before its socket is closed. Queued SQEs
+ * are flushed first so they still resolve to this socket, and the
+ * generation bump makes completions still in flight look stale.
+ */
+void bolt_iocp_dissociate(BoltIOCP* iocp, BoltConnection* conn) {
+    int idx = conn ? conn_index(iocp, conn) : -1;
+    if (idx < 0) return;
+
+    flush_submissions(iocp);
+    __atomic_add_fetch(&iocp->conn_gen[idx], 1, __ATOMIC_RELEASE);
+
+    /* A transfer cut short may have left body bytes in the pipe */
+    BoltOverlapped* send = &conn->send_overlapped;
+    if (send->op_type == BOLT_OP_TRANSMIT_FILE &&
+        (send->step == URING_STEP_SPLICE_IN || send->step == URING_STEP_SPLICE_OUT)) {
+        drop_splice_pipe(iocp, idx);
+        send->step = URING_STEP_NONE;
+    }
+
+    if (iocp->fixed_sockets[idx] != INVALID_SOCKET) {
+        int fd = -1;
+        struct io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = (uint32_t)idx;
+        update.fds = (uint64_t)(uintptr_t)&fd;
+        uring_register(iocp, IORING_REGISTER_FILES_UPDATE, &update, 1);
+        iocp->fixed_sockets[idx] = INVALID_SOCKET;
+    }
+}
+
+/*
+ * Post an accept: return the hand-off slot to the free stack. The
+ * multishot accept itself stays armed.
+ */
+bool bolt_iocp_post_accept(BoltIOCP* iocp, int accept_index) {
+    if (accept_index < 0 || accept_index >= iocp->num_accepts) {
+        return false;
+    }
+
+    iocp->accept_sockets[accept_index] = INVALID_SOCKET;
+
+    EnterCriticalSection(&iocp->accept_lock);
+    iocp->free_accepts[iocp->num_free_accepts++] = accept_index;
+    LeaveCriticalSection(&iocp->accept_lock);
+    return true;
+}
+
+/*
+ * Handle an accept CQE. Returns the hand-off slot, or NULL.
+ */
+static BoltOverlapped* accept_complete(BoltIOCP* iocp, const struct io_uring_cqe* cqe) {
+    if (cqe->res == -EINVAL && iocp->multishot_accept) {
+        /* Kernel without multishot accept: fall back to one SQE per accept */
+        iocp->multishot_accept = false;
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE) && iocp->running) {
+        queue_accept(iocp);
+    }
+    if (cqe->res < 0) {
+        if (cqe->res != -EINVAL && cqe->res != -ECONNABORTED) {
+            BOLT_ERROR("io_uring accept failed: %d", -cqe->res);
+        }
+        return NULL;
+    }
+
+    int accept_index = -1;
+    EnterCriticalSection(&iocp->accept_lock);
+    if (iocp->num_free_accepts > 0) {
+        accept_index = iocp->free_accepts[--iocp->num_free_accepts];
+    }
+    LeaveCriticalSection(&iocp->accept_lock);
+
+    if (accept_index < 0) {
+        /* Every slot is held by a worker mid-batch; cannot happen with a
+         * batch of slots per worker, but never leak the socket. */
+        closesocket(cqe->res);
+        return NULL;
+    }
+
+    iocp->accept_sockets[accept_index] = cqe->res;
+    return &iocp->accept_overlaps[accept_index];
+}
+
+/*
+ * Finish an accept completion.
+ */
+SOCKET bolt_iocp_finish_accept(BoltIOCP* iocp, BoltOverlapped* overlapped,
+                               DWORD bytes_transferred, uint32_t* client_ip) {
+    BOLT_UNUSED(bytes_transferred);
+
+    int accept_idx = overlapped->accept_index;
+    if (accept_idx < 0 || accept_idx >= iocp->num_accepts) {
+        return INVALID_SOCKET;
+    }
+
+    SOCKET client_socket = iocp->accept_sockets[accept_idx];
+
+    /* Multishot accept shares one SQE, so the peer address is fetched here */
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+    *client_ip = 0;
+    InterlockedIncrement64(&iocp->syscalls);
+    if (getpeername(client_socket, (struct sockaddr*)&peer, &peer_len) == 0 &&
+        peer.sin_family == AF_INET) {
+        *client_ip = peer.sin_addr.s_addr;
+    }
+
+    /* Disable Nagle */
+    int opt = 1;
+    InterlockedIncrement64(&iocp->syscalls);
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    return client_socket;
+}
+
+/*
+ * Post a receive operation.
+ */
+bool bolt_iocp_post_recv(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+
+    BoltOverlapped* overlap = &conn->recv_overlapped;
+    overlap->op_type = BOLT_OP_RECV;
+    overlap->connection = conn;
+    overlap->wsa_buf.buf = conn->recv_buffer + conn->recv_offset;
+    overlap->wsa_buf.len = (ULONG)(conn->recv_buffer_size - conn->recv_offset - 1);  /* Room for the terminator */
+
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, conn, overlap);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->addr = (uint64_t)(uintptr_t)overlap->wsa_buf.buf;
+    sqe->len = overlap->wsa_buf.len;
+    commit_sqe(iocp);
+    return true;
+}
+
+/*
+ * Post a send operation.
+ */
+bool bolt_iocp_post_send(BoltIOCP* iocp, BoltConnection* conn,
+                         const char* data, size_t len) {
+    if (!conn || !data || len == 0) return false;
+
+    /* Copy data to send buffer if needed */
+    if (data != conn->send_buffer) {
+        if (len > conn->send_buffer_size) {
+            return false;
+        }
+        memcpy(conn->send_buffer, data, len);
+    }
+
+    conn->send_segments[0].buf = conn->send_buffer;
+    conn->send_segments[0].len = (ULONG)len;
+    conn->send_segment_count = 1;
+    conn->send_buffer_used = len;
+    conn->send_remaining = len;
+    conn->send_offset = 0;
+
+    return bolt_iocp_repost_send(iocp, conn);
+}
+
+/*
+ * Re-post a send for the remaining bytes.
+ */
+bool bolt_iocp_repost_send(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+    if (conn->send_offset >= conn->send_remaining) return true;
+
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_SEND;
+    overlap->connection = conn;
+    overlap->step = URING_STEP_NONE;
+
+    WSABUF segments[BOLT_SEND_SEGMENTS];
+    int count = bolt_conn_send_vector(conn, segments, BOLT_SEND_SEGMENTS);
+    if (count == 0) return false;
+
+    int idx = conn_index(iocp, conn);
+    if (count > 1 && idx >= 0 && iocp->send_msgs) {
+        queue_sendmsg(iocp, conn, overlap, segments, count, idx);
+        return true;
+    }
+
+    /* One segment (a partial send of several re-posts the rest) */
+    overlap->wsa_buf = segments[0];
+    queue_send(iocp, conn, overlap, false);
+    return true;
+}
+
+/*
+ * Post TransmitFile (emulated: headers, then async read/send of the body).
+ * Supports range requests via range_start and range_length.
+ */
+bool bolt_iocp_post_transmit_file(BoltIOCP* iocp, BoltConnection* conn,
+                                   HANDLE file, size_t file_size,
+                                   const char* headers, size_t header_len,
+                                   size_t range_start, size_t range_length) {
+    if (!conn || file == INVALID_HANDLE_VALUE) return false;
+    if (header_len > conn->send_buffer_size) return false;
+
+    conn->file_handle = file;
+    conn->file_size = file_size;
+
+    /* Determine actual range to send */
+    size_t actual_start = 0;
+    size_t actual_length = file_size;
+
+    if (range_length > 0) {
+        /* Range request */
+        actual_start = range_start;
+        actual_length = range_length;
+
+        /* Validate range */
+        if (actual_start >= file_size) {
+            return false;  /* Invalid range */
+        }
+        if (actual_start + actual_length > file_size) {
+            actual_length = file_size - actual_start;  /* Clamp to file end */
+        }
+    }
+
+    conn->file_offset = actual_start;
+
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_TRANSMIT_FILE;
+    overlap->connection = conn;
+    overlap->file_end = actual_start + actual_length;
+    overlap->transferred = 0;
+    overlap->pipe_bytes = 0;
+
+    if (headers && header_len > 0) {
+        if (headers != conn->send_buffer) {
+            memcpy(conn->send_buffer, headers, header_len);
+        }
+        overlap->wsa_buf.buf = conn->send_buffer;
+        overlap->wsa_buf.len = (ULONG)header_len;
+        overlap->step = URING_STEP_SEND_HEADERS;
+        queue_send(iocp, conn, overlap, actual_length > 0);
+    } else if (actual_length > 0) {
+        queue_file_body(iocp, conn, overlap);
+    } else {
+        return false;  /* Nothing to transmit */
+    }
+
+    return true;
+}
+
+/*
+ * Abort outstanding I/O: shutdown completes an in-flight recv with 0 and
+ * fails sends/splices with EPIPE. Done synchronously, since the expiring
+ * worker holds the wheel lock and the socket must not be closed first.
+ */
+bool bolt_iocp_abort(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn || conn->socket == INVALID_SOCKET) return false;
+
+    InterlockedIncrement64(&iocp->syscalls);
+    return shutdown(conn->socket, SD_BOTH) == 0;
+}
+
+/*
+ * Post disconnect: async shutdown of both directions.
+ */
+bool bolt_iocp_post_disconnect(BoltIOCP* iocp, BoltConnection* conn) {
+    if (!conn) return false;
+
+    BoltOverlapped* overlap = &conn->send_overlapped;
+    overlap->op_type = BOLT_OP_DISCONNECT;
+    overlap->connection = conn;
+
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, conn, overlap);
+    sqe->opcode = IORING_OP_SHUTDOWN;
+    sqe->len = SHUT_RDWR;
+    commit_sqe(iocp);
+    return true;
+}
+
+/*
+ * Wake a worker: a NOP completion with no overlapped.
+ */
+bool bolt_iocp_post_wakeup(BoltIOCP* iocp) {
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = URING_TAG_WAKEUP;
+    commit_sqe(iocp);
+    flush_submissions(iocp);
+    return true;
+}
+
+/*
+ * Post a completion: a NOP tagged like an operation on the connection,
+ * so a connection closed meanwhile drops it as stale.
+ */
+bool bolt_iocp_post_completion(BoltIOCP* iocp, BoltOverlapped* overlapped) {
+    if (!overlapped || !overlapped->connection) return false;
+
+    struct io_uring_sqe* sqe = get_sqe(iocp);
+    prep_conn_sqe(iocp, sqe, overlapped->connection, overlapped);
+    sqe->opcode = IORING_OP_NOP;
+    sqe->fd = -1;
+    sqe->flags = 0;
+    commit_sqe(iocp);
+    flush_submissions(iocp);
+    return true;
+}
+
+/*
+ * Advance an emulated TransmitFile by one CQE.
+ * Returns true when the operation completed (or failed), false if the next
+ * step was queued.
+ */
+static bool transmit_step(BoltIOCP* iocp, BoltOverlapped* overlap, int res, DWORD* bytes) {
+    BoltConnection* conn = overlap->connection;
+
+    if (res <= 0) {
+        /* Send error, or read error / file truncated underneath us */
+        *bytes = 0;
+        return true;
+    }
+
+    switch (overlap->step) {
+        case URING_STEP_SEND_HEADERS:
+            overlap->wsa_buf.buf += res;
+            overlap->wsa_buf.len -= (ULONG)res;
+            overlap->transferred += (size_t)res;
+            if (overlap->wsa_buf.len > 0) {
+                queue_send(iocp, conn, overlap, conn->file_offset < overlap->file_end);
+                return false;
+            }
+            break;
+
+        case URING_STEP_READ:
+            overlap->wsa_buf.buf = conn->send_buffer;
+            overlap->wsa_buf.len = (ULONG)res;
+            overlap->step = URING_STEP_SEND_BODY;
+            queue_send(iocp, conn, overlap,
+                       conn->file_offset + (size_t)res < overlap->file_end);
+            return false;
+
+        case URING_STEP_SEND_BODY:
+            overlap->wsa_buf.buf += res;
+            overlap->wsa_buf.len -= (ULONG)res;
+            overlap->transferred += (size_t)res;
+            conn->file_offset += (size_t)res;
+            if (overlap->wsa_buf.len > 0) {
+                queue_send(iocp, conn, overlap,
+                           conn->file_offset + overlap->wsa_buf.len < overlap->file_end);
+                return false;
+            }
+            break;
+
+        case URING_STEP_SPLICE_IN:
+        case URING_STEP_SPLICE_OUT: {
+            int* pipe_fds = &iocp->splice_pipes[conn_index(iocp, conn) * 2];
+            if (overlap->step == URING_STEP_SPLICE_IN) {
+                overlap->pipe_bytes = (size_t)res;
+            } else {
+                overlap->pipe_bytes -= (size_t)res;
+                overlap->transferred += (size_t)res;
+                conn->file_offset += (size_t)res;
+            }
+            if (overlap->pipe_bytes > 0) {
+                /* Pipe still holds data (fresh or a short socket write) */
+                queue_splice(iocp, conn, overlap, pipe_fds, URING_STEP_SPLICE_OUT);
+                return false;
+            }
+            if (conn->file_offset < overlap->file_end) {
+                queue_splice(iocp, conn, overlap, pipe_fds, URING_STEP_SPLICE_IN);
+                return false;
+            }
+            break;
+        }
+
+        default:
+            *bytes = 0;
+            return true;
+    }
+
+    if (conn->file_offset < overlap->file_end) {
+        queue_file_body(iocp, conn, overlap);
+        return false;
+    }
+
+    overlap->step = URING_STEP_NONE;
+    *bytes = (DWORD)overlap->transferred;
+    return true;
+}
+
+/*
+ * Generations are checked when CQEs are reaped; an earlier entry of the
+ * same batch may have closed and recycled the slot since.
+ */
+bool bolt_iocp_completion_current(BoltIOCP* iocp, const BoltCompletion* entry) {
+    if (!entry->overlapped || entry->overlapped->op_type == BOLT_OP_ACCEPT) {
+        return true;
+    }
+    BoltConnection* conn = entry->overlapped->connection;
+    int idx = conn ? conn_index(iocp, conn) : -1;
+    if (idx < 0) {
+        return true;
+    }
+    return (uint16_t)entry->generation ==
+           __atomic_load_n(&iocp->conn_gen[idx], __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Backend name for metrics.
+ */
+const char* bolt_iocp_backend_name(void) {
+    return "io_uring";
+}
+
+/*
+ * Turn one CQE into a completion. Returns false if it produced none
+ * (stale, failed accept, or an internal TransmitFile step).
+ */
+static bool cqe_to_completion(BoltIOCP* iocp, const struct io_uring_cqe* cqe,
+                              BoltCompletion* entry) {
+    entry->overlapped = NULL;
+    entry->completion_key = 0;
+    entry->bytes_transferred = 0;
+    entry->generation = 0;
+
+    if (cqe->user_data == URING_TAG_WAKEUP) {
+        return true;  /* Wakeup: NULL overlapped */
+    }
+
+    if (cqe->user_data == URING_TAG_ACCEPT) {
+        entry->overlapped = accept_complete(iocp, cqe);
+        return entry->overlapped != NULL;
+    }
+
+    BoltOverlapped* overlap = (BoltOverlapped*)(uintptr_t)(cqe->user_data & URING_PTR_MASK);
+    BoltConnection* conn = overlap->connection;
+    if (!conn) {
+        return false;
+    }
+
+    /* Completion for an earlier incarnation of this connection */
+    int idx = conn_index(iocp, conn);
+    if (idx >= 0 &&
+        (uint16_t)(cqe->user_data >> URING_GEN_SHIFT) !=
+        __atomic_load_n(&iocp->conn_gen[idx], __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    DWORD bytes = 0;
+    switch (overlap->op_type) {
+        case BOLT_OP_RECV:
+        case BOLT_OP_SEND:
+            bytes = cqe->res > 0 ? (DWORD)cqe->res : 0;
+            break;
+
+        case BOLT_OP_TRANSMIT_FILE:
+            if (!transmit_step(iocp, overlap, cqe->res, &bytes)) {
+                return false;  /* Next step queued */
+            }
+            break;
+
+        case BOLT_OP_DISCONNECT:
+        default:
+            break;
+    }
+
+    entry->overlapped = overlap;
+    entry->completion_key = (ULONG_PTR)conn;
+    entry->bytes_transferred = bytes;
+    entry->generation = (uint16_t)(cqe->user_data >> URING_GEN_SHIFT);
+    return true;
+}
+
+/*
+ * Get a batch of completions from the ring. SQEs queued by the previous
+ * batch are submitted by the same io_uring_enter() that waits.
+ */
+int bolt_iocp_get_completions(BoltIOCP* iocp, BoltCompletion* entries,
+                              int max_entries, DWORD timeout_ms) {
+    struct io_uring_cqe cqes[BOLT_COMPLETION_BATCH_SIZE];
+    ULONGLONG deadline = GetTickCount64() + timeout_ms;
+
+    if (max_entries > BOLT_COMPLETION_BATCH_SIZE) max_entries = BOLT_COMPLETION_BATCH_SIZE;
+
+    for (;;) {
+        int n = reap_cqes(iocp, cqes, max_entries);
+        if (n == 0) {
+            /* Submit whatever is queued and wait for at least one CQE */
+            struct __kernel_timespec ts = { 0, 0 };
+            struct io_uring_getevents_arg arg;
+            memset(&arg, 0, sizeof(arg));
+            if (timeout_ms != INFINITE) {
+                ULONGLONG now = GetTickCount64();
+                ULONGLONG left = now >= deadline ? 0 : deadline - now;
+                if (left == 0) {
+                    flush_submissions(iocp);
+                    return 0;  /* Timeout */
+                }
+                ts.tv_sec = (long long)(left / 1000);
+                ts.tv_nsec = (long long)(left % 1000) * 1000000LL;
+                arg.ts = (uint64_t)(uintptr_t)&ts;
+            }
+
+            int ret = uring_enter(iocp, pending_submissions(iocp), 1,
+                                  IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                  &arg, sizeof(arg));
+            if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY &&
+                errno != EAGAIN) {
+                BOLT_ERROR("io_uring_enter failed: %d", errno);
+                return 0;
+            }
+            continue;
+        }
+
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            if (cqe_to_completion(iocp, &cqes[i], &entries[count])) {
+                count++;
+            }
+        }
+        if (count > 0) {
+            return count;
+        }
+    }
+}
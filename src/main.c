@@ -47,6 +47,9 @@ static void print_usage(const char* program) {
     printf("    -c, --config FILE Configuration file path (default: bolt.conf)\n");
     printf("    --stats           Print periodic stats to console\n");
     printf("    --stats-interval-ms N  Stats print interval (default: 1000)\n");
+    printf("    --reuseport       One listener + event loop per worker (Linux)\n");
+    printf("    --pin-workers     Pin each worker thread to a core\n");
+    printf("    --compute-threads N  Compression threads (0: compress on the workers)\n");
     printf("    -d, --daemon      Run as Windows Service\n");
     printf("    --install-service Install as Windows Service\n");
     printf("    --uninstall-service Uninstall Windows Service\n");
@@ -64,6 +67,9 @@ int main(int argc, char* argv[]) {
     BoltConfig config;
     bool stats = false;
     DWORD stats_interval_ms = 1000;
+    bool reuseport = false;
+    bool pin_workers = false;
+    int compute_threads = -2;   /* Not given */
     const char* config_path = "bolt.conf";
     
     /* Load default config */
@@ -115,6 +121,19 @@ int main(int argc, char* argv[]) {
             stats = true;
             continue;
         }
+        if (strcmp(argv[i], "--reuseport") == 0) {
+            reuseport = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--pin-workers") == 0) {
+            pin_workers = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--compute-threads") == 0 && i + 1 < argc) {
+            compute_threads = atoi(argv[i + 1]);
+            i++;
+            continue;
+        }
         if (strcmp(argv[i], "--stats-interval-ms") == 0 && i + 1 < argc) {
             stats_interval_ms = (DWORD)atoi(argv[i + 1]);
             i++;
@@ -141,9 +160,17 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Failed to load config from %s, using defaults\n", config_path);
     }
     
+    /* Command-line switches win over the config file */
+    if (reuseport) config.reuseport = true;
+    if (pin_workers) config.worker_cpu_affinity = true;
+    if (compute_threads != -2) config.compute_threads = compute_threads > 0 ? compute_threads : -1;
+    
     /* Setup signal handlers */
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);  /* Peer resets surface as send errors instead */
+#endif
     
     /* Create server with config */
     g_server = bolt_server_create_with_config(&config);
@@ -1,5 +1,6 @@
 #include "../include/metrics.h"
 #include "../include/threadpool.h"
+#include "../include/file_sender.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -26,6 +27,44 @@ bool metrics_generate_json(BoltServer* server, char* buffer, size_t buffer_size,
     ULONGLONG uptime = (GetTickCount64() - server->start_time) / 1000;
     double rps = uptime > 0 ? (double)total_requests / uptime : 0;
     
+    LONG64 syscalls = bolt_server_io_syscalls(server);
+    double syscalls_per_request = total_requests > 0 ? (double)syscalls / total_requests : 0;
+    
+    LONG64 histogram[BOLT_BATCH_HISTOGRAM_BUCKETS] = { 0 };
+    LONG64 completions = 0;
+    LONG64 batches = 0;
+    bolt_threadpool_batch_stats(server->thread_pool, histogram, &completions);
+    for (int i = 0; i < BOLT_BATCH_HISTOGRAM_BUCKETS; i++) {
+        batches += histogram[i];
+    }
+    double per_batch = batches > 0 ? (double)completions / batches : 0;
+    
+    BoltFileCacheStats cache;
+    bolt_file_cache_stats(server->file_cache, &cache);
+    LONG64 lookups = cache.hits + cache.misses;
+    double hit_ratio = lookups > 0 ? (double)cache.hits / lookups : 0;
+    
+    BoltOpenFileCacheStats open_files;
+    bolt_open_file_cache_stats(server->open_file_cache, &open_files);
+    
+    BoltPathCacheStats paths;
+    bolt_path_cache_stats(server->path_cache, &paths);
+    
+    BoltPathCacheStats negatives;
+    bolt_path_cache_stats(server->negative_cache, &negatives);
+    
+    BoltFsWatchStats watch;
+    bolt_fs_watch_stats(server->fs_watch, &watch);
+    
+    LONG64 contexts_created, contexts_reused;
+    compression_context_stats(&contexts_created, &contexts_reused);
+    
+    int compute_threads;
+    LONG64 jobs, jobs_stolen, jobs_inline;
+    LONG jobs_queued;
+    bolt_task_pool_stats(server->task_pool, &compute_threads, &jobs, &jobs_stolen,
+                         &jobs_inline, &jobs_queued);
+    
     int len = snprintf(buffer, buffer_size,
         "{\n"
         "  \"server\": {\n"
@@ -39,7 +78,8 @@ bool metrics_generate_json(BoltServer* server, char* buffer, size_t buffer_size,
         "  },\n"
         "  \"connections\": {\n"
         "    \"active\": %ld,\n"
-        "    \"max\": %d\n"
+        "    \"max\": %d,\n"
+        "    \"timed_out\": %lld\n"
         "  },\n"
         "  \"bandwidth\": {\n"
         "    \"bytes_sent\": %lld,\n"
@@ -48,19 +88,162 @@ bool metrics_generate_json(BoltServer* server, char* buffer, size_t buffer_size,
         "    \"bytes_received_mb\": %.2f\n"
         "  },\n"
         "  \"cache\": {\n"
-        "    \"enabled\": %s\n"
+        "    \"enabled\": %s,\n"
+        "    \"shards\": %zu,\n"
+        "    \"entries\": %zu,\n"
+        "    \"bytes\": %zu,\n"
+        "    \"hits\": %lld,\n"
+        "    \"misses\": %lld,\n"
+        "    \"hit_ratio\": %.4f,\n"
+        "    \"evictions\": %lld,\n"
+        "    \"fills\": %lld,\n"
+        "    \"compressions\": %lld,\n"
+        "    \"fill_fallbacks\": %lld,\n"
+        "    \"invalidations\": %lld,\n"
+        "    \"upgrades\": %lld\n"
+        "  },\n"
+        "  \"open_file_cache\": {\n"
+        "    \"enabled\": %s,\n"
+        "    \"entries\": %zu,\n"
+        "    \"handles\": %zu,\n"
+        "    \"hits\": %lld,\n"
+        "    \"misses\": %lld,\n"
+        "    \"opens\": %lld,\n"
+        "    \"revalidations\": %lld,\n"
+        "    \"evictions\": %lld,\n"
+        "    \"invalidations\": %lld\n"
+        "  },\n"
+        "  \"path_cache\": {\n"
+        "    \"enabled\": %s,\n"
+        "    \"entries\": %zu,\n"
+        "    \"hits\": %lld,\n"
+        "    \"misses\": %lld,\n"
+        "    \"evictions\": %lld,\n"
+        "    \"invalidations\": %lld\n"
+        "  },\n"
+        "  \"negative_cache\": {\n"
+        "    \"enabled\": %s,\n"
+        "    \"entries\": %zu,\n"
+        "    \"hits\": %lld,\n"
+        "    \"misses\": %lld,\n"
+        "    \"evictions\": %lld,\n"
+        "    \"invalidations\": %lld\n"
+        "  },\n"
+        "  \"fs_watch\": {\n"
+        "    \"enabled\": %s,\n"
+        "    \"roots\": %zu,\n"
+        "    \"watches\": %zu,\n"
+        "    \"events\": %lld,\n"
+        "    \"rescans\": %lld\n"
+        "  },\n"
+        "  \"compression\": {\n"
+        "    \"streams_active\": %ld,\n"
+        "    \"streams\": %lld,\n"
+        "    \"contexts_created\": %lld,\n"
+        "    \"contexts_reused\": %lld,\n"
+        "    \"adaptive\": %s,\n"
+        "    \"load\": \"%s\",\n"
+        "    \"worker_cpu_percent\": %d,\n"
+        "    \"load_raised\": %lld,\n"
+        "    \"load_lowered\": %lld,\n"
+        "    \"shed\": %lld,\n"
+        "    \"levels\": {\"gzip\": %d, \"br\": %d, \"zstd\": %d},\n"
+        "    \"stored_levels\": {\"gzip\": %d, \"br\": %d, \"zstd\": %d}\n"
+        "  },\n"
+        "  \"compute\": {\n"
+        "    \"threads\": %d,\n"
+        "    \"jobs\": %lld,\n"
+        "    \"stolen\": %lld,\n"
+        "    \"inline\": %lld,\n"
+        "    \"queued\": %ld\n"
+        "  },\n"
+        "  \"io\": {\n"
+        "    \"backend\": \"%s\",\n"
+        "    \"syscalls\": %lld,\n"
+        "    \"syscalls_per_request\": %.2f,\n"
+        "    \"batches\": %lld,\n"
+        "    \"completions_per_batch\": %.2f,\n"
+        "    \"batch_histogram\": {\"1\": %lld, \"2-3\": %lld, \"4-7\": %lld, "
+        "\"8-15\": %lld, \"16-31\": %lld, \"32-63\": %lld, \"64+\": %lld}\n"
         "  }\n"
         "}\n",
         uptime,
         total_requests,
         rps,
-        server->conn_pool ? server->conn_pool->active_count : 0,
-        server->conn_pool ? server->conn_pool->capacity : 0,
+        bolt_server_active_connections(server),
+        bolt_server_max_connections(server),
+        bolt_threadpool_timeouts(server->thread_pool),
         bytes_sent,
         bytes_received,
         bytes_sent / (1024.0 * 1024.0),
         bytes_received / (1024.0 * 1024.0),
-        server->file_cache ? "true" : "false"
+        server->file_cache ? "true" : "false",
+        cache.shards,
+        cache.entries,
+        cache.bytes,
+        cache.hits,
+        cache.misses,
+        hit_ratio,
+        cache.evictions,
+        cache.fills,
+        cache.compressions,
+        cache.fill_fallbacks,
+        cache.invalidations,
+        cache.upgrades,
+        server->open_file_cache ? "true" : "false",
+        open_files.entries,
+        open_files.handles,
+        open_files.hits,
+        open_files.misses,
+        open_files.opens,
+        open_files.revalidations,
+        open_files.evictions,
+        open_files.invalidations,
+        server->path_cache ? "true" : "false",
+        paths.entries,
+        paths.hits,
+        paths.misses,
+        paths.evictions,
+        paths.invalidations,
+        server->negative_cache ? "true" : "false",
+        negatives.entries,
+        negatives.hits,
+        negatives.misses,
+        negatives.evictions,
+        negatives.invalidations,
+        server->fs_watch ? "true" : "false",
+        watch.roots,
+        watch.watches,
+        watch.events,
+        watch.rescans,
+        bolt_send_stream_active(),
+        bolt_send_stream_total(),
+        contexts_created,
+        contexts_reused,
+        server->compression_adaptive ? "true" : "false",
+        compression_load_name(compression_load()),
+        server->compression_adapt.utilization,
+        server->compression_adapt.raised,
+        server->compression_adapt.lowered,
+        compression_shed_count(),
+        compression_level(NULL, BOLT_COMPRESS_GZIP),
+        compression_level(NULL, BOLT_COMPRESS_BROTLI),
+        compression_level(NULL, BOLT_COMPRESS_ZSTD),
+        compression_stored_level(NULL, BOLT_COMPRESS_GZIP),
+        compression_stored_level(NULL, BOLT_COMPRESS_BROTLI),
+        compression_stored_level(NULL, BOLT_COMPRESS_ZSTD),
+        compute_threads,
+        jobs,
+        jobs_stolen,
+        jobs_inline,
+        jobs_queued,
+        bolt_iocp_backend_name(),
+        syscalls,
+        syscalls_per_request,
+        batches,
+        per_batch,
+        histogram[0], histogram[1], histogram[2], histogram[3],
+        histogram[4], histogram[5], histogram[6]
     );
     
     if (len < 0 || len >= (int)buffer_size) {
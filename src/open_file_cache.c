@@ -0,0 +1,405 @@
+#include "../include/open_file_cache.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Independently locked segments; small caches use fewer */
+#define OPEN_CACHE_SHARDS           16
+#define OPEN_CACHE_MIN_SHARD_ENTRIES 16
+
+/*
+ * Cached path. Slots are preallocated per shard and recycled through the
+ * free list (via hash_next).
+ */
+typedef struct OpenEntry {
+    struct OpenEntry* hash_next;
+    struct OpenEntry* lru_prev;
+    struct OpenEntry* lru_next;
+    uint32_t hash;
+    FileInfo info;
+    ULONGLONG checked;          /* When info was last stat'ed */
+    BoltOpenFile* file;         /* Cache's reference, NULL until opened */
+    char path[BOLT_MAX_PATH_LENGTH];
+} OpenEntry;
+
+typedef struct {
+    CRITICAL_SECTION lock;
+    OpenEntry* entries;
+    OpenEntry* free_list;
+    OpenEntry** buckets;
+    size_t bucket_mask;
+    OpenEntry lru;              /* List head: most recent at lru_next */
+    size_t count;
+    size_t capacity;
+    size_t handles;
+    LONG64 generation;          /* Bumped by invalidations */
+
+    /* Statistics */
+    LONG64 hits;
+    LONG64 misses;
+    LONG64 opens;
+    LONG64 revalidations;
+    LONG64 evictions;
+    LONG64 invalidations;
+} OpenShard;
+
+struct BoltOpenFileCache {
+    OpenShard* shards;
+    size_t shard_mask;
+    volatile DWORD valid_ms;    /* Longer while a watcher reports changes */
+};
+
+static uint32_t fnv1a32(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)(*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * Open a file for transfers. The handle is only ever read at explicit
+ * offsets, so any number of transfers may share it. It outlives them in
+ * the cache, so it must not stop a deploy from replacing or deleting the
+ * file: the next re-stat then sees the change and drops it.
+ */
+static BoltOpenFile* open_file_create(const char* path) {
+    HANDLE handle = CreateFileA(path, GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                NULL);
+    if (handle == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER size;
+    BoltOpenFile* file = (BoltOpenFile*)malloc(sizeof(BoltOpenFile));
+    if (!file || !GetFileSizeEx(handle, &size)) {
+        free(file);
+        CloseHandle(handle);
+        return NULL;
+    }
+
+    file->handle = handle;
+    file->size = (size_t)size.QuadPart;
+    file->refs = 1;
+    return file;
+}
+
+void bolt_open_file_release(BoltOpenFile* file) {
+    if (!file) return;
+
+    if (InterlockedDecrement(&file->refs) == 0) {
+        CloseHandle(file->handle);
+        free(file);
+    }
+}
+
+static void lru_unlink(OpenEntry* entry) {
+    entry->lru_prev->lru_next = entry->lru_next;
+    entry->lru_next->lru_prev = entry->lru_prev;
+}
+
+static void lru_push(OpenShard* shard, OpenEntry* entry) {
+    entry->lru_prev = &shard->lru;
+    entry->lru_next = shard->lru.lru_next;
+    shard->lru.lru_next->lru_prev = entry;
+    shard->lru.lru_next = entry;
+}
+
+static OpenShard* shard_for(BoltOpenFileCache* cache, uint32_t hash) {
+    return &cache->shards[(hash >> 16) & cache->shard_mask];
+}
+
+/* Requires shard lock */
+static OpenEntry* shard_find(OpenShard* shard, uint32_t hash, const char* path) {
+    OpenEntry* entry = shard->buckets[hash & shard->bucket_mask];
+    while (entry) {
+        if (entry->hash == hash && strcmp(entry->path, path) == 0) return entry;
+        entry = entry->hash_next;
+    }
+    return NULL;
+}
+
+/* Requires shard lock */
+static void shard_drop_file(OpenShard* shard, OpenEntry* entry) {
+    if (!entry->file) return;
+
+    bolt_open_file_release(entry->file);
+    entry->file = NULL;
+    shard->handles--;
+}
+
+/* Requires shard lock */
+static void shard_remove(OpenShard* shard, OpenEntry* entry) {
+    OpenEntry** link = &shard->buckets[entry->hash & shard->bucket_mask];
+    while (*link != entry) link = &(*link)->hash_next;
+    *link = entry->hash_next;
+
+    lru_unlink(entry);
+    shard_drop_file(shard, entry);
+    entry->hash_next = shard->free_list;
+    shard->free_list = entry;
+    shard->count--;
+}
+
+/* Requires shard lock */
+static void shard_insert(OpenShard* shard, uint32_t hash, const char* path,
+                         const FileInfo* info, ULONGLONG now) {
+    if (shard->count == shard->capacity) {
+        shard_remove(shard, shard->lru.lru_prev);
+        shard->evictions++;
+    }
+
+    OpenEntry* entry = shard->free_list;
+    shard->free_list = entry->hash_next;
+
+    entry->hash = hash;
+    entry->info = *info;
+    entry->checked = now;
+    entry->file = NULL;
+    strcpy(entry->path, path);
+
+    entry->hash_next = shard->buckets[hash & shard->bucket_mask];
+    shard->buckets[hash & shard->bucket_mask] = entry;
+    lru_push(shard, entry);
+    shard->count++;
+}
+
+/*
+ * Look a path up, stat'ing it (outside the lock) only when it is unknown
+ * or its entry has expired. If `out_file` is set and the entry holds a
+ * handle, a reference to it is returned there. `out_generation` gets the
+ * shard generation the result is valid for.
+ */
+static FileInfo cache_lookup(BoltOpenFileCache* cache, const char* path,
+                             BoltOpenFile** out_file, LONG64* out_generation) {
+    uint32_t hash = fnv1a32(path);
+    OpenShard* shard = shard_for(cache, hash);
+
+    EnterCriticalSection(&shard->lock);
+    ULONGLONG now = GetTickCount64();
+    LONG64 generation = shard->generation;
+    if (out_generation) *out_generation = generation;
+    OpenEntry* entry = shard_find(shard, hash, path);
+    if (entry && now - entry->checked < cache->valid_ms) {
+        FileInfo info = entry->info;
+        if (out_file && entry->file) {
+            InterlockedIncrement(&entry->file->refs);
+            *out_file = entry->file;
+        }
+        lru_unlink(entry);
+        lru_push(shard, entry);
+        shard->hits++;
+        LeaveCriticalSection(&shard->lock);
+        return info;
+    }
+    LeaveCriticalSection(&shard->lock);
+
+    FileInfo info = utils_get_file_info(path);
+
+    EnterCriticalSection(&shard->lock);
+    if (shard->generation != generation) {
+        /* Invalidated while we were stat'ing: the result may predate the
+         * change, so use it for this request only */
+        LeaveCriticalSection(&shard->lock);
+        return info;
+    }
+    entry = shard_find(shard, hash, path);
+    if (entry) {
+        shard->revalidations++;
+        if (!info.exists) {
+            shard_remove(shard, entry);
+        } else {
+            if (entry->info.size != info.size || entry->info.mtime != info.mtime ||
+                entry->info.is_directory != info.is_directory) {
+                shard_drop_file(shard, entry);
+            }
+            entry->info = info;
+            entry->checked = now;
+            if (out_file && entry->file) {
+                InterlockedIncrement(&entry->file->refs);
+                *out_file = entry->file;
+            }
+        }
+    } else {
+        shard->misses++;
+        if (info.exists) {
+            shard_insert(shard, hash, path, &info, now);
+        }
+    }
+    LeaveCriticalSection(&shard->lock);
+
+    return info;
+}
+
+BoltOpenFileCache* bolt_open_file_cache_create(size_t capacity, DWORD valid_ms) {
+    if (capacity == 0) return NULL;
+
+    BoltOpenFileCache* cache = (BoltOpenFileCache*)calloc(1, sizeof(BoltOpenFileCache));
+    if (!cache) return NULL;
+
+    size_t shard_count = OPEN_CACHE_SHARDS;
+    while (shard_count > 1 && capacity / shard_count < OPEN_CACHE_MIN_SHARD_ENTRIES) {
+        shard_count >>= 1;
+    }
+
+    cache->shards = (OpenShard*)calloc(shard_count, sizeof(OpenShard));
+    if (!cache->shards) {
+        free(cache);
+        return NULL;
+    }
+    cache->shard_mask = shard_count - 1;
+    cache->valid_ms = valid_ms;
+
+    for (size_t i = 0; i < shard_count; i++) {
+        OpenShard* shard = &cache->shards[i];
+        InitializeCriticalSection(&shard->lock);
+        shard->lru.lru_next = &shard->lru;
+        shard->lru.lru_prev = &shard->lru;
+
+        /* Spread the remainder so the shards add up to capacity */
+        shard->capacity = capacity / shard_count + (i < capacity % shard_count ? 1 : 0);
+        if (shard->capacity == 0) shard->capacity = 1;
+
+        size_t buckets = 1;
+        while (buckets < shard->capacity * 2) buckets <<= 1;
+        shard->bucket_mask = buckets - 1;
+
+        shard->entries = (OpenEntry*)calloc(shard->capacity, sizeof(OpenEntry));
+        shard->buckets = (OpenEntry**)calloc(buckets, sizeof(OpenEntry*));
+        if (!shard->entries || !shard->buckets) {
+            cache->shard_mask = i;
+            bolt_open_file_cache_destroy(cache);
+            return NULL;
+        }
+        for (size_t j = 0; j < shard->capacity; j++) {
+            shard->entries[j].hash_next = shard->free_list;
+            shard->free_list = &shard->entries[j];
+        }
+    }
+
+    return cache;
+}
+
+void bolt_open_file_cache_destroy(BoltOpenFileCache* cache) {
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask && cache->shards; i++) {
+        OpenShard* shard = &cache->shards[i];
+        if (shard->entries) {
+            for (size_t j = 0; j < shard->capacity; j++) {
+                bolt_open_file_release(shard->entries[j].file);
+            }
+        }
+        free(shard->entries);
+        free(shard->buckets);
+        DeleteCriticalSection(&shard->lock);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+FileInfo bolt_open_file_cache_stat(BoltOpenFileCache* cache, const char* path) {
+    if (!cache || !path || strlen(path) >= BOLT_MAX_PATH_LENGTH) {
+        return utils_get_file_info(path);
+    }
+    return cache_lookup(cache, path, NULL, NULL);
+}
+
+BoltOpenFile* bolt_open_file_cache_open(BoltOpenFileCache* cache, const char* path) {
+    if (!path) return NULL;
+    if (!cache || strlen(path) >= BOLT_MAX_PATH_LENGTH) {
+        return open_file_create(path);
+    }
+
+    BoltOpenFile* file = NULL;
+    LONG64 generation;
+    FileInfo info = cache_lookup(cache, path, &file, &generation);
+    if (file) return file;
+    if (!info.exists || info.is_directory) return NULL;
+
+    /* Open outside the lock, then share the handle unless another request
+     * got there first or the file changed since it was stat'ed */
+    file = open_file_create(path);
+    if (!file) return NULL;
+
+    uint32_t hash = fnv1a32(path);
+    OpenShard* shard = shard_for(cache, hash);
+
+    EnterCriticalSection(&shard->lock);
+    shard->opens++;
+    OpenEntry* entry = shard_find(shard, hash, path);
+    if (entry && entry->file) {
+        BoltOpenFile* shared = entry->file;
+        InterlockedIncrement(&shared->refs);
+        LeaveCriticalSection(&shard->lock);
+        bolt_open_file_release(file);
+        return shared;
+    }
+    if (entry && shard->generation == generation &&
+        entry->info.size == file->size && entry->info.mtime == info.mtime) {
+        InterlockedIncrement(&file->refs);
+        entry->file = file;
+        shard->handles++;
+    }
+    LeaveCriticalSection(&shard->lock);
+
+    return file;
+}
+
+void bolt_open_file_cache_set_valid(BoltOpenFileCache* cache, DWORD valid_ms) {
+    if (cache) cache->valid_ms = valid_ms;
+}
+
+void bolt_open_file_cache_invalidate(BoltOpenFileCache* cache, const char* path) {
+    if (!cache || !path) return;
+
+    uint32_t hash = fnv1a32(path);
+    OpenShard* shard = shard_for(cache, hash);
+
+    EnterCriticalSection(&shard->lock);
+    OpenEntry* entry = shard_find(shard, hash, path);
+    if (entry) {
+        shard_remove(shard, entry);
+        shard->invalidations++;
+    }
+    shard->generation++;
+    LeaveCriticalSection(&shard->lock);
+}
+
+void bolt_open_file_cache_invalidate_all(BoltOpenFileCache* cache) {
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask; i++) {
+        OpenShard* shard = &cache->shards[i];
+        EnterCriticalSection(&shard->lock);
+        while (shard->lru.lru_next != &shard->lru) {
+            shard_remove(shard, shard->lru.lru_next);
+            shard->invalidations++;
+        }
+        shard->generation++;
+        LeaveCriticalSection(&shard->lock);
+    }
+}
+
+void bolt_open_file_cache_stats(BoltOpenFileCache* cache, BoltOpenFileCacheStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask; i++) {
+        OpenShard* shard = &cache->shards[i];
+        EnterCriticalSection(&shard->lock);
+        out->entries += shard->count;
+        out->handles += shard->handles;
+        out->hits += shard->hits;
+        out->misses += shard->misses;
+        out->opens += shard->opens;
+        out->revalidations += shard->revalidations;
+        out->evictions += shard->evictions;
+        out->invalidations += shard->invalidations;
+        LeaveCriticalSection(&shard->lock);
+    }
+}
@@ -0,0 +1,263 @@
+#include "../include/path_cache.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Independently locked segments; small caches use fewer */
+#define PATH_CACHE_SHARDS           16
+#define PATH_CACHE_MIN_SHARD_ENTRIES 16
+
+/*
+ * Cached resolution. Slots are preallocated per shard and recycled
+ * through the free list (via hash_next).
+ */
+typedef struct PathEntry {
+    struct PathEntry* hash_next;
+    struct PathEntry* lru_prev;
+    struct PathEntry* lru_next;
+    uint32_t hash;
+    LONG64 generation;          /* Cache generation it was resolved in */
+    ULONGLONG resolved_at;
+    BoltResolvedPath resolved;
+    char key[BOLT_PATH_CACHE_MAX_KEY];
+} PathEntry;
+
+typedef struct {
+    CRITICAL_SECTION lock;
+    PathEntry* entries;
+    PathEntry* free_list;
+    PathEntry** buckets;
+    size_t bucket_mask;
+    PathEntry lru;              /* List head: most recent at lru_next */
+    size_t count;
+    size_t capacity;
+
+    /* Statistics */
+    LONG64 hits;
+    LONG64 misses;
+    LONG64 evictions;
+} PathShard;
+
+struct BoltPathCache {
+    PathShard* shards;
+    size_t shard_mask;
+    volatile DWORD valid_ms;
+    volatile LONG64 generation; /* Bumped to drop every entry */
+};
+
+static uint32_t fnv1a32(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)(*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* "host uri": neither may contain a space */
+static bool make_key(char* key, const char* host, const char* uri) {
+    size_t host_len = host ? strlen(host) : 0;
+    size_t uri_len = strlen(uri);
+    if (host_len + 1 + uri_len >= BOLT_PATH_CACHE_MAX_KEY) return false;
+
+    memcpy(key, host, host_len);
+    key[host_len] = ' ';
+    memcpy(key + host_len + 1, uri, uri_len + 1);
+    return true;
+}
+
+static void lru_unlink(PathEntry* entry) {
+    entry->lru_prev->lru_next = entry->lru_next;
+    entry->lru_next->lru_prev = entry->lru_prev;
+}
+
+static void lru_push(PathShard* shard, PathEntry* entry) {
+    entry->lru_prev = &shard->lru;
+    entry->lru_next = shard->lru.lru_next;
+    shard->lru.lru_next->lru_prev = entry;
+    shard->lru.lru_next = entry;
+}
+
+static PathShard* shard_for(BoltPathCache* cache, uint32_t hash) {
+    return &cache->shards[(hash >> 16) & cache->shard_mask];
+}
+
+/* Requires shard lock */
+static PathEntry* shard_find(PathShard* shard, uint32_t hash, const char* key) {
+    PathEntry* entry = shard->buckets[hash & shard->bucket_mask];
+    while (entry) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) return entry;
+        entry = entry->hash_next;
+    }
+    return NULL;
+}
+
+/* Requires shard lock */
+static void shard_remove(PathShard* shard, PathEntry* entry) {
+    PathEntry** link = &shard->buckets[entry->hash & shard->bucket_mask];
+    while (*link != entry) link = &(*link)->hash_next;
+    *link = entry->hash_next;
+
+    lru_unlink(entry);
+    entry->hash_next = shard->free_list;
+    shard->free_list = entry;
+    shard->count--;
+}
+
+BoltPathCache* bolt_path_cache_create(size_t capacity, DWORD valid_ms) {
+    if (capacity == 0) return NULL;
+
+    BoltPathCache* cache = (BoltPathCache*)calloc(1, sizeof(BoltPathCache));
+    if (!cache) return NULL;
+
+    size_t shard_count = PATH_CACHE_SHARDS;
+    while (shard_count > 1 && capacity / shard_count < PATH_CACHE_MIN_SHARD_ENTRIES) {
+        shard_count >>= 1;
+    }
+
+    cache->shards = (PathShard*)calloc(shard_count, sizeof(PathShard));
+    if (!cache->shards) {
+        free(cache);
+        return NULL;
+    }
+    cache->shard_mask = shard_count - 1;
+    cache->valid_ms = valid_ms;
+
+    for (size_t i = 0; i < shard_count; i++) {
+        PathShard* shard = &cache->shards[i];
+        InitializeCriticalSection(&shard->lock);
+        shard->lru.lru_next = &shard->lru;
+        shard->lru.lru_prev = &shard->lru;
+
+        /* Spread the remainder so the shards add up to capacity */
+        shard->capacity = capacity / shard_count + (i < capacity % shard_count ? 1 : 0);
+        if (shard->capacity == 0) shard->capacity = 1;
+
+        size_t buckets = 1;
+        while (buckets < shard->capacity * 2) buckets <<= 1;
+        shard->bucket_mask = buckets - 1;
+
+        shard->entries = (PathEntry*)calloc(shard->capacity, sizeof(PathEntry));
+        shard->buckets = (PathEntry**)calloc(buckets, sizeof(PathEntry*));
+        if (!shard->entries || !shard->buckets) {
+            cache->shard_mask = i;
+            bolt_path_cache_destroy(cache);
+            return NULL;
+        }
+        for (size_t j = 0; j < shard->capacity; j++) {
+            shard->entries[j].hash_next = shard->free_list;
+            shard->free_list = &shard->entries[j];
+        }
+    }
+
+    return cache;
+}
+
+void bolt_path_cache_destroy(BoltPathCache* cache) {
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask && cache->shards; i++) {
+        PathShard* shard = &cache->shards[i];
+        free(shard->entries);
+        free(shard->buckets);
+        DeleteCriticalSection(&shard->lock);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+bool bolt_path_cache_lookup(BoltPathCache* cache, const char* host, const char* uri,
+                            BoltResolvedPath* out, LONG64* out_generation) {
+    if (out_generation) *out_generation = cache ? cache->generation : 0;
+
+    char key[BOLT_PATH_CACHE_MAX_KEY];
+    if (!cache || !uri || !out || !make_key(key, host, uri)) return false;
+
+    uint32_t hash = fnv1a32(key);
+    PathShard* shard = shard_for(cache, hash);
+
+    EnterCriticalSection(&shard->lock);
+    PathEntry* entry = shard_find(shard, hash, key);
+    if (entry && (entry->generation != cache->generation ||
+                  GetTickCount64() - entry->resolved_at >= cache->valid_ms)) {
+        shard_remove(shard, entry);
+        entry = NULL;
+    }
+    if (!entry) {
+        shard->misses++;
+        LeaveCriticalSection(&shard->lock);
+        return false;
+    }
+
+    *out = entry->resolved;
+    lru_unlink(entry);
+    lru_push(shard, entry);
+    shard->hits++;
+    LeaveCriticalSection(&shard->lock);
+    return true;
+}
+
+void bolt_path_cache_insert(BoltPathCache* cache, const char* host, const char* uri,
+                            const BoltResolvedPath* resolved, LONG64 generation) {
+    char key[BOLT_PATH_CACHE_MAX_KEY];
+    if (!cache || !uri || !resolved || !make_key(key, host, uri)) return;
+
+    uint32_t hash = fnv1a32(key);
+    PathShard* shard = shard_for(cache, hash);
+
+    EnterCriticalSection(&shard->lock);
+    if (generation != cache->generation) {
+        /* Resolved from a filesystem or configuration that has changed since */
+        LeaveCriticalSection(&shard->lock);
+        return;
+    }
+
+    PathEntry* entry = shard_find(shard, hash, key);
+    if (entry) {
+        lru_unlink(entry);
+    } else {
+        if (shard->count == shard->capacity) {
+            shard_remove(shard, shard->lru.lru_prev);
+            shard->evictions++;
+        }
+        entry = shard->free_list;
+        shard->free_list = entry->hash_next;
+        entry->hash = hash;
+        strcpy(entry->key, key);
+        entry->hash_next = shard->buckets[hash & shard->bucket_mask];
+        shard->buckets[hash & shard->bucket_mask] = entry;
+        shard->count++;
+    }
+
+    entry->generation = generation;
+    entry->resolved_at = GetTickCount64();
+    entry->resolved = *resolved;
+    lru_push(shard, entry);
+    LeaveCriticalSection(&shard->lock);
+}
+
+void bolt_path_cache_set_valid(BoltPathCache* cache, DWORD valid_ms) {
+    if (cache) cache->valid_ms = valid_ms;
+}
+
+void bolt_path_cache_invalidate_all(BoltPathCache* cache) {
+    if (cache) InterlockedIncrement64(&cache->generation);
+}
+
+void bolt_path_cache_stats(BoltPathCache* cache, BoltPathCacheStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!cache) return;
+
+    for (size_t i = 0; i <= cache->shard_mask; i++) {
+        PathShard* shard = &cache->shards[i];
+        EnterCriticalSection(&shard->lock);
+        out->entries += shard->count;
+        out->hits += shard->hits;
+        out->misses += shard->misses;
+        out->evictions += shard->evictions;
+        LeaveCriticalSection(&shard->lock);
+    }
+    out->invalidations = cache->generation;
+}
@@ -1,8 +1,9 @@
 #include "../include/profiler.h"
 #include "../include/connection.h"
 #include "../include/logger.h"
-#include <windows.h>
+#ifdef _WIN32
 #include <psapi.h>
+#endif
 #include <stdio.h>
 #include <string.h>
 
@@ -57,6 +58,7 @@ void profiler_end_request(BoltConnection* conn, BoltLogger* logger) {
  * Get memory usage statistics.
  */
 void profiler_get_memory_stats(size_t* total_memory, size_t* used_memory) {
+#ifdef _WIN32
     PROCESS_MEMORY_COUNTERS_EX pmc;
     if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
         if (total_memory) {
@@ -69,5 +71,18 @@ void profiler_get_memory_stats(size_t* total_memory, size_t* used_memory) {
         if (total_memory) *total_memory = 0;
         if (used_memory) *used_memory = 0;
     }
+#else
+    /* /proc/self/statm: size resident shared ... (in pages) */
+    unsigned long size_pages = 0, resident_pages = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f && fscanf(f, "%lu %lu", &size_pages, &resident_pages) == 2) {
+        long page = sysconf(_SC_PAGESIZE);
+        if (total_memory) *total_memory = (size_t)resident_pages * (size_t)page;
+        if (used_memory) *used_memory = (size_t)size_pages * (size_t)page;
+    } else {
+        if (total_memory) *total_memory = 0;
+        if (used_memory) *used_memory = 0;
+    }
+    if (f) fclose(f);
+#endif
 }
-
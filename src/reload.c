@@ -48,6 +48,10 @@ bool reload_config(BoltServer* server, const char* config_path) {
         }
     }
     
+    /* Resolutions depend on vhosts and rewrite rules */
+    bolt_path_cache_invalidate_all(server->path_cache);
+    bolt_path_cache_invalidate_all(server->negative_cache);
+    
     /* TODO: Apply new configuration */
     /* This requires updating:
      * - Logger paths/levels
@@ -71,10 +75,14 @@ bool reload_config(BoltServer* server, const char* config_path) {
 void reload_setup_signal_handler(BoltServer* server) {
     g_reload_server = server;
     
+#ifdef _WIN32
     /* On Windows, use Ctrl+Break or custom event for reload */
     /* For now, SIGHUP is not available on Windows */
     /* TODO: Implement Windows-specific reload mechanism */
     
     signal(SIGBREAK, reload_signal_handler);
+#else
+    signal(SIGHUP, reload_signal_handler);
+#endif
 }
 
@@ -1,13 +1,14 @@
 #include "../include/service.h"
 #include "../include/bolt_server.h"
 #include "../include/config.h"
-#include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define SERVICE_NAME_MAX 256
 
+#ifdef _WIN32
+
 static SERVICE_STATUS g_service_status;
 static SERVICE_STATUS_HANDLE g_service_status_handle = NULL;
 static BoltServer* g_service_server = NULL;
@@ -170,3 +171,31 @@ bool service_is_running(void) {
     return (g_service_status_handle != NULL);
 }
 
+#else /* POSIX: no service manager integration (use systemd or similar) */
+
+bool service_install(const char* service_name, const char* display_name,
+                     const char* description, const char* config_path) {
+    (void)service_name;
+    (void)display_name;
+    (void)description;
+    (void)config_path;
+    return false;
+}
+
+bool service_uninstall(const char* service_name) {
+    (void)service_name;
+    return false;
+}
+
+bool service_run(const char* service_name, int argc, char* argv[]) {
+    (void)service_name;
+    (void)argc;
+    (void)argv;
+    return false;
+}
+
+bool service_is_running(void) {
+    return false;
+}
+
+#endif /* _WIN32 */
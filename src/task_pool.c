@@ -0,0 +1,250 @@
+#include "../include/task_pool.h"
+#include "../include/connection.h"
+#include "../include/iocp.h"
+#include "../include/compression.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * One thread's jobs: a ring, oldest at head. The owner takes from the
+ * head, thieves from the tail, each under the deque's lock (jobs take
+ * milliseconds, so the lock is never the bottleneck).
+ */
+typedef struct TaskDeque {
+    CRITICAL_SECTION lock;
+    BoltConnection* jobs[BOLT_TASK_QUEUE_SIZE];
+    unsigned head;
+    unsigned count;
+} TaskDeque;
+
+typedef struct TaskThread {
+    BoltTaskPool* pool;
+    int index;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    bool started;
+} TaskThread;
+
+struct BoltTaskPool {
+    TaskDeque* deques;
+    TaskThread* threads;
+    int num_threads;
+    volatile LONG next_deque;           /* Round-robin submission */
+
+    /* Idle threads sleep until a job is queued anywhere */
+    CRITICAL_SECTION sleep_lock;
+    CONDITION_VARIABLE work_ready;
+    volatile LONG queued;
+    volatile LONG sleepers;
+    volatile bool stopping;
+
+    /* Statistics */
+    volatile LONG64 submitted;
+    volatile LONG64 stolen;
+    volatile LONG64 inlined;
+};
+
+/*
+ * Take the oldest job of the thread's own deque, else steal the newest
+ * of another's.
+ */
+static BoltConnection* take_job(BoltTaskPool* pool, int index) {
+    for (int i = 0; i < pool->num_threads; i++) {
+        TaskDeque* deque = &pool->deques[(index + i) % pool->num_threads];
+        if (deque->count == 0) continue;
+
+        BoltConnection* conn = NULL;
+        EnterCriticalSection(&deque->lock);
+        if (deque->count > 0) {
+            if (i == 0) {
+                conn = deque->jobs[deque->head];
+                deque->head = (deque->head + 1) % BOLT_TASK_QUEUE_SIZE;
+            } else {
+                conn = deque->jobs[(deque->head + deque->count - 1) % BOLT_TASK_QUEUE_SIZE];
+            }
+            deque->count--;
+            InterlockedDecrement(&pool->queued);
+        }
+        LeaveCriticalSection(&deque->lock);
+
+        if (conn) {
+            if (i > 0) InterlockedIncrement64(&pool->stolen);
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Run a job and post its completion to the connection's loop.
+ */
+static void run_job(BoltConnection* conn) {
+    conn->task.ok = conn->task.run(conn);
+
+    conn->send_overlapped.op_type = BOLT_OP_TASK;
+    conn->send_overlapped.connection = conn;
+    if (!bolt_iocp_post_completion(conn->iocp, &conn->send_overlapped)) {
+        BOLT_ERROR("Failed to post compute job completion");
+    }
+}
+
+static void task_thread_run(TaskThread* self) {
+    BoltTaskPool* pool = self->pool;
+
+    while (!pool->stopping) {
+        BoltConnection* conn = take_job(pool, self->index);
+        if (conn) {
+            run_job(conn);
+            continue;
+        }
+
+        /* Announce the sleep before checking for work: a submitter
+         * queues first and then looks for sleepers */
+        EnterCriticalSection(&pool->sleep_lock);
+        InterlockedIncrement(&pool->sleepers);
+        while (pool->queued == 0 && !pool->stopping) {
+            SleepConditionVariableCS(&pool->work_ready, &pool->sleep_lock, INFINITE);
+        }
+        InterlockedDecrement(&pool->sleepers);
+        LeaveCriticalSection(&pool->sleep_lock);
+    }
+
+    compression_release_thread_contexts();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI task_thread(LPVOID param) {
+    task_thread_run((TaskThread*)param);
+    return 0;
+}
+#else
+static void* task_thread(void* param) {
+    task_thread_run((TaskThread*)param);
+    return NULL;
+}
+#endif
+
+BoltTaskPool* bolt_task_pool_create(int threads) {
+    if (threads < 1) return NULL;
+    if (threads > BOLT_TASK_MAX_THREADS) threads = BOLT_TASK_MAX_THREADS;
+
+    BoltTaskPool* pool = (BoltTaskPool*)calloc(1, sizeof(BoltTaskPool));
+    if (!pool) return NULL;
+
+    pool->deques = (TaskDeque*)calloc((size_t)threads, sizeof(TaskDeque));
+    pool->threads = (TaskThread*)calloc((size_t)threads, sizeof(TaskThread));
+    if (!pool->deques || !pool->threads) {
+        free(pool->deques);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < threads; i++) {
+        InitializeCriticalSection(&pool->deques[i].lock);
+    }
+    InitializeCriticalSection(&pool->sleep_lock);
+    InitializeConditionVariable(&pool->work_ready);
+
+    /* Deques exist for every slot even if a thread fails to start: the
+     * running ones steal from the others */
+    pool->num_threads = threads;
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        TaskThread* thread = &pool->threads[i];
+        thread->pool = pool;
+        thread->index = i;
+#ifdef _WIN32
+        thread->thread = CreateThread(NULL, 0, task_thread, thread, 0, NULL);
+        thread->started = thread->thread != NULL;
+#else
+        thread->started = pthread_create(&thread->thread, NULL, task_thread, thread) == 0;
+#endif
+        if (thread->started) started++;
+    }
+    if (started == 0) {
+        bolt_task_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void bolt_task_pool_destroy(BoltTaskPool* pool) {
+    if (!pool) return;
+
+    EnterCriticalSection(&pool->sleep_lock);
+    pool->stopping = true;
+    WakeAllConditionVariable(&pool->work_ready);
+    LeaveCriticalSection(&pool->sleep_lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        if (!pool->threads[i].started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(pool->threads[i].thread, INFINITE);
+        CloseHandle(pool->threads[i].thread);
+#else
+        pthread_join(pool->threads[i].thread, NULL);
+#endif
+    }
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        DeleteCriticalSection(&pool->deques[i].lock);
+    }
+    DeleteCriticalSection(&pool->sleep_lock);
+    free(pool->deques);
+    free(pool->threads);
+    free(pool);
+}
+
+bool bolt_task_submit(BoltTaskPool* pool, BoltConnection* conn,
+                      bool (*run)(BoltConnection* conn),
+                      void (*complete)(BoltConnection* conn)) {
+    if (!pool || !conn || !run || pool->stopping) return false;
+
+    unsigned start = (unsigned)InterlockedIncrement(&pool->next_deque);
+    for (int i = 0; i < pool->num_threads; i++) {
+        TaskDeque* deque = &pool->deques[(start + (unsigned)i) % (unsigned)pool->num_threads];
+
+        EnterCriticalSection(&deque->lock);
+        if (deque->count == BOLT_TASK_QUEUE_SIZE) {
+            LeaveCriticalSection(&deque->lock);
+            continue;
+        }
+
+        /* The connection is handed over the moment it is queued */
+        conn->task.run = run;
+        conn->task.complete = complete;
+        conn->task.ok = false;
+        if (!complete) {
+            conn->requests_served--;    /* Counted again when it is answered */
+        }
+        bolt_conn_set_state(conn, BOLT_CONN_COMPUTING);
+        deque->jobs[(deque->head + deque->count) % BOLT_TASK_QUEUE_SIZE] = conn;
+        deque->count++;
+        InterlockedIncrement(&pool->queued);
+        LeaveCriticalSection(&deque->lock);
+
+        InterlockedIncrement64(&pool->submitted);
+        if (pool->sleepers > 0) {
+            EnterCriticalSection(&pool->sleep_lock);
+            WakeConditionVariable(&pool->work_ready);
+            LeaveCriticalSection(&pool->sleep_lock);
+        }
+        return true;
+    }
+
+    InterlockedIncrement64(&pool->inlined);
+    return false;
+}
+
+void bolt_task_pool_stats(BoltTaskPool* pool, int* threads, LONG64* submitted,
+                          LONG64* stolen, LONG64* inlined, LONG* queued) {
+    if (threads) *threads = pool ? pool->num_threads : 0;
+    if (submitted) *submitted = pool ? pool->submitted : 0;
+    if (stolen) *stolen = pool ? pool->stolen : 0;
+    if (inlined) *inlined = pool ? pool->inlined : 0;
+    if (queued) *queued = pool ? pool->queued : 0;
+}
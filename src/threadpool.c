@@ -3,6 +3,7 @@
 #include "../include/iocp.h"
 #include "../include/connection.h"
 #include "../include/file_server.h"
+#include "../include/file_sender.h"
 #include "../include/profiler.h"
 #include "../include/bolt_server.h"  /* For rate limiter functions */
 #include <stdio.h>
@@ -15,7 +16,6 @@ void bolt_rate_limiter_decrement(BoltRateLimiter* limiter, uint32_t ip);
 
 /* Forward declaration */
 static DWORD WINAPI worker_thread(LPVOID param);
-static bool post_send_from_offset(BoltConnection* conn);
 
 /* Worker context passed to thread */
 typedef struct {
@@ -23,49 +23,65 @@ typedef struct {
     BoltWorker* worker;
 } WorkerContext;
 
-/* Re-post an async send for remaining bytes (correct OVERLAPPED usage). */
-static bool post_send_from_offset(BoltConnection* conn) {
-    if (!conn) return false;
-    if (conn->send_offset >= conn->send_remaining) return true;
-
-    BoltOverlapped* ov = &conn->send_overlapped;
-    memset(&ov->overlapped, 0, sizeof(OVERLAPPED));
-    ov->op_type = BOLT_OP_SEND;
-    ov->connection = conn;
-    ov->wsa_buf.buf = conn->send_buffer + conn->send_offset;
-    ov->wsa_buf.len = (ULONG)(conn->send_remaining - conn->send_offset);
+#ifndef _WIN32
+/* pthread entry point adapter */
+static void* worker_thread_start(void* param) {
+    worker_thread(param);
+    return NULL;
+}
+#endif
 
-    DWORD bytes_sent = 0;
-    int rc = WSASend(conn->socket, &ov->wsa_buf, 1, &bytes_sent, 0, &ov->overlapped, NULL);
-    if (rc == SOCKET_ERROR) {
-        int err = WSAGetLastError();
-        if (err == WSA_IO_PENDING) {
-            return true;
-        }
-        return false;
+/*
+ * Bind the calling worker thread to one core.
+ */
+static void pin_worker_thread(BoltWorker* worker) {
+    if (worker->cpu < 0) return;
+#ifdef _WIN32
+    if (worker->cpu < 64 &&
+        !SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << worker->cpu)) {
+        BOLT_ERROR("Failed to pin worker %d to core %d: %lu",
+                   worker->worker_id, worker->cpu, (unsigned long)GetLastError());
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        BOLT_ERROR("Failed to pin worker %d to core %d: %d", worker->worker_id, worker->cpu, rc);
     }
-    return true;
+#endif
 }
 
 /*
  * Get number of CPU cores.
  */
 int bolt_get_cpu_count(void) {
+#ifdef _WIN32
     SYSTEM_INFO sysinfo;
     GetSystemInfo(&sysinfo);
     return (int)sysinfo.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
 }
 
 /*
  * Create thread pool.
  */
-BoltThreadPool* bolt_threadpool_create(HANDLE iocp, int num_workers) {
+BoltThreadPool* bolt_threadpool_create(BoltIOCP** loops, struct BoltConnectionPool** pools,
+                                       int num_loops, int num_workers, bool pin_cores) {
+    if (!loops || !pools || num_loops < 1) return NULL;
+    
     BoltThreadPool* pool = (BoltThreadPool*)calloc(1, sizeof(BoltThreadPool));
     if (!pool) {
         return NULL;
     }
     
-    pool->iocp = iocp;
+    int cpu_count = bolt_get_cpu_count();
+    
+    pool->iocp = loops[0];
     pool->num_workers = num_workers;
     pool->shutdown = false;
     pool->total_requests = 0;
@@ -80,10 +96,18 @@ BoltThreadPool* bolt_threadpool_create(HANDLE iocp, int num_workers) {
     /* Create worker threads */
     for (int i = 0; i < num_workers; i++) {
         pool->workers[i].worker_id = i;
+        pool->workers[i].cpu = pin_cores ? i % cpu_count : -1;
+        pool->workers[i].iocp = loops[i % num_loops];
+        pool->workers[i].conn_pool = pools[i % num_loops];
         pool->workers[i].running = true;
         pool->workers[i].requests_handled = 0;
         pool->workers[i].bytes_sent = 0;
         pool->workers[i].bytes_received = 0;
+        pool->workers[i].timers = bolt_timer_wheel_create(BOLT_TIMER_TICK_MS, GetTickCount64(),
+                                                          bolt_conn_timer_expired, NULL);
+        if (!pool->workers[i].timers) {
+            BOLT_ERROR("Failed to create timer wheel for worker %d", i);
+        }
         
         /* Create context (thread will free it) */
         WorkerContext* ctx = (WorkerContext*)malloc(sizeof(WorkerContext));
@@ -94,6 +118,7 @@ BoltThreadPool* bolt_threadpool_create(HANDLE iocp, int num_workers) {
         ctx->pool = pool;
         ctx->worker = &pool->workers[i];
         
+#ifdef _WIN32
         pool->workers[i].thread = CreateThread(
             NULL,
             0,
@@ -107,6 +132,16 @@ BoltThreadPool* bolt_threadpool_create(HANDLE iocp, int num_workers) {
             BOLT_ERROR("Failed to create worker thread %d: %lu", i, (unsigned long)GetLastError());
             free(ctx);
         }
+#else
+        pool->workers[i].thread_id = (DWORD)i;
+        int rc = pthread_create(&pool->workers[i].thread, NULL, worker_thread_start, ctx);
+        if (rc != 0) {
+            BOLT_ERROR("Failed to create worker thread %d: %d", i, rc);
+            free(ctx);
+        } else {
+            pool->workers[i].thread_started = true;
+        }
+#endif
     }
     
     return pool;
@@ -123,16 +158,27 @@ void bolt_threadpool_destroy(BoltThreadPool* pool) {
     
     /* Post completion packets to wake up workers */
     for (int i = 0; i < pool->num_workers; i++) {
-        PostQueuedCompletionStatus(pool->iocp, 0, 0, NULL);
+        bolt_iocp_post_wakeup(pool->workers[i].iocp);
     }
     
     /* Wait for workers to finish */
     for (int i = 0; i < pool->num_workers; i++) {
+#ifdef _WIN32
         if (pool->workers[i].thread) {
             pool->workers[i].running = false;
             WaitForSingleObject(pool->workers[i].thread, 5000);
             CloseHandle(pool->workers[i].thread);
         }
+#else
+        if (pool->workers[i].thread_started) {
+            pool->workers[i].running = false;
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+#endif
+    }
+    
+    for (int i = 0; i < pool->num_workers; i++) {
+        bolt_timer_wheel_destroy(pool->workers[i].timers);
     }
     
     free(pool->workers);
@@ -140,321 +186,343 @@ void bolt_threadpool_destroy(BoltThreadPool* pool) {
 }
 
 /*
- * Worker thread function.
+ * Count a dequeued batch in the worker's size histogram
+ * (bucket k holds batches of 2^k .. 2^(k+1)-1 completions).
  */
-static DWORD WINAPI worker_thread(LPVOID param) {
-    WorkerContext* ctx = (WorkerContext*)param;
-    BoltThreadPool* pool = ctx->pool;
-    BoltWorker* worker = ctx->worker;
-    free(ctx);  /* Free context immediately */
-    
-    BOLT_LOG("Worker %d started (thread %u)", worker->worker_id, worker->thread_id);
-    
-    while (worker->running && !pool->shutdown) {
-        DWORD bytes_transferred = 0;
-        ULONG_PTR completion_key = 0;
-        BoltOverlapped* overlapped = NULL;
-        
-        /* Wait for completion */
-        BOOL success = GetQueuedCompletionStatus(
-            pool->iocp,
-            &bytes_transferred,
-            &completion_key,
-            (OVERLAPPED**)&overlapped,
-            1000  /* 1 second timeout for shutdown check */
-        );
-        
-        if (!success) {
-            DWORD error = GetLastError();
-            if (error == WAIT_TIMEOUT) {
-                continue;  /* Check shutdown and retry */
-            }
-            if (overlapped) {
-                /* Handle error for specific operation */
-                BoltConnection* conn = overlapped->connection;
-                if (conn) {
-                    bolt_conn_close(conn);
-                }
-            }
-            continue;
-        }
-        
-        /* Check for shutdown signal */
-        if (!overlapped) {
-            if (pool->shutdown) {
-                break;
-            }
-            continue;
-        }
-        
-        /* Handle completion based on operation type */
-        switch (overlapped->op_type) {
-            case BOLT_OP_ACCEPT: {
-                BoltIOCP* iocp = g_bolt_server ? g_bolt_server->iocp : NULL;
-                if (!iocp) break;
+static void record_batch(BoltWorker* worker, int count) {
+    int bucket = 0;
+    while (count > 1 && bucket < BOLT_BATCH_HISTOGRAM_BUCKETS - 1) {
+        count >>= 1;
+        bucket++;
+    }
+    worker->batch_histogram[bucket]++;
+}
 
-                int accept_idx = overlapped->accept_index;
-                if (accept_idx >= 0 && accept_idx < iocp->num_accepts) {
-                    SOCKET client_socket = iocp->accept_sockets[accept_idx];
+/*
+ * Answer a complete request head and any requests pipelined behind it.
+ */
+static void dispatch_request(BoltThreadPool* pool, BoltWorker* worker, BoltConnection* conn) {
+    if (conn->request.valid) {
+        int handled = bolt_conn_handle_pipeline(conn);
+        InterlockedAdd64(&worker->requests_handled, handled);
+        InterlockedAdd64(&pool->total_requests, handled);
+    } else {
+        /* Invalid request or timeout - send error and close */
+        send_error_async(conn, HTTP_408_REQUEST_TIMEOUT);
+        bolt_conn_close(conn);
+        bolt_conn_release(conn->pool, conn);
+    }
+}
+
+/*
+ * Wait for the next keep-alive request, unless it is already buffered
+ * behind the one just answered.
+ */
+static void continue_keepalive(BoltThreadPool* pool, BoltWorker* worker, BoltConnection* conn) {
+    bolt_conn_reset(conn);
+    if (conn->recv_offset > 0 && bolt_conn_process_recv(conn, 0)) {
+        dispatch_request(pool, worker, conn);
+    } else {
+        bolt_iocp_post_recv(conn->iocp, conn);
+    }
+}
+
+/*
+ * Handle one dequeued completion.
+ */
+static void handle_completion(BoltThreadPool* pool, BoltWorker* worker,
+                              BoltOverlapped* overlapped, DWORD bytes_transferred) {
+    /* Dispatch on operation type */
+    switch (overlapped->op_type) {
+        case BOLT_OP_ACCEPT: {
+            BoltIOCP* iocp = worker->iocp;
+            if (!g_bolt_server) break;
+
+            int accept_idx = overlapped->accept_index;
+            if (accept_idx >= 0 && accept_idx < iocp->num_accepts) {
+                uint32_t client_ip = 0;
+                SOCKET client_socket = bolt_iocp_finish_accept(iocp, overlapped,
+                                                               bytes_transferred, &client_ip);
+                if (client_socket == INVALID_SOCKET) {
+                    /* Accept failed - recycle the slot */
+                    if (iocp->accept_sockets[accept_idx] != INVALID_SOCKET) {
+                        closesocket(iocp->accept_sockets[accept_idx]);
+                    }
+                    iocp->accept_sockets[accept_idx] = INVALID_SOCKET;
+                    bolt_iocp_post_accept(iocp, accept_idx);
+                    break;
+                }
+                
+                /* Rate limiting: check if IP can make another connection */
+                if (g_bolt_server->rate_limiter && client_ip != 0) {
+                    if (!bolt_rate_limiter_check(g_bolt_server->rate_limiter, client_ip)) {
+                        /* Rate limit exceeded - reject connection */
+                        closesocket(client_socket);
+                        iocp->accept_sockets[accept_idx] = INVALID_SOCKET;
+                        bolt_iocp_post_accept(iocp, accept_idx);
+                        break;
+                    }
+                }
+                
+                /* Get connection from pool */
+                BoltConnection* conn = bolt_conn_acquire(worker->conn_pool);
+                if (conn) {
+                    /* Store client IP in connection */
+                    conn->client_ip = client_ip;
                     
-                    /* Extract client IP from AcceptEx buffer */
-                    struct sockaddr_in* local_addr = NULL;
-                    struct sockaddr_in* remote_addr = NULL;
-                    int local_len = 0;
-                    int remote_len = 0;
-                    uint32_t client_ip = 0;
+                    bolt_conn_init(conn, client_socket, worker->worker_id);
+                    conn->iocp = iocp;
+                    conn->timers = worker->timers;
                     
-                    if (iocp->GetAcceptExSockaddrs) {
-                        iocp->GetAcceptExSockaddrs(
-                            overlapped->buffer,
-                            bytes_transferred,
-                            sizeof(struct sockaddr_in) + 16,
-                            sizeof(struct sockaddr_in) + 16,
-                            (struct sockaddr**)&local_addr, &local_len,
-                            (struct sockaddr**)&remote_addr, &remote_len
-                        );
-                        if (remote_addr) {
-                            client_ip = remote_addr->sin_addr.s_addr;
-                        }
-                    }
+                    /* First request head must arrive within the request timeout */
+                    bolt_conn_set_state(conn, BOLT_CONN_READING);
                     
-                    /* Rate limiting: check if IP can make another connection */
+                    /* Increment rate limiter counter */
                     if (g_bolt_server->rate_limiter && client_ip != 0) {
-                        if (!bolt_rate_limiter_check(g_bolt_server->rate_limiter, client_ip)) {
-                            /* Rate limit exceeded - reject connection */
-                            closesocket(client_socket);
-                            iocp->accept_sockets[accept_idx] = INVALID_SOCKET;
-                            bolt_iocp_post_accept(iocp, accept_idx);
-                            break;
-                        }
+                        bolt_rate_limiter_increment(g_bolt_server->rate_limiter, client_ip);
                     }
                     
-                    /* Inherit socket options from listen socket */
-                    setsockopt(client_socket, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
-                              (char*)&iocp->listen_socket, sizeof(iocp->listen_socket));
-                    
-                    /* Disable Nagle */
-                    int opt = 1;
-                    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&opt, sizeof(opt));
-                    
-                    /* Get connection from pool */
-                    BoltConnection* conn = bolt_conn_acquire(g_bolt_server->conn_pool);
-                    if (conn) {
-                        /* Store client IP in connection */
-                        conn->client_ip = client_ip;
-                        
-                        bolt_conn_init(conn, client_socket, worker->worker_id);
-                        
-                        /* Increment rate limiter counter */
-                        if (g_bolt_server->rate_limiter && client_ip != 0) {
-                            bolt_rate_limiter_increment(g_bolt_server->rate_limiter, client_ip);
-                        }
-                        
-                        /* Associate with IOCP */
-                        bolt_iocp_associate(iocp, client_socket, (void*)conn);
+                    /* Associate with IOCP */
+                    bolt_iocp_associate(iocp, client_socket, (void*)conn);
 
-                        /* If AcceptEx received initial data, prefill recv buffer */
-                        if (bytes_transferred > 0) {
-                            DWORD copy_len = bytes_transferred;
-                            if (copy_len > (DWORD)conn->recv_buffer_size) {
-                                copy_len = (DWORD)conn->recv_buffer_size;
-                            }
-                            memcpy(conn->recv_buffer, overlapped->buffer, copy_len);
-                            conn->recv_offset = copy_len;
-                            conn->recv_buffer[conn->recv_offset < conn->recv_buffer_size ? conn->recv_offset : (conn->recv_buffer_size - 1)] = '\0';
+                    /* If AcceptEx received initial data, prefill recv buffer */
+                    if (bytes_transferred > 0) {
+                        DWORD copy_len = bytes_transferred;
+                        if (copy_len > (DWORD)conn->recv_buffer_size - 1) {
+                            copy_len = (DWORD)conn->recv_buffer_size - 1;
+                        }
+                        memcpy(conn->recv_buffer, overlapped->buffer, copy_len);
+                        conn->recv_offset = copy_len;
+                        conn->recv_buffer[conn->recv_offset] = '\0';
 
-                            if (bolt_conn_process_recv(conn, 0)) {
-                                bolt_conn_handle_request(conn);
-                                InterlockedIncrement64(&worker->requests_handled);
-                                InterlockedIncrement64(&pool->total_requests);
-                            } else {
-                                bolt_iocp_post_recv(iocp, conn);
-                            }
+                        if (bolt_conn_process_recv(conn, 0)) {
+                            dispatch_request(pool, worker, conn);
                         } else {
-                            /* Post first recv */
                             bolt_iocp_post_recv(iocp, conn);
                         }
-
-                        BOLT_LOG("Worker %d accepted connection (slot %d)", worker->worker_id, accept_idx);
                     } else {
-                        closesocket(client_socket);
+                        /* Post first recv */
+                        bolt_iocp_post_recv(iocp, conn);
                     }
-                    
-                    /* Re-post accept */
-                    iocp->accept_sockets[accept_idx] = INVALID_SOCKET;
-                    bolt_iocp_post_accept(iocp, accept_idx);
+
+                    BOLT_LOG("Worker %d accepted connection (slot %d)", worker->worker_id, accept_idx);
+                } else {
+                    closesocket(client_socket);
                 }
-                break;
+                
+                /* Re-post accept */
+                iocp->accept_sockets[accept_idx] = INVALID_SOCKET;
+                bolt_iocp_post_accept(iocp, accept_idx);
             }
+            break;
+        }
+        
+        case BOLT_OP_RECV: {
+            BoltConnection* conn = overlapped->connection;
+            if (!conn) break;
             
-            case BOLT_OP_RECV: {
-                BoltConnection* conn = overlapped->connection;
-                if (!conn) break;
+            if (bytes_transferred == 0) {
+                /* Connection closed */
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            } else {
+                worker->bytes_received += bytes_transferred;
                 
-                if (bytes_transferred == 0) {
-                    /* Connection closed */
-                    bolt_conn_close(conn);
-                    bolt_conn_release(g_bolt_server->conn_pool, conn);
+                /* Process received data */
+                if (bolt_conn_process_recv(conn, bytes_transferred)) {
+                    /* Request complete or timed out - handle it (access
+                     * logging happens in send completion) */
+                    dispatch_request(pool, worker, conn);
                 } else {
-                    worker->bytes_received += bytes_transferred;
-                    
-                    /* Process received data */
-                    if (bolt_conn_process_recv(conn, bytes_transferred)) {
-                        /* Request complete or timed out - handle it */
-                        if (conn->request.valid) {
-                            bolt_conn_handle_request(conn);
-                            InterlockedIncrement64(&worker->requests_handled);
-                            InterlockedIncrement64(&pool->total_requests);
-                            
-                            /* Log access (will be logged after response is sent) */
-                            /* Note: Actual logging happens in send completion */
-                        } else {
-                            /* Invalid request or timeout - send error and close */
-                            send_error_async(conn, HTTP_408_REQUEST_TIMEOUT);
-                            bolt_conn_close(conn);
-                            bolt_conn_release(g_bolt_server->conn_pool, conn);
-                        }
+                    /* Need more data - check timeout before posting another recv */
+                    if (bolt_conn_deadline_passed(conn)) {
+                        /* Request timeout - close connection */
+                        send_error_async(conn, HTTP_408_REQUEST_TIMEOUT);
+                        bolt_conn_close(conn);
+                        bolt_conn_release(conn->pool, conn);
                     } else {
-                        /* Need more data - check timeout before posting another recv */
-                        if (bolt_conn_is_timed_out(conn, BOLT_REQUEST_TIMEOUT)) {
-                            /* Request timeout - close connection */
-                            send_error_async(conn, HTTP_408_REQUEST_TIMEOUT);
-                            bolt_conn_close(conn);
-                            bolt_conn_release(g_bolt_server->conn_pool, conn);
-                        } else {
-                            /* Post another recv */
-                            bolt_iocp_post_recv(g_bolt_server->iocp, conn);
-                        }
+                        /* Post another recv */
+                        bolt_iocp_post_recv(conn->iocp, conn);
                     }
                 }
-                break;
             }
+            break;
+        }
+        
+        case BOLT_OP_SEND: {
+            BoltConnection* conn = overlapped->connection;
+            if (!conn) break;
             
-            case BOLT_OP_SEND: {
-                BoltConnection* conn = overlapped->connection;
-                if (!conn) break;
-                
-                worker->bytes_sent += bytes_transferred;
-                conn->bytes_sent += bytes_transferred;
-                
-                /* Check if more to send */
-                conn->send_offset += bytes_transferred;
-                if (conn->send_offset < conn->send_remaining) {
-                    /* Continue sending (re-post with fresh OVERLAPPED) */
-                    if (!post_send_from_offset(conn)) {
-                        bolt_conn_close(conn);
-                        bolt_conn_release(g_bolt_server->conn_pool, conn);
-                    }
-                } else {
-                    /* End profiling */
-                    if (g_bolt_server && g_bolt_server->logger) {
-                        profiler_end_request(conn, g_bolt_server->logger);
-                    }
-                    
-                    /* Send complete */
-                    if (conn->keep_alive && conn->requests_served < BOLT_MAX_KEEPALIVE_REQUESTS) {
-                        /* Reset for next request */
-                        bolt_conn_reset(conn);
-                        bolt_iocp_post_recv(g_bolt_server->iocp, conn);
-                    } else {
-                        bolt_conn_close(conn);
-                        bolt_conn_release(g_bolt_server->conn_pool, conn);
-                    }
+            if (bytes_transferred == 0) {
+                /* Send failed; skip if the connection was already closed */
+                if (conn->socket != INVALID_SOCKET) {
+                    bolt_conn_close(conn);
+                    bolt_conn_release(conn->pool, conn);
                 }
                 break;
             }
             
-            case BOLT_OP_TRANSMIT_FILE: {
-                BoltConnection* conn = overlapped->connection;
-                if (!conn) break;
-                
-                worker->bytes_sent += bytes_transferred;
-                conn->bytes_sent += bytes_transferred;
+            worker->bytes_sent += bytes_transferred;
+            conn->bytes_sent += bytes_transferred;
+            
+            /* Check if more to send */
+            conn->send_offset += bytes_transferred;
+            if (conn->send_offset < conn->send_remaining) {
+                /* Progress: re-arm the send deadline for what is left */
+                bolt_conn_set_state(conn, BOLT_CONN_SENDING);
                 
-                /* Log access entry */
-                if (g_bolt_server->logger && conn->request.valid) {
-                    char ip_str[64];
-                    struct in_addr addr;
-                    addr.s_addr = conn->client_ip;
-                    inet_ntop(AF_INET, &addr, ip_str, sizeof(ip_str));
-                    
-                    const char* method_str = "UNKNOWN";
-                    switch (conn->request.method) {
-                        case HTTP_GET: method_str = "GET"; break;
-                        case HTTP_HEAD: method_str = "HEAD"; break;
-                        case HTTP_POST: method_str = "POST"; break;
-                        case HTTP_OPTIONS: method_str = "OPTIONS"; break;
-                        default: break;
-                    }
-                    
-                    /* Extract Referer and User-Agent from request */
-                    char referer[256] = "";
-                    char user_agent[512] = "";
-                    const char* req_buf = conn->recv_buffer;
-                    
-                    char* ref_start = strstr(req_buf, "Referer:");
-                    if (ref_start) {
-                        const char* ref_val = ref_start + 8;
-                        while (*ref_val == ' ' || *ref_val == '\t') ref_val++;
-                        const char* ref_end = ref_val;
-                        while (*ref_end && *ref_end != '\r' && *ref_end != '\n') ref_end++;
-                        size_t ref_len = ref_end - ref_val;
-                        if (ref_len >= sizeof(referer)) ref_len = sizeof(referer) - 1;
-                        strncpy(referer, ref_val, ref_len);
-                        referer[ref_len] = '\0';
-                    }
-                    
-                    char* ua_start = strstr(req_buf, "User-Agent:");
-                    if (ua_start) {
-                        const char* ua_val = ua_start + 11;
-                        while (*ua_val == ' ' || *ua_val == '\t') ua_val++;
-                        const char* ua_end = ua_val;
-                        while (*ua_end && *ua_end != '\r' && *ua_end != '\n') ua_end++;
-                        size_t ua_len = ua_end - ua_val;
-                        if (ua_len >= sizeof(user_agent)) ua_len = sizeof(user_agent) - 1;
-                        strncpy(user_agent, ua_val, ua_len);
-                        user_agent[ua_len] = '\0';
-                    }
-                    
-                    int status = 200;  /* TODO: Track actual status code */
-                    logger_access(g_bolt_server->logger, ip_str, method_str,
-                                 conn->request.uri, status, bytes_transferred,
-                                 referer[0] ? referer : NULL,
-                                 user_agent[0] ? user_agent : NULL);
+                /* Continue sending (re-post with fresh OVERLAPPED) */
+                if (!bolt_iocp_repost_send(conn->iocp, conn)) {
+                    bolt_conn_close(conn);
+                    bolt_conn_release(conn->pool, conn);
                 }
-                
-                /* Close file handle */
-                if (conn->file_handle != INVALID_HANDLE_VALUE) {
-                    CloseHandle(conn->file_handle);
-                    conn->file_handle = INVALID_HANDLE_VALUE;
+            } else if (conn->stream && !conn->stream->finished) {
+                /* Compressed stream: encode the next chunks now the last are out */
+                if (!bolt_send_stream_next(conn)) {
+                    bolt_conn_close(conn);
+                    bolt_conn_release(conn->pool, conn);
                 }
-                
+            } else {
                 /* End profiling */
                 if (g_bolt_server && g_bolt_server->logger) {
                     profiler_end_request(conn, g_bolt_server->logger);
                 }
                 
-                /* Handle keep-alive or close */
+                /* Send complete */
                 if (conn->keep_alive && conn->requests_served < BOLT_MAX_KEEPALIVE_REQUESTS) {
-                    bolt_conn_reset(conn);
-                    bolt_iocp_post_recv(g_bolt_server->iocp, conn);
+                    /* Reset for next request */
+                    continue_keepalive(pool, worker, conn);
                 } else {
                     bolt_conn_close(conn);
-                    bolt_conn_release(g_bolt_server->conn_pool, conn);
+                    bolt_conn_release(conn->pool, conn);
                 }
-                break;
             }
+            break;
+        }
+        
+        case BOLT_OP_TRANSMIT_FILE: {
+            BoltConnection* conn = overlapped->connection;
+            if (!conn) break;
             
-            case BOLT_OP_DISCONNECT: {
-                BoltConnection* conn = overlapped->connection;
-                if (conn) {
-                    bolt_conn_release(g_bolt_server->conn_pool, conn);
+            if (bytes_transferred == 0) {
+                /* Transmit failed; skip if the connection was already closed */
+                if (conn->socket != INVALID_SOCKET) {
+                    bolt_conn_close(conn);
+                    bolt_conn_release(conn->pool, conn);
                 }
                 break;
             }
+            
+            worker->bytes_sent += bytes_transferred;
+            conn->bytes_sent += bytes_transferred;
+            
+            /* Log access entry */
+            if (g_bolt_server->logger && conn->request.valid) {
+                char ip_str[64];
+                struct in_addr addr;
+                addr.s_addr = conn->client_ip;
+                inet_ntop(AF_INET, &addr, ip_str, sizeof(ip_str));
+                
+                const char* method_str = "UNKNOWN";
+                switch (conn->request.method) {
+                    case HTTP_GET: method_str = "GET"; break;
+                    case HTTP_HEAD: method_str = "HEAD"; break;
+                    case HTTP_POST: method_str = "POST"; break;
+                    case HTTP_OPTIONS: method_str = "OPTIONS"; break;
+                    default: break;
+                }
+                
+                int status = 200;  /* TODO: Track actual status code */
+                logger_access(g_bolt_server->logger, ip_str, method_str,
+                             conn->request.uri, status, bytes_transferred,
+                             http_header(&conn->request, HTTP_HEADER_REFERER),
+                             http_header(&conn->request, HTTP_HEADER_USER_AGENT));
+            }
+            
+            /* Release file handle */
+            bolt_conn_close_file(conn);
+            
+            /* End profiling */
+            if (g_bolt_server && g_bolt_server->logger) {
+                profiler_end_request(conn, g_bolt_server->logger);
+            }
+            
+            /* Handle keep-alive or close */
+            if (conn->keep_alive && conn->requests_served < BOLT_MAX_KEEPALIVE_REQUESTS) {
+                continue_keepalive(pool, worker, conn);
+            } else {
+                bolt_conn_close(conn);
+                bolt_conn_release(conn->pool, conn);
+            }
+            break;
+        }
+        
+        case BOLT_OP_DISCONNECT: {
+            BoltConnection* conn = overlapped->connection;
+            if (conn) {
+                bolt_conn_release(conn->pool, conn);
+            }
+            break;
+        }
+        
+        case BOLT_OP_TASK: {
+            BoltConnection* conn = overlapped->connection;
+            if (!conn || conn->state != BOLT_CONN_COMPUTING) break;
+            
+            if (conn->task.complete) {
+                /* The job's own completion sends the result */
+                conn->task.complete(conn);
+            } else {
+                /* Answer the request again with the result ready; it was
+                 * counted when it was handed over */
+                conn->task.ready = true;
+                int handled = bolt_conn_handle_pipeline(conn);
+                InterlockedAdd64(&worker->requests_handled, handled - 1);
+                InterlockedAdd64(&pool->total_requests, handled - 1);
+            }
+            break;
         }
     }
+}
+
+/*
+ * Worker thread function.
+ */
+static DWORD WINAPI worker_thread(LPVOID param) {
+    WorkerContext* ctx = (WorkerContext*)param;
+    BoltThreadPool* pool = ctx->pool;
+    BoltWorker* worker = ctx->worker;
+    free(ctx);  /* Free context immediately */
+    
+    BOLT_LOG("Worker %d started (thread %u)", worker->worker_id, worker->thread_id);
+    pin_worker_thread(worker);
     
+    BoltCompletion batch[BOLT_COMPLETION_BATCH_SIZE];
+    
+    while (worker->running && !pool->shutdown) {
+        /* Wait for a batch, waking at least once per timer tick */
+        int count = bolt_iocp_get_completions(worker->iocp, batch,
+                                              BOLT_COMPLETION_BATCH_SIZE, BOLT_TIMER_TICK_MS);
+        if (count > 0) {
+            worker->completions += count;
+            record_batch(worker, count);
+            
+            for (int i = 0; i < count; i++) {
+                /* NULL overlapped is a wakeup (shutdown signal) */
+                if (batch[i].overlapped &&
+                    bolt_iocp_completion_current(worker->iocp, &batch[i])) {
+                    handle_completion(pool, worker, batch[i].overlapped,
+                                      batch[i].bytes_transferred);
+                }
+            }
+        }
+        
+        /* Abort connections past their deadline; their failed operations
+         * come back as completions and close them */
+        bolt_timer_wheel_advance(worker->timers, GetTickCount64());
+    }
+    
+    compression_release_thread_contexts();
     BOLT_LOG("Worker %d stopped", worker->worker_id);
     return 0;
 }
@@ -480,3 +548,67 @@ void bolt_threadpool_stats(BoltThreadPool* pool,
     if (bytes_received) *bytes_received = recv;
 }
 
+/*
+ * Sum the per-worker batch size histograms.
+ */
+void bolt_threadpool_batch_stats(BoltThreadPool* pool, LONG64* histogram,
+                                 LONG64* completions) {
+    if (!pool || !histogram) return;
+    
+    LONG64 total = 0;
+    for (int i = 0; i < pool->num_workers; i++) {
+        total += pool->workers[i].completions;
+    }
+    if (completions) *completions = total;
+    
+    for (int b = 0; b < BOLT_BATCH_HISTOGRAM_BUCKETS; b++) {
+        histogram[b] = 0;
+        for (int i = 0; i < pool->num_workers; i++) {
+            histogram[b] += pool->workers[i].batch_histogram[b];
+        }
+    }
+}
+
+/*
+ * Count connections closed for missing a deadline.
+ */
+LONG64 bolt_threadpool_timeouts(BoltThreadPool* pool) {
+    if (!pool) return 0;
+    
+    LONG64 total = 0;
+    for (int i = 0; i < pool->num_workers; i++) {
+        if (pool->workers[i].timers) {
+            total += pool->workers[i].timers->expired;
+        }
+    }
+    return total;
+}
+
+/*
+ * Sum the workers' CPU time, read from their thread clocks.
+ */
+LONG64 bolt_threadpool_cpu_us(BoltThreadPool* pool) {
+    if (!pool) return 0;
+    
+    LONG64 total = 0;
+    for (int i = 0; i < pool->num_workers; i++) {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (pool->workers[i].thread &&
+            GetThreadTimes(pool->workers[i].thread, &created, &exited, &kernel, &user)) {
+            ULARGE_INTEGER k = { .LowPart = kernel.dwLowDateTime, .HighPart = kernel.dwHighDateTime };
+            ULARGE_INTEGER u = { .LowPart = user.dwLowDateTime, .HighPart = user.dwHighDateTime };
+            total += (LONG64)((k.QuadPart + u.QuadPart) / 10);  /* 100 ns units */
+        }
+#else
+        clockid_t clock;
+        struct timespec ts;
+        if (pool->workers[i].thread_started &&
+            pthread_getcpuclockid(pool->workers[i].thread, &clock) == 0 &&
+            clock_gettime(clock, &ts) == 0) {
+            total += (LONG64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+#endif
+    }
+    return total;
+}
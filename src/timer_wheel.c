@@ -0,0 +1,198 @@
+#include "../include/timer_wheel.h"
+#include <stdlib.h>
+
+/* Ticks covered by one slot of the given level */
+#define LEVEL_SHIFT(level)  (BOLT_TIMER_WHEEL_BITS * (level))
+#define WHEEL_SPAN          (1ull << LEVEL_SHIFT(BOLT_TIMER_WHEEL_LEVELS))
+
+/*
+ * Unlink a timer from its slot list.
+ */
+static void timer_unlink(BoltTimer* timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+/*
+ * Link a timer into the slot matching its expiry.
+ */
+static void wheel_insert(BoltTimerWheel* wheel, BoltTimer* timer) {
+    ULONGLONG delta = timer->expires > wheel->current_tick ?
+                      timer->expires - wheel->current_tick : 0;
+
+    int level = 0;
+    while (level < BOLT_TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ull << LEVEL_SHIFT(level + 1))) {
+        level++;
+    }
+
+    /* Place overdue timers in the slot being processed; park timers past
+     * the wheel's span in the farthest slot, they cascade back down. */
+    ULONGLONG position = timer->expires;
+    if (delta == 0) {
+        position = wheel->current_tick;
+    } else if (delta >= WHEEL_SPAN) {
+        position = wheel->current_tick + WHEEL_SPAN - 1;
+    }
+
+    BoltTimer* head = &wheel->slots[level][(position >> LEVEL_SHIFT(level)) & BOLT_TIMER_WHEEL_MASK];
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+    timer->wheel = wheel;
+}
+
+/*
+ * Move every timer of a higher-level slot down to the levels below.
+ */
+static void wheel_cascade(BoltTimerWheel* wheel, int level, int slot) {
+    BoltTimer* head = &wheel->slots[level][slot];
+    BoltTimer* timer = head->next;
+
+    head->next = head;
+    head->prev = head;
+
+    while (timer != head) {
+        BoltTimer* next = timer->next;
+        wheel_insert(wheel, timer);
+        timer = next;
+    }
+}
+
+/*
+ * Create timing wheel.
+ */
+BoltTimerWheel* bolt_timer_wheel_create(DWORD tick_ms, ULONGLONG now_ms,
+                                        BoltTimerCallback callback, void* context) {
+    if (tick_ms == 0 || !callback) return NULL;
+
+    BoltTimerWheel* wheel = (BoltTimerWheel*)calloc(1, sizeof(BoltTimerWheel));
+    if (!wheel) return NULL;
+
+    for (int level = 0; level < BOLT_TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < BOLT_TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot].next = &wheel->slots[level][slot];
+            wheel->slots[level][slot].prev = &wheel->slots[level][slot];
+        }
+    }
+
+    wheel->tick_ms = tick_ms;
+    wheel->current_tick = now_ms / tick_ms;
+    wheel->callback = callback;
+    wheel->context = context;
+    InitializeCriticalSection(&wheel->lock);
+
+    return wheel;
+}
+
+/*
+ * Destroy timing wheel.
+ */
+void bolt_timer_wheel_destroy(BoltTimerWheel* wheel) {
+    if (!wheel) return;
+
+    /* Detach remaining timers so their owners see them as idle */
+    for (int level = 0; level < BOLT_TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < BOLT_TIMER_WHEEL_SLOTS; slot++) {
+            BoltTimer* head = &wheel->slots[level][slot];
+            while (head->next != head) {
+                BoltTimer* timer = head->next;
+                timer_unlink(timer);
+                timer->wheel = NULL;
+            }
+        }
+    }
+
+    DeleteCriticalSection(&wheel->lock);
+    free(wheel);
+}
+
+/*
+ * Arm or re-arm a timer.
+ */
+void bolt_timer_arm(BoltTimerWheel* wheel, BoltTimer* timer,
+                    ULONGLONG now_ms, DWORD timeout_ms) {
+    if (!wheel || !timer) return;
+
+    EnterCriticalSection(&wheel->lock);
+
+    if (timer->wheel) {
+        timer_unlink(timer);
+    } else {
+        wheel->armed++;
+    }
+
+    /* Round up so a timer never fires early */
+    timer->expires = (now_ms + timeout_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (timer->expires <= wheel->current_tick) {
+        timer->expires = wheel->current_tick + 1;
+    }
+    wheel_insert(wheel, timer);
+
+    LeaveCriticalSection(&wheel->lock);
+}
+
+/*
+ * Cancel a timer.
+ */
+void bolt_timer_cancel(BoltTimerWheel* wheel, BoltTimer* timer) {
+    if (!wheel || !timer) return;
+
+    EnterCriticalSection(&wheel->lock);
+
+    if (timer->wheel) {
+        timer_unlink(timer);
+        timer->wheel = NULL;
+        wheel->armed--;
+    }
+
+    LeaveCriticalSection(&wheel->lock);
+}
+
+/*
+ * Advance the wheel and fire expired timers.
+ */
+int bolt_timer_wheel_advance(BoltTimerWheel* wheel, ULONGLONG now_ms) {
+    if (!wheel) return 0;
+
+    ULONGLONG target = now_ms / wheel->tick_ms;
+    int fired = 0;
+
+    EnterCriticalSection(&wheel->lock);
+
+    while (wheel->current_tick < target) {
+        /* Nothing armed: skip straight to now */
+        if (wheel->armed == 0) {
+            wheel->current_tick = target;
+            break;
+        }
+
+        ULONGLONG tick = ++wheel->current_tick;
+
+        /* Each level cascades when the level below it wraps */
+        for (int level = 1; level < BOLT_TIMER_WHEEL_LEVELS; level++) {
+            if ((tick >> LEVEL_SHIFT(level - 1)) & BOLT_TIMER_WHEEL_MASK) {
+                break;
+            }
+            wheel_cascade(wheel, level, (int)((tick >> LEVEL_SHIFT(level)) & BOLT_TIMER_WHEEL_MASK));
+        }
+
+        BoltTimer* head = &wheel->slots[0][tick & BOLT_TIMER_WHEEL_MASK];
+        while (head->next != head) {
+            BoltTimer* timer = head->next;
+            timer_unlink(timer);
+            timer->wheel = NULL;
+            wheel->armed--;
+            wheel->expired++;
+            fired++;
+            wheel->callback(timer, wheel->context);
+        }
+    }
+
+    LeaveCriticalSection(&wheel->lock);
+
+    return fired;
+}
@@ -90,21 +90,29 @@ static bool normalize_path_components(char* path, size_t path_size) {
             }
         } else {
             if (write_idx < 64) {
-                strncpy(components[write_idx], components[i], BOLT_MAX_PATH_LENGTH - 1);
-                components[write_idx][BOLT_MAX_PATH_LENGTH - 1] = '\0';
+                /* Components are terminated and write_idx <= i: may overlap */
+                if (write_idx != i) {
+                    memmove(components[write_idx], components[i], strlen(components[i]) + 1);
+                }
                 write_idx++;
             }
         }
     }
     
     /* Rebuild path */
-    path[0] = '\0';
+    size_t len = 0;
     for (int i = 0; i < write_idx; i++) {
+        size_t comp_len = strlen(components[i]);
+        if (len + (i > 0 ? 1 : 0) + comp_len >= path_size) {
+            return false;  /* Cannot happen: never longer than the input */
+        }
         if (i > 0) {
-            strncat(path, "\\", path_size - strlen(path) - 1);
+            path[len++] = BOLT_PATH_SEP;
         }
-        strncat(path, components[i], path_size - strlen(path) - 1);
+        memcpy(path + len, components[i], comp_len);
+        len += comp_len;
     }
+    path[len] = '\0';
     
     return true;
 }
@@ -246,7 +254,7 @@ bool utils_sanitize_path_with_root(const char* uri, const char* web_root, char*
     /* Add separator if needed */
     if (current_len > 0 && out_path[current_len - 1] != '/' && 
         out_path[current_len - 1] != '\\') {
-        out_path[current_len++] = '\\';
+        out_path[current_len++] = BOLT_PATH_SEP;
         out_path[current_len] = '\0';
     }
     
@@ -254,9 +262,9 @@ bool utils_sanitize_path_with_root(const char* uri, const char* web_root, char*
     strncpy(out_path + current_len, uri_start, out_size - current_len - 1);
     out_path[out_size - 1] = '\0';
     
-    /* Convert forward slashes to backslashes for Windows */
+    /* Convert separators to the native one (backslash on Windows) */
     for (char* c = out_path; *c; c++) {
-        if (*c == '/') *c = '\\';
+        if (*c == '/' || *c == '\\') *c = BOLT_PATH_SEP;
     }
     
     /* Normalize path components (resolve . and ..) - only normalize the URI part */
@@ -281,19 +289,19 @@ bool utils_sanitize_path_with_root(const char* uri, const char* web_root, char*
     }
     
     /* Ensure root is still there */
-    strncpy(out_path, BOLT_WEB_ROOT, out_size - 1);
+    strncpy(out_path, root, out_size - 1);
     out_path[root_len] = '\0';
     
     /* Append normalized URI part */
     if (normalized_len > 0) {
-        if (root_len > 0 && out_path[root_len - 1] != '\\') {
-            strncat(out_path, "\\", out_size - strlen(out_path) - 1);
+        if (root_len > 0 && out_path[root_len - 1] != BOLT_PATH_SEP) {
+            strncat(out_path, BOLT_PATH_SEP_STR, out_size - strlen(out_path) - 1);
         }
         strncat(out_path, uri_part, out_size - strlen(out_path) - 1);
     }
     
     /* Final check: ensure path still starts with web root */
-    if (strncmp(out_path, BOLT_WEB_ROOT, root_len) != 0) {
+    if (strncmp(out_path, root, root_len) != 0) {
         return false;  /* Path escaped root during normalization */
     }
     
@@ -379,9 +387,15 @@ void utils_format_http_date(time_t timestamp, char* buffer, size_t buffer_size)
         return;
     }
     
-    struct tm* gmt = gmtime(&timestamp);
-    if (gmt) {
-        strftime(buffer, buffer_size, "%a, %d %b %Y %H:%M:%S GMT", gmt);
+    /* Reentrant: workers format dates concurrently */
+    struct tm gmt;
+#ifdef _WIN32
+    bool ok = gmtime_s(&gmt, &timestamp) == 0;
+#else
+    bool ok = gmtime_r(&timestamp, &gmt) != NULL;
+#endif
+    if (ok) {
+        strftime(buffer, buffer_size, "%a, %d %b %Y %H:%M:%S GMT", &gmt);
     } else {
         buffer[0] = '\0';
     }
@@ -54,7 +54,7 @@ extern const char* mu_last_error;
     if (strcmp((expected), (actual)) != 0) { \
         static char mu_msg_buffer[256]; \
         snprintf(mu_msg_buffer, sizeof(mu_msg_buffer), \
-            "Expected \"%s\" but got \"%s\"", (expected), (actual)); \
+            "Expected \"%.100s\" but got \"%.100s\"", (expected), (actual)); \
         mu_last_error = mu_msg_buffer; \
         return mu_msg_buffer; \
     } \
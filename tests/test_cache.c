@@ -6,6 +6,7 @@
 
 #include "minunit.h"
 #include "../include/file_cache.h"
+#include "../include/compression.h"
 #include "../include/bolt.h"
 #include <string.h>
 #include <stdio.h>
@@ -27,6 +28,15 @@ static void delete_temp_file(const char* filename) {
     remove(filename);
 }
 
+static bool headers_contain(const BoltCachedResponse* response, const char* text) {
+    char headers[2048];
+    size_t len = response->headers_len < sizeof(headers) - 1 ? response->headers_len
+                                                              : sizeof(headers) - 1;
+    memcpy(headers, response->headers, len);
+    headers[len] = '\0';
+    return strstr(headers, text) != NULL;
+}
+
 /*============================================================================
  * Cache Creation/Destruction Tests
  *============================================================================*/
@@ -72,6 +82,7 @@ MU_TEST(test_cache_get_existing) {
     mu_assert_true(found);
     mu_assert_size_eq(strlen(content), out.body_len);
     mu_check(memcmp(out.body, content, out.body_len) == 0);
+    bolt_file_cache_release(cache, out.ref);
     
     delete_temp_file(filename);
     bolt_file_cache_destroy(cache);
@@ -94,10 +105,12 @@ MU_TEST(test_cache_get_miss) {
     bool found = bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out);
     mu_assert_true(found);
     mu_check(memcmp(out.body, content, out.body_len) == 0);
+    bolt_file_cache_release(cache, out.ref);
     
     /* Second call should hit cache (internal check, hard to verify from outside without mocking) */
     found = bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out);
     mu_assert_true(found);
+    bolt_file_cache_release(cache, out.ref);
     
     delete_temp_file(filename);
     bolt_file_cache_destroy(cache);
@@ -151,6 +164,7 @@ MU_TEST(test_cache_stale_update) {
     BoltCachedResponse out;
     bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out);
     mu_check(memcmp(out.body, "Version 1", 9) == 0);
+    bolt_file_cache_release(cache, out.ref);
     
     /* Update file */
     /* Wait a bit to ensure mtime changes if resolution is low, or just rely on size change if possible, 
@@ -166,12 +180,633 @@ MU_TEST(test_cache_stale_update) {
     
     mu_assert_true(found);
     mu_check(memcmp(out.body, "Version 2 - Updated", 19) == 0);
+    bolt_file_cache_release(cache, out.ref);
+    
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_invalidate) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    
+    const char* filename = "test_cache_invalidate.txt";
+    create_temp_file(filename, "Hello");
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    BoltCachedResponse held;
+    mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &held));
+    
+    /* The entry goes; a send still holding it is unaffected */
+    bolt_file_cache_invalidate(cache, filename);
+    bolt_file_cache_invalidate(cache, "not_cached.txt");
+    bolt_file_cache_invalidate(NULL, filename);
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    mu_assert_size_eq(0, stats.entries);
+    mu_check(stats.invalidations == 1);
+    mu_check(memcmp(held.body, "Hello", 5) == 0);
+    bolt_file_cache_release(cache, held.ref);
+    
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_encoded_variants) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    
+    const char* filename = "test_cache_variants.txt";
+    char content[2048];
+    for (size_t i = 0; i < sizeof(content) - 1; i++) {
+        content[i] = "compressible text "[i % 18];
+    }
+    content[sizeof(content) - 1] = '\0';
+    create_temp_file(filename, content);
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    BoltCachedResponse identity;
+    BoltCachedResponse gzip;
+    mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size,
+                                       &identity));
+    mu_assert_true(bolt_file_cache_get_encoded(cache, filename, "text/plain", BOLT_COMPRESS_GZIP,
+                                               st.st_mtime, st.st_size, &gzip));
+    mu_assert_false(headers_contain(&identity, "Content-Encoding"));
+    mu_assert_true(headers_contain(&identity, "Vary: Accept-Encoding\r\n"));
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    mu_assert_size_eq(2, stats.entries);
+    if (stats.compressions == 1) {
+        /* Built with zlib: a smaller body with its own headers */
+        mu_check(gzip.body_len < identity.body_len);
+        mu_assert_true(headers_contain(&gzip, "Content-Encoding: gzip\r\n"));
+        mu_assert_true(headers_contain(&gzip, "-gzip\""));
+    } else {
+        mu_assert_size_eq(identity.body_len, gzip.body_len);
+    }
+    bolt_file_cache_release(cache, gzip.ref);
+    
+    /* Hits come from the variant already stored */
+    mu_assert_true(bolt_file_cache_get_encoded(cache, filename, "text/plain", BOLT_COMPRESS_GZIP,
+                                               st.st_mtime, st.st_size, &gzip));
+    bolt_file_cache_release(cache, gzip.ref);
+    bolt_file_cache_release(cache, identity.ref);
+    bolt_file_cache_stats(cache, &stats);
+    mu_check(stats.fills == 2);
+    
+    /* A change drops every variant */
+    bolt_file_cache_invalidate(cache, filename);
+    bolt_file_cache_stats(cache, &stats);
+    mu_assert_size_eq(0, stats.entries);
+    mu_check(stats.invalidations == 2);
+    
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_referenced_entry_survives_refresh) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    
+    const char* filename = "test_cache_ref.txt";
+    create_temp_file(filename, "Version 1");
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    BoltCachedResponse held;
+    mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &held));
+    mu_assert_not_null(held.ref);
+    
+    /* Refresh unlinks the old response; a send still holding it reads it intact */
+    create_temp_file(filename, "Version 2 - Updated");
+    stat(filename, &st);
+    
+    BoltCachedResponse out;
+    mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out));
+    mu_check(memcmp(out.body, "Version 2 - Updated", 19) == 0);
+    mu_check(out.ref != held.ref);
+    mu_check(memcmp(held.body, "Version 1", 9) == 0);
+    
+    char headers[1024];
+    mu_assert_true(held.headers_len < sizeof(headers));
+    memcpy(headers, held.headers, held.headers_len);
+    headers[held.headers_len] = '\0';
+    mu_check(strstr(headers, "Content-Length: 9\r\n") != NULL);
+    
+    /* Last reference frees it */
+    bolt_file_cache_release(cache, held.ref);
+    bolt_file_cache_release(cache, out.ref);
+    
+    /* NULL is ignored */
+    bolt_file_cache_release(cache, NULL);
     
     delete_temp_file(filename);
     bolt_file_cache_destroy(cache);
     return NULL;
 }
 
+MU_TEST(test_cache_reference_outlives_cache) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    
+    const char* filename = "test_cache_outlive.txt";
+    create_temp_file(filename, "Still here");
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    BoltCachedResponse held;
+    mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &held));
+    
+    /* Destroying the cache drops its references, not the reader's */
+    bolt_file_cache_destroy(cache);
+    mu_check(memcmp(held.body, "Still here", 10) == 0);
+    bolt_file_cache_release(NULL, held.ref);
+    
+    delete_temp_file(filename);
+    return NULL;
+}
+
+/*============================================================================
+ * Eviction Tests
+ *============================================================================*/
+
+MU_TEST(test_cache_full_keeps_hot_files) {
+    /* Room for 8 entries: 2 hot assets, then a crawler touching 40 pages */
+    BoltFileCache* cache = bolt_file_cache_create(8, 1024 * 1024);
+    mu_assert_not_null(cache);
+    
+    char filename[64];
+    struct stat st;
+    BoltCachedResponse out;
+    
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 2; i++) {
+            snprintf(filename, sizeof(filename), "test_cache_hot_%d.txt", i);
+            if (round == 0) create_temp_file(filename, "hot asset");
+            stat(filename, &st);
+            mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out));
+            bolt_file_cache_release(cache, out.ref);
+        }
+    }
+    
+    for (int i = 0; i < 40; i++) {
+        snprintf(filename, sizeof(filename), "test_cache_crawl_%d.txt", i);
+        create_temp_file(filename, "crawled page");
+        stat(filename, &st);
+        
+        /* A full cache still admits new files */
+        mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out));
+        bolt_file_cache_release(cache, out.ref);
+        delete_temp_file(filename);
+    }
+    
+    BoltFileCacheStats before;
+    bolt_file_cache_stats(cache, &before);
+    mu_assert_size_eq(8, before.entries);
+    mu_check(before.evictions >= 34);
+    
+    /* The hot assets were never evicted */
+    for (int i = 0; i < 2; i++) {
+        snprintf(filename, sizeof(filename), "test_cache_hot_%d.txt", i);
+        stat(filename, &st);
+        mu_assert_true(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out));
+        bolt_file_cache_release(cache, out.ref);
+        delete_temp_file(filename);
+    }
+    
+    BoltFileCacheStats after;
+    bolt_file_cache_stats(cache, &after);
+    mu_check(after.hits == before.hits + 2);
+    mu_check(after.misses == before.misses);
+    
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+/*============================================================================
+ * Concurrency Tests
+ *============================================================================*/
+
+#define CONTENTION_HOT_FILES    64
+#define CONTENTION_COLD_FILES   16
+#define CONTENTION_LOOKUPS      40000
+#define CONTENTION_MAX_THREADS  8
+
+typedef struct {
+    BoltFileCache* cache;
+    int hit_percent;
+    uint32_t seed;
+    volatile LONG* errors;
+    volatile LONG* fallbacks;
+} ContentionWorker;
+
+static char g_hot_names[CONTENTION_HOT_FILES][64];
+static struct stat g_hot_stat[CONTENTION_HOT_FILES];
+static char g_cold_names[CONTENTION_COLD_FILES][64];
+static struct stat g_cold_stat[CONTENTION_COLD_FILES];
+
+/*
+ * Hot files are looked up as they are (hits once loaded); cold files with
+ * a new mtime each time, so every cold lookup refreshes an entry and
+ * retires the old response while other threads read.
+ */
+#ifdef _WIN32
+static DWORD WINAPI contention_worker(LPVOID arg) {
+#else
+static void* contention_worker(void* arg) {
+#endif
+    ContentionWorker* w = (ContentionWorker*)arg;
+    uint32_t rng = w->seed;
+    char expected[64];
+    
+    for (int i = 0; i < CONTENTION_LOOKUPS; i++) {
+        rng = rng * 1103515245u + 12345u;
+        bool hot = (int)((rng >> 16) % 100) < w->hit_percent;
+        int f = (int)((rng >> 8) % (hot ? CONTENTION_HOT_FILES : CONTENTION_COLD_FILES));
+        
+        const char* name = hot ? g_hot_names[f] : g_cold_names[f];
+        struct stat* st = hot ? &g_hot_stat[f] : &g_cold_stat[f];
+        time_t mtime = hot ? st->st_mtime : st->st_mtime + 1 + (time_t)(rng % 1000);
+        
+        BoltCachedResponse out;
+        if (!bolt_file_cache_get(w->cache, name, "text/plain", mtime, st->st_size, &out)) {
+            /* Another thread is loading it: the server would send from disk */
+            InterlockedIncrement(w->fallbacks);
+            continue;
+        }
+        snprintf(expected, sizeof(expected), "content of %s", name);
+        if (out.body_len != strlen(expected) || memcmp(out.body, expected, out.body_len) != 0) {
+            InterlockedIncrement(w->errors);
+        }
+        bolt_file_cache_release(w->cache, out.ref);
+    }
+    
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void contention_file(char* name, size_t name_size, struct stat* st, const char* kind, int i) {
+    char content[64];
+    snprintf(name, name_size, "test_cache_%s_%d.txt", kind, i);
+    snprintf(content, sizeof(content), "content of %s", name);
+    create_temp_file(name, content);
+    stat(name, st);
+}
+
+/*
+ * Lookups per second by thread count and hit ratio; every lookup served
+ * from the cache must return the right bytes while others refresh entries
+ * around it.
+ */
+MU_TEST(test_cache_contention) {
+    BoltFileCache* cache = bolt_file_cache_create(BOLT_FILE_CACHE_CAPACITY, BOLT_FILE_CACHE_MAX_TOTAL_BYTES);
+    mu_assert_not_null(cache);
+    
+    for (int i = 0; i < CONTENTION_HOT_FILES; i++) {
+        contention_file(g_hot_names[i], sizeof(g_hot_names[i]), &g_hot_stat[i], "hot", i);
+    }
+    for (int i = 0; i < CONTENTION_COLD_FILES; i++) {
+        contention_file(g_cold_names[i], sizeof(g_cold_names[i]), &g_cold_stat[i], "cold", i);
+    }
+    
+    static const int hit_percents[] = { 100, 90, 50 };
+    volatile LONG errors = 0;
+    volatile LONG fallbacks = 0;
+    
+    printf("    threads  hit%%  lookups/s  measured hit%%  fallbacks\n");
+    for (size_t h = 0; h < sizeof(hit_percents) / sizeof(hit_percents[0]); h++) {
+        for (int threads = 1; threads <= CONTENTION_MAX_THREADS; threads *= 2) {
+            ContentionWorker workers[CONTENTION_MAX_THREADS];
+            BoltFileCacheStats before, after;
+            bolt_file_cache_stats(cache, &before);
+            fallbacks = 0;
+            ULONGLONG start = GetTickCount64();
+            
+#ifdef _WIN32
+            HANDLE handles[CONTENTION_MAX_THREADS];
+#else
+            pthread_t handles[CONTENTION_MAX_THREADS];
+#endif
+            for (int t = 0; t < threads; t++) {
+                workers[t].cache = cache;
+                workers[t].hit_percent = hit_percents[h];
+                workers[t].seed = (uint32_t)(t * 7919 + 1);
+                workers[t].errors = &errors;
+                workers[t].fallbacks = &fallbacks;
+#ifdef _WIN32
+                handles[t] = CreateThread(NULL, 0, contention_worker, &workers[t], 0, NULL);
+                mu_assert_not_null(handles[t]);
+#else
+                mu_assert_int_eq(0, pthread_create(&handles[t], NULL, contention_worker, &workers[t]));
+#endif
+            }
+            for (int t = 0; t < threads; t++) {
+#ifdef _WIN32
+                WaitForSingleObject(handles[t], INFINITE);
+                CloseHandle(handles[t]);
+#else
+                pthread_join(handles[t], NULL);
+#endif
+            }
+            
+            ULONGLONG elapsed = GetTickCount64() - start;
+            bolt_file_cache_stats(cache, &after);
+            LONG64 hits = after.hits - before.hits;
+            LONG64 lookups = hits + after.misses - before.misses;
+            printf("    %7d  %4d  %9.0f  %13.1f  %9ld\n", threads, hit_percents[h],
+                   (double)threads * CONTENTION_LOOKUPS * 1000.0 / (double)(elapsed ? elapsed : 1),
+                   lookups ? 100.0 * (double)hits / (double)lookups : 0.0, (long)fallbacks);
+        }
+    }
+    mu_assert_int_eq(0, errors);
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    mu_assert_size_eq(BOLT_FILE_CACHE_SHARDS, stats.shards);
+    
+    bolt_file_cache_destroy(cache);
+    for (int i = 0; i < CONTENTION_HOT_FILES; i++) delete_temp_file(g_hot_names[i]);
+    for (int i = 0; i < CONTENTION_COLD_FILES; i++) delete_temp_file(g_cold_names[i]);
+    return NULL;
+}
+
+/*============================================================================
+ * Fill Tests
+ *============================================================================*/
+
+#define SINGLE_FLIGHT_THREADS   8
+#define SINGLE_FLIGHT_SIZE      (128 * 1024)
+
+typedef struct {
+    BoltFileCache* cache;
+    const char* filename;
+    struct stat st;
+    volatile LONG* ready;
+    bool found;
+    bool body_ok;
+} SingleFlightWorker;
+
+#ifdef _WIN32
+static DWORD WINAPI single_flight_worker(LPVOID arg) {
+#else
+static void* single_flight_worker(void* arg) {
+#endif
+    SingleFlightWorker* w = (SingleFlightWorker*)arg;
+    
+    /* Start together so the misses overlap */
+    InterlockedIncrement(w->ready);
+    while (*w->ready < SINGLE_FLIGHT_THREADS) {}
+    
+    BoltCachedResponse out;
+    w->found = bolt_file_cache_get(w->cache, w->filename, "application/octet-stream",
+                                   w->st.st_mtime, w->st.st_size, &out);
+    if (w->found) {
+        w->body_ok = out.body_len == SINGLE_FLIGHT_SIZE &&
+                     out.body[0] == 'x' && out.body[SINGLE_FLIGHT_SIZE - 1] == 'x';
+        bolt_file_cache_release(w->cache, out.ref);
+    }
+    
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+MU_TEST(test_cache_single_flight_fill) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 4 * 1024 * 1024);
+    mu_assert_not_null(cache);
+    
+    const char* filename = "test_cache_single_flight.bin";
+    static char content[SINGLE_FLIGHT_SIZE + 1];
+    memset(content, 'x', SINGLE_FLIGHT_SIZE);
+    create_temp_file(filename, content);
+    
+    SingleFlightWorker workers[SINGLE_FLIGHT_THREADS];
+    volatile LONG ready = 0;
+#ifdef _WIN32
+    HANDLE handles[SINGLE_FLIGHT_THREADS];
+#else
+    pthread_t handles[SINGLE_FLIGHT_THREADS];
+#endif
+    for (int t = 0; t < SINGLE_FLIGHT_THREADS; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].cache = cache;
+        workers[t].filename = filename;
+        workers[t].ready = &ready;
+        stat(filename, &workers[t].st);
+#ifdef _WIN32
+        handles[t] = CreateThread(NULL, 0, single_flight_worker, &workers[t], 0, NULL);
+        mu_assert_not_null(handles[t]);
+#else
+        mu_assert_int_eq(0, pthread_create(&handles[t], NULL, single_flight_worker, &workers[t]));
+#endif
+    }
+    
+    int found = 0;
+    for (int t = 0; t < SINGLE_FLIGHT_THREADS; t++) {
+#ifdef _WIN32
+        WaitForSingleObject(handles[t], INFINITE);
+        CloseHandle(handles[t]);
+#else
+        pthread_join(handles[t], NULL);
+#endif
+        if (workers[t].found) {
+            mu_assert_true(workers[t].body_ok);
+            found++;
+        }
+    }
+    
+    /* One read however many missed at once; the others either waited for
+     * nothing (fell back to the file) or found it loaded */
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    mu_check(stats.fills == 1);
+    mu_check(found >= 1);
+    mu_check(found + stats.fill_fallbacks == SINGLE_FLIGHT_THREADS);
+    
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_loader_fills_in_background) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    mu_assert_not_null(cache);
+    mu_assert_true(bolt_file_cache_start_loaders(cache, 1));
+    
+    /* Already running */
+    mu_assert_false(bolt_file_cache_start_loaders(cache, 1));
+    
+    const char* filename = "test_cache_loader.txt";
+    create_temp_file(filename, "Loaded in the background");
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    /* The miss is handed off; the caller would send from the file */
+    BoltCachedResponse out;
+    mu_assert_false(bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out));
+    
+    bool found = false;
+    for (int i = 0; i < 2000 && !found; i++) {
+        found = bolt_file_cache_get(cache, filename, "text/plain", st.st_mtime, st.st_size, &out);
+        if (!found) Sleep(1);
+    }
+    mu_assert_true(found);
+    mu_check(memcmp(out.body, "Loaded in the background", 24) == 0);
+    bolt_file_cache_release(cache, out.ref);
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    mu_check(stats.fills == 1);
+    
+    /* Destroy stops the loader */
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_upgrade_when_quiet) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    mu_assert_not_null(cache);
+    
+    /* Nothing to upgrade without loaders */
+    mu_assert_size_eq(0, bolt_file_cache_upgrade(cache, 4));
+    mu_assert_true(bolt_file_cache_start_loaders(cache, 1));
+    
+    const char* filename = "test_cache_upgrade.txt";
+    char content[8192];
+    unsigned seed = 7;
+    for (size_t i = 0; i < sizeof(content) - 1; i++) {
+        seed = seed * 1103515245u + 12345u;
+        content[i] = "abcdefgh ,.\n"[(seed >> 16) % 12];
+    }
+    content[sizeof(content) - 1] = '\0';
+    create_temp_file(filename, content);
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    /* Filled while busy, at the fast level */
+    compression_set_load(BOLT_LOAD_BUSY);
+    BoltCachedResponse out;
+    bool found = false;
+    for (int i = 0; i < 2000 && !found; i++) {
+        found = bolt_file_cache_get_encoded(cache, filename, "text/plain", BOLT_COMPRESS_GZIP,
+                                            st.st_mtime, st.st_size, &out);
+        if (!found) Sleep(1);
+    }
+    mu_assert_true(found);
+    size_t fast_len = out.body_len;
+    bolt_file_cache_release(cache, out.ref);
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    if (stats.compressions == 1) {
+        /* Not while busy; once quiet, at the best level */
+        mu_assert_size_eq(0, bolt_file_cache_upgrade(cache, 4));
+        compression_set_load(BOLT_LOAD_QUIET);
+        size_t queued = 0;
+        for (int i = 0; i < BOLT_FILE_CACHE_SHARDS && queued == 0; i++) {
+            queued = bolt_file_cache_upgrade(cache, 4);
+        }
+        mu_assert_size_eq(1, queued);
+        for (int i = 0; i < 2000 && stats.upgrades == 0; i++) {
+            Sleep(1);
+            bolt_file_cache_stats(cache, &stats);
+        }
+        mu_check(stats.upgrades == 1);
+        
+        mu_assert_true(bolt_file_cache_get_encoded(cache, filename, "text/plain",
+                                                   BOLT_COMPRESS_GZIP, st.st_mtime, st.st_size,
+                                                   &out));
+        mu_check(out.body_len < fast_len);
+        bolt_file_cache_release(cache, out.ref);
+        
+        /* Already at the best level */
+        for (int i = 0; i < BOLT_FILE_CACHE_SHARDS; i++) {
+            mu_assert_size_eq(0, bolt_file_cache_upgrade(cache, 4));
+        }
+    }
+    
+    compression_set_load(BOLT_LOAD_NORMAL);
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_cache_upgrade_skips_changed_file) {
+    BoltFileCache* cache = bolt_file_cache_create(100, 1024 * 1024);
+    mu_assert_not_null(cache);
+    mu_assert_true(bolt_file_cache_start_loaders(cache, 1));
+    
+    const char* filename = "test_cache_upgrade_changed.txt";
+    char content[8192];
+    unsigned seed = 11;
+    for (size_t i = 0; i < sizeof(content) - 1; i++) {
+        seed = seed * 1103515245u + 12345u;
+        content[i] = "abcdefgh ,.\n"[(seed >> 16) % 12];
+    }
+    content[sizeof(content) - 1] = '\0';
+    create_temp_file(filename, content);
+    
+    struct stat st;
+    stat(filename, &st);
+    
+    /* Cached from an older version of the file (the caller's mtime is
+     * trusted), as if it changed after the fill */
+    time_t old_mtime = st.st_mtime - 10;
+    compression_set_load(BOLT_LOAD_BUSY);
+    BoltCachedResponse out;
+    bool found = false;
+    for (int i = 0; i < 2000 && !found; i++) {
+        found = bolt_file_cache_get_encoded(cache, filename, "text/plain", BOLT_COMPRESS_GZIP,
+                                            old_mtime, st.st_size, &out);
+        if (!found) Sleep(1);
+    }
+    mu_assert_true(found);
+    size_t fast_len = out.body_len;
+    bolt_file_cache_release(cache, out.ref);
+    
+    BoltFileCacheStats stats;
+    bolt_file_cache_stats(cache, &stats);
+    if (stats.compressions == 1) {
+        /* The upgrade would read the current file: it must not be
+         * published under the old version's mtime */
+        compression_set_load(BOLT_LOAD_QUIET);
+        size_t queued = 0;
+        for (int i = 0; i < BOLT_FILE_CACHE_SHARDS && queued == 0; i++) {
+            queued = bolt_file_cache_upgrade(cache, 4);
+        }
+        mu_assert_size_eq(1, queued);
+        Sleep(200);
+        bolt_file_cache_stats(cache, &stats);
+        mu_check(stats.upgrades == 0);
+        
+        mu_assert_true(bolt_file_cache_get_encoded(cache, filename, "text/plain",
+                                                   BOLT_COMPRESS_GZIP, old_mtime, st.st_size,
+                                                   &out));
+        mu_assert_size_eq(fast_len, out.body_len);
+        bolt_file_cache_release(cache, out.ref);
+    }
+    
+    compression_set_load(BOLT_LOAD_NORMAL);
+    delete_temp_file(filename);
+    bolt_file_cache_destroy(cache);
+    return NULL;
+}
+
 /*============================================================================
  * Test Suite Runner
  *============================================================================*/
@@ -190,4 +825,20 @@ void test_suite_cache(void) {
     
     /* Updates */
     MU_RUN_TEST(test_cache_stale_update);
+    MU_RUN_TEST(test_cache_invalidate);
+    MU_RUN_TEST(test_cache_encoded_variants);
+    MU_RUN_TEST(test_cache_referenced_entry_survives_refresh);
+    MU_RUN_TEST(test_cache_reference_outlives_cache);
+    
+    /* Eviction */
+    MU_RUN_TEST(test_cache_full_keeps_hot_files);
+    
+    /* Fills */
+    MU_RUN_TEST(test_cache_single_flight_fill);
+    MU_RUN_TEST(test_cache_loader_fills_in_background);
+    MU_RUN_TEST(test_cache_upgrade_when_quiet);
+    MU_RUN_TEST(test_cache_upgrade_skips_changed_file);
+    
+    /* Concurrency */
+    MU_RUN_TEST(test_cache_contention);
 }
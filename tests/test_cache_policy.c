@@ -0,0 +1,199 @@
+/*
+ * Bolt Test Suite - Cache Policy Tests
+ *
+ * Tests for S3-FIFO queue movement, ghost admission and scan resistance.
+ */
+
+#include "minunit.h"
+#include "../include/cache_policy.h"
+#include "../include/bolt.h"
+#include <string.h>
+
+/* Fresh node with a given key hash and size */
+static void node_init(BoltS3Node* node, uint32_t hash, size_t bytes) {
+    memset(node, 0, sizeof(*node));
+    node->hash = hash;
+    node->bytes = bytes;
+}
+
+/*============================================================================
+ * Setup Tests
+ *============================================================================*/
+
+MU_TEST(test_s3fifo_init) {
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, 1000, 10));
+    mu_assert_null(bolt_s3fifo_evict(&policy));
+    mu_assert_false(bolt_s3fifo_full(&policy, 1000));
+    mu_assert_true(bolt_s3fifo_full(&policy, 1001));
+    bolt_s3fifo_destroy(&policy);
+
+    mu_assert_false(bolt_s3fifo_init(&policy, 0, 10));
+    mu_assert_false(bolt_s3fifo_init(&policy, 1000, 0));
+    mu_assert_false(bolt_s3fifo_init(NULL, 1000, 10));
+    return NULL;
+}
+
+MU_TEST(test_s3fifo_full_by_entries_and_bytes) {
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, 1000, 2));
+
+    BoltS3Node a, b;
+    node_init(&a, 1, 600);
+    node_init(&b, 2, 100);
+    bolt_s3fifo_insert(&policy, &a);
+    mu_assert_true(bolt_s3fifo_full(&policy, 401));
+    mu_assert_false(bolt_s3fifo_full(&policy, 400));
+
+    bolt_s3fifo_insert(&policy, &b);
+    mu_assert_true(bolt_s3fifo_full(&policy, 1));
+
+    bolt_s3fifo_remove(&policy, &a);
+    bolt_s3fifo_remove(&policy, &b);
+    mu_assert_size_eq(0, policy.entries);
+    mu_assert_null(bolt_s3fifo_evict(&policy));
+
+    bolt_s3fifo_destroy(&policy);
+    return NULL;
+}
+
+/*============================================================================
+ * Queue Movement Tests
+ *============================================================================*/
+
+MU_TEST(test_s3fifo_evicts_unhit_in_fifo_order) {
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, 1000, 10));
+
+    BoltS3Node nodes[3];
+    for (int i = 0; i < 3; i++) {
+        node_init(&nodes[i], (uint32_t)(i + 1), 10);
+        bolt_s3fifo_insert(&policy, &nodes[i]);
+    }
+
+    mu_check(bolt_s3fifo_evict(&policy) == &nodes[0]);
+    mu_check(bolt_s3fifo_evict(&policy) == &nodes[1]);
+    mu_assert_int_eq(BOLT_S3FIFO_NONE, nodes[0].queue);
+    mu_assert_size_eq(1, policy.entries);
+    mu_assert_size_eq(10, policy.small_bytes);
+
+    bolt_s3fifo_destroy(&policy);
+    return NULL;
+}
+
+MU_TEST(test_s3fifo_hit_promotes_to_main) {
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, 1000, 10));
+
+    BoltS3Node hot, cold;
+    node_init(&hot, 1, 10);
+    node_init(&cold, 2, 10);
+    bolt_s3fifo_insert(&policy, &hot);
+    bolt_s3fifo_insert(&policy, &cold);
+    bolt_s3fifo_hit(&hot);
+
+    /* The older entry was hit, so the newer one goes first */
+    mu_check(bolt_s3fifo_evict(&policy) == &cold);
+    mu_assert_int_eq(BOLT_S3FIFO_MAIN, hot.queue);
+    mu_assert_int_eq(0, hot.freq);
+    mu_check(policy.promotions == 1);
+
+    bolt_s3fifo_destroy(&policy);
+    return NULL;
+}
+
+MU_TEST(test_s3fifo_hit_saturates) {
+    BoltS3Node node;
+    node_init(&node, 1, 10);
+    for (int i = 0; i < 10; i++) {
+        bolt_s3fifo_hit(&node);
+    }
+    mu_assert_int_eq(BOLT_S3FIFO_MAX_FREQ, node.freq);
+
+    /* Should be safe to call with NULL */
+    bolt_s3fifo_hit(NULL);
+    return NULL;
+}
+
+MU_TEST(test_s3fifo_ghost_readmits_to_main) {
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, 1000, 10));
+
+    BoltS3Node node;
+    node_init(&node, 42, 10);
+    bolt_s3fifo_insert(&policy, &node);
+    mu_check(bolt_s3fifo_evict(&policy) == &node);
+
+    /* Evicted too early: coming back skips probation */
+    node_init(&node, 42, 10);
+    bolt_s3fifo_insert(&policy, &node);
+    mu_assert_int_eq(BOLT_S3FIFO_MAIN, node.queue);
+    mu_check(policy.ghost_hits == 1);
+
+    /* A ghost is consumed by re-admission */
+    mu_check(bolt_s3fifo_evict(&policy) == &node);
+    node_init(&node, 42, 10);
+    bolt_s3fifo_insert(&policy, &node);
+    mu_assert_int_eq(BOLT_S3FIFO_SMALL, node.queue);
+
+    bolt_s3fifo_destroy(&policy);
+    return NULL;
+}
+
+/*============================================================================
+ * Scan Resistance Tests
+ *============================================================================*/
+
+MU_TEST(test_s3fifo_scan_keeps_hot_set) {
+    enum { CAPACITY = 100, HOT = 20, SCAN = 2000 };
+    static BoltS3Node hot[HOT];
+    static BoltS3Node scan[SCAN];
+
+    BoltS3Fifo policy;
+    mu_assert_true(bolt_s3fifo_init(&policy, CAPACITY * 10, CAPACITY));
+
+    for (int i = 0; i < HOT; i++) {
+        node_init(&hot[i], (uint32_t)(i + 1), 10);
+        bolt_s3fifo_insert(&policy, &hot[i]);
+    }
+
+    /* The hot set keeps getting hits while a crawler walks once over 20x
+     * the cache's capacity */
+    for (int i = 0; i < SCAN; i++) {
+        if (i % 10 == 0) {
+            for (int h = 0; h < HOT; h++) bolt_s3fifo_hit(&hot[h]);
+        }
+        node_init(&scan[i], (uint32_t)(1000 + i), 10);
+        while (bolt_s3fifo_full(&policy, scan[i].bytes)) {
+            mu_assert_not_null(bolt_s3fifo_evict(&policy));
+        }
+        bolt_s3fifo_insert(&policy, &scan[i]);
+    }
+
+    for (int h = 0; h < HOT; h++) {
+        mu_assert_int_eq(BOLT_S3FIFO_MAIN, hot[h].queue);
+    }
+    mu_assert_size_eq(CAPACITY, policy.entries);
+
+    bolt_s3fifo_destroy(&policy);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_cache_policy(void) {
+    /* Setup */
+    MU_RUN_TEST(test_s3fifo_init);
+    MU_RUN_TEST(test_s3fifo_full_by_entries_and_bytes);
+
+    /* Queue movement */
+    MU_RUN_TEST(test_s3fifo_evicts_unhit_in_fifo_order);
+    MU_RUN_TEST(test_s3fifo_hit_promotes_to_main);
+    MU_RUN_TEST(test_s3fifo_hit_saturates);
+    MU_RUN_TEST(test_s3fifo_ghost_readmits_to_main);
+
+    /* Scan resistance */
+    MU_RUN_TEST(test_s3fifo_scan_keeps_hot_set);
+}
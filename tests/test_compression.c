@@ -0,0 +1,339 @@
+/*
+ * Bolt Test Suite - Compression Tests
+ *
+ * Tests for content-coding negotiation and the encoders.
+ */
+
+#include "minunit.h"
+#include "../include/compression.h"
+#include "../include/compression_adapt.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define TEST_HAVE_ZLIB 1
+#else
+#define TEST_HAVE_ZLIB 0
+#endif
+
+/*============================================================================
+ * Accept-Encoding Tests
+ *============================================================================*/
+
+MU_TEST(test_accepts_listed_coding) {
+    mu_assert_true(compression_accepts("gzip, deflate, br", "br"));
+    mu_assert_true(compression_accepts("gzip, deflate, br", "gzip"));
+    mu_assert_true(compression_accepts("GZIP", "gzip"));
+    mu_assert_false(compression_accepts("gzip, deflate", "br"));
+    return NULL;
+}
+
+MU_TEST(test_accepts_whole_tokens_only) {
+    /* "br" is not a substring match of another coding */
+    mu_assert_false(compression_accepts("x-brotli", "br"));
+    mu_assert_false(compression_accepts("gzipper", "gzip"));
+    return NULL;
+}
+
+MU_TEST(test_accepts_q_zero_refuses) {
+    mu_assert_false(compression_accepts("gzip;q=0, br", "gzip"));
+    mu_assert_true(compression_accepts("gzip;q=0, br", "br"));
+    mu_assert_false(compression_accepts("br ; q=0.0", "br"));
+    mu_assert_true(compression_accepts("br;q=0.5", "br"));
+    return NULL;
+}
+
+MU_TEST(test_accepts_wildcard) {
+    mu_assert_true(compression_accepts("*", "br"));
+    mu_assert_false(compression_accepts("*;q=0", "br"));
+    /* A listed coding overrides the wildcard */
+    mu_assert_false(compression_accepts("br;q=0, *", "br"));
+    return NULL;
+}
+
+MU_TEST(test_accepts_missing_header) {
+    mu_assert_false(compression_accepts(NULL, "gzip"));
+    mu_assert_false(compression_accepts("", "gzip"));
+    mu_assert_false(compression_accepts("identity", "gzip"));
+    return NULL;
+}
+
+/*============================================================================
+ * Negotiation Tests
+ *============================================================================*/
+
+static const BoltCompressionType g_all_codings[] = {
+    BOLT_COMPRESS_BROTLI, BOLT_COMPRESS_ZSTD, BOLT_COMPRESS_GZIP, BOLT_COMPRESS_DEFLATE
+};
+
+MU_TEST(test_negotiate_server_order_breaks_ties) {
+    mu_assert_int_eq(BOLT_COMPRESS_BROTLI,
+                     compression_negotiate("gzip, deflate, br, zstd", g_all_codings, 4));
+    mu_assert_int_eq(BOLT_COMPRESS_ZSTD,
+                     compression_negotiate("gzip, zstd", g_all_codings, 4));
+    mu_assert_int_eq(BOLT_COMPRESS_GZIP,
+                     compression_negotiate("deflate, gzip", g_all_codings, 4));
+    return NULL;
+}
+
+MU_TEST(test_negotiate_higher_q_wins) {
+    mu_assert_int_eq(BOLT_COMPRESS_GZIP,
+                     compression_negotiate("br;q=0.5, gzip", g_all_codings, 4));
+    mu_assert_int_eq(BOLT_COMPRESS_ZSTD,
+                     compression_negotiate("br;q=0.8, zstd;q=0.9, gzip;q=0.1", g_all_codings, 4));
+    mu_assert_int_eq(BOLT_COMPRESS_NONE,
+                     compression_negotiate("br;q=0, gzip;q=0", g_all_codings, 4));
+    /* Wildcard picks the server's favourite, except what is refused */
+    mu_assert_int_eq(BOLT_COMPRESS_ZSTD,
+                     compression_negotiate("br;q=0, *", g_all_codings, 4));
+    return NULL;
+}
+
+MU_TEST(test_negotiate_only_candidates) {
+    BoltCompressionType sidecars[] = { BOLT_COMPRESS_GZIP };
+    mu_assert_int_eq(BOLT_COMPRESS_NONE, compression_negotiate("br", sidecars, 1));
+    mu_assert_int_eq(BOLT_COMPRESS_GZIP, compression_negotiate("br, gzip", sidecars, 1));
+    return NULL;
+}
+
+MU_TEST(test_parse_accept_encoding_uses_preference) {
+    BoltCompressionConfig config = compression_get_default_config();
+    config.preference[0] = BOLT_COMPRESS_GZIP;
+    config.preference[1] = BOLT_COMPRESS_NONE;
+    mu_assert_int_eq(BOLT_COMPRESS_GZIP,
+                     compression_parse_accept_encoding("br, gzip", &config));
+    mu_assert_int_eq(BOLT_COMPRESS_NONE,
+                     compression_parse_accept_encoding("br", &config));
+    config.enabled = false;
+    mu_assert_int_eq(BOLT_COMPRESS_NONE,
+                     compression_parse_accept_encoding("gzip", &config));
+    return NULL;
+}
+
+/*============================================================================
+ * Encoder Tests
+ *============================================================================*/
+
+static char* make_text(size_t size) {
+    char* text = (char*)malloc(size);
+    if (!text) return NULL;
+    for (size_t i = 0; i < size; i++) {
+        text[i] = "function bolt() { return 42; }\n"[i % 31];
+    }
+    return text;
+}
+
+MU_TEST(test_compress_shrinks_text) {
+    size_t size = 16384;
+    char* text = make_text(size);
+    mu_assert_not_null(text);
+    
+    for (size_t i = 0; i < sizeof(g_all_codings) / sizeof(g_all_codings[0]); i++) {
+        BoltCompressionType type = g_all_codings[i];
+        BoltCompressedData out = { NULL, 0, BOLT_COMPRESS_NONE };
+        bool ok = compression_compress(type, text, size, &out, compression_level(NULL, type));
+        mu_assert_int_eq(compression_available(type), ok);
+        if (ok) {
+            mu_assert_int_eq(type, out.type);
+            mu_assert_true(out.size > 0 && out.size < size / 4);
+            free(out.data);
+        }
+    }
+    free(text);
+    return NULL;
+}
+
+MU_TEST(test_compress_round_trip_zlib) {
+#if TEST_HAVE_ZLIB
+    size_t size = 8192;
+    char* text = make_text(size);
+    char* back = (char*)malloc(size);
+    mu_assert_not_null(text);
+    mu_assert_not_null(back);
+    
+    /* deflate is the zlib wrapper, which uncompress() reads */
+    BoltCompressedData out = { NULL, 0, BOLT_COMPRESS_NONE };
+    mu_assert_true(compression_compress(BOLT_COMPRESS_DEFLATE, text, size, &out, 6));
+    uLongf back_len = (uLongf)size;
+    mu_assert_int_eq(Z_OK, uncompress((Bytef*)back, &back_len, (const Bytef*)out.data, out.size));
+    mu_assert_int_eq((int)size, (int)back_len);
+    mu_assert_true(memcmp(text, back, size) == 0);
+    free(out.data);
+    
+    /* gzip carries the gzip magic */
+    mu_assert_true(compression_compress(BOLT_COMPRESS_GZIP, text, size, &out, 6));
+    mu_assert_true((unsigned char)out.data[0] == 0x1f && (unsigned char)out.data[1] == 0x8b);
+    free(out.data);
+    
+    free(back);
+    free(text);
+#endif
+    return NULL;
+}
+
+MU_TEST(test_compress_reused_context_same_output) {
+    size_t size = 12000;
+    char* text = make_text(size);
+    mu_assert_not_null(text);
+    
+    for (size_t i = 0; i < sizeof(g_all_codings) / sizeof(g_all_codings[0]); i++) {
+        BoltCompressionType type = g_all_codings[i];
+        if (!compression_available(type)) continue;
+        
+        BoltCompressedData first = { NULL, 0, BOLT_COMPRESS_NONE };
+        mu_assert_true(compression_compress(type, text, size, &first, 4));
+        
+        /* A reset context, used at another level in between, encodes the same */
+        LONG64 created_before, reused_before, created_after, reused_after;
+        compression_context_stats(&created_before, &reused_before);
+        size_t len = 0;
+        mu_assert_not_null(compression_compress_scratch(type, text, size / 2, &len, 1));
+        const char* again = compression_compress_scratch(type, text, size, &len, 4);
+        mu_assert_not_null(again);
+        compression_context_stats(&created_after, &reused_after);
+        
+        mu_assert_int_eq((int)first.size, (int)len);
+        mu_assert_true(memcmp(first.data, again, len) == 0);
+        mu_assert_true(reused_after >= reused_before + 2);
+        mu_assert_true(created_after == created_before);
+        free(first.data);
+    }
+    free(text);
+    return NULL;
+}
+
+MU_TEST(test_compress_into_too_small) {
+    size_t size = 4096;
+    char* text = make_text(size);
+    char out[16];
+    size_t len = 0;
+    mu_assert_not_null(text);
+    if (compression_available(BOLT_COMPRESS_GZIP)) {
+        mu_assert_false(compression_compress_into(BOLT_COMPRESS_GZIP, text, size,
+                                                  out, sizeof(out), &len, 6));
+        /* The context went back to the pool in a usable state */
+        mu_assert_not_null(compression_compress_scratch(BOLT_COMPRESS_GZIP, text, size, &len, 6));
+    }
+    free(text);
+    return NULL;
+}
+
+MU_TEST(test_compress_rejects_none_and_empty) {
+    BoltCompressedData out = { NULL, 0, BOLT_COMPRESS_NONE };
+    mu_assert_false(compression_compress(BOLT_COMPRESS_NONE, "abc", 3, &out, 1));
+    mu_assert_false(compression_compress(BOLT_COMPRESS_GZIP, "abc", 0, &out, 1));
+    mu_assert_null(compression_coding_name(BOLT_COMPRESS_NONE));
+    mu_assert_string_eq("zstd", compression_coding_name(BOLT_COMPRESS_ZSTD));
+    return NULL;
+}
+
+/*============================================================================
+ * Load-Adaptive Level Tests
+ *============================================================================*/
+
+MU_TEST(test_levels_follow_load) {
+    BoltCompressionConfig config = compression_get_default_config();
+    config.level = 6;
+    config.brotli_level = 5;
+    
+    compression_set_load(BOLT_LOAD_NORMAL);
+    mu_assert_int_eq(6, compression_level(&config, BOLT_COMPRESS_GZIP));
+    mu_assert_int_eq(5, compression_stored_level(&config, BOLT_COMPRESS_BROTLI));
+    mu_assert_false(compression_overloaded());
+    
+    /* Quiet: stored variants get the best level, responses keep theirs */
+    compression_set_load(BOLT_LOAD_QUIET);
+    mu_assert_int_eq(6, compression_level(&config, BOLT_COMPRESS_GZIP));
+    mu_assert_int_eq(9, compression_stored_level(&config, BOLT_COMPRESS_GZIP));
+    mu_assert_int_eq(11, compression_stored_level(&config, BOLT_COMPRESS_BROTLI));
+    
+    /* Busy: fast everywhere */
+    compression_set_load(BOLT_LOAD_BUSY);
+    mu_assert_int_eq(1, compression_level(&config, BOLT_COMPRESS_GZIP));
+    mu_assert_int_eq(1, compression_stored_level(&config, BOLT_COMPRESS_BROTLI));
+    
+    /* Overload: the request path stops compressing */
+    compression_set_load(BOLT_LOAD_OVERLOAD);
+    LONG64 shed = compression_shed_count();
+    mu_assert_true(compression_overloaded());
+    mu_assert_true(compression_shed_count() == shed + 1);
+    
+    compression_set_load(BOLT_LOAD_NORMAL);
+    return NULL;
+}
+
+MU_TEST(test_adapt_target) {
+    mu_assert_int_eq(BOLT_LOAD_QUIET, compression_adapt_target(5, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_NORMAL, compression_adapt_target(40, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_NORMAL, compression_adapt_target(5, 1, 4));
+    mu_assert_int_eq(BOLT_LOAD_BUSY, compression_adapt_target(BOLT_ADAPT_BUSY_UTIL, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_BUSY, compression_adapt_target(10, 4, 4));
+    mu_assert_int_eq(BOLT_LOAD_OVERLOAD, compression_adapt_target(BOLT_ADAPT_OVERLOAD_UTIL, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_OVERLOAD,
+                     compression_adapt_target(10, BOLT_ADAPT_OVERLOAD_QUEUE * 4, 4));
+    
+    /* Without a compute pool only the CPU counts */
+    mu_assert_int_eq(BOLT_LOAD_NORMAL, compression_adapt_target(40, 100, 0));
+    return NULL;
+}
+
+MU_TEST(test_adapt_rises_at_once_falls_slowly) {
+    BoltCompressionAdapt adapt;
+    compression_adapt_init(&adapt);
+    mu_assert_int_eq(BOLT_LOAD_NORMAL, adapt.load);
+    
+    mu_assert_int_eq(BOLT_LOAD_OVERLOAD, compression_adapt_update(&adapt, 95, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_OVERLOAD, compression_load());
+    
+    /* Calm samples step down one level at a time */
+    for (int i = 0; i < BOLT_ADAPT_CALM_SAMPLES - 1; i++) {
+        mu_assert_int_eq(BOLT_LOAD_OVERLOAD, compression_adapt_update(&adapt, 5, 0, 4));
+    }
+    mu_assert_int_eq(BOLT_LOAD_BUSY, compression_adapt_update(&adapt, 5, 0, 4));
+    
+    /* A sample at the current level restarts the count */
+    for (int i = 0; i < BOLT_ADAPT_CALM_SAMPLES - 1; i++) {
+        compression_adapt_update(&adapt, 5, 0, 4);
+    }
+    mu_assert_int_eq(BOLT_LOAD_BUSY, compression_adapt_update(&adapt, 75, 0, 4));
+    mu_assert_int_eq(BOLT_LOAD_BUSY, compression_adapt_update(&adapt, 5, 0, 4));
+    
+    mu_assert_true(adapt.raised == 1);
+    mu_assert_true(adapt.lowered == 1);
+    mu_assert_int_eq(5, adapt.utilization);
+    
+    compression_set_load(BOLT_LOAD_NORMAL);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_compression(void) {
+    /* Accept-Encoding */
+    MU_RUN_TEST(test_accepts_listed_coding);
+    MU_RUN_TEST(test_accepts_whole_tokens_only);
+    MU_RUN_TEST(test_accepts_q_zero_refuses);
+    MU_RUN_TEST(test_accepts_wildcard);
+    MU_RUN_TEST(test_accepts_missing_header);
+    
+    /* Negotiation */
+    MU_RUN_TEST(test_negotiate_server_order_breaks_ties);
+    MU_RUN_TEST(test_negotiate_higher_q_wins);
+    MU_RUN_TEST(test_negotiate_only_candidates);
+    MU_RUN_TEST(test_parse_accept_encoding_uses_preference);
+    
+    /* Encoders */
+    MU_RUN_TEST(test_compress_shrinks_text);
+    MU_RUN_TEST(test_compress_round_trip_zlib);
+    MU_RUN_TEST(test_compress_reused_context_same_output);
+    MU_RUN_TEST(test_compress_into_too_small);
+    MU_RUN_TEST(test_compress_rejects_none_and_empty);
+    
+    /* Load-adaptive levels */
+    MU_RUN_TEST(test_levels_follow_load);
+    MU_RUN_TEST(test_adapt_target);
+    MU_RUN_TEST(test_adapt_rises_at_once_falls_slowly);
+}
@@ -41,6 +41,7 @@ MU_TEST(test_config_default_compression) {
     
     /* Compression settings should have reasonable defaults */
     mu_check(config.gzip_level >= 0 && config.gzip_level <= 9);
+    mu_assert_true(config.compression_adaptive);
     
     return NULL;
 }
@@ -212,6 +213,97 @@ MU_TEST(test_config_workers_negative) {
     return NULL;
 }
 
+/*============================================================================
+ * Event Loop Model Tests
+ *============================================================================*/
+
+MU_TEST(test_config_reuseport_default_off) {
+    BoltConfig config;
+    config_load_defaults(&config);
+    
+    /* Shared event loop unless asked otherwise */
+    mu_assert_false(config.reuseport);
+    mu_assert_false(config.worker_cpu_affinity);
+    
+    return NULL;
+}
+
+MU_TEST(test_config_reuseport_from_file) {
+    const char* path = "test_reuseport.conf";
+    FILE* f = fopen(path, "w");
+    mu_check(f != NULL);
+    fputs("reuseport = on;\nworker_cpu_affinity = 1;\n", f);
+    fclose(f);
+    
+    BoltConfig config;
+    config_load_defaults(&config);
+    bool result = config_load_from_file(&config, path);
+    remove(path);
+    
+    mu_assert_true(result);
+    mu_assert_true(config.reuseport);
+    mu_assert_true(config.worker_cpu_affinity);
+    
+    return NULL;
+}
+
+MU_TEST(test_config_compression_from_file) {
+    const char* path = "test_compression.conf";
+    FILE* f = fopen(path, "w");
+    mu_check(f != NULL);
+    fputs("brotli_level = 11;\nzstd_level = 99;\ncompression_order = gzip, br;\n"
+          "compression_adaptive = off;\nzstd_static = off;\n", f);
+    fclose(f);
+    
+    BoltConfig config;
+    config_load_defaults(&config);
+    bool result = config_load_from_file(&config, path);
+    remove(path);
+    
+    mu_assert_true(result);
+    mu_assert_int_eq(11, config.brotli_level);
+    mu_assert_int_eq(19, config.zstd_level);
+    mu_assert_int_eq(BOLT_COMPRESS_GZIP, config.compression_order[0]);
+    mu_assert_int_eq(BOLT_COMPRESS_BROTLI, config.compression_order[1]);
+    mu_assert_int_eq(BOLT_COMPRESS_NONE, config.compression_order[2]);
+    mu_assert_false(config.compression_adaptive);
+    mu_assert_false(config.zstd_static);
+    mu_assert_true(config.brotli_static);
+    
+    return NULL;
+}
+
+MU_TEST(test_config_compute_threads_from_file) {
+    const char* path = "test_compute.conf";
+    BoltConfig config;
+    config_load_defaults(&config);
+    mu_assert_int_eq(0, config.compute_threads);
+    
+    FILE* f = fopen(path, "w");
+    mu_check(f != NULL);
+    fputs("compute_threads = 4;\n", f);
+    fclose(f);
+    mu_assert_true(config_load_from_file(&config, path));
+    mu_assert_int_eq(4, config.compute_threads);
+    
+    f = fopen(path, "w");
+    mu_check(f != NULL);
+    fputs("compute_threads = off;\n", f);
+    fclose(f);
+    mu_assert_true(config_load_from_file(&config, path));
+    mu_assert_int_eq(-1, config.compute_threads);
+    
+    f = fopen(path, "w");
+    mu_check(f != NULL);
+    fputs("compute_threads = auto;\n", f);
+    fclose(f);
+    mu_assert_true(config_load_from_file(&config, path));
+    remove(path);
+    mu_assert_int_eq(0, config.compute_threads);
+    
+    return NULL;
+}
+
 /*============================================================================
  * Test Suite Runner
  *============================================================================*/
@@ -245,4 +337,10 @@ void test_suite_config(void) {
     MU_RUN_TEST(test_config_workers_auto);
     MU_RUN_TEST(test_config_workers_explicit);
     MU_RUN_TEST(test_config_workers_negative);
+    
+    /* Event loop model */
+    MU_RUN_TEST(test_config_reuseport_default_off);
+    MU_RUN_TEST(test_config_reuseport_from_file);
+    MU_RUN_TEST(test_config_compression_from_file);
+    MU_RUN_TEST(test_config_compute_threads_from_file);
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+ * Bolt Test Suite - Filesystem Watcher Tests
+ *
+ * Tests for change notifications on watched directory trees.
+ */
+
+#include "minunit.h"
+#include "../include/fs_watch.h"
+#include "../include/bolt.h"
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define test_mkdir(path) _mkdir(path)
+#define test_rmdir(path) _rmdir(path)
+#else
+#define test_mkdir(path) mkdir(path, 0755)
+#define test_rmdir(path) rmdir(path)
+#endif
+
+#define FSW_ROOT  "test_fs_watch_dir"
+#define FSW_FILE  FSW_ROOT BOLT_PATH_SEP_STR "a.txt"
+#define FSW_SUB   FSW_ROOT BOLT_PATH_SEP_STR "sub"
+#define FSW_SUB_FILE FSW_SUB BOLT_PATH_SEP_STR "b.txt"
+
+#define FSW_WAIT_MS 2000
+
+/* Events seen by the callback, on the watcher thread */
+typedef struct {
+    CRITICAL_SECTION lock;
+    int events;
+    int lost;
+    char wanted[BOLT_MAX_PATH_LENGTH];
+    bool wanted_seen;
+} WatchLog;
+
+static void log_event(void* context, BoltFsWatchEvent event, const char* path) {
+    WatchLog* log = (WatchLog*)context;
+
+    EnterCriticalSection(&log->lock);
+    switch (event) {
+        case BOLT_FS_CHANGED:
+            if (strcmp(path, log->wanted) == 0) log->wanted_seen = true;
+            break;
+        case BOLT_FS_RESCAN:
+            break;
+        case BOLT_FS_LOST:
+            log->lost++;
+            break;
+    }
+    log->events++;
+    LeaveCriticalSection(&log->lock);
+}
+
+static void log_init(WatchLog* log, const char* wanted) {
+    memset(log, 0, sizeof(*log));
+    InitializeCriticalSection(&log->lock);
+    snprintf(log->wanted, sizeof(log->wanted), "%s", wanted);
+}
+
+static void log_want(WatchLog* log, const char* wanted) {
+    EnterCriticalSection(&log->lock);
+    snprintf(log->wanted, sizeof(log->wanted), "%s", wanted);
+    log->wanted_seen = false;
+    LeaveCriticalSection(&log->lock);
+}
+
+/* Wait until `counter` (read under the lock) becomes non-zero */
+static bool log_wait(WatchLog* log, const void* counter, bool is_flag) {
+    for (int waited = 0; waited < FSW_WAIT_MS; waited += 10) {
+        EnterCriticalSection(&log->lock);
+        bool seen = is_flag ? *(const bool*)counter : *(const int*)counter > 0;
+        LeaveCriticalSection(&log->lock);
+        if (seen) return true;
+        Sleep(10);
+    }
+    return false;
+}
+
+static void write_file(const char* filename, const char* content) {
+    FILE* f = fopen(filename, "wb");
+    if (f) {
+        fwrite(content, 1, strlen(content), f);
+        fclose(f);
+    }
+}
+
+/*============================================================================
+ * Setup Tests
+ *============================================================================*/
+
+MU_TEST(test_fs_watch_create) {
+    WatchLog log;
+    log_init(&log, "");
+
+    mu_assert_null(bolt_fs_watch_create(NULL, NULL));
+
+    BoltFsWatch* watch = bolt_fs_watch_create(log_event, &log);
+    mu_assert_not_null(watch);
+
+    /* Missing roots are refused; nothing to start without roots */
+    mu_assert_false(bolt_fs_watch_add_root(watch, "no_such_dir_999"));
+    mu_assert_false(bolt_fs_watch_start(watch));
+
+    BoltFsWatchStats stats;
+    bolt_fs_watch_stats(watch, &stats);
+    mu_assert_size_eq(0, stats.roots);
+    mu_assert_size_eq(0, stats.watches);
+    bolt_fs_watch_destroy(watch);
+
+    /* Should be safe with NULL */
+    bolt_fs_watch_destroy(NULL);
+    bolt_fs_watch_stats(NULL, &stats);
+    mu_assert_size_eq(0, stats.roots);
+
+    DeleteCriticalSection(&log.lock);
+    return NULL;
+}
+
+/*============================================================================
+ * Notification Tests
+ *============================================================================*/
+
+MU_TEST(test_fs_watch_reports_file_change) {
+    WatchLog log;
+    log_init(&log, FSW_FILE);
+    test_mkdir(FSW_ROOT);
+
+    BoltFsWatch* watch = bolt_fs_watch_create(log_event, &log);
+    mu_assert_not_null(watch);
+    mu_assert_true(bolt_fs_watch_add_root(watch, FSW_ROOT));
+    mu_assert_true(bolt_fs_watch_start(watch));
+
+    /* Reported as root + separator + name, the cache key form */
+    write_file(FSW_FILE, "hello");
+    mu_assert_true(log_wait(&log, &log.wanted_seen, true));
+
+    /* Deletion too */
+    log_want(&log, FSW_FILE);
+    remove(FSW_FILE);
+    mu_assert_true(log_wait(&log, &log.wanted_seen, true));
+
+    BoltFsWatchStats stats;
+    bolt_fs_watch_stats(watch, &stats);
+    mu_assert_size_eq(1, stats.roots);
+    mu_check(stats.events >= 2);
+
+    bolt_fs_watch_destroy(watch);
+    test_rmdir(FSW_ROOT);
+    DeleteCriticalSection(&log.lock);
+    return NULL;
+}
+
+MU_TEST(test_fs_watch_follows_new_directory) {
+    WatchLog log;
+    log_init(&log, FSW_SUB_FILE);
+    test_mkdir(FSW_ROOT);
+
+    BoltFsWatch* watch = bolt_fs_watch_create(log_event, &log);
+    mu_assert_not_null(watch);
+    mu_assert_true(bolt_fs_watch_add_root(watch, FSW_ROOT));
+    mu_assert_true(bolt_fs_watch_start(watch));
+
+    /* A new directory is followed once its creation is seen */
+    test_mkdir(FSW_SUB);
+    mu_assert_true(log_wait(&log, &log.events, false));
+    write_file(FSW_SUB_FILE, "nested");
+    mu_assert_true(log_wait(&log, &log.wanted_seen, true));
+
+    bolt_fs_watch_destroy(watch);
+    remove(FSW_SUB_FILE);
+    test_rmdir(FSW_SUB);
+    test_rmdir(FSW_ROOT);
+    DeleteCriticalSection(&log.lock);
+    return NULL;
+}
+
+MU_TEST(test_fs_watch_reports_lost_root) {
+    WatchLog log;
+    log_init(&log, "");
+    test_mkdir(FSW_ROOT);
+
+    BoltFsWatch* watch = bolt_fs_watch_create(log_event, &log);
+    mu_assert_not_null(watch);
+    mu_assert_true(bolt_fs_watch_add_root(watch, FSW_ROOT));
+    mu_assert_true(bolt_fs_watch_start(watch));
+
+    /* Nothing under a removed root can be followed any more */
+    test_rmdir(FSW_ROOT);
+    mu_assert_true(log_wait(&log, &log.lost, false));
+
+    bolt_fs_watch_destroy(watch);
+    mu_assert_int_eq(1, log.lost);
+    DeleteCriticalSection(&log.lock);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_fs_watch(void) {
+    /* Setup */
+    MU_RUN_TEST(test_fs_watch_create);
+
+    /* Notifications */
+    MU_RUN_TEST(test_fs_watch_reports_file_change);
+    MU_RUN_TEST(test_fs_watch_follows_new_directory);
+    MU_RUN_TEST(test_fs_watch_reports_lost_root);
+}
@@ -14,7 +14,7 @@
  *============================================================================*/
 
 MU_TEST(test_parse_get_request) {
-    const char* raw = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -25,7 +25,7 @@ MU_TEST(test_parse_get_request) {
 }
 
 MU_TEST(test_parse_head_request) {
-    const char* raw = "HEAD /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "HEAD /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -35,7 +35,7 @@ MU_TEST(test_parse_head_request) {
 }
 
 MU_TEST(test_parse_post_request) {
-    const char* raw = "POST /api/data HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "POST /api/data HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -45,7 +45,7 @@ MU_TEST(test_parse_post_request) {
 }
 
 MU_TEST(test_parse_options_request) {
-    const char* raw = "OPTIONS /api HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "OPTIONS /api HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -55,7 +55,7 @@ MU_TEST(test_parse_options_request) {
 }
 
 MU_TEST(test_parse_unknown_method) {
-    const char* raw = "DELETE /resource HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "DELETE /resource HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_int_eq(HTTP_UNKNOWN, req.method);
@@ -68,7 +68,7 @@ MU_TEST(test_parse_unknown_method) {
  *============================================================================*/
 
 MU_TEST(test_parse_root_uri) {
-    const char* raw = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -78,7 +78,7 @@ MU_TEST(test_parse_root_uri) {
 }
 
 MU_TEST(test_parse_uri_with_query_string) {
-    const char* raw = "GET /search?q=test&page=1 HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "GET /search?q=test&page=1 HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -89,7 +89,7 @@ MU_TEST(test_parse_uri_with_query_string) {
 }
 
 MU_TEST(test_parse_uri_with_fragment) {
-    const char* raw = "GET /page#section HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "GET /page#section HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -100,7 +100,7 @@ MU_TEST(test_parse_uri_with_fragment) {
 }
 
 MU_TEST(test_parse_deep_nested_uri) {
-    const char* raw = "GET /a/b/c/d/e/f/g.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    char raw[] = "GET /a/b/c/d/e/f/g.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
@@ -114,28 +114,187 @@ MU_TEST(test_parse_deep_nested_uri) {
  *============================================================================*/
 
 MU_TEST(test_parse_if_none_match_header) {
-    const char* raw = "GET /index.html HTTP/1.1\r\n"
+    char raw[] = "GET /index.html HTTP/1.1\r\n"
                       "Host: localhost\r\n"
                       "If-None-Match: \"abc123\"\r\n"
                       "\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
-    mu_check(strlen(req.if_none_match) > 0);
-    mu_check(strstr(req.if_none_match, "abc123") != NULL);
+    mu_check(http_header(&req, HTTP_HEADER_IF_NONE_MATCH) != NULL);
+    mu_check(strstr(http_header(&req, HTTP_HEADER_IF_NONE_MATCH), "abc123") != NULL);
     
     return NULL;
 }
 
 MU_TEST(test_parse_accept_encoding_header) {
-    const char* raw = "GET /index.html HTTP/1.1\r\n"
+    char raw[] = "GET /index.html HTTP/1.1\r\n"
                       "Host: localhost\r\n"
                       "Accept-Encoding: gzip, deflate\r\n"
                       "\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_true(req.valid);
-    mu_check(strstr(req.accept_encoding, "gzip") != NULL);
+    mu_check(strstr(http_header(&req, HTTP_HEADER_ACCEPT_ENCODING), "gzip") != NULL);
+    
+    return NULL;
+}
+
+MU_TEST(test_parse_headers_ignore_case) {
+    char raw[] = "GET /index.html HTTP/1.1\r\n"
+                 "host: example.com\r\n"
+                 "ACCEPT-ENCODING: br\r\n"
+                 "rAnGe: bytes=0-9\r\n"
+                 "\r\n";
+    HttpRequest req = http_parse_request(raw, strlen(raw));
+    
+    mu_assert_true(req.valid);
+    mu_assert_string_eq("example.com", http_header(&req, HTTP_HEADER_HOST));
+    mu_assert_string_eq("br", http_header(&req, HTTP_HEADER_ACCEPT_ENCODING));
+    mu_assert_string_eq("bytes=0-9", http_header(&req, HTTP_HEADER_RANGE));
+    mu_check(http_header(&req, HTTP_HEADER_REFERER) == NULL);
+    
+    mu_assert_int_eq(HTTP_HEADER_USER_AGENT, http_header_id("User-Agent", 10));
+    mu_assert_int_eq(HTTP_HEADER_IF_MODIFIED_SINCE, http_header_id("if-modified-since", 17));
+    mu_assert_int_eq(HTTP_HEADER_TRANSFER_ENCODING, http_header_id("Transfer-Encoding", 17));
+    mu_assert_int_eq(HTTP_HEADER_OTHER, http_header_id("X-Host", 6));
+    mu_assert_int_eq(HTTP_HEADER_OTHER, http_header_id("Hosts", 5));
+    
+    return NULL;
+}
+
+MU_TEST(test_parse_headers_are_slices) {
+    char raw[] = "GET /docs/a.html?v=2 HTTP/1.1\r\n"
+                 "Host: example.com\r\n"
+                 "User-Agent:   curl/8.0  \r\n"
+                 "\r\n"
+                 "GET /next HTTP/1.1\r\n";
+    size_t head = strlen(raw) - strlen("GET /next HTTP/1.1\r\n");
+    char copy[sizeof(raw)];
+    memcpy(copy, raw, sizeof(raw));
+    HttpRequest req = http_parse_request(raw, strlen(raw));
+    
+    /* Values point into the buffer, trimmed and terminated in place */
+    mu_assert_true(req.valid);
+    mu_assert_size_eq(head, req.head_length);
+    mu_check(req.uri == raw + 4);
+    mu_assert_size_eq(12, req.uri_len);
+    mu_assert_string_eq("/docs/a.html", req.uri);
+    mu_assert_size_eq(8, req.headers[HTTP_HEADER_USER_AGENT].len);
+    mu_assert_string_eq("curl/8.0", http_header(&req, HTTP_HEADER_USER_AGENT));
+    
+    /* Restoring gives back the bytes as received */
+    http_request_restore(&req);
+    mu_check(memcmp(raw, copy, sizeof(raw)) == 0);
+    mu_assert_false(req.valid);
+    
+    req = http_parse_request(raw, strlen(raw));
+    mu_assert_true(req.valid);
+    mu_assert_string_eq("/docs/a.html", req.uri);
+    
+    return NULL;
+}
+
+MU_TEST(test_parse_incomplete_head) {
+    char raw[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n";
+    HttpRequest req = http_parse_request(raw, strlen(raw));
+    
+    mu_assert_size_eq(0, req.head_length);
+    mu_assert_false(req.valid);
+    mu_check(strchr(raw, '\0') == raw + strlen("GET /index.html HTTP/1.1\r\nHost: localhost\r\n"));
+    mu_assert_string_eq("", req.uri);
+    
+    return NULL;
+}
+
+MU_TEST(test_parse_bare_lf_head) {
+    char raw[] = "GET /a HTTP/1.0\nConnection: keep-alive\n\n";
+    HttpRequest req = http_parse_request(raw, strlen(raw));
+    
+    mu_assert_true(req.valid);
+    mu_assert_int_eq(0, req.version_minor);
+    mu_assert_size_eq(strlen("GET /a HTTP/1.0\nConnection: keep-alive\n\n"), req.head_length);
+    mu_assert_string_eq("keep-alive", http_header(&req, HTTP_HEADER_CONNECTION));
+    
+    return NULL;
+}
+
+MU_TEST(test_head_length_matches_parser) {
+    /* Two pipelined heads: the first ends where the parser says it does */
+    char crlf[] = "GET /a HTTP/1.1\r\nHost: x\r\n\r\nGET /b HTTP/1.1\r\n\r\n";
+    size_t length = http_head_length(crlf, strlen(crlf));
+    HttpRequest req = http_parse_request(crlf, strlen(crlf));
+    mu_assert_size_eq(strlen("GET /a HTTP/1.1\r\nHost: x\r\n\r\n"), length);
+    mu_assert_size_eq(req.head_length, length);
+    
+    char lf[] = "GET /a HTTP/1.1\nHost: x\n\nGET /b HTTP/1.1\n\n";
+    length = http_head_length(lf, strlen(lf));
+    req = http_parse_request(lf, strlen(lf));
+    mu_assert_size_eq(strlen("GET /a HTTP/1.1\nHost: x\n\n"), length);
+    mu_assert_size_eq(req.head_length, length);
+    
+    char bad[] = "GET / HTTP/1.1\r\nHost localhost\r\n\r\n";
+    req = http_parse_request(bad, strlen(bad));
+    mu_assert_size_eq(req.head_length, http_head_length(bad, strlen(bad)));
+    
+    /* Incomplete: no blank line yet, or only half of one */
+    const char* no_blank = "GET / HTTP/1.1\r\nHost: x\r\n";
+    const char* half_blank = "GET / HTTP/1.1\r\nHost: x\r\n\r";
+    mu_assert_size_eq(0, http_head_length(no_blank, strlen(no_blank)));
+    mu_assert_size_eq(0, http_head_length(half_blank, strlen(half_blank)));
+    mu_assert_size_eq(0, http_head_length("\r\n", 2));
+    
+    return NULL;
+}
+
+MU_TEST(test_parse_rejects_malformed_headers) {
+    /* The head still ends at the blank line, so the server can answer 400 */
+    char no_colon[] = "GET / HTTP/1.1\r\nHost localhost\r\n\r\n";
+    HttpRequest req = http_parse_request(no_colon, strlen(no_colon));
+    mu_assert_false(req.valid);
+    mu_assert_size_eq(strlen(no_colon), req.head_length);
+    
+    char space_before_colon[] = "GET / HTTP/1.1\r\nHost : localhost\r\n\r\n";
+    req = http_parse_request(space_before_colon, strlen(space_before_colon));
+    mu_assert_false(req.valid);
+    
+    char control[] = "GET / HTTP/1.1\r\nReferer: a\x01b\r\n\r\n";
+    req = http_parse_request(control, strlen(control));
+    mu_assert_false(req.valid);
+    
+    char two_hosts[] = "GET / HTTP/1.1\r\nHost: a\r\nHost: b\r\n\r\n";
+    req = http_parse_request(two_hosts, strlen(two_hosts));
+    mu_assert_false(req.valid);
+    
+    char two_lengths[] = "GET / HTTP/1.1\r\nContent-Length: 0\r\ncontent-length: 5\r\n\r\n";
+    req = http_parse_request(two_lengths, strlen(two_lengths));
+    mu_assert_false(req.valid);
+    
+    /* Recorded so the connection can close rather than parse the body */
+    char chunked[] = "GET / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n";
+    req = http_parse_request(chunked, strlen(chunked));
+    mu_assert_true(req.valid);
+    mu_assert_string_eq("chunked", http_header(&req, HTTP_HEADER_TRANSFER_ENCODING));
+    
+    /* Other repeated headers: the first one counts */
+    char two_ranges[] = "GET / HTTP/1.1\r\nRange: bytes=0-1\r\nRange: bytes=5-\r\n\r\n";
+    req = http_parse_request(two_ranges, strlen(two_ranges));
+    mu_assert_true(req.valid);
+    mu_assert_string_eq("bytes=0-1", http_header(&req, HTTP_HEADER_RANGE));
+    
+    return NULL;
+}
+
+MU_TEST(test_connection_tokens) {
+    char raw[] = "Keep-Alive, Close";
+    HttpSlice value = { raw, strlen(raw) };
+    
+    mu_assert_true(http_slice_has_token(value, "close"));
+    mu_assert_true(http_slice_has_token(value, "keep-alive"));
+    mu_assert_false(http_slice_has_token(value, "clos"));
+    
+    HttpSlice absent = { NULL, 0 };
+    mu_assert_false(http_slice_has_token(absent, "close"));
     
     return NULL;
 }
@@ -243,7 +402,7 @@ MU_TEST(test_parse_null_request) {
 }
 
 MU_TEST(test_parse_incomplete_request_line) {
-    const char* raw = "GET";
+    char raw[] = "GET";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     mu_assert_false(req.valid);
@@ -252,11 +411,12 @@ MU_TEST(test_parse_incomplete_request_line) {
 }
 
 MU_TEST(test_parse_missing_http_version) {
-    const char* raw = "GET /index.html\r\n\r\n";
+    char raw[] = "GET /index.html\r\n\r\n";
     HttpRequest req = http_parse_request(raw, strlen(raw));
     
     /* Should either be invalid or handle gracefully */
     /* Depending on implementation, this might be valid or invalid */
+    (void)req;
     
     return NULL;  /* Just don't crash */
 }
@@ -310,6 +470,13 @@ void test_suite_http(void) {
     /* Header extraction */
     MU_RUN_TEST(test_parse_if_none_match_header);
     MU_RUN_TEST(test_parse_accept_encoding_header);
+    MU_RUN_TEST(test_parse_headers_ignore_case);
+    MU_RUN_TEST(test_parse_headers_are_slices);
+    MU_RUN_TEST(test_parse_incomplete_head);
+    MU_RUN_TEST(test_parse_bare_lf_head);
+    MU_RUN_TEST(test_head_length_matches_parser);
+    MU_RUN_TEST(test_parse_rejects_malformed_headers);
+    MU_RUN_TEST(test_connection_tokens);
     
     /* Range header parsing */
     MU_RUN_TEST(test_parse_range_bytes_start_end);
@@ -6,8 +6,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef _WIN32
 #include <winsock2.h>
 #include <windows.h>
+#endif
 
 #include "minunit.h"
 
@@ -22,10 +24,16 @@ const char* mu_last_error = NULL;
 extern void test_suite_utils(void);
 extern void test_suite_http(void);
 extern void test_suite_mime(void);
+extern void test_suite_compression(void);
 extern void test_suite_rewrite(void);
 extern void test_suite_config(void);
 extern void test_suite_pool(void);
+extern void test_suite_timer(void);
 extern void test_suite_cache(void);
+extern void test_suite_cache_policy(void);
+extern void test_suite_open_file_cache(void);
+extern void test_suite_path_cache(void);
+extern void test_suite_fs_watch(void);
 extern void test_suite_server(void);
 extern void test_suite_security(void);
 
@@ -33,12 +41,14 @@ extern void test_suite_security(void);
  * Initialize Winsock for network tests.
  */
 static int init_winsock(void) {
+#ifdef _WIN32
     WSADATA wsa_data;
     int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
     if (result != 0) {
         printf("WSAStartup failed: %d\n", result);
         return -1;
     }
+#endif
     return 0;
 }
 
@@ -46,7 +56,9 @@ static int init_winsock(void) {
  * Cleanup Winsock.
  */
 static void cleanup_winsock(void) {
+#ifdef _WIN32
     WSACleanup();
+#endif
 }
 
 /*
@@ -80,10 +92,16 @@ int main(int argc, char* argv[]) {
     MU_RUN_SUITE(test_suite_utils);
     MU_RUN_SUITE(test_suite_http);
     MU_RUN_SUITE(test_suite_mime);
+    MU_RUN_SUITE(test_suite_compression);
     MU_RUN_SUITE(test_suite_rewrite);
     MU_RUN_SUITE(test_suite_config);
     MU_RUN_SUITE(test_suite_pool);
+    MU_RUN_SUITE(test_suite_timer);
     MU_RUN_SUITE(test_suite_cache);
+    MU_RUN_SUITE(test_suite_cache_policy);
+    MU_RUN_SUITE(test_suite_open_file_cache);
+    MU_RUN_SUITE(test_suite_path_cache);
+    MU_RUN_SUITE(test_suite_fs_watch);
     MU_RUN_SUITE(test_suite_security);
     
     /* Run integration tests */
@@ -0,0 +1,291 @@
+/*
+ * Bolt Test Suite - Open-File Cache Tests
+ *
+ * Tests for cached stat results, TTL revalidation, invalidation and
+ * shared handles.
+ */
+
+#include "minunit.h"
+#include "../include/open_file_cache.h"
+#include "../include/bolt.h"
+#include <string.h>
+#include <stdio.h>
+
+#define OFC_FILE  "test_open_file.txt"
+#define OFC_OTHER "test_open_file_other.txt"
+
+static void write_file(const char* filename, const char* content) {
+    FILE* f = fopen(filename, "wb");
+    if (f) {
+        fwrite(content, 1, strlen(content), f);
+        fclose(f);
+    }
+}
+
+/*============================================================================
+ * Setup Tests
+ *============================================================================*/
+
+MU_TEST(test_open_file_cache_create) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 1000);
+    mu_assert_not_null(cache);
+    bolt_open_file_cache_destroy(cache);
+
+    mu_assert_null(bolt_open_file_cache_create(0, 1000));
+
+    /* Should be safe with NULL */
+    bolt_open_file_cache_destroy(NULL);
+    bolt_open_file_release(NULL);
+    return NULL;
+}
+
+/*============================================================================
+ * Stat Tests
+ *============================================================================*/
+
+MU_TEST(test_open_file_cache_stat_trusted_within_ttl) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "abc");
+
+    FileInfo info = bolt_open_file_cache_stat(cache, OFC_FILE);
+    mu_assert_true(info.exists);
+    mu_assert_size_eq(3, info.size);
+
+    /* Not stat'ed again until the entry expires */
+    write_file(OFC_FILE, "abcdef");
+    info = bolt_open_file_cache_stat(cache, OFC_FILE);
+    mu_assert_size_eq(3, info.size);
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.misses == 1);
+    mu_check(stats.hits == 1);
+    mu_assert_size_eq(1, stats.entries);
+
+    remove(OFC_FILE);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_stat_revalidates_after_ttl) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 0);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "abc");
+
+    mu_assert_size_eq(3, bolt_open_file_cache_stat(cache, OFC_FILE).size);
+    write_file(OFC_FILE, "abcdef");
+    mu_assert_size_eq(6, bolt_open_file_cache_stat(cache, OFC_FILE).size);
+
+    /* A deleted file is forgotten */
+    remove(OFC_FILE);
+    mu_assert_false(bolt_open_file_cache_stat(cache, OFC_FILE).exists);
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.revalidations == 2);
+    mu_assert_size_eq(0, stats.entries);
+
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_missing_not_cached) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    mu_assert_false(bolt_open_file_cache_stat(cache, "no_such_file.txt").exists);
+    mu_assert_null(bolt_open_file_cache_open(cache, "no_such_file.txt"));
+
+    /* Directories are remembered but never opened */
+    mu_assert_true(bolt_open_file_cache_stat(cache, ".").is_directory);
+    mu_assert_null(bolt_open_file_cache_open(cache, "."));
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_assert_size_eq(1, stats.entries);
+    mu_assert_size_eq(0, stats.handles);
+
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+/*============================================================================
+ * Invalidation Tests
+ *============================================================================*/
+
+MU_TEST(test_open_file_cache_invalidate) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "abc");
+    write_file(OFC_OTHER, "other");
+
+    BoltOpenFile* file = bolt_open_file_cache_open(cache, OFC_FILE);
+    mu_assert_not_null(file);
+    mu_assert_true(bolt_open_file_cache_stat(cache, OFC_OTHER).exists);
+
+    /* A notified change is seen despite the long TTL */
+    write_file(OFC_FILE, "abcdef");
+    bolt_open_file_cache_invalidate(cache, OFC_FILE);
+    mu_assert_size_eq(6, bolt_open_file_cache_stat(cache, OFC_FILE).size);
+    mu_assert_int_eq(1, file->refs);  /* The transfer keeps its handle */
+    bolt_open_file_release(file);
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.invalidations == 1);
+    mu_assert_size_eq(2, stats.entries);
+
+    bolt_open_file_cache_invalidate_all(cache);
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.invalidations == 3);
+    mu_assert_size_eq(0, stats.entries);
+
+    remove(OFC_FILE);
+    remove(OFC_OTHER);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_set_valid) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "abc");
+
+    mu_assert_size_eq(3, bolt_open_file_cache_stat(cache, OFC_FILE).size);
+    write_file(OFC_FILE, "abcdef");
+
+    /* Dropping the TTL expires what is cached */
+    bolt_open_file_cache_set_valid(cache, 0);
+    mu_assert_size_eq(6, bolt_open_file_cache_stat(cache, OFC_FILE).size);
+
+    remove(OFC_FILE);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+/*============================================================================
+ * Handle Tests
+ *============================================================================*/
+
+MU_TEST(test_open_file_cache_shares_handle) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "hello");
+
+    BoltOpenFile* a = bolt_open_file_cache_open(cache, OFC_FILE);
+    BoltOpenFile* b = bolt_open_file_cache_open(cache, OFC_FILE);
+    mu_assert_not_null(a);
+    mu_check(a == b);
+    mu_assert_size_eq(5, a->size);
+    mu_assert_int_eq(3, a->refs);  /* Cache + two transfers */
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.opens == 1);
+    mu_assert_size_eq(1, stats.handles);
+
+    bolt_open_file_release(a);
+    bolt_open_file_release(b);
+    mu_assert_int_eq(1, a->refs);
+
+    remove(OFC_FILE);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_handle_outlives_eviction) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(1, 60000);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "hello");
+    write_file(OFC_OTHER, "other");
+
+    BoltOpenFile* file = bolt_open_file_cache_open(cache, OFC_FILE);
+    mu_assert_not_null(file);
+
+    /* A second path evicts the first; the transfer keeps its handle */
+    mu_assert_true(bolt_open_file_cache_stat(cache, OFC_OTHER).exists);
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(cache, &stats);
+    mu_check(stats.evictions == 1);
+    mu_assert_size_eq(0, stats.handles);
+    mu_assert_int_eq(1, file->refs);
+
+    char buf[8] = { 0 };
+    DWORD bytes = 0;
+    mu_assert_true(ReadFile(file->handle, buf, 5, &bytes, NULL));
+    mu_assert_int_eq(5, (int)bytes);
+    mu_assert_string_eq("hello", buf);
+    bolt_open_file_release(file);
+
+    remove(OFC_FILE);
+    remove(OFC_OTHER);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_reopens_changed_file) {
+    BoltOpenFileCache* cache = bolt_open_file_cache_create(100, 0);
+    mu_assert_not_null(cache);
+    write_file(OFC_FILE, "abc");
+
+    BoltOpenFile* old_file = bolt_open_file_cache_open(cache, OFC_FILE);
+    mu_assert_not_null(old_file);
+    write_file(OFC_FILE, "abcdef");
+
+    BoltOpenFile* new_file = bolt_open_file_cache_open(cache, OFC_FILE);
+    mu_assert_not_null(new_file);
+    mu_check(new_file != old_file);
+    mu_assert_size_eq(6, new_file->size);
+    mu_assert_int_eq(1, old_file->refs);  /* Only the old transfer left */
+
+    bolt_open_file_release(old_file);
+    bolt_open_file_release(new_file);
+
+    remove(OFC_FILE);
+    bolt_open_file_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_open_file_cache_null_cache) {
+    write_file(OFC_FILE, "hello");
+
+    mu_assert_true(bolt_open_file_cache_stat(NULL, OFC_FILE).exists);
+
+    /* Without a cache every open gets a private handle */
+    BoltOpenFile* file = bolt_open_file_cache_open(NULL, OFC_FILE);
+    mu_assert_not_null(file);
+    mu_assert_int_eq(1, file->refs);
+    bolt_open_file_release(file);
+
+    BoltOpenFileCacheStats stats;
+    bolt_open_file_cache_stats(NULL, &stats);
+    mu_assert_size_eq(0, stats.entries);
+
+    remove(OFC_FILE);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_open_file_cache(void) {
+    /* Setup */
+    MU_RUN_TEST(test_open_file_cache_create);
+
+    /* Stat */
+    MU_RUN_TEST(test_open_file_cache_stat_trusted_within_ttl);
+    MU_RUN_TEST(test_open_file_cache_stat_revalidates_after_ttl);
+    MU_RUN_TEST(test_open_file_cache_missing_not_cached);
+
+    /* Invalidation */
+    MU_RUN_TEST(test_open_file_cache_invalidate);
+    MU_RUN_TEST(test_open_file_cache_set_valid);
+
+    /* Handles */
+    MU_RUN_TEST(test_open_file_cache_shares_handle);
+    MU_RUN_TEST(test_open_file_cache_handle_outlives_eviction);
+    MU_RUN_TEST(test_open_file_cache_reopens_changed_file);
+    MU_RUN_TEST(test_open_file_cache_null_cache);
+}
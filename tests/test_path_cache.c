@@ -0,0 +1,231 @@
+/*
+ * Bolt Test Suite - Resolved-Path Cache Tests
+ *
+ * Tests for cached request resolutions, expiry and invalidation.
+ */
+
+#include "minunit.h"
+#include "../include/path_cache.h"
+#include "../include/bolt.h"
+#include <string.h>
+#include <stdio.h>
+
+static BoltResolvedPath make_resolved(const char* path, size_t size) {
+    BoltResolvedPath resolved;
+    memset(&resolved, 0, sizeof(resolved));
+    resolved.kind = BOLT_RESOLVED_FILE;
+    resolved.info.exists = true;
+    resolved.info.size = size;
+    snprintf(resolved.path, sizeof(resolved.path), "%s", path);
+    snprintf(resolved.content_type, sizeof(resolved.content_type), "text/html; charset=utf-8");
+    return resolved;
+}
+
+/*============================================================================
+ * Setup Tests
+ *============================================================================*/
+
+MU_TEST(test_path_cache_create) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 1000);
+    mu_assert_not_null(cache);
+    bolt_path_cache_destroy(cache);
+
+    mu_assert_null(bolt_path_cache_create(0, 1000));
+
+    /* Should be safe with NULL */
+    bolt_path_cache_destroy(NULL);
+    bolt_path_cache_invalidate_all(NULL);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    mu_assert_false(bolt_path_cache_lookup(NULL, "", "/", &out, &generation));
+    return NULL;
+}
+
+/*============================================================================
+ * Lookup Tests
+ *============================================================================*/
+
+MU_TEST(test_path_cache_hit_after_insert) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    BoltResolvedPath resolved = make_resolved("public/index.html", 42);
+    bolt_path_cache_insert(cache, "", "/", &resolved, generation);
+
+    mu_assert_true(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+    mu_assert_string_eq("public/index.html", out.path);
+    mu_assert_string_eq("text/html; charset=utf-8", out.content_type);
+    mu_assert_size_eq(42, out.info.size);
+
+    BoltPathCacheStats stats;
+    bolt_path_cache_stats(cache, &stats);
+    mu_check(stats.hits == 1);
+    mu_check(stats.misses == 1);
+    mu_assert_size_eq(1, stats.entries);
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_path_cache_keyed_by_host) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    bolt_path_cache_lookup(cache, "a.example", "/", &out, &generation);
+    BoltResolvedPath resolved = make_resolved("a/index.html", 1);
+    bolt_path_cache_insert(cache, "a.example", "/", &resolved, generation);
+
+    mu_assert_false(bolt_path_cache_lookup(cache, "b.example", "/", &out, &generation));
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+    mu_assert_true(bolt_path_cache_lookup(cache, "a.example", "/", &out, &generation));
+
+    /* Too long to key: never cached */
+    char uri[BOLT_PATH_CACHE_MAX_KEY + 16];
+    memset(uri, 'a', sizeof(uri) - 1);
+    uri[0] = '/';
+    uri[sizeof(uri) - 1] = '\0';
+    bolt_path_cache_insert(cache, "", uri, &resolved, generation);
+    mu_assert_false(bolt_path_cache_lookup(cache, "", uri, &out, &generation));
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_path_cache_expires) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 0);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    BoltResolvedPath resolved = make_resolved("public/index.html", 1);
+    bolt_path_cache_lookup(cache, "", "/", &out, &generation);
+    bolt_path_cache_insert(cache, "", "/", &resolved, generation);
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    /* A longer TTL applies to what is resolved from then on */
+    bolt_path_cache_set_valid(cache, 60000);
+    bolt_path_cache_insert(cache, "", "/", &resolved, generation);
+    mu_assert_true(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_path_cache_evicts_lru) {
+    BoltPathCache* cache = bolt_path_cache_create(1, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    BoltResolvedPath resolved = make_resolved("public/a.html", 1);
+    bolt_path_cache_lookup(cache, "", "/a.html", &out, &generation);
+    bolt_path_cache_insert(cache, "", "/a.html", &resolved, generation);
+    bolt_path_cache_insert(cache, "", "/b.html", &resolved, generation);
+
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/a.html", &out, &generation));
+    mu_assert_true(bolt_path_cache_lookup(cache, "", "/b.html", &out, &generation));
+
+    BoltPathCacheStats stats;
+    bolt_path_cache_stats(cache, &stats);
+    mu_check(stats.evictions == 1);
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_path_cache_holds_errors) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    bolt_path_cache_lookup(cache, "", "/wp-login.php", &out, &generation);
+
+    BoltResolvedPath missing;
+    memset(&missing, 0, sizeof(missing));
+    missing.kind = BOLT_RESOLVED_ERROR;
+    missing.status = 404;
+    bolt_path_cache_insert(cache, "", "/wp-login.php", &missing, generation);
+
+    mu_assert_true(bolt_path_cache_lookup(cache, "", "/wp-login.php", &out, &generation));
+    mu_check(out.kind == BOLT_RESOLVED_ERROR);
+    mu_assert_int_eq(404, out.status);
+
+    /* A file appearing drops the miss with everything else */
+    bolt_path_cache_invalidate_all(cache);
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/wp-login.php", &out, &generation));
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+/*============================================================================
+ * Invalidation Tests
+ *============================================================================*/
+
+MU_TEST(test_path_cache_invalidate_all) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    BoltResolvedPath resolved = make_resolved("public/index.html", 1);
+    bolt_path_cache_lookup(cache, "", "/", &out, &generation);
+    bolt_path_cache_insert(cache, "", "/", &resolved, generation);
+
+    bolt_path_cache_invalidate_all(cache);
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    BoltPathCacheStats stats;
+    bolt_path_cache_stats(cache, &stats);
+    mu_check(stats.invalidations == 1);
+    mu_assert_size_eq(0, stats.entries);
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+MU_TEST(test_path_cache_drops_racing_insert) {
+    BoltPathCache* cache = bolt_path_cache_create(100, 60000);
+    mu_assert_not_null(cache);
+
+    BoltResolvedPath out;
+    LONG64 generation;
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    /* A file changed while the request was being resolved */
+    bolt_path_cache_invalidate_all(cache);
+    BoltResolvedPath resolved = make_resolved("public/index.html", 1);
+    bolt_path_cache_insert(cache, "", "/", &resolved, generation);
+    mu_assert_false(bolt_path_cache_lookup(cache, "", "/", &out, &generation));
+
+    bolt_path_cache_destroy(cache);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_path_cache(void) {
+    /* Setup */
+    MU_RUN_TEST(test_path_cache_create);
+
+    /* Lookups */
+    MU_RUN_TEST(test_path_cache_hit_after_insert);
+    MU_RUN_TEST(test_path_cache_keyed_by_host);
+    MU_RUN_TEST(test_path_cache_expires);
+    MU_RUN_TEST(test_path_cache_evicts_lru);
+    MU_RUN_TEST(test_path_cache_holds_errors);
+
+    /* Invalidation */
+    MU_RUN_TEST(test_path_cache_invalidate_all);
+    MU_RUN_TEST(test_path_cache_drops_racing_insert);
+}
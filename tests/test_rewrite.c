@@ -19,7 +19,7 @@ MU_TEST(test_match_exact) {
 }
 
 MU_TEST(test_match_wildcard_end) {
-    /* Pattern "/api/*" should match anything starting with /api/ */
+    /* Pattern "/api/" + '*' should match anything starting with /api/ */
     mu_assert_true(rewrite_match_pattern("/api/*", "/api/users"));
     mu_assert_true(rewrite_match_pattern("/api/*", "/api/users/123"));
     mu_assert_true(rewrite_match_pattern("/api/*", "/api/"));
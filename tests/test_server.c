@@ -7,12 +7,17 @@
 
 #include "minunit.h"
 #include "../include/bolt.h"
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <windows.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define TEST_HAVE_ZLIB 1
+#else
+#define TEST_HAVE_ZLIB 0
+#endif
+
 /* Test configuration */
 #define TEST_HOST "127.0.0.1"
 #define TEST_PORT 8080
@@ -34,7 +39,11 @@ static SOCKET connect_to_server(void) {
     }
     
     /* Set timeout */
+#ifdef _WIN32
     DWORD timeout = TEST_TIMEOUT_MS;
+#else
+    struct timeval timeout = { TEST_TIMEOUT_MS / 1000, (TEST_TIMEOUT_MS % 1000) * 1000 };
+#endif
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
     setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
     
@@ -352,6 +361,210 @@ MU_TEST(test_keepalive_connection) {
     return NULL;
 }
 
+MU_TEST(test_pipelined_requests) {
+    if (!server_is_running()) {
+        printf("    [SKIP] Server not running\n");
+        return NULL;
+    }
+    
+    SOCKET sock = connect_to_server();
+    mu_assert("Could not connect", sock != INVALID_SOCKET);
+    
+    /* Three requests in one write; responses must come back in order */
+    const char* requests = 
+        "HEAD / HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "\r\n"
+        "GET /nonexistent_file_12345.html HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "\r\n"
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    
+    send(sock, requests, (int)strlen(requests), 0);
+    
+    static char response[RECV_BUFFER_SIZE * 4];
+    int total_received = 0;
+    int received;
+    while ((received = recv(sock, response + total_received,
+                            (int)(sizeof(response) - total_received - 1), 0)) > 0) {
+        total_received += received;
+        if (total_received >= (int)sizeof(response) - 1) break;
+    }
+    response[total_received] = '\0';
+    closesocket(sock);
+    
+    const char* first = strstr(response, "HTTP/1.1 200");
+    mu_assert("First response missing", first == response);
+    const char* second = strstr(first + 1, "HTTP/1.1 ");
+    mu_assert("Second response missing", second != NULL);
+    mu_check(strncmp(second, "HTTP/1.1 404", 12) == 0);
+    const char* third = strstr(second + 1, "HTTP/1.1 ");
+    mu_assert("Third response missing", third != NULL);
+    mu_check(strncmp(third, "HTTP/1.1 200", 12) == 0);
+    
+    return NULL;
+}
+
+/*
+ * Send a request with a body and a second request behind it; count the
+ * responses until the server closes.
+ */
+static int count_responses_after_body(const char* requests) {
+    SOCKET sock = connect_to_server();
+    if (sock == INVALID_SOCKET) return -1;
+    send(sock, requests, (int)strlen(requests), 0);
+    
+    static char response[RECV_BUFFER_SIZE * 4];
+    int total_received = 0;
+    int received;
+    while ((received = recv(sock, response + total_received,
+                            (int)(sizeof(response) - total_received - 1), 0)) > 0) {
+        total_received += received;
+        if (total_received >= (int)sizeof(response) - 1) break;
+    }
+    response[total_received] = '\0';
+    closesocket(sock);
+    
+    if (strncmp(response, "HTTP/1.1 200", 12) != 0) return -1;
+    int count = 0;
+    for (const char* p = response; (p = strstr(p, "HTTP/1.1 ")) != NULL; p++) {
+        count++;
+    }
+    return count;
+}
+
+MU_TEST(test_request_body_closes_connection) {
+    if (!server_is_running()) {
+        printf("    [SKIP] Server not running\n");
+        return NULL;
+    }
+    
+    /* Bodies are not read: the body must not be answered as a request */
+    const char* with_length =
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Content-Length: 37\r\n"
+        "\r\n"
+        "GET /index.html HTTP/1.1\r\nHost: x\r\n\r\n"
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "\r\n";
+    mu_assert_int_eq(1, count_responses_after_body(with_length));
+    
+    const char* chunked =
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "0\r\n"
+        "\r\n"
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "\r\n";
+    mu_assert_int_eq(1, count_responses_after_body(chunked));
+    
+    return NULL;
+}
+
+/*============================================================================
+ * Streamed Compression Tests
+ *============================================================================*/
+
+MU_TEST(test_stream_compressed_chunked) {
+    if (!server_is_running()) {
+        printf("    [SKIP] Server not running\n");
+        return NULL;
+    }
+    
+    /* Text well past the in-memory compression limit */
+    const char* path = "public/_stream_test.txt";
+    size_t size = 300000;
+    char* text = (char*)malloc(size);
+    mu_assert_not_null(text);
+    const char line[] = "streamed line of text for bolt\n";
+    for (size_t i = 0; i < size; i++) {
+        text[i] = line[i % (sizeof(line) - 1)];
+    }
+    FILE* f = fopen(path, "wb");
+    mu_assert_not_null(f);
+    fwrite(text, 1, size, f);
+    fclose(f);
+    
+    SOCKET sock = connect_to_server();
+    mu_assert("Could not connect", sock != INVALID_SOCKET);
+    const char* request =
+        "GET /_stream_test.txt HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Accept-Encoding: gzip\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    send(sock, request, (int)strlen(request), 0);
+    
+    size_t capacity = size;
+    char* response = (char*)malloc(capacity + 1);
+    size_t total = 0;
+    int received;
+    while (total < capacity &&
+           (received = recv(sock, response + total, (int)(capacity - total), 0)) > 0) {
+        total += (size_t)received;
+    }
+    response[total] = '\0';
+    closesocket(sock);
+    remove(path);
+    
+    mu_check(strncmp(response, "HTTP/1.1 200", 12) == 0);
+    mu_check(strstr(response, "Transfer-Encoding: chunked\r\n") != NULL);
+    mu_check(strstr(response, "Content-Encoding: gzip\r\n") != NULL);
+    char* body = strstr(response, "\r\n\r\n");
+    mu_assert_not_null(body);
+    body += 4;
+    
+    /* Undo the chunking in place, up to the last chunk */
+    char* out = body;
+    char* p = body;
+    bool last = false;
+    while (p < response + total) {
+        char* end = NULL;
+        size_t len = (size_t)strtoul(p, &end, 16);
+        mu_check(end && end[0] == '\r' && end[1] == '\n');
+        p = end + 2;
+        if (len == 0) {
+            last = true;
+            break;
+        }
+        mu_check(p + len + 2 <= response + total);
+        memmove(out, p, len);
+        out += len;
+        p += len + 2;
+    }
+    mu_assert("Last chunk missing", last);
+    size_t compressed = (size_t)(out - body);
+    mu_check(compressed > 0 && compressed < size / 4);
+    
+#if TEST_HAVE_ZLIB
+    char* plain = (char*)malloc(size);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    mu_check(inflateInit2(&zs, 31) == Z_OK);
+    zs.next_in = (Bytef*)body;
+    zs.avail_in = (uInt)compressed;
+    zs.next_out = (Bytef*)plain;
+    zs.avail_out = (uInt)size;
+    mu_check(inflate(&zs, Z_FINISH) == Z_STREAM_END);
+    mu_assert_size_eq(size, (size_t)zs.total_out);
+    mu_check(memcmp(plain, text, size) == 0);
+    inflateEnd(&zs);
+    free(plain);
+#endif
+    
+    free(response);
+    free(text);
+    return NULL;
+}
+
 /*============================================================================
  * Response Header Tests
  *============================================================================*/
@@ -461,6 +674,11 @@ void test_suite_server(void) {
     
     /* Keep-alive */
     MU_RUN_TEST(test_keepalive_connection);
+    MU_RUN_TEST(test_pipelined_requests);
+    MU_RUN_TEST(test_request_body_closes_connection);
+    
+    /* Streamed compression */
+    MU_RUN_TEST(test_stream_compressed_chunked);
     
     /* Response headers */
     MU_RUN_TEST(test_server_header);
@@ -0,0 +1,194 @@
+/*
+ * Bolt Test Suite - Timing Wheel Tests
+ *
+ * Tests for connection deadline arming, cancellation and expiry.
+ */
+
+#include "minunit.h"
+#include "../include/timer_wheel.h"
+#include "../include/bolt.h"
+#include <string.h>
+
+#define TEST_TICK_MS 100
+#define TEST_START_MS 1000000ull
+
+/* Expiry callback: counts timers fired */
+static void count_expired(BoltTimer* timer, void* context) {
+    BOLT_UNUSED(timer);
+    (*(int*)context)++;
+}
+
+/*============================================================================
+ * Creation Tests
+ *============================================================================*/
+
+MU_TEST(test_timer_wheel_create) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+MU_TEST(test_timer_wheel_create_invalid) {
+    int fired = 0;
+    mu_assert_null(bolt_timer_wheel_create(0, TEST_START_MS, count_expired, &fired));
+    mu_assert_null(bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS, NULL, &fired));
+
+    /* Should be safe to call with NULL */
+    bolt_timer_wheel_destroy(NULL);
+    return NULL;
+}
+
+/*============================================================================
+ * Expiry Tests
+ *============================================================================*/
+
+MU_TEST(test_timer_fires_at_deadline) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+
+    BoltTimer timer;
+    memset(&timer, 0, sizeof(timer));
+    bolt_timer_arm(wheel, &timer, TEST_START_MS, 5000);
+
+    /* Not one tick early */
+    mu_assert_int_eq(0, bolt_timer_wheel_advance(wheel, TEST_START_MS + 4900));
+    mu_assert_int_eq(0, fired);
+
+    mu_assert_int_eq(1, bolt_timer_wheel_advance(wheel, TEST_START_MS + 5000));
+    mu_assert_int_eq(1, fired);
+    mu_assert_null(timer.wheel);
+
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+MU_TEST(test_timer_cascades_from_upper_levels) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+
+    /* 60s and 10min are beyond level 0 (64 ticks) and level 1 (4096 ticks) */
+    BoltTimer keepalive, slow;
+    memset(&keepalive, 0, sizeof(keepalive));
+    memset(&slow, 0, sizeof(slow));
+    bolt_timer_arm(wheel, &keepalive, TEST_START_MS, 60000);
+    bolt_timer_arm(wheel, &slow, TEST_START_MS, 600000);
+
+    /* Advance in small steps as a worker would */
+    ULONGLONG now = TEST_START_MS;
+    while (now < TEST_START_MS + 59900) {
+        now += 250;
+        if (now > TEST_START_MS + 59900) now = TEST_START_MS + 59900;
+        bolt_timer_wheel_advance(wheel, now);
+    }
+    mu_assert_int_eq(0, fired);
+
+    bolt_timer_wheel_advance(wheel, TEST_START_MS + 60000);
+    mu_assert_int_eq(1, fired);
+
+    bolt_timer_wheel_advance(wheel, TEST_START_MS + 599900);
+    mu_assert_int_eq(1, fired);
+
+    bolt_timer_wheel_advance(wheel, TEST_START_MS + 600000);
+    mu_assert_int_eq(2, fired);
+
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+MU_TEST(test_timer_batch_expiry) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+
+    BoltTimer timers[100];
+    memset(timers, 0, sizeof(timers));
+    for (int i = 0; i < 100; i++) {
+        bolt_timer_arm(wheel, &timers[i], TEST_START_MS, 1000 + (DWORD)(i % 10) * 100);
+    }
+    mu_assert_int_eq(100, wheel->armed);
+
+    /* One late advance reaps everything that is due */
+    mu_assert_int_eq(100, bolt_timer_wheel_advance(wheel, TEST_START_MS + 5000));
+    mu_assert_int_eq(0, wheel->armed);
+    mu_assert_true(wheel->expired == 100);
+
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+/*============================================================================
+ * Cancel / Re-arm Tests
+ *============================================================================*/
+
+MU_TEST(test_timer_cancel) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+
+    BoltTimer timer;
+    memset(&timer, 0, sizeof(timer));
+    bolt_timer_arm(wheel, &timer, TEST_START_MS, 1000);
+    bolt_timer_cancel(wheel, &timer);
+    mu_assert_null(timer.wheel);
+
+    /* Cancelling an idle timer is a no-op */
+    bolt_timer_cancel(wheel, &timer);
+    mu_assert_int_eq(0, wheel->armed);
+
+    mu_assert_int_eq(0, bolt_timer_wheel_advance(wheel, TEST_START_MS + 10000));
+    mu_assert_int_eq(0, fired);
+
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+MU_TEST(test_timer_rearm_moves_deadline) {
+    int fired = 0;
+    BoltTimerWheel* wheel = bolt_timer_wheel_create(TEST_TICK_MS, TEST_START_MS,
+                                                    count_expired, &fired);
+    mu_assert_not_null(wheel);
+
+    BoltTimer timer;
+    memset(&timer, 0, sizeof(timer));
+    bolt_timer_arm(wheel, &timer, TEST_START_MS, 1000);
+
+    /* Progress just before the deadline pushes it out */
+    bolt_timer_wheel_advance(wheel, TEST_START_MS + 900);
+    bolt_timer_arm(wheel, &timer, TEST_START_MS + 900, 1000);
+    mu_assert_int_eq(1, wheel->armed);
+
+    mu_assert_int_eq(0, bolt_timer_wheel_advance(wheel, TEST_START_MS + 1800));
+    mu_assert_int_eq(1, bolt_timer_wheel_advance(wheel, TEST_START_MS + 1900));
+    mu_assert_int_eq(1, fired);
+
+    bolt_timer_wheel_destroy(wheel);
+    return NULL;
+}
+
+/*============================================================================
+ * Test Suite Runner
+ *============================================================================*/
+
+void test_suite_timer(void) {
+    /* Creation */
+    MU_RUN_TEST(test_timer_wheel_create);
+    MU_RUN_TEST(test_timer_wheel_create_invalid);
+
+    /* Expiry */
+    MU_RUN_TEST(test_timer_fires_at_deadline);
+    MU_RUN_TEST(test_timer_cascades_from_upper_levels);
+    MU_RUN_TEST(test_timer_batch_expiry);
+
+    /* Cancel / re-arm */
+    MU_RUN_TEST(test_timer_cancel);
+    MU_RUN_TEST(test_timer_rearm_moves_deadline);
+}
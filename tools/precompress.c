@@ -0,0 +1,320 @@
+/*
+ * bolt-precompress: build precompressed siblings for a web root.
+ *
+ * Walks the tree and writes app.js.gz, app.js.br and app.js.zst next to
+ * every file the server would compress (mime_get_type() by extension,
+ * then compression_should_compress()), at each coding's best level. Bolt
+ * sends those siblings as is (gzip_static, brotli_static, zstd_static),
+ * so a deploy built this way costs no compression CPU at runtime.
+ *
+ * Files are spread over one thread per core. A sibling at least as new as
+ * its file is up to date and left alone, the same rule the server uses to
+ * trust it. Output that would not be smaller than the file is not
+ * written. New siblings go to a temporary name first and are renamed into
+ * place, so the server never sees half a file.
+ *
+ * Codings whose library this build lacks are skipped.
+ *
+ * Usage: bolt-precompress [-j threads] [-f] [-v] [root]
+ *   -j  threads (default: one per core)
+ *   -f  rewrite siblings even if they are up to date
+ *   -v  print a line per sibling written
+ * root defaults to public.
+ */
+
+#include "compression.h"
+#include "mime.h"
+#include "utils.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PRECOMPRESS_MAX_THREADS 256
+
+/* Siblings written, by coding: suffix as the server looks it up */
+static const BoltCompressionType g_codings[] = {
+    BOLT_COMPRESS_GZIP, BOLT_COMPRESS_BROTLI, BOLT_COMPRESS_ZSTD
+};
+static const char* const g_suffixes[] = { ".gz", ".br", ".zst" };
+
+#define CODINGS (sizeof(g_codings) / sizeof(g_codings[0]))
+
+typedef struct {
+    long written;
+    long current;           /* Up to date, left alone */
+    long larger;            /* Not smaller than the file, not written */
+    long failed;
+    long long in_bytes;     /* Of the files written for */
+    long long out_bytes;
+} CodingStats;
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+} FileList;
+
+typedef struct {
+    pthread_t thread;
+    CodingStats stats[CODINGS];
+} Worker;
+
+static FileList g_files;
+static volatile LONG g_next_file;
+static bool g_force;
+static bool g_verbose;
+static BoltCompressionConfig g_config;
+static pthread_mutex_t g_print_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool ends_with(const char* s, const char* suffix) {
+    size_t len = strlen(s);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+/*
+ * Whether the server would compress this file: same classification as
+ * its resolver, and not a sibling or a leftover temporary itself.
+ */
+static bool is_compressible(const char* path, size_t size) {
+    for (size_t i = 0; i < CODINGS; i++) {
+        if (ends_with(path, g_suffixes[i])) return false;
+    }
+    if (ends_with(path, ".tmp") || size < g_config.min_size) return false;
+    return compression_should_compress(mime_get_type(utils_get_extension(path)), &g_config);
+}
+
+static bool list_add(FileList* list, const char* path) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        char** paths = (char**)realloc(list->paths, capacity * sizeof(char*));
+        if (!paths) return false;
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+    list->paths[list->count] = strdup(path);
+    return list->paths[list->count++] != NULL;
+}
+
+/*
+ * Collect the compressible regular files below path. Symlinked
+ * directories are not followed, as in the server's watcher.
+ */
+static bool walk(const char* path, long* seen) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "bolt-precompress: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    bool ok = true;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        char child[BOLT_MAX_PATH_LENGTH];
+        if (snprintf(child, sizeof(child), "%s/%s", path, name) >= (int)sizeof(child)) {
+            continue;  /* Too long to be served */
+        }
+        struct stat st;
+        if (lstat(child, &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            ok = walk(child, seen);
+            continue;
+        }
+        if (S_ISLNK(st.st_mode) && (stat(child, &st) != 0 || !S_ISREG(st.st_mode))) continue;
+        if (!S_ISREG(st.st_mode)) continue;
+
+        (*seen)++;
+        if (is_compressible(child, (size_t)st.st_size)) {
+            ok = list_add(&g_files, child);
+        }
+    }
+    closedir(dir);
+    return ok;
+}
+
+static char* read_file(const char* path, size_t size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    char* data = (char*)malloc(size ? size : 1);
+    if (data && fread(data, 1, size, f) != size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+/*
+ * Write a sibling under a temporary name, then move it into place.
+ */
+static bool write_sibling(const char* path, const char* data, size_t size) {
+    char tmp[BOLT_MAX_PATH_LENGTH + 16];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, size, f) == size;
+    ok = fclose(f) == 0 && ok;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+static void precompress_file(Worker* worker, const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return;
+    size_t size = (size_t)st.st_size;
+
+    char* data = NULL;
+    for (size_t i = 0; i < CODINGS; i++) {
+        BoltCompressionType type = g_codings[i];
+        CodingStats* stats = &worker->stats[i];
+        if (!compression_available(type)) continue;
+
+        char sibling[BOLT_MAX_PATH_LENGTH];
+        if (snprintf(sibling, sizeof(sibling), "%s%s", path, g_suffixes[i]) >= (int)sizeof(sibling)) {
+            continue;
+        }
+        struct stat sibling_st;
+        if (!g_force && stat(sibling, &sibling_st) == 0 && sibling_st.st_mtime >= st.st_mtime) {
+            stats->current++;
+            continue;
+        }
+
+        if (!data && !(data = read_file(path, size))) {
+            fprintf(stderr, "bolt-precompress: cannot read %s\n", path);
+            stats->failed++;
+            break;
+        }
+        BoltCompressedData out = { NULL, 0, BOLT_COMPRESS_NONE };
+        if (!compression_compress(type, data, size, &out, compression_best_level(type))) {
+            stats->failed++;
+            continue;
+        }
+        if (out.size >= size) {
+            stats->larger++;
+        } else if (write_sibling(sibling, out.data, out.size)) {
+            stats->written++;
+            stats->in_bytes += (long long)size;
+            stats->out_bytes += (long long)out.size;
+            if (g_verbose) {
+                pthread_mutex_lock(&g_print_lock);
+                printf("  %s (%zu -> %zu)\n", sibling, size, out.size);
+                pthread_mutex_unlock(&g_print_lock);
+            }
+        } else {
+            fprintf(stderr, "bolt-precompress: cannot write %s: %s\n", sibling, strerror(errno));
+            stats->failed++;
+        }
+        free(out.data);
+    }
+    free(data);
+}
+
+static void* worker_run(void* param) {
+    Worker* worker = (Worker*)param;
+    for (;;) {
+        LONG next = InterlockedIncrement(&g_next_file) - 1;
+        if ((size_t)next >= g_files.count) break;
+        precompress_file(worker, g_files.paths[next]);
+    }
+    compression_release_thread_contexts();
+    return NULL;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: bolt-precompress [-j threads] [-f] [-v] [root]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* root = BOLT_WEB_ROOT;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cores > 0 ? (int)cores : 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0) {
+            g_force = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            g_verbose = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            root = argv[i];
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > PRECOMPRESS_MAX_THREADS) threads = PRECOMPRESS_MAX_THREADS;
+
+    /* The server's defaults: same types and minimum size */
+    g_config = compression_get_default_config();
+
+    double start = now_seconds();
+    long seen = 0;
+    if (!walk(root, &seen)) return 1;
+    if ((size_t)threads > g_files.count) threads = g_files.count > 0 ? (int)g_files.count : 1;
+
+    printf("bolt-precompress: %s: %ld files, %zu compressible, %d threads\n",
+           root, seen, g_files.count, threads);
+
+    Worker* workers = (Worker*)calloc((size_t)threads, sizeof(Worker));
+    if (!workers) return 1;
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]) != 0) break;
+        started++;
+    }
+    if (started == 0) worker_run(&workers[0]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("  coding  written  current  larger  failed      in bytes     out bytes   ratio\n");
+    long failed = 0;
+    for (size_t c = 0; c < CODINGS; c++) {
+        if (!compression_available(g_codings[c])) {
+            printf("  %-6s  (not in this build)\n", compression_coding_name(g_codings[c]));
+            continue;
+        }
+        CodingStats total = { 0, 0, 0, 0, 0, 0 };
+        for (int i = 0; i < threads; i++) {
+            CodingStats* s = &workers[i].stats[c];
+            total.written += s->written;
+            total.current += s->current;
+            total.larger += s->larger;
+            total.failed += s->failed;
+            total.in_bytes += s->in_bytes;
+            total.out_bytes += s->out_bytes;
+        }
+        failed += total.failed;
+        printf("  %-6s %8ld %8ld %7ld %7ld %13lld %13lld %6.1f%%\n",
+               compression_coding_name(g_codings[c]), total.written, total.current,
+               total.larger, total.failed, total.in_bytes, total.out_bytes,
+               total.in_bytes > 0 ? 100.0 * (double)total.out_bytes / (double)total.in_bytes : 0.0);
+    }
+    printf("  Time: %.2f s\n", elapsed);
+
+    for (size_t i = 0; i < g_files.count; i++) {
+        free(g_files.paths[i]);
+    }
+    free(g_files.paths);
+    free(workers);
+    return failed > 0 ? 1 : 0;
+}